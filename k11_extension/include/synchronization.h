@@ -43,6 +43,9 @@ void rosalinaRescheduleThread(KThread *thread, bool lock);
 void rosalinaLockThreads(u32 mask);
 void rosalinaUnlockThreads(u32 mask);
 
+bool rosalinaIsThreadDebugParked(KThread *thread);
+Result rosalinaParkDebugThread(u32 threadId, bool park);
+
 // Taken from ctrulib:
 
 static inline void __dsb(void)
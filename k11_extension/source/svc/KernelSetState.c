@@ -190,6 +190,11 @@ Result KernelSetStateHook(u32 type, u32 varg1, u32 varg2, u32 varg3)
             KRecursiveLock__Unlock(&dbgParamsLock);
             break;
         }
+        case 0x10007:
+        {
+            res = rosalinaParkDebugThread(varg1, (bool)varg2);
+            break;
+        }
         default:
         {
             res = KernelSetState(type, varg1, varg2, varg3);
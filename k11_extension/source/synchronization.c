@@ -66,6 +66,12 @@ void KThread__DebugReschedule(KThread *this, bool lock)
     KRecursiveLock__Unlock(criticalSectionLock);
 }
 
+#define MAX_DEBUG_PARKED_THREADS 128
+
+// Threads stopped on their own by the GDB stub (non-stop mode); thread IDs are unique system-wide
+static u32 debugParkedThreadIds[MAX_DEBUG_PARKED_THREADS];
+static u32 nbDebugParkedThreads = 0;
+
 static void rosalinaLockThread(KThread *thread)
 {
     KThread *syncThread = synchronizationMutex->owner;
@@ -174,7 +180,67 @@ void rosalinaUnlockThreads(u32 mask)
         if((thread->schedulingMask & 0xF) == 2) // thread is terminating
             continue;
 
+        if(rosalinaIsThreadDebugParked(thread)) // stays stopped until the debugger resumes it
+            continue;
+
         if((thread->schedulingMask & 0x40) && rosalinaThreadLockPredicate(thread, mask))
             rosalinaRescheduleThread(thread, false);
     }
 }
+
+bool rosalinaIsThreadDebugParked(KThread *thread)
+{
+    for(u32 i = 0; i < nbDebugParkedThreads; i++)
+    {
+        if(debugParkedThreadIds[i] == thread->threadId)
+            return true;
+    }
+
+    return false;
+}
+
+Result rosalinaParkDebugThread(u32 threadId, bool park)
+{
+    Result res = 0xE0E01BFD; // thread not found
+
+    KRecursiveLock__Lock(criticalSectionLock);
+
+    u32 id;
+    for(id = 0; id < nbDebugParkedThreads && debugParkedThreadIds[id] != threadId; id++);
+
+    if(!park && id < nbDebugParkedThreads)
+    {
+        debugParkedThreadIds[id] = debugParkedThreadIds[--nbDebugParkedThreads];
+        res = 0;
+    }
+    else if(park && id == nbDebugParkedThreads && nbDebugParkedThreads == MAX_DEBUG_PARKED_THREADS)
+    {
+        KRecursiveLock__Unlock(criticalSectionLock);
+        return 0xC86018FF; // Out of resource (255)
+    }
+
+    for(KLinkedListNode *node = threadList->list.nodes.first; node != (KLinkedListNode *)&threadList->list.nodes; node = node->next)
+    {
+        KThread *thread = (KThread *)node->key;
+        if(thread->threadId != threadId)
+            continue;
+
+        if(park)
+        {
+            if(id == nbDebugParkedThreads)
+                debugParkedThreadIds[nbDebugParkedThreads++] = threadId;
+
+            rosalinaRescheduleThread(thread, true);
+            if(thread == coreCtxs[thread->coreId].objectContext.currentThread && thread->coreId != getCurrentCoreID())
+                KScheduler__TriggerCrossCoreInterrupt(currentCoreContext->objectContext.currentScheduler);
+        }
+        else if(!((rosalinaState & 1) && rosalinaThreadLockPredicate(thread, 1)))
+            rosalinaRescheduleThread(thread, false); // otherwise, rosalinaUnlockThreads will do it
+
+        res = 0;
+        break;
+    }
+
+    KRecursiveLock__Unlock(criticalSectionLock);
+    return res;
+}
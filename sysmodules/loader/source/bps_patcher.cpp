@@ -1,6 +1,8 @@
 #include "bps_patcher.h"
 
+#include <algorithm>
 #include <array>
+#include <cstdint>
 #include <cstring>
 #include <optional>
 #include <string_view>
@@ -30,21 +32,64 @@ using Number = u32;
 constexpr std::size_t FooterSize = 12;
 
 // The BPS format uses CRC32 checksums.
-[[gnu::optimize("Os")]] static u32 crc32(const u8 *data, std::size_t size)
+// Tables for slicing-by-4: Crc32Tables[k][i] is the CRC of byte i followed by k zero bytes.
+static constexpr std::array<std::array<u32, 256>, 4> MakeCrc32Tables()
 {
-    u32 crc = 0xFFFFFFFF;
-    for(std::size_t i = 0; i < size; ++i)
+    std::array<std::array<u32, 256>, 4> tables{};
+    for(u32 i = 0; i < 256; ++i)
     {
-        crc ^= data[i];
+        u32 crc = i;
         for(std::size_t j = 0; j < 8; ++j)
-        {
-            u32 mask = -(crc & 1);
-            crc = (crc >> 1) ^ (0xEDB88320 & mask);
-        }
+            crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+        tables[0][i] = crc;
+    }
+    for(std::size_t k = 1; k < tables.size(); ++k)
+    {
+        for(u32 i = 0; i < 256; ++i)
+            tables[k][i] = (tables[k - 1][i] >> 8) ^ tables[0][tables[k - 1][i] & 0xFF];
     }
+    return tables;
+}
+
+static constexpr auto Crc32Tables = MakeCrc32Tables();
+
+static u32 crc32(const u8 *data, std::size_t size)
+{
+    u32 crc = 0xFFFFFFFF;
+    while(size != 0 && (reinterpret_cast<uintptr_t>(data) & 3) != 0)
+    {
+        crc = (crc >> 8) ^ Crc32Tables[0][(crc ^ *data++) & 0xFF];
+        --size;
+    }
+    for(; size >= 4; size -= 4, data += 4)
+    {
+        // Little endian: the first byte of the word is the lowest one.
+        crc ^= *reinterpret_cast<const u32 *>(data);
+        crc = Crc32Tables[3][crc & 0xFF] ^ Crc32Tables[2][(crc >> 8) & 0xFF] ^
+              Crc32Tables[1][(crc >> 16) & 0xFF] ^ Crc32Tables[0][crc >> 24];
+    }
+    while(size-- != 0)
+        crc = (crc >> 8) ^ Crc32Tables[0][(crc ^ *data++) & 0xFF];
     return ~crc;
 }
 
+// Decodes a variable length number from a patch stream.
+template <typename StreamType>
+[[gnu::optimize("Os")]] static Number ReadNumber(StreamType &stream)
+{
+    Number data = 0, shift = 1;
+    std::optional<u8> x;
+    while((x = stream.template Read<u8>()))
+    {
+        data += (*x & 0x7f) * shift;
+        if(*x & 0x80)
+            break;
+        shift <<= 7;
+        data += shift;
+    }
+    return data;
+}
+
 // Utility class to make keeping track of offsets and bound checks less error prone.
 template <typename T>
 class Stream
@@ -61,8 +106,8 @@ public:
         return true;
     }
 
-    template <typename OtherType>
-    [[gnu::optimize("Os")]] bool CopyFrom(Stream<OtherType> &other, std::size_t length)
+    template <typename OtherStream>
+    bool CopyFrom(OtherStream &other, std::size_t length)
     {
         if(m_offset + length > m_size)
             return false;
@@ -82,19 +127,12 @@ public:
         return val;
     }
 
-    [[gnu::optimize("Os")]] Number ReadNumber()
+    bool Skip(std::size_t length)
     {
-        Number data = 0, shift = 1;
-        std::optional<u8> x;
-        while((x = Read<u8>()))
-        {
-            data += (*x & 0x7f) * shift;
-            if(*x & 0x80)
-                break;
-            shift <<= 7;
-            data += shift;
-        }
-        return data;
+        if(m_offset + length > m_size)
+            return false;
+        m_offset += length;
+        return true;
     }
 
     auto data() const { return m_ptr; }
@@ -113,52 +151,241 @@ private:
     std::size_t m_offset = 0;
 };
 
+// Reads the patch file through a small window so that it never has to be loaded whole.
+class PatchStream
+{
+public:
+    static constexpr std::size_t WindowSize = 0x800;
+
+    PatchStream(util::File &file, std::size_t size, u8 *window)
+        : m_file{file}, m_size{size}, m_window{window}
+    {
+    }
+
+    bool Read(void *buffer, std::size_t length)
+    {
+        if(m_offset + length > m_size)
+            return false;
+        u8 *out = static_cast<u8 *>(buffer);
+        while(length != 0)
+        {
+            if(m_offset < m_window_offset || m_offset >= m_window_offset + m_window_size)
+            {
+                // Large reads bypass the window.
+                if(length >= WindowSize)
+                {
+                    if(!m_file.Read(out, length, m_offset))
+                        return false;
+                    m_offset += length;
+                    return true;
+                }
+                m_window_offset = m_offset;
+                m_window_size = std::min(WindowSize, m_size - m_offset);
+                if(!m_file.Read(m_window, m_window_size, m_window_offset))
+                {
+                    m_window_size = 0;
+                    return false;
+                }
+            }
+            const std::size_t chunk = std::min(length, m_window_offset + m_window_size - m_offset);
+            std::memcpy(out, m_window + (m_offset - m_window_offset), chunk);
+            out += chunk;
+            m_offset += chunk;
+            length -= chunk;
+        }
+        return true;
+    }
+
+    template <typename ValueType>
+    std::optional<ValueType> Read()
+    {
+        static_assert(std::is_pod_v<ValueType>);
+        ValueType val{};
+        if(!Read(&val, sizeof(val)))
+            return std::nullopt;
+        return val;
+    }
+
+    bool Skip(std::size_t length)
+    {
+        if(m_offset + length > m_size)
+            return false;
+        m_offset += length;
+        return true;
+    }
+
+    std::size_t size() const { return m_size; }
+    std::size_t Tell() const { return m_offset; }
+
+    bool Seek(size_t offset)
+    {
+        m_offset = offset;
+        return true;
+    }
+
+private:
+    util::File &m_file;
+    std::size_t m_size = 0;
+    std::size_t m_offset = 0;
+    u8 *m_window = nullptr;
+    std::size_t m_window_offset = 0;
+    std::size_t m_window_size = 0;
+};
+
+// Keeps a copy of the source blocks that SourceCopy commands read after the
+// target has already overwritten them. Everything else is read in place.
+class SourceBackup
+{
+public:
+    static constexpr std::size_t MaxBlocks = 0x8000;
+
+    void Reset(std::size_t size)
+    {
+        m_size = size;
+        m_block_shift = 8;
+        while(((size + BlockSize() - 1) >> m_block_shift) > MaxBlocks)
+            ++m_block_shift;
+        std::memset(m_bitmap, 0, sizeof(m_bitmap));
+        m_storage = nullptr;
+    }
+
+    void Mark(std::size_t offset, std::size_t length)
+    {
+        const std::size_t last = (offset + length - 1) >> m_block_shift;
+        for(std::size_t block = offset >> m_block_shift; block <= last; ++block)
+            m_bitmap[block / 32] |= 1u << (block % 32);
+    }
+
+    // Returns the amount of memory needed to hold all the marked blocks.
+    std::size_t Finalize()
+    {
+        u32 count = 0;
+        for(std::size_t i = 0; i < BitmapWords; ++i)
+        {
+            m_rank[i] = count;
+            count += __builtin_popcount(m_bitmap[i]);
+        }
+        return std::size_t(count) << m_block_shift;
+    }
+
+    void Save(const u8 *source, u8 *storage)
+    {
+        m_storage = storage;
+        for(std::size_t block = 0; (block << m_block_shift) < m_size; ++block)
+        {
+            if(!IsMarked(block))
+                continue;
+            const std::size_t offset = block << m_block_shift;
+            std::memcpy(m_storage + (Index(block) << m_block_shift), source + offset,
+                        std::min(BlockSize(), m_size - offset));
+        }
+    }
+
+    void Copy(u8 *out, std::size_t offset, std::size_t length) const
+    {
+        while(length != 0)
+        {
+            const std::size_t block = offset >> m_block_shift;
+            const std::size_t in_block = offset & (BlockSize() - 1);
+            const std::size_t chunk = std::min(length, BlockSize() - in_block);
+            std::memcpy(out, m_storage + (Index(block) << m_block_shift) + in_block, chunk);
+            out += chunk;
+            offset += chunk;
+            length -= chunk;
+        }
+    }
+
+private:
+    static constexpr std::size_t BitmapWords = MaxBlocks / 32;
+
+    std::size_t BlockSize() const { return std::size_t(1) << m_block_shift; }
+    bool IsMarked(std::size_t block) const { return m_bitmap[block / 32] & (1u << (block % 32)); }
+    std::size_t Index(std::size_t block) const
+    {
+        const u32 lower = m_bitmap[block / 32] & ((1u << (block % 32)) - 1);
+        return m_rank[block / 32] + __builtin_popcount(lower);
+    }
+
+    u32 m_bitmap[BitmapWords];
+    u16 m_rank[BitmapWords];
+    u8 *m_storage;
+    std::size_t m_size;
+    std::size_t m_block_shift;
+};
+
+// Applies the patch in place: the target buffer initially holds the source.
+// A first pass over the commands validates them and finds which source ranges
+// must be backed up; the second pass actually writes the target.
 class PatchApplier
 {
 public:
-    PatchApplier(Stream<const u8> source, Stream<u8> target, Stream<const u8> patch)
-        : m_source{source}, m_target{target}, m_patch{patch}
+    PatchApplier(Stream<u8> target, PatchStream patch, SourceBackup &backup)
+        : m_target{target}, m_patch{patch}, m_backup{backup}
     {
     }
 
-    [[gnu::always_inline]] bool Apply()
+    [[gnu::always_inline]] bool Prepare()
     {
-        const auto magic = *m_patch.Read<std::array<char, 4>>();
-        if(std::string_view(magic.data(), magic.size()) != "BPS1")
+        const auto magic = m_patch.Read<std::array<char, 4>>();
+        if(!magic || std::string_view(magic->data(), magic->size()) != "BPS1")
+            return false;
+
+        m_source_size = ReadNumber(m_patch);
+        m_target_size = ReadNumber(m_patch);
+        const Bps::Number metadata_size = ReadNumber(m_patch);
+        if(m_source_size > m_target.size() || m_target_size > m_target.size() || metadata_size != 0 ||
+           m_patch.size() < m_patch.Tell() + FooterSize)
+            return false;
+
+        m_command_start_offset = m_patch.Tell();
+        m_command_end_offset = m_patch.size() - FooterSize;
+        m_patch.Seek(m_command_end_offset);
+        const auto source_crc32 = m_patch.Read<u32>();
+        const auto target_crc32 = m_patch.Read<u32>();
+        if(!source_crc32 || !target_crc32)
             return false;
+        m_target_crc32 = *target_crc32;
 
-        const Bps::Number source_size = m_patch.ReadNumber();
-        const Bps::Number target_size = m_patch.ReadNumber();
-        const Bps::Number metadata_size = m_patch.ReadNumber();
-        if(source_size > m_source.size() || target_size > m_target.size() || metadata_size != 0)
+        if(crc32(m_target.data(), m_source_size) != *source_crc32)
             return false;
 
-        const std::size_t command_start_offset = m_patch.Tell();
-        const std::size_t command_end_offset = m_patch.size() - FooterSize;
-        m_patch.Seek(command_end_offset);
-        const u32 source_crc32 = *m_patch.Read<u32>();
-        const u32 target_crc32 = *m_patch.Read<u32>();
-        m_patch.Seek(command_start_offset);
+        m_backup.Reset(m_target.size());
+        return RunCommands(false);
+    }
+
+    std::size_t BackupSize() { return m_backup.Finalize(); }
 
-        if(crc32(m_source.data(), source_size) != source_crc32)
+    [[gnu::always_inline]] bool Apply(u8 *backup_storage)
+    {
+        m_backup.Save(m_target.data(), backup_storage);
+        if(!RunCommands(true))
             return false;
 
-        // Process all patch commands.
-        std::memset(m_target.data(), 0, m_target.size());
-        while(m_patch.Tell() < command_end_offset)
+        // Anything past the last command is left zeroed.
+        std::memset(m_target.data() + m_target.Tell(), 0, m_target.size() - m_target.Tell());
+        return crc32(m_target.data(), m_target_size) == m_target_crc32;
+    }
+
+private:
+    bool RunCommands(bool write)
+    {
+        m_write = write;
+        m_target.Seek(0);
+        m_patch.Seek(m_command_start_offset);
+        m_source_relative_offset = 0;
+        m_target_relative_offset = 0;
+        while(m_patch.Tell() < m_command_end_offset)
         {
             const bool ok = HandleCommand();
             if(!ok)
                 return false;
         }
-
-        return crc32(m_target.data(), target_size) == target_crc32;
+        return true;
     }
 
-private:
     bool HandleCommand()
     {
-        const Number data = m_patch.ReadNumber();
+        const Number data = ReadNumber(m_patch);
         const Number command = data & 3;
         const Number length = (data >> 2) + 1;
 
@@ -177,43 +404,82 @@ private:
         }
     }
 
-    bool SourceRead(Number length)
+    // Relative offsets moved before the start of the buffer wrap around, "offset + length" can't be trusted.
+    bool IsInTarget(std::size_t offset, Number length) const
     {
-        return m_source.Seek(m_target.Tell()) && m_target.CopyFrom(m_source, length);
+        return offset <= m_target.size() && length <= m_target.size() - offset;
     }
 
-    bool TargetRead(Number length) { return m_target.CopyFrom(m_patch, length); }
+    // The bytes at the output offset have not been written yet, so they still hold the source.
+    bool SourceRead(Number length) { return m_target.Skip(length); }
+
+    bool TargetRead(Number length)
+    {
+        if(!m_write)
+            return m_target.Skip(length) && m_patch.Skip(length);
+        return m_target.CopyFrom(m_patch, length);
+    }
 
     bool SourceCopy(Number length)
     {
-        const Number data = m_patch.ReadNumber();
+        const Number data = ReadNumber(m_patch);
         m_source_relative_offset += (data & 1 ? -1 : +1) * int(data >> 1);
-        if(!m_source.Seek(m_source_relative_offset) || !m_target.CopyFrom(m_source, length))
+        if(!IsInTarget(m_source_relative_offset, length) || !IsInTarget(m_target.Tell(), length))
             return false;
+
+        // Source bytes before the output offset may already have been overwritten.
+        const bool overwritten = m_source_relative_offset < m_target.Tell();
+        if(!m_write && overwritten)
+            m_backup.Mark(m_source_relative_offset, length);
+        else if(m_write && overwritten)
+            m_backup.Copy(m_target.data() + m_target.Tell(), m_source_relative_offset, length);
+        else if(m_write)
+            std::memmove(m_target.data() + m_target.Tell(), m_target.data() + m_source_relative_offset, length);
+
         m_source_relative_offset += length;
-        return true;
+        return m_target.Skip(length);
     }
 
     bool TargetCopy(Number length)
     {
-        const Number data = m_patch.ReadNumber();
+        const Number data = ReadNumber(m_patch);
         m_target_relative_offset += (data & 1 ? -1 : +1) * int(data >> 1);
-        if(m_target.Tell() + length > m_target.size())
+        if(!IsInTarget(m_target.Tell(), length) || !IsInTarget(m_target_relative_offset, length))
             return false;
-        if(m_target_relative_offset + length > m_target.size())
-            return false;
-        // Byte by byte copy.
-        for(size_t i = 0; i < length; ++i)
-            m_target.data()[m_target.Tell() + i] = m_target.data()[m_target_relative_offset++];
-        m_target.Seek(m_target.Tell() + length);
-        return true;
+        if(m_write)
+        {
+            u8 *const out = m_target.data() + m_target.Tell();
+            const u8 *const in = m_target.data() + m_target_relative_offset;
+            if(in >= out)
+                // Bytes past the output offset are zero in the target.
+                std::memset(out, 0, length);
+            else if(in + length <= out)
+                std::memcpy(out, in, length);
+            else if(in + 1 == out)
+                // Run-length encoding of the previous byte.
+                std::memset(out, out[-1], length);
+            else
+            {
+                // Overlapping runs must be copied byte by byte to repeat the pattern.
+                for(size_t i = 0; i < length; ++i)
+                    out[i] = in[i];
+            }
+        }
+        m_target_relative_offset += length;
+        return m_target.Skip(length);
     }
 
     std::size_t m_source_relative_offset = 0;
     std::size_t m_target_relative_offset = 0;
-    Stream<const u8> m_source;
+    std::size_t m_command_start_offset = 0;
+    std::size_t m_command_end_offset = 0;
+    Number m_source_size = 0;
+    Number m_target_size = 0;
+    u32 m_target_crc32 = 0;
+    bool m_write = false;
     Stream<u8> m_target;
-    Stream<const u8> m_patch;
+    PatchStream m_patch;
+    SourceBackup &m_backup;
 };
 
 }  // namespace Bps
@@ -221,11 +487,11 @@ private:
 class ScopedAppHeap
 {
 public:
-    ScopedAppHeap()
+    explicit ScopedAppHeap(u32 size) : m_size{(size + 0xFFF) & ~0xFFFu}
     {
         u32 tmp;
-        m_size = osGetMemRegionFree(MEMREGION_APPLICATION);
-        if(!R_SUCCEEDED(svcControlMemory(&tmp, BaseAddress, 0, m_size,
+        if(m_size != 0 &&
+           !R_SUCCEEDED(svcControlMemory(&tmp, BaseAddress, 0, m_size,
                                          MemOp(MEMOP_ALLOC | MEMOP_REGION_APP),
                                          MemPerm(MEMPERM_READ | MEMPERM_WRITE))))
         {
@@ -236,7 +502,8 @@ public:
     ~ScopedAppHeap()
     {
         u32 tmp;
-        svcControlMemory(&tmp, BaseAddress, 0, m_size, MEMOP_FREE, MemPerm(0));
+        if(m_size != 0)
+            svcControlMemory(&tmp, BaseAddress, 0, m_size, MEMOP_FREE, MemPerm(0));
     }
 
     static constexpr u32 BaseAddress = 0x08000000;
@@ -254,20 +521,20 @@ static inline bool ApplyCodeBpsPatch(u64 prog_id, u8 *code, u32 size)
         return true;
     const u32 patch_size = u32(patch_file.GetSize().value_or(0));
 
-    // Temporarily use APPLICATION memory to store the source and patch data.
-    ScopedAppHeap memory;
+    // Both are too large for the loader stack.
+    static u8 patch_window[Bps::PatchStream::WindowSize];
+    static Bps::SourceBackup backup;
 
-    u8 *source_data = reinterpret_cast<u8 *>(memory.BaseAddress);
-    u8 *patch_data = source_data + size;
-    std::memcpy(source_data, code, size);
-    if(!patch_file.Read(patch_data, patch_size, 0))
-        return false;
-
-    Bps::Stream<const u8> source_stream{source_data, size};
     Bps::Stream target_stream{code, size};
-    Bps::Stream<const u8> patch_stream{patch_data, patch_size};
-    Bps::PatchApplier applier{source_stream, target_stream, patch_stream};
-    if(!applier.Apply())
+    Bps::PatchStream patch_stream{patch_file, patch_size, patch_window};
+    Bps::PatchApplier applier{target_stream, patch_stream, backup};
+    if(!applier.Prepare())
+        svcBreak(USERBREAK_PANIC);
+
+    // Temporarily use APPLICATION memory to store the source ranges that get overwritten before being read.
+    ScopedAppHeap memory(applier.BackupSize());
+
+    if(!applier.Apply(reinterpret_cast<u8 *>(memory.BaseAddress)))
         svcBreak(USERBREAK_PANIC);
     return true;
 }
@@ -26,70 +26,69 @@ typedef struct prog_addrs_t
     u32 total_size;
 } prog_addrs_t;
 
-static int lzss_decompress(u8 *end)
+static inline void lzss_copy_word(u8 *dst, const u8 *src)
 {
-    unsigned int v1; // r1@2
-    u8 *v2; // r2@2
-    u8 *v3; // r3@2
-    u8 *v4; // r1@2
-    char v5; // r5@4
-    char v6; // t1@4
-    signed int v7; // r6@4
-    int v9; // t1@7
-    u8 *v11; // r3@8
-    int v12; // r12@8
-    int v13; // t1@8
-    int v14; // t1@8
-    unsigned int v15; // r7@8
-    int v16; // r12@8
-    int ret;
-
-    ret = 0;
-    if ( end )
+    u32 word;
+
+    memcpy(&word, src, 4);
+    memcpy(dst, &word, 4);
+}
+
+// The compressed data is decoded backwards, in place, from the end of the buffer.
+// Footer: u32 (compressed size | (footer size << 24)), u32 additional decompressed size
+static void lzss_decompress(u8 *end)
+{
+    if(end == NULL)
+        return;
+
+    u32 footer = *((u32 *)end - 2);
+    u8 *out = end + *((u32 *)end - 1);
+    u8 *in = end - (footer >> 24);
+    const u8 *stop = end - (footer & 0xFFFFFF);
+
+    while(in > stop)
     {
-        v1 = *((u32 *)end - 2);
-        v2 = &end[*((u32 *)end - 1)];
-        v3 = &end[-(v1 >> 24)];
-        v4 = &end[-(v1 & 0xFFFFFF)];
-        while ( v3 > v4 )
+        u8 flags = *--in;
+
+        // Fast path for 8 literals in a row; reading and writing backwards in lockstep
+        // with out >= in never clobbers bytes that are yet to be read
+        if(flags == 0 && in - 8 >= stop)
         {
-            v6 = *(v3-- - 1);
-            v5 = v6;
-            v7 = 8;
-            while ( 1 )
+            in -= 8;
+            out -= 8;
+            lzss_copy_word(out + 4, in + 4);
+            lzss_copy_word(out, in);
+            continue;
+        }
+
+        for(u32 i = 0; i < 8; i++, flags <<= 1)
+        {
+            if(flags & 0x80)
             {
-                if ( (v7-- < 1) )
-                    break;
-                if ( v5 & 0x80 )
-                {
-                    v13 = *(v3 - 1);
-                    v11 = v3 - 1;
-                    v12 = v13;
-                    v14 = *(v11 - 1);
-                    v3 = v11 - 1;
-                    v15 = ((v14 | (v12 << 8)) & 0xFFFF0FFF) + 2;
-                    v16 = v12 + 32;
-                    do
-                    {
-                        ret = v2[v15];
-                        *(v2-- - 1) = ret;
-                        v16 -= 16;
-                    }
-                    while ( !(v16 < 0) );
-                }
-                else
+                u32 hi = *--in;
+                u32 lo = *--in;
+                u32 count = (hi >> 4) + 3;
+                u32 dist = (((hi << 8) | lo) & 0xFFF) + 3;
+
+                out -= count;
+
+                // Each word only reads bytes that have already been written
+                u32 n = count;
+                if(dist >= 4)
                 {
-                    v9 = *(v3-- - 1);
-                    ret = v9;
-                    *(v2-- - 1) = v9;
+                    for(; n >= 4; n -= 4)
+                        lzss_copy_word(out + n - 4, out + n - 4 + dist);
                 }
-                v5 *= 2;
-                if ( v3 <= v4 )
-                    return ret;
+                while(n-- > 0)
+                    out[n] = out[n + dist];
             }
+            else
+                *--out = *--in;
+
+            if(in <= stop)
+                return;
         }
     }
-    return ret;
 }
 
 static inline bool hbldrIs3dsxTitle(u64 tid)
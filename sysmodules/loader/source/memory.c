@@ -24,3 +24,68 @@ u8 *memsearch(u8 *startPos, const void *pattern, u32 size, u32 patternSize)
 
     return NULL;
 }
+
+//Set Horspool: finds the first occurrence of up to 32 patterns in a single pass over startPos.
+//The shift table is built over the first minSize bytes of every pattern, so no occurrence can be skipped
+u32 memsearchMulti(u8 *startPos, u32 size, PatternSearch *patterns, u32 patternCount)
+{
+    u32 table[256],
+        lastByteMask[256] = {0},
+        remaining = 0,
+        minSize = 0xFFFFFFFF,
+        foundCount = 0;
+
+    if(patternCount > 32) patternCount = 32;
+
+    for(u32 i = 0; i < patternCount; i++)
+    {
+        patterns[i].found = NULL;
+        if(patterns[i].patternSize == 0 || patterns[i].patternSize > size) continue;
+
+        remaining |= 1u << i;
+        if(patterns[i].patternSize < minSize) minSize = patterns[i].patternSize;
+    }
+
+    if(remaining == 0) return 0;
+
+    //Preprocessing
+    for(u32 i = 0; i < 256; i++)
+        table[i] = minSize;
+    for(u32 i = 0; i < patternCount; i++)
+    {
+        if(!(remaining & (1u << i))) continue;
+
+        const u8 *patternc = (const u8 *)patterns[i].pattern;
+
+        for(u32 j = 0; j < minSize - 1; j++)
+            if(table[patternc[j]] > minSize - j - 1) table[patternc[j]] = minSize - j - 1;
+
+        lastByteMask[patternc[minSize - 1]] |= 1u << i;
+    }
+
+    //Searching
+    u32 j = 0;
+    while(remaining != 0 && j <= size - minSize)
+    {
+        u8 c = startPos[j + minSize - 1];
+        u32 candidates = lastByteMask[c] & remaining;
+
+        while(candidates != 0)
+        {
+            u32 i = __builtin_ctz(candidates);
+            candidates &= candidates - 1;
+
+            PatternSearch *p = &patterns[i];
+            if(j + p->patternSize <= size && memcmp(p->pattern, startPos + j, p->patternSize) == 0)
+            {
+                p->found = startPos + j;
+                remaining &= ~(1u << i);
+                foundCount++;
+            }
+        }
+
+        j += lastByteMask[c] != 0 ? 1 : table[c];
+    }
+
+    return foundCount;
+}
@@ -3,4 +3,12 @@
 #include <3ds/types.h>
 #include <string.h>
 
+typedef struct PatternSearch
+{
+    const void *pattern;
+    u32 patternSize;
+    u8 *found;
+} PatternSearch;
+
 u8 *memsearch(u8 *startPos, const void *pattern, u32 size, u32 patternSize);
+u32 memsearchMulti(u8 *startPos, u32 size, PatternSearch *patterns, u32 patternCount);
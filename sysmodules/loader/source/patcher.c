@@ -259,6 +259,53 @@ static inline bool findLayeredFsPayloadOffset(u8 *code, u32 size, u32 roSize, u3
     return *payloadOffset != 0 && *pathOffset != 0;
 }
 
+#define IPS_BUFFER_SIZE 0x2000
+
+typedef struct IpsReader
+{
+    IFile *file;
+    u8 *buffer;
+    u32 pos;
+    u32 end;
+} IpsReader;
+
+//Makes sure at least len bytes are buffered, reading the next chunk of the file if needed
+static bool ipsReaderFill(IpsReader *reader, u32 len)
+{
+    u32 left = reader->end - reader->pos;
+
+    if(left >= len) return true;
+
+    memmove(reader->buffer, reader->buffer + reader->pos, left);
+    reader->pos = 0;
+    reader->end = left;
+
+    u64 total;
+
+    if(R_FAILED(IFile_Read(reader->file, &total, reader->buffer + left, IPS_BUFFER_SIZE - left))) return false;
+
+    reader->end += (u32)total;
+
+    return reader->end >= len;
+}
+
+static bool ipsReaderCopy(IpsReader *reader, u8 *dst, u32 len)
+{
+    u32 buffered = reader->end - reader->pos;
+
+    if(buffered > len) buffered = len;
+
+    memcpy(dst, reader->buffer + reader->pos, buffered);
+    reader->pos += buffered;
+
+    if(buffered == len) return true;
+
+    //Payloads larger than what's left in the buffer are read straight into the code section
+    u64 total;
+
+    return R_SUCCEEDED(IFile_Read(reader->file, &total, dst + buffered, len - buffered)) && total == len - buffered;
+}
+
 static inline bool applyCodeIpsPatch(u64 progId, u8 *code, u32 size)
 {
     /* Here we look for "/luma/titles/[u64 titleID in hex, uppercase]/code.ips"
@@ -271,45 +318,52 @@ static inline bool applyCodeIpsPatch(u64 progId, u8 *code, u32 size)
 
     if(!openLumaFile(&file, path)) return true;
 
+    static u8 buffer[IPS_BUFFER_SIZE];
+    IpsReader reader = { &file, buffer, 0, 0 };
     bool ret = false;
-    u8 buffer[5];
-    u64 total;
 
-    if(R_FAILED(IFile_Read(&file, &total, buffer, 5)) || total != 5 || memcmp(buffer, "PATCH", 5) != 0) goto exit;
+    if(!ipsReaderFill(&reader, 5) || memcmp(buffer, "PATCH", 5) != 0) goto exit;
+
+    reader.pos = 5;
 
-    while(R_SUCCEEDED(IFile_Read(&file, &total, buffer, 3)) && total == 3)
+    while(ipsReaderFill(&reader, 3))
     {
-        if(memcmp(buffer, "EOF", 3) == 0)
+        const u8 *record = buffer + reader.pos;
+
+        if(memcmp(record, "EOF", 3) == 0)
         {
             ret = true;
             break;
         }
 
-        u32 offset = (buffer[0] << 16) | (buffer[1] << 8) | buffer[2];
+        if(!ipsReaderFill(&reader, 5)) break;
 
-        if(R_FAILED(IFile_Read(&file, &total, buffer, 2)) || total != 2) break;
+        record = buffer + reader.pos;
 
-        u32 patchSize = (buffer[0] << 8) | buffer[1];
+        u32 offset = (record[0] << 16) | (record[1] << 8) | record[2],
+            patchSize = (record[3] << 8) | record[4];
 
         if(!patchSize)
         {
-            if(R_FAILED(IFile_Read(&file, &total, buffer, 2)) || total != 2) break;
+            if(!ipsReaderFill(&reader, 8)) break;
 
-            u32 rleSize = (buffer[0] << 8) | buffer[1];
+            record = buffer + reader.pos;
 
-            if(offset + rleSize > size) break;
+            u32 rleSize = (record[5] << 8) | record[6];
 
-            if(R_FAILED(IFile_Read(&file, &total, buffer, 1)) || total != 1) break;
+            if(offset + rleSize > size) break;
 
-            for(u32 i = 0; i < rleSize; i++)
-                code[offset + i] = buffer[0];
+            memset(code + offset, record[7], rleSize);
+            reader.pos += 8;
 
             continue;
         }
 
         if(offset + patchSize > size) break;
 
-        if(R_FAILED(IFile_Read(&file, &total, code + offset, patchSize)) || total != patchSize) break;
+        reader.pos += 5;
+
+        if(!ipsReaderCopy(&reader, code + offset, patchSize)) break;
     }
 
 exit:
@@ -481,7 +535,160 @@ exit:
     return ret;
 }
 
-static inline bool patchLayeredFs(u64 progId, u8 *code, u32 size, u32 textSize, u32 roSize, u32 dataSize, u32 roAddress, u32 dataAddress)
+static const char *updateRomFsMounts[] = { "rom2:",
+                                           "rex:",
+                                           "patch:",
+                                           "ext:",
+                                           "rom:" };
+
+#define UPDATE_ROMFS_MOUNT_COUNT (sizeof(updateRomFsMounts) / sizeof(char *))
+
+#define PATCHLOC_CACHE_MAGIC       0x434F4C50 //"PLOC"
+#define PATCHLOC_CACHE_VERSION     3
+#define PATCHLOC_CACHE_MAX_ENTRIES 64
+
+typedef struct LayeredFsLocations
+{
+    u32 fsMountArchive;
+    u32 fsRegisterArchive;
+    u32 fsTryOpenFile;
+    u32 fsOpenFileDirectly;
+    u32 payloadOffset;
+    u32 pathOffset;
+    u32 pathAddress;
+    u32 updateRomFsIndex;
+} LayeredFsLocations;
+
+typedef struct PatchLocCacheEntry
+{
+    u64 progId;
+    u16 progVer;
+    u16 reserved;
+    u32 codeChecksum;
+    LayeredFsLocations locations;
+} PatchLocCacheEntry;
+
+typedef struct PatchLocCache
+{
+    u32 magic;
+    u16 version;
+    u16 numEntries;
+    u32 hits;
+    u32 misses;
+    PatchLocCacheEntry entries[PATCHLOC_CACHE_MAX_ENTRIES];
+} PatchLocCache;
+
+static PatchLocCache patchLocCache;
+
+//Hits aren't worth a write of their own: they're counted here and saved along with the next miss
+static u32 patchLocCacheUnsavedHits;
+
+static u32 computeCodeChecksum(const u8 *code, u32 size)
+{
+    const u32 *code32 = (const u32 *)code;
+    u32 h0 = 0x811C9DC5, h1 = 0x811C9DC5, h2 = 0x811C9DC5, h3 = 0x811C9DC5;
+    u32 i;
+
+    //FNV-1a over four interleaved lanes of words, so that each multiplication doesn't have to wait for the previous one
+    for(i = 0; i < size / 16; i++)
+    {
+        h0 = (h0 ^ code32[4 * i]) * 0x01000193;
+        h1 = (h1 ^ code32[4 * i + 1]) * 0x01000193;
+        h2 = (h2 ^ code32[4 * i + 2]) * 0x01000193;
+        h3 = (h3 ^ code32[4 * i + 3]) * 0x01000193;
+    }
+
+    u32 checksum = (((h0 ^ h1) * 0x01000193 ^ h2) * 0x01000193 ^ h3) * 0x01000193;
+
+    for(i = size & ~15; i < size; i++)
+        checksum = (checksum ^ code[i]) * 0x01000193;
+
+    return checksum;
+}
+
+static bool openPatchLocCache(IFile *file)
+{
+    FS_ArchiveID archiveId = isSdMode ? ARCHIVE_SDMC : ARCHIVE_NAND_RW;
+    FS_Archive archive;
+
+    if(R_SUCCEEDED(FSUSER_OpenArchive(&archive, archiveId, fsMakePath(PATH_EMPTY, ""))))
+    {
+        FSUSER_CreateDirectory(archive, fsMakePath(PATH_ASCII, "/luma/cache"), 0);
+        FSUSER_CloseArchive(archive);
+    }
+
+    if(R_FAILED(fileOpen(file, archiveId, "/luma/cache/patchloc.bin", FS_OPEN_READ | FS_OPEN_WRITE | FS_OPEN_CREATE))) return false;
+
+    u64 total;
+
+    if(R_FAILED(IFile_Read(file, &total, &patchLocCache, sizeof(PatchLocCache))) || total < offsetof(PatchLocCache, entries) ||
+       patchLocCache.magic != PATCHLOC_CACHE_MAGIC || patchLocCache.version != PATCHLOC_CACHE_VERSION ||
+       patchLocCache.numEntries > PATCHLOC_CACHE_MAX_ENTRIES ||
+       total < offsetof(PatchLocCache, entries) + patchLocCache.numEntries * sizeof(PatchLocCacheEntry))
+    {
+        //Missing, outdated or corrupted cache, start over
+        memset(&patchLocCache, 0, sizeof(PatchLocCache));
+        patchLocCache.magic = PATCHLOC_CACHE_MAGIC;
+        patchLocCache.version = PATCHLOC_CACHE_VERSION;
+    }
+
+    return true;
+}
+
+static PatchLocCacheEntry *findPatchLocCacheEntry(u64 progId, u16 progVer, u32 codeChecksum)
+{
+    for(u32 i = 0; i < patchLocCache.numEntries; i++)
+    {
+        PatchLocCacheEntry *entry = &patchLocCache.entries[i];
+
+        if(entry->progId == progId && entry->progVer == progVer && entry->codeChecksum == codeChecksum) return entry;
+    }
+
+    return NULL;
+}
+
+static void writePatchLocCache(IFile *file, const PatchLocCacheEntry *entry)
+{
+    u64 total;
+
+    file->pos = 0;
+    if(R_FAILED(IFile_Write(file, &total, &patchLocCache, offsetof(PatchLocCache, entries), 0)) || entry == NULL) return;
+
+    file->pos = (u8 *)entry - (u8 *)&patchLocCache;
+    IFile_Write(file, &total, entry, sizeof(PatchLocCacheEntry), 0);
+}
+
+static inline bool locateLayeredFs(u8 *code, u32 size, u32 textSize, u32 roSize, u32 dataSize, u32 roAddress, u32 dataAddress, LayeredFsLocations *loc)
+{
+    loc->fsMountArchive = loc->fsRegisterArchive = loc->fsTryOpenFile = loc->fsOpenFileDirectly = 0xFFFFFFFF;
+    loc->payloadOffset = loc->pathOffset = 0;
+    loc->pathAddress = 0xDEADCAFE;
+
+    if(!findLayeredFsSymbols(code, textSize, &loc->fsMountArchive, &loc->fsRegisterArchive, &loc->fsTryOpenFile, &loc->fsOpenFileDirectly) ||
+       !findLayeredFsPayloadOffset(code, textSize, roSize, dataSize, roAddress, dataAddress, &loc->payloadOffset, &loc->pathOffset, &loc->pathAddress)) return false;
+
+    u8 temp[UPDATE_ROMFS_MOUNT_COUNT - 1][7];
+    PatternSearch searches[UPDATE_ROMFS_MOUNT_COUNT - 1];
+
+    //Locate update RomFSes, looking for all the mount names in a single pass
+    for(u32 i = 0; i < sizeof(searches) / sizeof(PatternSearch); i++)
+    {
+        u32 patternSize = strlen(updateRomFsMounts[i]);
+        temp[i][0] = 0;
+        memcpy(temp[i] + 1, updateRomFsMounts[i], patternSize);
+        searches[i].pattern = temp[i];
+        searches[i].patternSize = patternSize + 1;
+    }
+
+    memsearchMulti(code, size, searches, sizeof(searches) / sizeof(PatternSearch));
+
+    for(loc->updateRomFsIndex = 0; loc->updateRomFsIndex < sizeof(searches) / sizeof(PatternSearch); loc->updateRomFsIndex++)
+        if(searches[loc->updateRomFsIndex].found != NULL) break;
+
+    return true;
+}
+
+static inline bool patchLayeredFs(u64 progId, u16 progVer, u8 *code, u32 size, u32 textSize, u32 roSize, u32 dataSize, u32 roAddress, u32 dataAddress)
 {
     /* Here we look for "/luma/titles/[u64 titleID in hex, uppercase]/romfs"
        If it exists it should be a folder containing ROMFS files */
@@ -493,55 +700,76 @@ static inline bool patchLayeredFs(u64 progId, u8 *code, u32 size, u32 textSize,
 
     if(!archiveId) return true;
 
-    u32 fsMountArchive = 0xFFFFFFFF,
-        fsRegisterArchive = 0xFFFFFFFF,
-        fsTryOpenFile = 0xFFFFFFFF,
-        fsOpenFileDirectly = 0xFFFFFFFF,
-        payloadOffset = 0,
-        pathOffset = 0,
-        pathAddress = 0xDEADCAFE;
-
-    if(!findLayeredFsSymbols(code, textSize, &fsMountArchive, &fsRegisterArchive, &fsTryOpenFile, &fsOpenFileDirectly) ||
-       !findLayeredFsPayloadOffset(code, textSize, roSize, dataSize, roAddress, dataAddress, &payloadOffset, &pathOffset, &pathAddress)) return false;
-
-    static const char *updateRomFsMounts[] = { "rom2:",
-                                               "rex:",
-                                               "patch:",
-                                               "ext:",
-                                               "rom:" };
-    u32 updateRomFsIndex;
-
-    //Locate update RomFSes
-    for(updateRomFsIndex = 0; updateRomFsIndex < sizeof(updateRomFsMounts) / sizeof(char *) - 1; updateRomFsIndex++)
+    /* The symbol and payload locations only depend on the code, so they're kept in
+       "/luma/cache/patchloc.bin" to avoid scanning the whole code again on every launch.
+       The key covers everything that is searched, .data included */
+    LayeredFsLocations loc;
+    u32 codeChecksum = computeCodeChecksum(code, size);
+    IFile cacheFile;
+    bool cacheOpened = openPatchLocCache(&cacheFile);
+    PatchLocCacheEntry *entry = cacheOpened ? findPatchLocCacheEntry(progId, progVer, codeChecksum) : NULL;
+
+    //Nothing is written on a hit, the cache only changes on a miss
+    if(entry != NULL)
     {
-        u32 patternSize = strlen(updateRomFsMounts[updateRomFsIndex]);
-        u8 temp[7];
-        temp[0] = 0;
-        memcpy(temp + 1, updateRomFsMounts[updateRomFsIndex], patternSize);
-        if(memsearch(code, temp, size, patternSize + 1) != NULL) break;
+        loc = entry->locations;
+        patchLocCacheUnsavedHits++;
+    }
+    else
+    {
+        bool found = locateLayeredFs(code, size, textSize, roSize, dataSize, roAddress, dataAddress, &loc);
+
+        if(cacheOpened && found)
+        {
+            //Evict the oldest entries first once the cache is full
+            u32 index = patchLocCache.numEntries < PATCHLOC_CACHE_MAX_ENTRIES ? patchLocCache.numEntries++ : patchLocCache.misses % PATCHLOC_CACHE_MAX_ENTRIES;
+
+            entry = &patchLocCache.entries[index];
+            entry->progId = progId;
+            entry->progVer = progVer;
+            entry->reserved = 0;
+            entry->codeChecksum = codeChecksum;
+            entry->locations = loc;
+        }
+
+        if(cacheOpened)
+        {
+            patchLocCache.hits += patchLocCacheUnsavedHits;
+            patchLocCache.misses++;
+            patchLocCacheUnsavedHits = 0;
+            writePatchLocCache(&cacheFile, entry);
+        }
+
+        if(!found)
+        {
+            if(cacheOpened) IFile_Close(&cacheFile);
+            return false;
+        }
     }
 
+    if(cacheOpened) IFile_Close(&cacheFile);
+
     //Setup the payload
-    u8 *payload = code + payloadOffset;
-
-    romfsRedirPatchSubstituted1 = *(u32 *)(code + fsOpenFileDirectly);
-    romfsRedirPatchHook1 = MAKE_BRANCH(payloadOffset + (u32)&romfsRedirPatchHook1 - (u32)romfsRedirPatch, fsOpenFileDirectly + 4);
-    romfsRedirPatchSubstituted2 = *(u32 *)(code + fsTryOpenFile);
-    romfsRedirPatchHook2 = MAKE_BRANCH(payloadOffset + (u32)&romfsRedirPatchHook2 - (u32)romfsRedirPatch, fsTryOpenFile + 4);
-    romfsRedirPatchCustomPath = pathAddress;
-    romfsRedirPatchFsMountArchive = 0x100000 + fsMountArchive;
-    romfsRedirPatchFsRegisterArchive = 0x100000 + fsRegisterArchive;
+    u8 *payload = code + loc.payloadOffset;
+
+    romfsRedirPatchSubstituted1 = *(u32 *)(code + loc.fsOpenFileDirectly);
+    romfsRedirPatchHook1 = MAKE_BRANCH(loc.payloadOffset + (u32)&romfsRedirPatchHook1 - (u32)romfsRedirPatch, loc.fsOpenFileDirectly + 4);
+    romfsRedirPatchSubstituted2 = *(u32 *)(code + loc.fsTryOpenFile);
+    romfsRedirPatchHook2 = MAKE_BRANCH(loc.payloadOffset + (u32)&romfsRedirPatchHook2 - (u32)romfsRedirPatch, loc.fsTryOpenFile + 4);
+    romfsRedirPatchCustomPath = loc.pathAddress;
+    romfsRedirPatchFsMountArchive = 0x100000 + loc.fsMountArchive;
+    romfsRedirPatchFsRegisterArchive = 0x100000 + loc.fsRegisterArchive;
     romfsRedirPatchArchiveId = archiveId;
-    memcpy(&romfsRedirPatchUpdateRomFsMount, updateRomFsMounts[updateRomFsIndex], 4);
+    memcpy(&romfsRedirPatchUpdateRomFsMount, updateRomFsMounts[loc.updateRomFsIndex], 4);
 
     memcpy(payload, romfsRedirPatch, romfsRedirPatchSize);
 
-    memcpy(code + pathOffset, "lf:", 3);
-    memcpy(code + pathOffset + 3, path, sizeof(path));
+    memcpy(code + loc.pathOffset, "lf:", 3);
+    memcpy(code + loc.pathOffset + 3, path, sizeof(path));
 
     //Place the hooks
-    *(u32 *)(code + fsOpenFileDirectly) = MAKE_BRANCH(fsOpenFileDirectly, payloadOffset);
-    *(u32 *)(code + fsTryOpenFile) = MAKE_BRANCH(fsTryOpenFile, payloadOffset + 12);
+    *(u32 *)(code + loc.fsOpenFileDirectly) = MAKE_BRANCH(loc.fsOpenFileDirectly, loc.payloadOffset);
+    *(u32 *)(code + loc.fsTryOpenFile) = MAKE_BRANCH(loc.fsTryOpenFile, loc.payloadOffset + 12);
 
     return true;
 }
@@ -571,22 +799,30 @@ void patchCode(u64 progId, u16 progVer, u8 *code, u32 size, u32 textSize, u32 ro
                 break;
         }
 
+        static const u8 regionFreePattern[] = {
+            0x0A, 0x0C, 0x00, 0x10
+        },
+                        regionFreePatch[] = {
+            0x01, 0x00, 0xA0, 0xE3, 0x1E, 0xFF, 0x2F, 0xE1
+        },
+                        flashcartPattern[] = {
+            0x10, 0xD1, 0xE5, 0x08, 0x00, 0x8D
+        };
+
+        //Look for the DS flashcart whitelist check and the SMDH region check in a single pass
+        PatternSearch searches[] = {
+            { flashcartPattern, sizeof(flashcartPattern), NULL },
+            { regionFreePattern, sizeof(regionFreePattern), NULL },
+        };
+
+        memsearchMulti(code, textSize, searches, applyRegionFreePatch ? 2 : 1);
+
         if(applyRegionFreePatch)
         {
-            static const u8 pattern[] = {
-                0x0A, 0x0C, 0x00, 0x10
-            },
-                            patch[] = {
-                0x01, 0x00, 0xA0, 0xE3, 0x1E, 0xFF, 0x2F, 0xE1
-            };
+            if(searches[1].found == NULL) goto error;
 
             //Patch SMDH region check
-            if(!patchMemory(code, textSize,
-                    pattern,
-                    sizeof(pattern), -31,
-                    patch,
-                    sizeof(patch), 1
-                )) goto error;
+            memcpy(searches[1].found - 31, regionFreePatch, sizeof(regionFreePatch));
         }
 
         //Patch SMDH region check for manuals
@@ -604,11 +840,7 @@ void patchCode(u64 progId, u16 progVer, u8 *code, u32 size, u32 textSize, u32 ro
         if(i == textSize) goto error;
 
         //Patch DS flashcart whitelist check
-        static const u8 pattern[] = {
-            0x10, 0xD1, 0xE5, 0x08, 0x00, 0x8D
-        };
-
-        u8 *temp = memsearch(code, pattern, textSize, sizeof(pattern));
+        u8 *temp = searches[0].found;
 
         if(temp == NULL) goto error;
 
@@ -784,25 +1016,18 @@ void patchCode(u64 progId, u16 progVer, u8 *code, u32 size, u32 textSize, u32 ro
             0x00, 0x00, 0xA0, 0xE3, 0x1E, 0xFF, 0x2F, 0xE1 //mov r0, #0; bx lr
         };
 
+        PatternSearch searches[] = {
+            { pattern, sizeof(pattern), NULL },
+            { pattern2, sizeof(pattern2), NULL },
+            { pattern3, sizeof(pattern3), NULL },
+        };
+
+        if(memsearchMulti(code, textSize, searches, sizeof(searches) / sizeof(PatternSearch)) != sizeof(searches) / sizeof(PatternSearch)) goto error;
+
         //Disable CRR0 signature (RSA2048 with SHA256) check and CRO0/CRR0 SHA256 hash checks (section hashes, and hash table)
-        if(!patchMemory(code, textSize,
-                pattern,
-                sizeof(pattern), -9,
-                patch,
-                sizeof(patch), 1
-            ) ||
-           !patchMemory(code, textSize,
-                pattern2,
-                sizeof(pattern2), 1,
-                patch,
-                sizeof(patch), 1
-            ) ||
-           !patchMemory(code, textSize,
-                pattern3,
-                sizeof(pattern3), -2,
-                patch,
-                sizeof(patch), 1
-            )) goto error;
+        memcpy(searches[0].found - 9, patch, sizeof(patch));
+        memcpy(searches[1].found + 1, patch, sizeof(patch));
+        memcpy(searches[2].found - 2, patch, sizeof(patch));
     }
 
     else if(progId == 0x0004013000002802LL) //DLP
@@ -824,16 +1049,19 @@ void patchCode(u64 progId, u16 progVer, u8 *code, u32 size, u32 textSize, u32 ro
             0xC0, 0x46 // mov r8, r8
         };
 
+        PatternSearch searches[] = {
+            { pattern, sizeof(pattern), NULL },
+            { pattern2, sizeof(pattern2), NULL },
+        };
+
+        memsearchMulti(code, textSize, searches, sizeof(searches) / sizeof(PatternSearch));
+
         //Patch DLP region check
-        if(!patchMemory(code, textSize,
-                pattern,
-                sizeof(pattern), 0,
-                patch,
-                sizeof(patch), 1
-            )) goto error;
+        if(searches[0].found == NULL) goto error;
+        memcpy(searches[0].found, patch, sizeof(patch));
 
         // Patch DLP client region check
-        u8 *found = memsearch(code, pattern2, textSize, sizeof(pattern2));
+        u8 *found = searches[1].found;
 
         if (!patchMemory(found, textSize,
                pattern3,
@@ -876,7 +1104,7 @@ void patchCode(u64 progId, u16 progVer, u8 *code, u32 size, u32 textSize, u32 ro
 
             if(loadTitleLocaleConfig(progId, &mask, &regionId, &languageId, &countryId, &stateId))
                 svcKernelSetState(0x10001, ((u32)stateId << 24) | ((u32)countryId << 16) | ((u32)languageId << 8) | ((u32)regionId << 4) | (u32)mask , progId);
-            if(!patchLayeredFs(progId, code, size, textSize, roSize, dataSize, roAddress, dataAddress)) goto error;
+            if(!patchLayeredFs(progId, progVer, code, size, textSize, roSize, dataSize, roAddress, dataAddress)) goto error;
         }
     }
 
@@ -18,15 +18,37 @@
 
 #define MAX_DEBUG           3
 #define MAX_DEBUG_THREAD    127
-#define MAX_BREAKPOINT      64
+#define MAX_BREAKPOINT      4096
+#define MAX_WATCHPOINT      16
+
+// Agent expression bytecode of conditional breakpoints, evaluated on the target
+#define MAX_BREAKPOINT_CONDITION        16
+#define BREAKPOINT_CONDITION_MAX_LEN    0x80
 
 #define MAX_TIO_OPEN_FILE   32
 
+// Every thread can have at most one pending stop event, plus process exit
+#define MAX_STOP_EVENT      (MAX_DEBUG_THREAD + 1)
+
 // 512+24 is the ideal size as IDA will try to read exactly 0x100 bytes at a time. Add 4 to this, for $#<checksum>, see below.
 // IDA seems to want additional bytes as well.
 // 1024 is fine enough to put all regs in the 'T' stop reply packets
 #define GDB_BUF_LEN 1024
 
+// Packet size negotiated in qSupported when the per-context packet buffers could be allocated on connection.
+// This lets 'm', 'M' and 'X' move several pages per round-trip instead of ~500 bytes
+#define GDB_LARGE_BUF_LEN           0x4000
+#define GDB_PACKET_BUFFERS_ADDRESS  0x0F000000
+
+// Per-context breakpoint tables, committed on demand
+#define GDB_BREAKPOINTS_ADDRESS     0x0F200000
+
+// Per-context thread snapshots, committed on demand
+#define GDB_THREAD_SNAPSHOTS_ADDRESS    0x0F300000
+
+// Per-context vFile read-ahead buffers, committed while files using them are open
+#define GDB_TIO_READ_AHEAD_ADDRESS      0x0F800000
+
 #define GDB_HANDLER(name)           GDB_Handle##name
 #define GDB_QUERY_HANDLER(name)     GDB_HANDLER(Query##name)
 #define GDB_VERBOSE_HANDLER(name)   GDB_HANDLER(Verbose##name)
@@ -41,8 +63,25 @@ typedef struct Breakpoint
     u32 savedInstruction;
     u8 instructionSize;
     bool persistent;
+    u8 conditionId; // 1 + index in the condition table, or 0
 } Breakpoint;
 
+typedef struct BreakpointCondition
+{
+    u32 size; // 0 when unused
+    u8 bytecode[BREAKPOINT_CONDITION_MAX_LEN]; // one or more expressions, each preceded by its 16-bit length
+} BreakpointCondition;
+
+// Stepping a thread over a breakpoint whose condition was false, with temporary breakpoints on the next instruction(s)
+typedef struct BreakpointStep
+{
+    bool pending;
+    bool holdsThreads;
+    u32 breakpointAddress;
+    u32 nbTemporaryBreakpoints;
+    u32 temporaryBreakpoints[2];
+} BreakpointStep;
+
 typedef struct PackedGdbHioRequest
 {
     char magic[4]; // "GDB\x00"
@@ -65,6 +104,9 @@ typedef struct GdbTioFileInfo
 {
     IFile f;
     int flags;
+    u8 *readAheadBuffer; // sequential reads are served from there
+    u64 readAheadOffset;
+    u32 readAheadSize;
 } GdbTioFileInfo;
 
 enum
@@ -74,11 +116,12 @@ enum
     GDB_FLAG_ALLOCATED_MASK = GDB_FLAG_SELECTED | GDB_FLAG_USED,
     GDB_FLAG_EXTENDED_REMOTE = 4,
     GDB_FLAG_NOACK = 8,
-    GDB_FLAG_PROC_RESTART_MASK = GDB_FLAG_NOACK | GDB_FLAG_EXTENDED_REMOTE | GDB_FLAG_USED,
     GDB_FLAG_PROCESS_CONTINUING = 16,
     GDB_FLAG_TERMINATE_PROCESS = 32,
     GDB_FLAG_ATTACHED_AT_START = 64,
     GDB_FLAG_CREATED = 128,
+    GDB_FLAG_NONSTOP = 256,
+    GDB_FLAG_PROC_RESTART_MASK = GDB_FLAG_NOACK | GDB_FLAG_EXTENDED_REMOTE | GDB_FLAG_USED | GDB_FLAG_NONSTOP,
 };
 
 typedef enum GDBState
@@ -93,8 +136,33 @@ typedef struct ThreadInfo
 {
     u32 id;
     u32 tls;
+    bool stopped; // non-stop mode: kept from running while the rest of the process runs
+    bool heldForStep; // kept from running while another thread steps over a breakpoint or watchpoint
 } ThreadInfo;
 
+typedef enum ThreadSnapshotField
+{
+    THREADSNAPSHOT_CONTEXT          = BIT(0), // THREADCONTEXT_CONTROL_ALL
+    THREADSNAPSHOT_SCHEDULING_MASK  = BIT(1),
+    THREADSNAPSHOT_DYNAMIC_PRIORITY = BIT(2),
+    THREADSNAPSHOT_STATIC_PRIORITY  = BIT(3),
+    THREADSNAPSHOT_IDEAL_CORE       = BIT(4),
+    THREADSNAPSHOT_CREATOR_CORE     = BIT(5),
+
+    THREADSNAPSHOT_PARAMS           = THREADSNAPSHOT_SCHEDULING_MASK | THREADSNAPSHOT_DYNAMIC_PRIORITY | THREADSNAPSHOT_STATIC_PRIORITY |
+                                      THREADSNAPSHOT_IDEAL_CORE | THREADSNAPSHOT_CREATOR_CORE,
+} ThreadSnapshotField;
+
+typedef struct ThreadSnapshot
+{
+    u32 id;
+    u32 fetchedFields, validFields; // fields that couldn't be fetched aren't fetched again
+    u32 schedulingMask;
+    s32 dynamicPriority, staticPriority;
+    u32 idealCore, creatorCore;
+    ThreadContext context;
+} ThreadSnapshot;
+
 struct GDBServer;
 
 typedef struct GDBContext
@@ -121,6 +189,10 @@ typedef struct GDBContext
     u32 currentThreadId, selectedThreadId, selectedThreadIdForContinuing;
     u32 totalNbCreatedThreads;
 
+    // What's known of the threads while they're stopped; dropped when they're continued
+    ThreadSnapshot *threadSnapshots;
+    u32 nbThreadSnapshots;
+
     Handle processAttachedEvent, continuedEvent;
     Handle eventToWaitFor;
 
@@ -132,11 +204,23 @@ typedef struct GDBContext
     DebugFlags continueFlags;
     u32 svcMask[8];
 
+    // Non-stop mode: stop events not acknowledged by vStopped yet, the first one has been reported
+    DebugEventInfo stopEventQueue[MAX_STOP_EVENT];
+    u32 stopEventQueueStart, nbStopEvents;
+    bool stopNotificationPending;
+
+    // Breakpoints are kept in a pool, indexed by an open-addressed hash table of (pool index + 1)
     u32 nbBreakpoints;
-    Breakpoint breakpoints[MAX_BREAKPOINT];
+    u16 *breakpointBuckets;
+    Breakpoint *breakpointPool;
+    u32 breakpointPoolEnd, breakpointFreeList;
+    u32 breakpointsCommittedSize;
+    BreakpointCondition breakpointConditions[MAX_BREAKPOINT_CONDITION];
+    BreakpointStep breakpointStep;
+    u32 nbStepsHoldingThreads;
 
     u32 nbWatchpoints;
-    u32 watchpoints[2];
+    u32 watchpoints[MAX_WATCHPOINT];
 
     u32 currentHioRequestTargetAddr;
     PackedGdbHioRequest currentHioRequest;
@@ -147,13 +231,28 @@ typedef struct GDBContext
     bool enableExternalMemoryAccess;
     char *commandData, *commandEnd;
     int latestSentPacketSize;
-    char buffer[GDB_BUF_LEN + 4];
+
+    // Point to either the default buffers below or the large ones, bufferSize being the negotiated packet size.
+    // Received packets are kept apart from the latest sent one, which may have to be sent again
+    char *buffer, *sendBuffer;
+    u8 *workBuffer;
+    u32 bufferSize;
+    u32 receivedSize, scannedSize, packetSize; // received data may span several packets, or part of one
+    u32 oversizedPacketTrailerLeft; // size of the trailer ('#' and checksum) of the oversized packet being dropped, if any
+    char defaultBuffer[GDB_BUF_LEN + 4];
+    char defaultSendBuffer[GDB_BUF_LEN + 4];
+    u8 defaultWorkBuffer[GDB_BUF_LEN];
+
+    // Stop notifications can be sent from within command handlers (Break, vCtrlC, vCont;t, ...), which may be using
+    // the work buffer. Their data, a stop reply, always fits in the default packet size
+    char notificationBuffer[GDB_BUF_LEN + 4];
 
     char threadListData[0x800];
     u32 threadListDataPos;
 
-    char memoryOsInfoXmlData[0x800];
-    char processesOsInfoXmlData[0x1800];
+    // Generation of the shared osdata snapshot a chunked qXfer read started from, 0 if none
+    u32 memoryOsDataGeneration;
+    u32 processesOsDataGeneration;
 } GDBContext;
 
 typedef int (*GDBCommandHandler)(GDBContext *ctx);
@@ -161,6 +260,9 @@ typedef int (*GDBCommandHandler)(GDBContext *ctx);
 void GDB_InitializeContext(GDBContext *ctx);
 void GDB_FinalizeContext(GDBContext *ctx);
 
+Result GDB_AllocatePacketBuffers(GDBContext *ctx);
+void GDB_FreePacketBuffers(GDBContext *ctx);
+
 Result GDB_AttachToProcess(GDBContext *ctx);
 void GDB_DetachFromProcess(GDBContext *ctx);
 Result GDB_CreateProcess(GDBContext *ctx, const FS_ProgramInfo *progInfo, u32 launchFlags);
@@ -19,9 +19,19 @@ GDB_DECLARE_HANDLER(Break);
 GDB_DECLARE_HANDLER(Continue);
 GDB_DECLARE_VERBOSE_HANDLER(Continue);
 GDB_DECLARE_HANDLER(GetStopReason);
+GDB_DECLARE_VERBOSE_HANDLER(Stopped);
+GDB_DECLARE_VERBOSE_HANDLER(CtrlC);
+GDB_DECLARE_QUERY_HANDLER(NonStop);
 
 void GDB_ContinueExecution(GDBContext *ctx);
 void GDB_PreprocessDebugEvent(GDBContext *ctx, DebugEventInfo *info);
 int GDB_SendStopReply(GDBContext *ctx, const DebugEventInfo *info);
 int GDB_HandleDebugEvents(GDBContext *ctx);
 void GDB_BreakProcessAndSinkDebugEvents(GDBContext *ctx, DebugFlags flags);
+
+Result GDB_GetThreadContext(ThreadContext *regs, GDBContext *ctx, u32 threadId, u32 controlFlags);
+Result GDB_SetThreadContext(GDBContext *ctx, u32 threadId, ThreadContext *regs, u32 controlFlags);
+void GDB_SwitchToNonStop(GDBContext *ctx);
+void GDB_ResetNonStopState(GDBContext *ctx);
+void GDB_HoldOtherThreadsForStep(GDBContext *ctx, u32 threadId);
+void GDB_ReleaseThreadsHeldForStep(GDBContext *ctx);
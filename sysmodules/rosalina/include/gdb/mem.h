@@ -9,6 +9,10 @@
 
 #include "gdb.h"
 
+// Target memory is mapped there in windows of GDB_SEARCH_WINDOW_SIZE bytes while searching it
+#define GDB_SEARCH_WINDOW_ADDRESS   0x0F100000
+#define GDB_SEARCH_WINDOW_SIZE      0x100000
+
 Result GDB_ReadTargetMemoryInPage(void *out, GDBContext *ctx, u32 addr, u32 len);
 Result GDB_WriteTargetMemoryInPage(GDBContext *ctx, const void *in, u32 addr, u32 len);
 u32 GDB_ReadTargetMemory(void *out, GDBContext *ctx, u32 addr, u32 len);
@@ -16,9 +20,10 @@ u32 GDB_WriteTargetMemory(GDBContext *ctx, const void *in, u32 addr, u32 len);
 
 int GDB_SendMemory(GDBContext *ctx, const char *prefix, u32 prefixLen, u32 addr, u32 len);
 int GDB_WriteMemory(GDBContext *ctx, const void *buf, u32 addr, u32 len);
-u32 GDB_SearchMemory(bool *found, GDBContext *ctx, u32 addr, u32 len, const void *pattern, u32 patternLen);
+u32 GDB_SearchMemory(u32 *foundAddrs, u32 maxFound, GDBContext *ctx, u32 addr, u32 len, const void *pattern, u32 patternLen);
 
 GDB_DECLARE_HANDLER(ReadMemory);
+GDB_DECLARE_HANDLER(ReadMemoryRaw);
 GDB_DECLARE_HANDLER(WriteMemory);
 GDB_DECLARE_HANDLER(WriteMemoryRaw);
 GDB_DECLARE_QUERY_HANDLER(SearchMemory);
@@ -21,9 +21,14 @@ const char *GDB_ParseHexIntegerList(u32 *dst, const char *src, u32 nb, char last
 const char *GDB_ParseIntegerList64(u64 *dst, const char *src, u32 nb, char sep, char lastSep, u32 base, bool allowPrefix);
 const char *GDB_ParseHexIntegerList64(u64 *dst, const char *src, u32 nb, char lastSep);
 int GDB_ReceivePacket(GDBContext *ctx);
+int GDB_FramePacket(GDBContext *ctx);
 int GDB_SendPacket(GDBContext *ctx, const char *packetData, u32 len);
+int GDB_SendNotification(GDBContext *ctx, const char *packetData, u32 len);
 int GDB_SendFormattedPacket(GDBContext *ctx, const char *packetDataFmt, ...);
 int GDB_SendHexPacket(GDBContext *ctx, const void *packetData, u32 len);
+int GDB_SendPrefixedHexPacket(GDBContext *ctx, const char *prefix, u32 prefixLen, const void *packetData, u32 len);
+int GDB_SendPrefixedBinaryPacket(GDBContext *ctx, u32 *sentCount, const char *prefix, u32 prefixLen, const void *packetData, u32 len);
+int GDB_SendCountPrefixedBinaryPacket(GDBContext *ctx, u32 *sentCount, const char *prefixFmt, u32 prefixLen, const void *packetData, u32 len);
 int GDB_SendStreamData(GDBContext *ctx, const char *streamData, u32 offset, u32 length, u32 totalSize, bool forceEmptyLast);
 int GDB_SendDebugString(GDBContext *ctx, const char *fmt, ...); // unsecure
 int GDB_ReplyEmpty(GDBContext *ctx);
@@ -18,5 +18,8 @@ GDB_DECLARE_REMOTE_COMMAND_HANDLER(GetMmuConfig);
 GDB_DECLARE_REMOTE_COMMAND_HANDLER(GetMemRegions);
 GDB_DECLARE_REMOTE_COMMAND_HANDLER(FlushCaches);
 GDB_DECLARE_REMOTE_COMMAND_HANDLER(ToggleExternalMemoryAccess);
+GDB_DECLARE_REMOTE_COMMAND_HANDLER(SearchMemory);
+GDB_DECLARE_REMOTE_COMMAND_HANDLER(ValueScan);
+GDB_DECLARE_REMOTE_COMMAND_HANDLER(Breakpoints);
 
 GDB_DECLARE_QUERY_HANDLER(Rcmd);
@@ -23,6 +23,13 @@ const char *GDB_ParseThreadId(GDBContext *ctx, u32 *outPid, u32 *outTid, const c
 u32 GDB_ParseDecodeSingleThreadId(GDBContext *ctx, const char *str, char lastSep);
 int GDB_EncodeThreadId(GDBContext *ctx, char *outbuf, u32 tid);
 
+// Snapshots are kept for stopped threads only; scratch is filled instead for the others
+const ThreadSnapshot *GDB_GetThreadSnapshot(ThreadSnapshot *scratch, GDBContext *ctx, u32 threadId, u32 fields);
+const ThreadContext *GDB_GetThreadContextSnapshot(GDBContext *ctx, u32 threadId);
+void GDB_InvalidateThreadSnapshot(GDBContext *ctx, u32 threadId, u32 fields);
+void GDB_InvalidateThreadSnapshots(GDBContext *ctx);
+void GDB_ReleaseThreadSnapshots(GDBContext *ctx);
+
 u32 GDB_GetCurrentThreadFromList(GDBContext *ctx, u32 *threadIds, u32 nbThreads);
 u32 GDB_GetCurrentThread(GDBContext *ctx);
 
@@ -9,4 +9,6 @@
 
 #include "gdb.h"
 
+void GDB_TioCloseAllFiles(GDBContext *ctx);
+
 GDB_DECLARE_VERBOSE_HANDLER(File);
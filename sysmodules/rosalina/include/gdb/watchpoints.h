@@ -21,5 +21,9 @@ void GDB_ResetWatchpoints(void); // needed for software breakpoints to be detect
 
 int GDB_AddWatchpoint(GDBContext *ctx, u32 address, u32 size, WatchpointKind kind);
 int GDB_RemoveWatchpoint(GDBContext *ctx, u32 address, WatchpointKind kind);
+void GDB_RemoveAllWatchpoints(GDBContext *ctx);
 
 WatchpointKind GDB_GetWatchpointKind(GDBContext *ctx, u32 address);
+
+// Software watchpoints: returns true if the event was only needed by them, and should be continued silently
+bool GDB_HandleWatchpointDebugEvent(GDBContext *ctx, DebugEventInfo *info);
@@ -15,6 +15,9 @@
 #define GDB_XFER_OSDATA_HANDLER(name)           GDB_XFER_HANDLER(OsData##name)
 #define GDB_DECLARE_XFER_OSDATA_HANDLER(name)   int GDB_XFER_OSDATA_HANDLER(name)(GDBContext *ctx, bool write, u32 offset, u32 length)
 
+// Process creation and exit, forces the processes osdata snapshot to be refreshed
+void GDB_NotifyProcessListChanged(void);
+
 GDB_DECLARE_XFER_HANDLER(Features);
 
 GDB_DECLARE_XFER_OSDATA_HANDLER(CfwVersion);
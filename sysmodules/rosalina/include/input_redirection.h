@@ -29,10 +29,22 @@
 #include <3ds/types.h>
 #include "MyThread.h"
 
+#define INPUT_REDIRECTION_NB_LATENCY_BUCKETS    8
+
+typedef struct InputRedirectionStats
+{
+    u32 nbPackets;      // v2 packets received
+    u32 nbStalePackets; // v2 packets dropped because they were reordered or duplicated
+    u32 nbLostSamples;  // v2 samples neither received directly nor through a later batch
+    // Delay of each v2 packet relative to the fastest one: < 1ms, < 2ms, < 4ms, ..., >= 64ms
+    u32 latencyHistogram[INPUT_REDIRECTION_NB_LATENCY_BUCKETS];
+} InputRedirectionStats;
+
 extern bool inputRedirectionEnabled;
 extern Handle inputRedirectionThreadStartedEvent;
 
 extern int inputRedirectionStartResult;
+extern InputRedirectionStats inputRedirectionStats;
 
 MyThread *inputRedirectionCreateThread(void);
 void inputRedirectionThreadMain(void);
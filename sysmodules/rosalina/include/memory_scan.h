@@ -0,0 +1,82 @@
+/*
+*   This file is part of Luma3DS
+*   Copyright (C) 2016-2020 Aurora Wright, TuxSH
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+#pragma once
+
+#include <3ds/types.h>
+
+typedef enum MemoryScanValueType
+{
+    MEMSCAN_TYPE_U8 = 0,
+    MEMSCAN_TYPE_U16,
+    MEMSCAN_TYPE_U32,
+    MEMSCAN_TYPE_FLOAT,
+
+    MEMSCAN_TYPE_MAX,
+} MemoryScanValueType;
+
+typedef enum MemoryScanFilter
+{
+    MEMSCAN_FILTER_EQUAL = 0,
+    MEMSCAN_FILTER_UNKNOWN,     // first scan only
+    MEMSCAN_FILTER_CHANGED,     // next scans only, from here on
+    MEMSCAN_FILTER_UNCHANGED,
+    MEMSCAN_FILTER_INCREASED,
+    MEMSCAN_FILTER_DECREASED,
+
+    MEMSCAN_FILTER_MAX,
+} MemoryScanFilter;
+
+typedef struct MemoryScanChunk
+{
+    u32 address;        // address in the target process
+    u32 size;
+    const void *data;   // where the chunk is readable from Rosalina
+} MemoryScanChunk;
+
+typedef struct MemoryScanResult
+{
+    u32 address;
+    u32 value;
+} MemoryScanResult;
+
+// Returns the next chunk to scan, or false when done. Chunks must be yielded in ascending address order.
+typedef bool (*MemoryScanNextChunkFunc)(MemoryScanChunk *chunk, void *userData);
+
+void MemoryScan_Init(void);
+
+Result MemoryScan_FirstScan(u32 pid, MemoryScanValueType type, MemoryScanFilter filter, u32 value, MemoryScanNextChunkFunc nextChunk, void *userData);
+Result MemoryScan_NextScan(u32 pid, MemoryScanFilter filter, u32 value, MemoryScanNextChunkFunc nextChunk, void *userData);
+void MemoryScan_Reset(void);
+
+bool MemoryScan_IsActive(u32 pid, MemoryScanValueType *type);
+u32 MemoryScan_GetResultCount(void);
+u32 MemoryScan_GetResults(MemoryScanResult *out, u32 first, u32 maxResults);
+
+const char *MemoryScan_GetTypeName(MemoryScanValueType type);
+const char *MemoryScan_GetFilterName(MemoryScanFilter filter);
+bool MemoryScan_ParseType(MemoryScanValueType *type, const char *name, u32 len);
+bool MemoryScan_ParseFilter(MemoryScanFilter *filter, const char *name, u32 len);
@@ -33,5 +33,10 @@
 #define CHEATS_PER_MENU_PAGE 18
 
 void RosalinaMenu_Cheats(void);
+void Cheat_Init(void);
 void Cheat_SeedRng(u64 seed);
 void Cheat_ApplyCheats(void);
+void Cheat_LockSession(void);
+void Cheat_UnlockSession(void);
+void Cheat_EndSession(void);
+void Cheat_WaitForEvents(s64 timeout);
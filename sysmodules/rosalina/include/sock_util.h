@@ -32,6 +32,14 @@ typedef enum socket_type
     SOCK_CLIENT
 } socket_type;
 
+// Time between the poll returning and the data callback being done with the connection, in ticks
+typedef struct sock_latency_stats
+{
+    u32 nb_events;
+    u64 total;
+    u64 max;
+} sock_latency_stats;
+
 typedef struct sock_ctx
 {
     enum socket_type type;
@@ -39,8 +47,10 @@ typedef struct sock_ctx
     int sockfd;
     struct sockaddr_in addr_in;
     struct sock_ctx *serv;
+    struct sock_ctx *next_free;
     int n;
     int i;
+    sock_latency_stats latency;
 } sock_ctx;
 
 typedef struct sock_server
@@ -52,12 +62,12 @@ typedef struct sock_server
     // poll stuff
     struct pollfd poll_fds[MAX_CTXS];
     struct sock_ctx serv_ctxs[MAX_PORTS];
+    struct sock_ctx *free_serv_ctxs;
     struct sock_ctx *ctx_ptrs[MAX_CTXS];
 
     nfds_t nfds;
     bool running;
     Handle started_event;
-    bool compact_needed;
 
     // callbacks
     sock_accept_cb accept_cb;
@@ -281,9 +281,42 @@ void Draw_CreateBitmapHeader(u8 *dst, u32 width, u32 heigth)
     Draw_WriteUnaligned(dst + 0x22, 3 * width * heigth, 4);
 }
 
+static inline void Draw_ConvertRGB565PixelToBGR8(u8 *dst, u32 px)
+{
+    // thanks neobrain
+    u8 blue = px & 0x1F;
+    u8 green = (px >> 5) & 0x3F;
+    u8 red = (px >> 11) & 0x1F;
+
+    dst[0] = (blue  << 3) | (blue  >> 2);
+    dst[1] = (green << 2) | (green >> 4);
+    dst[2] = (red   << 3) | (red   >> 2);
+}
+
+static inline void Draw_ConvertRGB5A1PixelToBGR8(u8 *dst, u32 px)
+{
+    u8 blue = (px >> 1) & 0x1F;
+    u8 green = (px >> 6) & 0x1F;
+    u8 red = (px >> 11) & 0x1F;
+
+    dst[0] = (blue  << 3) | (blue  >> 2);
+    dst[1] = (green << 3) | (green >> 2);
+    dst[2] = (red   << 3) | (red   >> 2);
+}
+
+static inline void Draw_ConvertRGBA4PixelToBGR8(u8 *dst, u32 px)
+{
+    u8 blue = (px >> 4) & 0xF;
+    u8 green = (px >> 8) & 0xF;
+    u8 red = (px >> 12) & 0xF;
+
+    dst[0] = (blue  << 4) | (blue  >> 0);
+    dst[1] = (green << 4) | (green >> 0);
+    dst[2] = (red   << 4) | (red   >> 0);
+}
+
 static inline void Draw_ConvertPixelToBGR8(u8 *dst, const u8 *src, GSPGPU_FramebufferFormat srcFormat)
 {
-    u8 red, green, blue;
     switch(srcFormat)
     {
         case GSP_RGBA8_OES:
@@ -302,46 +335,133 @@ static inline void Draw_ConvertPixelToBGR8(u8 *dst, const u8 *src, GSPGPU_Frameb
             break;
         }
         case GSP_RGB565_OES:
-        {
-            // thanks neobrain
-            u16 px = *(u16 *)src;
-            blue = px & 0x1F;
-            green = (px >> 5) & 0x3F;
-            red = (px >> 11) & 0x1F;
+            Draw_ConvertRGB565PixelToBGR8(dst, *(u16 *)src);
+            break;
+        case GSP_RGB5_A1_OES:
+            Draw_ConvertRGB5A1PixelToBGR8(dst, *(u16 *)src);
+            break;
+        case GSP_RGBA4_OES:
+            Draw_ConvertRGBA4PixelToBGR8(dst, *(u16 *)src);
+            break;
+        default: break;
+    }
+}
 
-            dst[0] = (blue  << 3) | (blue  >> 2);
-            dst[1] = (green << 2) | (green >> 4);
-            dst[2] = (red   << 3) | (red   >> 2);
+/*
+    The framebuffers are stored rotated: each screen column (bottom to top, like bitmap lines) is contiguous,
+    so the picture is a transpose of the framebuffer. The lines are converted by bands of FB_CONVERT_BAND_LINES
+    lines: for each column, the pixels of the band are contiguous and read one word at a time (one cache line for
+    the 16 and 32-bit formats, the 24-byte bands of BGR8 may straddle two), and are written to as many output lines.
+    The next column is prefetched meanwhile. There's one kernel per format, so the format is only looked at once
+    per band.
+*/
 
-            break;
+#define FB_CONVERT_BAND_LINES   8
+
+typedef void (*FrameBufferBandConverter)(u8 *dst, const u8 *src, u32 width, u32 stride, u32 lineSize);
+
+static void Draw_ConvertFrameBufferBandRGBA8(u8 *dst, const u8 *src, u32 width, u32 stride, u32 lineSize)
+{
+    for(u32 x = 0; x < width; x++, dst += 3, src += stride)
+    {
+        const u32 *words = (const u32 *)src;
+        u8 *line = dst;
+
+        __builtin_prefetch(src + stride, 0, 3);
+        for(u32 i = 0; i < FB_CONVERT_BAND_LINES; i++, line += lineSize)
+        {
+            u32 px = words[i];
+            line[0] = px >> 8;
+            line[1] = px >> 16;
+            line[2] = px >> 24;
         }
-        case GSP_RGB5_A1_OES:
+    }
+}
+
+static void Draw_ConvertFrameBufferBandBGR8(u8 *dst, const u8 *src, u32 width, u32 stride, u32 lineSize)
+{
+    for(u32 x = 0; x < width; x++, dst += 3, src += stride)
+    {
+        const u32 *words = (const u32 *)src;
+        u8 *line = dst;
+
+        __builtin_prefetch(src + stride, 0, 3);
+        for(u32 i = 0; i < FB_CONVERT_BAND_LINES; i += 4, words += 3)
         {
-            u16 px = *(u16 *)src;
-            blue = (px >> 1) & 0x1F;
-            green = (px >> 6) & 0x1F;
-            red = (px >> 11) & 0x1F;
+            // 4 pixels in 3 words: B0 G0 R0 B1 | G1 R1 B2 G2 | R2 B3 G3 R3
+            u32 w0 = words[0], w1 = words[1], w2 = words[2];
+
+            line[0] = w0;
+            line[1] = w0 >> 8;
+            line[2] = w0 >> 16;
+            line += lineSize;
+
+            line[0] = w0 >> 24;
+            line[1] = w1;
+            line[2] = w1 >> 8;
+            line += lineSize;
+
+            line[0] = w1 >> 16;
+            line[1] = w1 >> 24;
+            line[2] = w2;
+            line += lineSize;
+
+            line[0] = w2 >> 8;
+            line[1] = w2 >> 16;
+            line[2] = w2 >> 24;
+            line += lineSize;
+        }
+    }
+}
 
-            dst[0] = (blue  << 3) | (blue  >> 2);
-            dst[1] = (green << 3) | (green >> 2);
-            dst[2] = (red   << 3) | (red   >> 2);
+static void Draw_ConvertFrameBufferBandRGB565(u8 *dst, const u8 *src, u32 width, u32 stride, u32 lineSize)
+{
+    for(u32 x = 0; x < width; x++, dst += 3, src += stride)
+    {
+        const u32 *words = (const u32 *)src;
+        u8 *line = dst;
 
-            break;
+        __builtin_prefetch(src + stride, 0, 3);
+        for(u32 i = 0; i < FB_CONVERT_BAND_LINES / 2; i++, line += 2 * lineSize)
+        {
+            u32 px = words[i];
+            Draw_ConvertRGB565PixelToBGR8(line, px & 0xFFFF);
+            Draw_ConvertRGB565PixelToBGR8(line + lineSize, px >> 16);
         }
-        case GSP_RGBA4_OES:
+    }
+}
+
+static void Draw_ConvertFrameBufferBandRGB5A1(u8 *dst, const u8 *src, u32 width, u32 stride, u32 lineSize)
+{
+    for(u32 x = 0; x < width; x++, dst += 3, src += stride)
+    {
+        const u32 *words = (const u32 *)src;
+        u8 *line = dst;
+
+        __builtin_prefetch(src + stride, 0, 3);
+        for(u32 i = 0; i < FB_CONVERT_BAND_LINES / 2; i++, line += 2 * lineSize)
         {
-            u16 px = *(u32 *)src;
-            blue = (px >> 4) & 0xF;
-            green = (px >> 8) & 0xF;
-            red = (px >> 12) & 0xF;
+            u32 px = words[i];
+            Draw_ConvertRGB5A1PixelToBGR8(line, px & 0xFFFF);
+            Draw_ConvertRGB5A1PixelToBGR8(line + lineSize, px >> 16);
+        }
+    }
+}
 
-            dst[0] = (blue  << 4) | (blue  >> 0);
-            dst[1] = (green << 4) | (green >> 0);
-            dst[2] = (red   << 4) | (red   >> 0);
+static void Draw_ConvertFrameBufferBandRGBA4(u8 *dst, const u8 *src, u32 width, u32 stride, u32 lineSize)
+{
+    for(u32 x = 0; x < width; x++, dst += 3, src += stride)
+    {
+        const u32 *words = (const u32 *)src;
+        u8 *line = dst;
 
-            break;
+        __builtin_prefetch(src + stride, 0, 3);
+        for(u32 i = 0; i < FB_CONVERT_BAND_LINES / 2; i++, line += 2 * lineSize)
+        {
+            u32 px = words[i];
+            Draw_ConvertRGBA4PixelToBGR8(line, px & 0xFFFF);
+            Draw_ConvertRGBA4PixelToBGR8(line + lineSize, px >> 16);
         }
-        default: break;
     }
 }
 
@@ -354,25 +474,52 @@ typedef struct FrameBufferConvertArgs {
     bool left;
 } FrameBufferConvertArgs;
 
+static void Draw_ConvertFrameBufferLinesSlow(u8 *dst, const u8 *src, u32 width, u32 stride, u32 bpp, u32 numLines, GSPGPU_FramebufferFormat fmt)
+{
+    for(u32 y = 0; y < numLines; y++)
+    {
+        for(u32 x = 0; x < width; x++)
+            Draw_ConvertPixelToBGR8(dst + (x + width * y) * 3, src + x * stride + y * bpp, fmt);
+    }
+}
+
 static void Draw_ConvertFrameBufferLinesKernel(const FrameBufferConvertArgs *args)
 {
     static const u8 formatSizes[] = { 4, 3, 2, 2, 2 };
+    static const FrameBufferBandConverter bandConverters[] = {
+        Draw_ConvertFrameBufferBandRGBA8,
+        Draw_ConvertFrameBufferBandBGR8,
+        Draw_ConvertFrameBufferBandRGB565,
+        Draw_ConvertFrameBufferBandRGB5A1,
+        Draw_ConvertFrameBufferBandRGBA4,
+    };
 
     GSPGPU_FramebufferFormat fmt = args->top ? (GSPGPU_FramebufferFormat)(GPU_FB_TOP_FMT & 7) : (GSPGPU_FramebufferFormat)(GPU_FB_BOTTOM_FMT & 7);
+    if(fmt > GSP_RGBA4_OES)
+        return;
+
     u32 width = args->width;
+    u32 lineSize = 3 * width;
     u32 stride = args->top ? GPU_FB_TOP_STRIDE : GPU_FB_BOTTOM_STRIDE;
+    u32 bpp = formatSizes[fmt];
 
     u32 pa = Draw_GetCurrentFramebufferAddress(args->top, args->left);
-    u8 *addr = (u8 *)KERNPA2VA(pa);
+    const u8 *addr = (const u8 *)KERNPA2VA(pa);
 
-    for (u32 y = args->startingLine; y < args->startingLine + args->numLines; y++)
-    {
-        for(u32 x = 0; x < width; x++)
-        {
-            __builtin_prefetch(addr + x * stride + y * formatSizes[fmt], 0, 3);
-            Draw_ConvertPixelToBGR8(args->buf + (x + width * y) * 3 , addr + x * stride + y * formatSizes[fmt], fmt);
-        }
-    }
+    // Bands are aligned on absolute line numbers, so that the word reads are aligned
+    u32 startingLine = args->startingLine, endLine = startingLine + args->numLines;
+    u32 bandsStart = (startingLine + FB_CONVERT_BAND_LINES - 1) & ~(FB_CONVERT_BAND_LINES - 1);
+    u32 bandsEnd = endLine & ~(FB_CONVERT_BAND_LINES - 1);
+    if(bandsStart > bandsEnd)
+        bandsStart = bandsEnd = endLine;
+
+    u8 *buf = args->buf; // holds lines startingLine to endLine
+    Draw_ConvertFrameBufferLinesSlow(buf, addr + startingLine * bpp, width, stride, bpp, bandsStart - startingLine, fmt);
+
+    for(u32 y = bandsStart; y < bandsEnd; y += FB_CONVERT_BAND_LINES)
+        bandConverters[fmt](buf + (y - startingLine) * lineSize, addr + y * bpp, width, stride, lineSize);
+
+    Draw_ConvertFrameBufferLinesSlow(buf + (bandsEnd - startingLine) * lineSize, addr + bandsEnd * bpp, width, stride, bpp, endLine - bandsEnd, fmt);
 }
 
 void Draw_ConvertFrameBufferLines(u8 *buf, u32 width, u32 startingLine, u32 numLines, bool top, bool left)
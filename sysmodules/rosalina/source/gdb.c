@@ -10,11 +10,25 @@
 #include "gdb/server.h"
 
 #include "gdb/debug.h"
+#include "gdb/thread.h"
 
 #include "gdb/watchpoints.h"
 #include "gdb/breakpoints.h"
 #include "gdb/stop_point.h"
 
+#include "menus/cheats.h"
+
+#define GDB_PACKET_BUFFERS_SIZE     ((2 * (GDB_LARGE_BUF_LEN + 4) + GDB_LARGE_BUF_LEN + 0xFFF) & ~0xFFF)
+#define GDB_PACKET_BUFFERS_STRIDE   0x10000
+
+static void GDB_UseDefaultPacketBuffers(GDBContext *ctx)
+{
+    ctx->buffer = ctx->defaultBuffer;
+    ctx->sendBuffer = ctx->defaultSendBuffer;
+    ctx->workBuffer = ctx->defaultWorkBuffer;
+    ctx->bufferSize = GDB_BUF_LEN;
+}
+
 void GDB_InitializeContext(GDBContext *ctx)
 {
     memset(ctx, 0, sizeof(GDBContext));
@@ -22,6 +36,8 @@ void GDB_InitializeContext(GDBContext *ctx)
 
     RecursiveLock_Lock(&ctx->lock);
 
+    GDB_UseDefaultPacketBuffers(ctx);
+
     svcCreateEvent(&ctx->continuedEvent, RESET_ONESHOT);
     svcCreateEvent(&ctx->processAttachedEvent, RESET_STICKY);
 
@@ -43,6 +59,36 @@ void GDB_FinalizeContext(GDBContext *ctx)
     RecursiveLock_Unlock(&ctx->lock);
 }
 
+Result GDB_AllocatePacketBuffers(GDBContext *ctx)
+{
+    if(ctx->bufferSize == GDB_LARGE_BUF_LEN)
+        return 0;
+
+    u32 tmp;
+    u32 addr = GDB_PACKET_BUFFERS_ADDRESS + GDB_PACKET_BUFFERS_STRIDE * (ctx - ctx->parent->ctxs);
+    Result res = svcControlMemoryEx(&tmp, addr, 0, GDB_PACKET_BUFFERS_SIZE, MEMOP_ALLOC, MEMREGION_SYSTEM | MEMPERM_READWRITE, true);
+    if(R_FAILED(res))
+        return res; // keep using the default buffers
+
+    ctx->buffer = (char *)addr;
+    ctx->sendBuffer = ctx->buffer + GDB_LARGE_BUF_LEN + 4;
+    ctx->workBuffer = (u8 *)ctx->sendBuffer + GDB_LARGE_BUF_LEN + 4;
+    ctx->bufferSize = GDB_LARGE_BUF_LEN;
+
+    return 0;
+}
+
+void GDB_FreePacketBuffers(GDBContext *ctx)
+{
+    if(ctx->bufferSize != GDB_LARGE_BUF_LEN)
+        return;
+
+    u32 tmp;
+    svcControlMemory(&tmp, (u32)ctx->buffer, 0, GDB_PACKET_BUFFERS_SIZE, MEMOP_FREE, 0);
+    GDB_UseDefaultPacketBuffers(ctx);
+    ctx->latestSentPacketSize = 0;
+}
+
 Result GDB_AttachToProcess(GDBContext *ctx)
 {
     Result r;
@@ -51,7 +97,13 @@ Result GDB_AttachToProcess(GDBContext *ctx)
     // The second case will have, after RunQueuedProcess: attach process, debugger break, attach thread (with creator = 0)
 
     if (!(ctx->flags & GDB_FLAG_ATTACHED_AT_START))
+    {
+        // The cheat engine may be holding the only debugger a process can have, don't race its next pass for it
+        Cheat_LockSession();
+        Cheat_EndSession();
         r = svcDebugActiveProcess(&ctx->debug, ctx->pid);
+        Cheat_UnlockSession();
+    }
     else
     {
         r = 0;
@@ -103,20 +155,10 @@ Result GDB_AttachToProcess(GDBContext *ctx)
 void GDB_DetachFromProcess(GDBContext *ctx)
 {
     DebugEventInfo dummy;
-    for(u32 i = 0; i < ctx->nbBreakpoints; i++)
-    {
-        if(!ctx->breakpoints[i].persistent)
-            GDB_DisableBreakpointById(ctx, i);
-    }
-    memset(&ctx->breakpoints, 0, sizeof(ctx->breakpoints));
-    ctx->nbBreakpoints = 0;
+    GDB_ResetNonStopState(ctx); // stopped threads would prevent the process from terminating
+    GDB_RemoveAllBreakpoints(ctx);
 
-    for(u32 i = 0; i < ctx->nbWatchpoints; i++)
-    {
-        GDB_RemoveWatchpoint(ctx, ctx->watchpoints[i], WATCHPOINT_DISABLED);
-        ctx->watchpoints[i] = 0;
-    }
-    ctx->nbWatchpoints = 0;
+    GDB_RemoveAllWatchpoints(ctx);
 
     svcKernelSetState(0x10002, ctx->pid, false);
     memset(ctx->svcMask, 0, 32);
@@ -159,6 +201,8 @@ void GDB_DetachFromProcess(GDBContext *ctx)
     ctx->nbThreads = 0;
     ctx->totalNbCreatedThreads = 0;
     memset(ctx->threadInfos, 0, sizeof(ctx->threadInfos));
+    ctx->nbStepsHoldingThreads = 0;
+    GDB_ReleaseThreadSnapshots(ctx);
 
     ctx->currentHioRequestTargetAddr = 0;
     memset(&ctx->currentHioRequest, 0, sizeof(PackedGdbHioRequest));
@@ -6,43 +6,160 @@
 */
 
 #include "gdb/breakpoints.h"
+#include "gdb/server.h"
+#include "gdb/debug.h"
 
 #define _REENT_ONLY
 #include <errno.h>
 
-u32 GDB_FindClosestBreakpointSlot(GDBContext *ctx, u32 address)
+// Linear probing, kept at most half full so that lookups stay short
+#define BREAKPOINT_HASH_BITS        13
+#define BREAKPOINT_NB_BUCKETS       (1u << BREAKPOINT_HASH_BITS)
+#define BREAKPOINT_BUCKETS_SIZE     ((BREAKPOINT_NB_BUCKETS * sizeof(u16) + 0xFFF) & ~0xFFF)
+#define BREAKPOINT_POOL_SIZE        ((MAX_BREAKPOINT * sizeof(Breakpoint) + 0xFFF) & ~0xFFF)
+#define BREAKPOINT_AREA_STRIDE      0x10000
+
+_Static_assert(2 * MAX_BREAKPOINT <= BREAKPOINT_NB_BUCKETS, "Too many breakpoints for the hash table");
+_Static_assert(BREAKPOINT_BUCKETS_SIZE + BREAKPOINT_POOL_SIZE <= BREAKPOINT_AREA_STRIDE, "Breakpoint area too small");
+
+static inline u32 GDB_HashBreakpointAddress(u32 address)
+{
+    // Fibonacci hashing; instructions are at least 2-byte aligned
+    return ((address >> 1) * 2654435761u) >> (32 - BREAKPOINT_HASH_BITS);
+}
+
+// Returns the bucket of the breakpoint at this address, or the empty bucket it would go to
+static u32 GDB_FindBreakpointBucket(GDBContext *ctx, u32 address)
+{
+    u32 i;
+    for(i = GDB_HashBreakpointAddress(address);
+        ctx->breakpointBuckets[i] != 0 && ctx->breakpointPool[ctx->breakpointBuckets[i] - 1].address != address;
+        i = (i + 1) & (BREAKPOINT_NB_BUCKETS - 1));
+
+    return i;
+}
+
+Breakpoint *GDB_FindBreakpoint(GDBContext *ctx, u32 address)
 {
-    if(ctx->nbBreakpoints == 0 || address <= ctx->breakpoints[0].address)
+    if(ctx->nbBreakpoints == 0)
+        return NULL;
+
+    u16 idx = ctx->breakpointBuckets[GDB_FindBreakpointBucket(ctx, address)];
+    return idx == 0 ? NULL : &ctx->breakpointPool[idx - 1];
+}
+
+static Result GDB_CommitBreakpointArea(GDBContext *ctx, u32 size)
+{
+    u32 base = GDB_BREAKPOINTS_ADDRESS + BREAKPOINT_AREA_STRIDE * (ctx - ctx->parent->ctxs);
+    u32 tmp;
+
+    if(size <= ctx->breakpointsCommittedSize)
         return 0;
-    else if(address > ctx->breakpoints[ctx->nbBreakpoints - 1].address)
-        return ctx->nbBreakpoints;
 
-    u32 a = 0, b = ctx->nbBreakpoints - 1, m;
+    size = (size + 0xFFF) & ~0xFFF;
+    Result r = svcControlMemoryEx(&tmp, base + ctx->breakpointsCommittedSize, 0, size - ctx->breakpointsCommittedSize,
+                                  MEMOP_ALLOC, MEMREGION_SYSTEM | MEMPERM_READWRITE, true);
+    if(R_FAILED(r))
+        return r;
 
-    do
+    if(ctx->breakpointsCommittedSize == 0)
     {
-        m = (a + b) / 2;
-        if(ctx->breakpoints[m].address < address)
-            a = m;
-        else if(ctx->breakpoints[m].address > address)
-            b = m;
-        else
-            return m;
+        ctx->breakpointBuckets = (u16 *)base;
+        ctx->breakpointPool = (Breakpoint *)(base + BREAKPOINT_BUCKETS_SIZE);
+        memset(ctx->breakpointBuckets, 0, BREAKPOINT_BUCKETS_SIZE);
     }
-    while(b - a > 1);
 
-    return b;
+    ctx->breakpointsCommittedSize = size;
+    return 0;
+}
+
+static void GDB_ReleaseBreakpointArea(GDBContext *ctx)
+{
+    u32 tmp;
+    if(ctx->breakpointsCommittedSize != 0)
+        svcControlMemory(&tmp, (u32)ctx->breakpointBuckets, 0, ctx->breakpointsCommittedSize, MEMOP_FREE, 0);
+
+    ctx->nbBreakpoints = 0;
+    ctx->breakpointBuckets = NULL;
+    ctx->breakpointPool = NULL;
+    ctx->breakpointPoolEnd = ctx->breakpointFreeList = 0;
+    ctx->breakpointsCommittedSize = 0;
+}
+
+static Breakpoint *GDB_AllocateBreakpoint(GDBContext *ctx)
+{
+    // Freed entries are chained through savedInstruction
+    if(ctx->breakpointFreeList != 0)
+    {
+        Breakpoint *bkpt = &ctx->breakpointPool[ctx->breakpointFreeList - 1];
+        ctx->breakpointFreeList = bkpt->savedInstruction;
+        return bkpt;
+    }
+
+    if(ctx->breakpointPoolEnd == MAX_BREAKPOINT ||
+       R_FAILED(GDB_CommitBreakpointArea(ctx, BREAKPOINT_BUCKETS_SIZE + (ctx->breakpointPoolEnd + 1) * sizeof(Breakpoint))))
+        return NULL;
+
+    return &ctx->breakpointPool[ctx->breakpointPoolEnd++];
+}
+
+static void GDB_FreeBreakpoint(GDBContext *ctx, Breakpoint *bkpt)
+{
+    memset(bkpt, 0, sizeof(Breakpoint));
+    bkpt->savedInstruction = ctx->breakpointFreeList;
+    ctx->breakpointFreeList = bkpt - ctx->breakpointPool + 1;
+}
+
+static void GDB_RemoveBreakpointBucket(GDBContext *ctx, u32 i)
+{
+    // Backward-shift deletion: move up the entries that would otherwise become unreachable
+    u32 j = i;
+    for(;;)
+    {
+        j = (j + 1) & (BREAKPOINT_NB_BUCKETS - 1);
+        if(ctx->breakpointBuckets[j] == 0)
+            break;
+
+        u32 k = GDB_HashBreakpointAddress(ctx->breakpointPool[ctx->breakpointBuckets[j] - 1].address);
+        if(i <= j ? (i < k && k <= j) : (i < k || k <= j))
+            continue;
+
+        ctx->breakpointBuckets[i] = ctx->breakpointBuckets[j];
+        i = j;
+    }
+
+    ctx->breakpointBuckets[i] = 0;
+}
+
+static void GDB_FinishBreakpointStep(GDBContext *ctx);
+
+static void GDB_FreeBreakpointCondition(GDBContext *ctx, Breakpoint *bkpt)
+{
+    if(bkpt->conditionId != 0)
+        ctx->breakpointConditions[bkpt->conditionId - 1].size = 0;
+    bkpt->conditionId = 0;
+}
+
+// A breakpoint the user asks for at the address of a temporary one becomes theirs
+static void GDB_ClaimTemporaryBreakpoint(GDBContext *ctx, u32 address)
+{
+    BreakpointStep *step = &ctx->breakpointStep;
+    for(u32 i = 0; i < step->nbTemporaryBreakpoints; i++)
+    {
+        if(step->temporaryBreakpoints[i] == address)
+            step->temporaryBreakpoints[i--] = step->temporaryBreakpoints[--step->nbTemporaryBreakpoints];
+    }
 }
 
 int GDB_GetBreakpointInstruction(u32 *instruction, GDBContext *ctx, u32 address)
 {
-    u32 id = GDB_FindClosestBreakpointSlot(ctx, address);
+    Breakpoint *bkpt = GDB_FindBreakpoint(ctx, address);
 
-    if(id == ctx->nbBreakpoints || ctx->breakpoints[id].address != address)
+    if(bkpt == NULL)
         return -EINVAL;
 
     if(instruction != NULL)
-        *instruction = ctx->breakpoints[id].savedInstruction;
+        *instruction = bkpt->savedInstruction;
 
     return 0;
 }
@@ -54,27 +171,25 @@ int GDB_AddBreakpoint(GDBContext *ctx, u32 address, bool thumb, bool persist)
 
     address &= ~1;
 
-    u32 id = GDB_FindClosestBreakpointSlot(ctx, address);
-
-    if(id != ctx->nbBreakpoints && ctx->breakpoints[id].instructionSize != 0 && ctx->breakpoints[id].address == address)
+    if(GDB_FindBreakpoint(ctx, address) != NULL)
+    {
+        GDB_ClaimTemporaryBreakpoint(ctx, address);
         return 0;
+    }
     else if(ctx->nbBreakpoints == MAX_BREAKPOINT)
         return -EBUSY;
 
-    for(u32 i = ctx->nbBreakpoints; i > id && i != 0; i--)
-        ctx->breakpoints[i] = ctx->breakpoints[i - 1];
+    Breakpoint *bkpt = GDB_AllocateBreakpoint(ctx);
+    if(bkpt == NULL)
+        return -ENOMEM;
 
-    ctx->nbBreakpoints++;
-
-    Breakpoint *bkpt = &ctx->breakpoints[id];
     u32 instr = thumb ? BREAKPOINT_INSTRUCTION_THUMB : BREAKPOINT_INSTRUCTION_ARM;
     if(R_FAILED(svcReadProcessMemory(&bkpt->savedInstruction, ctx->debug, address, thumb ? 2 : 4)) ||
        R_FAILED(svcWriteProcessMemory(ctx->debug, &instr, address, thumb ? 2 : 4)))
     {
-        for(u32 i = id; i < ctx->nbBreakpoints - 1; i++)
-            ctx->breakpoints[i] = ctx->breakpoints[i + 1];
-
-        memset(&ctx->breakpoints[--ctx->nbBreakpoints], 0, sizeof(Breakpoint));
+        GDB_FreeBreakpoint(ctx, bkpt);
+        if(ctx->nbBreakpoints == 0)
+            GDB_ReleaseBreakpointArea(ctx);
         return -EFAULT;
     }
 
@@ -82,12 +197,14 @@ int GDB_AddBreakpoint(GDBContext *ctx, u32 address, bool thumb, bool persist)
     bkpt->address = address;
     bkpt->persistent = persist;
 
+    ctx->breakpointBuckets[GDB_FindBreakpointBucket(ctx, address)] = bkpt - ctx->breakpointPool + 1;
+    ctx->nbBreakpoints++;
+
     return 0;
 }
 
-int GDB_DisableBreakpointById(GDBContext *ctx, u32 id)
+int GDB_DisableBreakpoint(GDBContext *ctx, const Breakpoint *bkpt)
 {
-    Breakpoint *bkpt = &ctx->breakpoints[id];
     if(R_FAILED(svcWriteProcessMemory(ctx->debug, &bkpt->savedInstruction, bkpt->address, bkpt->instructionSize)))
         return -EFAULT;
     else return 0;
@@ -97,20 +214,557 @@ int GDB_RemoveBreakpoint(GDBContext *ctx, u32 address)
 {
     address &= ~1;
 
-    u32 id = GDB_FindClosestBreakpointSlot(ctx, address);
-    if(id == ctx->nbBreakpoints || ctx->breakpoints[id].address != address)
+    if(ctx->nbBreakpoints == 0)
         return -EINVAL;
 
-    int r = GDB_DisableBreakpointById(ctx, id);
+    u32 bucket = GDB_FindBreakpointBucket(ctx, address);
+    if(ctx->breakpointBuckets[bucket] == 0)
+        return -EINVAL;
+
+    Breakpoint *bkpt = &ctx->breakpointPool[ctx->breakpointBuckets[bucket] - 1];
+    int r = GDB_DisableBreakpoint(ctx, bkpt);
     if(r != 0)
         return r;
-    else
+
+    GDB_FreeBreakpointCondition(ctx, bkpt);
+    GDB_RemoveBreakpointBucket(ctx, bucket);
+    GDB_FreeBreakpoint(ctx, bkpt);
+
+    if(--ctx->nbBreakpoints == 0)
+        GDB_ReleaseBreakpointArea(ctx);
+
+    return 0;
+}
+
+void GDB_RemoveAllBreakpoints(GDBContext *ctx)
+{
+    GDB_FinishBreakpointStep(ctx);
+
+    // Persistent breakpoints are left in place
+    for(u32 i = 0; i < ctx->breakpointPoolEnd; i++)
     {
-        for(u32 i = id; i < ctx->nbBreakpoints - 1; i++)
-            ctx->breakpoints[i] = ctx->breakpoints[i + 1];
+        Breakpoint *bkpt = &ctx->breakpointPool[i];
+        if(bkpt->instructionSize != 0 && !bkpt->persistent)
+            GDB_DisableBreakpoint(ctx, bkpt);
+    }
+
+    GDB_ReleaseBreakpointArea(ctx);
+    memset(ctx->breakpointConditions, 0, sizeof(ctx->breakpointConditions));
+    memset(&ctx->breakpointStep, 0, sizeof(BreakpointStep));
+}
+
+
+/*
+    Conditional breakpoints.
+
+    Conditions are agent expressions (see the "Agent Expressions" appendix of the GDB manual), evaluated here
+    against the context of the thread that hit the breakpoint. When none of them holds, the breakpoint is put out
+    of the way, the thread is let go until it reaches the instruction(s) that can follow, and the breakpoint is
+    put back: this saves GDB a round-trip per hit, which is what makes conditions on hot code usable at all.
+*/
+
+#define AGENT_EXPRESSION_STACK_SIZE 32
+#define AGENT_EXPRESSION_MAX_STEPS  0x1000 // gotos can go backwards
+
+typedef enum AgentExpressionOpcode
+{
+    AX_ADD = 0x02,
+    AX_SUB,
+    AX_MUL,
+    AX_DIV_SIGNED,
+    AX_DIV_UNSIGNED,
+    AX_REM_SIGNED,
+    AX_REM_UNSIGNED,
+    AX_LSH,
+    AX_RSH_SIGNED,
+    AX_RSH_UNSIGNED,
+    AX_LOG_NOT = 0x0E,
+    AX_BIT_AND,
+    AX_BIT_OR,
+    AX_BIT_XOR,
+    AX_BIT_NOT,
+    AX_EQUAL,
+    AX_LESS_SIGNED,
+    AX_LESS_UNSIGNED,
+    AX_EXT,
+    AX_REF8,
+    AX_REF16,
+    AX_REF32,
+    AX_REF64,
+    AX_IF_GOTO = 0x20,
+    AX_GOTO,
+    AX_CONST8,
+    AX_CONST16,
+    AX_CONST32,
+    AX_CONST64,
+    AX_REG,
+    AX_END,
+    AX_DUP,
+    AX_POP,
+    AX_ZERO_EXT,
+    AX_SWAP,
+    AX_PICK = 0x32,
+    AX_ROT,
+} AgentExpressionOpcode;
 
-        memset(&ctx->breakpoints[--ctx->nbBreakpoints], 0, sizeof(Breakpoint));
+int GDB_SetBreakpointCondition(GDBContext *ctx, u32 address, const u8 *bytecode, u32 size)
+{
+    Breakpoint *bkpt = GDB_FindBreakpoint(ctx, address & ~1);
 
+    if(bkpt == NULL)
+        return -EINVAL;
+    else if(size == 0)
+    {
+        GDB_FreeBreakpointCondition(ctx, bkpt);
         return 0;
     }
+    else if(size > BREAKPOINT_CONDITION_MAX_LEN)
+        return -ENOSPC;
+
+    for(u32 id = 0; bkpt->conditionId == 0 && id < MAX_BREAKPOINT_CONDITION; id++)
+    {
+        if(ctx->breakpointConditions[id].size == 0)
+            bkpt->conditionId = id + 1;
+    }
+
+    if(bkpt->conditionId == 0)
+        return -ENOSPC;
+
+    BreakpointCondition *cond = &ctx->breakpointConditions[bkpt->conditionId - 1];
+    memcpy(cond->bytecode, bytecode, size);
+    cond->size = size;
+
+    return 0;
+}
+
+static bool GDB_GetAgentExpressionRegister(u64 *value, const ThreadContext *regs, u32 gdbNum)
+{
+    if(gdbNum <= 12)
+        *value = regs->cpu_registers.r[gdbNum];
+    else if(gdbNum <= 15)
+        *value = (&regs->cpu_registers.sp)[gdbNum - 13]; // hacky
+    else if(gdbNum == 25)
+        *value = regs->cpu_registers.cpsr;
+    else if(gdbNum >= 26 && gdbNum <= 41)
+        memcpy(value, &regs->fpu_registers.d[gdbNum - 26], 8);
+    else if(gdbNum == 42 || gdbNum == 43)
+        *value = (&regs->fpu_registers.fpscr)[gdbNum - 42]; // hacky
+    else
+        return false;
+
+    return true;
+}
+
+static inline u64 GDB_ReadAgentExpressionImmediate(const u8 *code, u32 size)
+{
+    u64 value = 0;
+    for(u32 i = 0; i < size; i++)
+        value = (value << 8) | code[i]; // big-endian
+
+    return value;
+}
+
+static int GDB_EvaluateAgentExpression(u64 *result, GDBContext *ctx, const ThreadContext *regs, const u8 *code, u32 len)
+{
+    u64 stack[AGENT_EXPRESSION_STACK_SIZE];
+    u32 sp = 0, pc = 0;
+
+    for(u32 nbSteps = 0; pc < len && nbSteps < AGENT_EXPRESSION_MAX_STEPS; nbSteps++)
+    {
+        u8 op = code[pc++];
+
+        // Operand counts, immediate sizes, and the stack space the result needs
+        u32 nbOperands, immSize = 0;
+        switch(op)
+        {
+            case AX_LOG_NOT: case AX_BIT_NOT: case AX_EXT: case AX_ZERO_EXT: case AX_IF_GOTO: case AX_POP:
+            case AX_REF8: case AX_REF16: case AX_REF32: case AX_REF64: case AX_END: case AX_DUP:
+                nbOperands = 1;
+                break;
+            case AX_GOTO: case AX_CONST8: case AX_CONST16: case AX_CONST32: case AX_CONST64: case AX_REG: case AX_PICK:
+                nbOperands = 0;
+                break;
+            case AX_ROT:
+                nbOperands = 3;
+                break;
+            default:
+                nbOperands = (op >= AX_ADD && op <= AX_RSH_UNSIGNED) || (op >= AX_BIT_AND && op <= AX_LESS_UNSIGNED) || op == AX_SWAP ? 2 : 0xFF;
+                break;
+        }
+
+        if(op == AX_EXT || op == AX_ZERO_EXT || op == AX_PICK || op == AX_CONST8)
+            immSize = 1;
+        else if(op == AX_IF_GOTO || op == AX_GOTO || op == AX_REG || op == AX_CONST16)
+            immSize = 2;
+        else if(op == AX_CONST32)
+            immSize = 4;
+        else if(op == AX_CONST64)
+            immSize = 8;
+
+        if(nbOperands == 0xFF) // floating point, tracing, state variables, printf...
+            return -ENOSYS;
+        else if(sp < nbOperands || len - pc < immSize)
+            return -EINVAL;
+        else if(sp == AGENT_EXPRESSION_STACK_SIZE && (op == AX_DUP || (nbOperands == 0 && op != AX_GOTO)))
+            return -EOVERFLOW;
+
+        u64 imm = GDB_ReadAgentExpressionImmediate(code + pc, immSize);
+        pc += immSize;
+
+        u64 a = sp >= 2 ? stack[sp - 2] : 0, b = sp >= 1 ? stack[sp - 1] : 0;
+        u64 *dst = nbOperands == 0 ? NULL : &stack[sp - (nbOperands == 2 ? 2 : 1)];
+        switch(op)
+        {
+            case AX_ADD: *dst = a + b; break;
+            case AX_SUB: *dst = a - b; break;
+            case AX_MUL: *dst = a * b; break;
+            case AX_DIV_SIGNED:
+            case AX_REM_SIGNED:
+                if(b == 0)
+                    return -EDOM;
+                else if((s64)b == -1) // avoid the INT64_MIN / -1 trap
+                    *dst = op == AX_DIV_SIGNED ? -a : 0;
+                else
+                    *dst = op == AX_DIV_SIGNED ? (u64)((s64)a / (s64)b) : (u64)((s64)a % (s64)b);
+                break;
+            case AX_DIV_UNSIGNED:
+            case AX_REM_UNSIGNED:
+                if(b == 0)
+                    return -EDOM;
+                *dst = op == AX_DIV_UNSIGNED ? a / b : a % b;
+                break;
+            case AX_LSH: *dst = b >= 64 ? 0 : a << b; break;
+            case AX_RSH_SIGNED: *dst = (u64)((s64)a >> (b >= 64 ? 63 : b)); break;
+            case AX_RSH_UNSIGNED: *dst = b >= 64 ? 0 : a >> b; break;
+            case AX_LOG_NOT: *dst = b == 0; break;
+            case AX_BIT_AND: *dst = a & b; break;
+            case AX_BIT_OR: *dst = a | b; break;
+            case AX_BIT_XOR: *dst = a ^ b; break;
+            case AX_BIT_NOT: *dst = ~b; break;
+            case AX_EQUAL: *dst = a == b; break;
+            case AX_LESS_SIGNED: *dst = (s64)a < (s64)b; break;
+            case AX_LESS_UNSIGNED: *dst = a < b; break;
+            case AX_EXT:
+            case AX_ZERO_EXT:
+                if(imm == 0)
+                    return -EINVAL;
+                else if(imm < 64)
+                    *dst = op == AX_EXT ? (u64)((s64)(b << (64 - imm)) >> (64 - imm)) : b & ((1ULL << imm) - 1);
+                break;
+            case AX_REF8:
+            case AX_REF16:
+            case AX_REF32:
+            case AX_REF64:
+            {
+                u64 value = 0;
+                if((u32)b != b || R_FAILED(svcReadProcessMemory(&value, ctx->debug, (u32)b, 1 << (op - AX_REF8))))
+                    return -EFAULT;
+                *dst = value;
+                break;
+            }
+            case AX_IF_GOTO:
+            case AX_GOTO:
+                if(op == AX_IF_GOTO && stack[--sp] == 0)
+                    break;
+                else if(imm >= len)
+                    return -EINVAL;
+                pc = imm;
+                break;
+            case AX_CONST8:
+            case AX_CONST16:
+            case AX_CONST32:
+            case AX_CONST64:
+                stack[sp++] = imm;
+                break;
+            case AX_REG:
+                if(!GDB_GetAgentExpressionRegister(&stack[sp], regs, imm))
+                    return -EINVAL;
+                sp++;
+                break;
+            case AX_END:
+                *result = b;
+                return 0;
+            case AX_DUP: stack[sp++] = b; break;
+            case AX_POP: sp--; break;
+            case AX_SWAP:
+                stack[sp - 2] = b;
+                stack[sp - 1] = a;
+                break;
+            case AX_PICK:
+                if(imm >= sp)
+                    return -EINVAL;
+                stack[sp] = stack[sp - 1 - imm];
+                sp++;
+                break;
+            case AX_ROT:
+            {
+                // Same as gdbserver: a b c => c a b, c being the top of the stack
+                u64 third = stack[sp - 3];
+                stack[sp - 3] = b;
+                stack[sp - 2] = third;
+                stack[sp - 1] = a;
+                break;
+            }
+            default:
+                return -ENOSYS;
+        }
+
+        if(nbOperands == 2)
+            sp--;
+    }
+
+    return -EINVAL; // no "end"
+}
+
+static bool GDB_IsBreakpointConditionTrue(GDBContext *ctx, const ThreadContext *regs, const BreakpointCondition *cond)
+{
+    // Any of the expressions holding is enough; ones that can't be evaluated count as holding, so that the user sees the stop
+    for(u32 pos = 0; pos + 2 <= cond->size;)
+    {
+        u32 len = cond->bytecode[pos] | (cond->bytecode[pos + 1] << 8);
+        u64 result = 0;
+
+        pos += 2;
+        if(len > cond->size - pos || GDB_EvaluateAgentExpression(&result, ctx, regs, cond->bytecode + pos, len) != 0 || result != 0)
+            return true;
+
+        pos += len;
+    }
+
+    return false;
+}
+
+static inline u32 GDB_GetStepRegister(const ThreadContext *regs, u32 n, u32 pcValue)
+{
+    if(n == 15)
+        return pcValue;
+    else if(n >= 13)
+        return (&regs->cpu_registers.sp)[n - 13]; // hacky
+    else
+        return regs->cpu_registers.r[n];
+}
+
+// Gets the addresses the instruction at a breakpoint can be followed by (bit 0 set for Thumb), returns their count, 0 if unknown
+static u32 GDB_GetNextInstructionAddresses(u32 *next, GDBContext *ctx, const ThreadContext *regs, const Breakpoint *bkpt)
+{
+    u32 pc = bkpt->address;
+    u32 instr = bkpt->savedInstruction;
+    u32 target = 0, nb = 0;
+    bool writesPc = true, conditional = false;
+
+    if(bkpt->instructionSize == 4)
+    {
+        u32 rd = (instr >> 12) & 0xF;
+        conditional = (instr >> 28) < 0xE;
+
+        if((instr >> 28) == 0xF)
+        {
+            if((instr & 0x0E000000) == 0x0A000000) // BLX (immediate)
+                target = (pc + 8 + ((s32)(instr << 8) >> 6) + ((instr >> 23) & 2)) | 1;
+            else if((instr & 0x0E500000) == 0x08100000) // RFE
+                return 0;
+            else
+                writesPc = false;
+        }
+        else if((instr & 0x0E000000) == 0x0A000000) // B, BL
+            target = pc + 8 + ((s32)(instr << 8) >> 6);
+        else if((instr & 0x0FFFFFD0) == 0x012FFF10) // BX, BLX (register)
+            target = GDB_GetStepRegister(regs, instr & 0xF, pc + 8);
+        else if((instr & 0x0FEFFFF0) == 0x01A0F000) // MOV pc, Rm
+            target = GDB_GetStepRegister(regs, instr & 0xF, pc + 8) & ~3;
+        else if((instr & 0x0C500000) == 0x04100000 && rd == 15 && (instr & 0x02000010) != 0x02000010) // LDR pc
+        {
+            u32 rn = GDB_GetStepRegister(regs, (instr >> 16) & 0xF, pc + 8);
+            u32 offset = instr & 0xFFF;
+            if(instr & (1 << 25))
+            {
+                u32 rm = GDB_GetStepRegister(regs, instr & 0xF, pc + 8);
+                u32 shift = (instr >> 7) & 0x1F;
+                switch((instr >> 5) & 3)
+                {
+                    case 0: offset = rm << shift; break;
+                    case 1: offset = shift == 0 ? 0 : rm >> shift; break;
+                    case 2: offset = (u32)((s32)rm >> (shift == 0 ? 31 : shift)); break;
+                    default:
+                        if(shift == 0) // RRX
+                            return 0;
+                        offset = (rm >> shift) | (rm << (32 - shift));
+                        break;
+                }
+            }
+
+            u32 address = (instr & (1 << 24)) ? ((instr & (1 << 23)) ? rn + offset : rn - offset) : rn;
+            if(R_FAILED(svcReadProcessMemory(&target, ctx->debug, address, 4)))
+                return 0;
+        }
+        else if((instr & 0x0E108000) == 0x08108000) // LDM with pc
+        {
+            u32 rn = GDB_GetStepRegister(regs, (instr >> 16) & 0xF, pc + 8);
+            u32 n = __builtin_popcount(instr & 0xFFFF);
+            bool pre = (instr & (1 << 24)) != 0;
+            u32 address = (instr & (1 << 23)) ? rn + 4 * n - (pre ? 0 : 4) : rn - (pre ? 4 : 0);
+            if(R_FAILED(svcReadProcessMemory(&target, ctx->debug, address, 4)))
+                return 0;
+        }
+        else if((instr & 0x0C000000) == 0 && rd == 15 && !((instr & 0x01900000) == 0x01100000)) // other data processing (but not TST/TEQ/CMP/CMN)
+            return 0;
+        else
+            writesPc = false;
+
+        if(conditional || !writesPc)
+            next[nb++] = pc + 4;
+    }
+    else
+    {
+        u16 hw = instr & 0xFFFF;
+        u32 size = 2;
+
+        if((hw & 0xF000) == 0xD000 && (hw & 0x0F00) < 0x0E00) // B<cond>
+        {
+            target = (pc + 4 + ((s32)((u32)hw << 24) >> 23)) | 1;
+            conditional = true;
+        }
+        else if((hw & 0xF800) == 0xE000) // B
+            target = (pc + 4 + ((s32)((u32)hw << 21) >> 20)) | 1;
+        else if((hw & 0xF800) == 0xF000) // BL, BLX (immediate): a pair of halfwords
+        {
+            u32 hw2 = 0;
+            if(GDB_GetBreakpointInstruction(&hw2, ctx, pc + 2) != 0 && R_FAILED(svcReadProcessMemory(&hw2, ctx->debug, pc + 2, 2)))
+                return 0;
+
+            s32 offset = ((s32)((u32)hw << 21) >> 9) | ((hw2 & 0x7FF) << 1);
+            if((hw2 & 0xF800) == 0xF800)
+                target = (pc + 4 + offset) | 1;
+            else if((hw2 & 0xF800) == 0xE800)
+                target = (pc + 4 + offset) & ~3;
+            else
+                return 0;
+            size = 4;
+        }
+        else if((hw & 0xFF00) == 0x4700) // BX, BLX (register)
+            target = GDB_GetStepRegister(regs, (hw >> 3) & 0xF, pc + 4);
+        else if((hw & 0xFF87) == 0x4687) // MOV pc, Rm
+            target = GDB_GetStepRegister(regs, (hw >> 3) & 0xF, pc + 4) | 1;
+        else if((hw & 0xFF87) == 0x4487) // ADD pc, Rm
+            target = (pc + 4 + GDB_GetStepRegister(regs, (hw >> 3) & 0xF, pc + 4)) | 1;
+        else if((hw & 0xFF00) == 0xBD00) // POP with pc
+        {
+            u32 address = regs->cpu_registers.sp + 4 * __builtin_popcount(hw & 0xFF);
+            if(R_FAILED(svcReadProcessMemory(&target, ctx->debug, address, 4)))
+                return 0;
+        }
+        else
+            writesPc = false;
+
+        if(conditional || !writesPc)
+            next[nb++] = (pc + size) | 1;
+    }
+
+    if(writesPc)
+        next[nb++] = target;
+
+    for(u32 i = 0; i < nb; i++)
+    {
+        // Misaligned Arm targets and instructions looping onto themselves can't be stepped with breakpoints
+        if(((next[i] & 1) == 0 && (next[i] & 3) != 0) || (next[i] & ~1) == pc)
+            return 0;
+    }
+
+    return nb;
+}
+
+static void GDB_EnableBreakpoint(GDBContext *ctx, const Breakpoint *bkpt)
+{
+    u32 instr = bkpt->instructionSize == 2 ? BREAKPOINT_INSTRUCTION_THUMB : BREAKPOINT_INSTRUCTION_ARM;
+    svcWriteProcessMemory(ctx->debug, &instr, bkpt->address, bkpt->instructionSize);
+}
+
+static void GDB_FinishBreakpointStep(GDBContext *ctx)
+{
+    BreakpointStep *step = &ctx->breakpointStep;
+    if(!step->pending)
+        return;
+
+    for(u32 i = 0; i < step->nbTemporaryBreakpoints; i++)
+        GDB_RemoveBreakpoint(ctx, step->temporaryBreakpoints[i]);
+
+    // It may have been removed in the meantime
+    Breakpoint *bkpt = GDB_FindBreakpoint(ctx, step->breakpointAddress);
+    if(bkpt != NULL)
+        GDB_EnableBreakpoint(ctx, bkpt);
+
+    if(step->holdsThreads)
+        GDB_ReleaseThreadsHeldForStep(ctx);
+
+    memset(step, 0, sizeof(BreakpointStep));
+}
+
+static inline bool GDB_IsSupervisorCall(const Breakpoint *bkpt)
+{
+    u32 instr = bkpt->savedInstruction;
+    return bkpt->instructionSize == 4 ? (instr & 0x0F000000) == 0x0F000000 && (instr >> 28) != 0xF : (instr & 0xFF00) == 0xDF00;
+}
+
+static bool GDB_StartBreakpointStep(GDBContext *ctx, u32 threadId, const ThreadContext *regs, const Breakpoint *bkpt)
+{
+    BreakpointStep *step = &ctx->breakpointStep;
+    u32 next[2];
+    u32 nb = GDB_GetNextInstructionAddresses(next, ctx, regs, bkpt);
+
+    if(nb == 0 || GDB_DisableBreakpoint(ctx, bkpt) != 0)
+        return false;
+
+    step->pending = true;
+    step->breakpointAddress = bkpt->address;
+
+    for(u32 i = 0; i < nb; i++)
+    {
+        // An existing breakpoint stops the thread there all the same
+        u32 address = next[i] & ~1;
+        if(GDB_FindBreakpoint(ctx, address) != NULL)
+            continue;
+        else if(GDB_AddBreakpoint(ctx, address, (next[i] & 1) != 0, false) != 0)
+        {
+            GDB_FinishBreakpointStep(ctx);
+            return false;
+        }
+
+        step->temporaryBreakpoints[step->nbTemporaryBreakpoints++] = address;
+    }
+
+    // A SVC may wait on the other threads, they have to keep running then
+    step->holdsThreads = !GDB_IsSupervisorCall(bkpt);
+    if(step->holdsThreads)
+        GDB_HoldOtherThreadsForStep(ctx, threadId);
+
+    return true;
+}
+
+bool GDB_HandleBreakpointDebugEvent(GDBContext *ctx, const DebugEventInfo *info)
+{
+    BreakpointStep *step = &ctx->breakpointStep;
+    bool isBreakpoint = info->type == DBGEVENT_EXCEPTION && info->exception.type == EXCEVENT_STOP_POINT &&
+                        info->exception.stop_point.type == STOPPOINT_SVC_FF;
+
+    if(step->pending)
+    {
+        bool isStepBreakpoint = false;
+        for(u32 i = 0; i < step->nbTemporaryBreakpoints; i++)
+            isStepBreakpoint = isStepBreakpoint || (isBreakpoint && info->exception.address == step->temporaryBreakpoints[i]);
+
+        // Whatever the event, the breakpoint is put back: at worst, the thread hits it again and the condition is evaluated again
+        GDB_FinishBreakpointStep(ctx);
+        if(isStepBreakpoint)
+            return true;
+    }
+
+    Breakpoint *bkpt = isBreakpoint ? GDB_FindBreakpoint(ctx, info->exception.address) : NULL;
+    ThreadContext regs;
+
+    if(bkpt == NULL || bkpt->conditionId == 0 ||
+       R_FAILED(svcGetDebugThreadContext(&regs, ctx->debug, info->thread_id, THREADCONTEXT_CONTROL_ALL)))
+        return false;
+
+    return !GDB_IsBreakpointConditionTrue(ctx, &regs, &ctx->breakpointConditions[bkpt->conditionId - 1]) &&
+           GDB_StartBreakpointStep(ctx, info->thread_id, &regs, bkpt);
 }
@@ -14,12 +14,19 @@
 #include "gdb/mem.h"
 #include "gdb/hio.h"
 #include "gdb/watchpoints.h"
+#include "gdb/breakpoints.h"
+#include "gdb/xfer.h"
 #include "fmt.h"
 
 #include <stdlib.h>
 #include <signal.h>
 #include "pmdbgext.h"
 
+static int GDB_SendAttachReply(GDBContext *ctx);
+static void GDB_InterruptNonStop(GDBContext *ctx);
+static int GDB_ContinueNonStop(GDBContext *ctx);
+static int GDB_SendNonStopStopReason(GDBContext *ctx);
+
 static void GDB_DetachImmediatelyExtended(GDBContext *ctx)
 {
     // detach immediately
@@ -102,7 +109,7 @@ GDB_DECLARE_VERBOSE_HANDLER(Run)
     }
 
     RecursiveLock_Unlock(&ctx->lock);
-    return R_SUCCEEDED(r) ? GDB_SendStopReply(ctx, &ctx->latestDebugEvent) : GDB_ReplyErrno(ctx, EPERM);
+    return R_SUCCEEDED(r) ? GDB_SendAttachReply(ctx) : GDB_ReplyErrno(ctx, EPERM);
 }
 
 GDB_DECLARE_HANDLER(Restart)
@@ -143,7 +150,7 @@ GDB_DECLARE_VERBOSE_HANDLER(Attach)
     if(R_FAILED(r))
         GDB_DetachImmediatelyExtended(ctx);
     RecursiveLock_Unlock(&ctx->lock);
-    return R_SUCCEEDED(r) ? GDB_SendStopReply(ctx, &ctx->latestDebugEvent) : GDB_ReplyErrno(ctx, EPERM);
+    return R_SUCCEEDED(r) ? GDB_SendAttachReply(ctx) : GDB_ReplyErrno(ctx, EPERM);
 }
 
 /*
@@ -205,7 +212,13 @@ GDB_DECLARE_VERBOSE_HANDLER(Kill)
 
 GDB_DECLARE_HANDLER(Break)
 {
-    if(!(ctx->flags & GDB_FLAG_PROCESS_CONTINUING))
+    if(ctx->flags & GDB_FLAG_NONSTOP)
+    {
+        // Reported through a stop notification
+        GDB_InterruptNonStop(ctx);
+        return 0;
+    }
+    else if(!(ctx->flags & GDB_FLAG_PROCESS_CONTINUING))
         return GDB_SendPacket(ctx, "S02", 3);
     else
     {
@@ -217,6 +230,7 @@ GDB_DECLARE_HANDLER(Break)
 void GDB_ContinueExecution(GDBContext *ctx)
 {
     ctx->selectedThreadId = ctx->selectedThreadIdForContinuing = 0;
+    GDB_InvalidateThreadSnapshots(ctx);
     svcContinueDebugEvent(ctx->debug, ctx->continueFlags);
     ctx->flags |= GDB_FLAG_PROCESS_CONTINUING;
 }
@@ -226,6 +240,13 @@ GDB_DECLARE_HANDLER(Continue)
     char *addrStart = NULL;
     u32 addr = 0;
 
+    if(ctx->flags & GDB_FLAG_NONSTOP)
+    {
+        // Not used by GDB in non-stop mode; resume every thread
+        ctx->commandData = "c";
+        return GDB_ContinueNonStop(ctx);
+    }
+
     if(ctx->selectedThreadIdForContinuing != 0 && ctx->selectedThreadIdForContinuing != ctx->currentThreadId)
         return 0;
 
@@ -251,11 +272,11 @@ GDB_DECLARE_HANDLER(Continue)
         if(GDB_ParseHexIntegerList(&addr, ctx->commandData + 3, 1, 0) == NULL)
             return GDB_ReplyErrno(ctx, EILSEQ);
 
-        Result r = svcGetDebugThreadContext(&regs, ctx->debug, ctx->currentThreadId, THREADCONTEXT_CONTROL_CPU_SPRS);
+        Result r = GDB_GetThreadContext(&regs, ctx, ctx->currentThreadId, THREADCONTEXT_CONTROL_CPU_SPRS);
         if(R_SUCCEEDED(r))
         {
             regs.cpu_registers.pc = addr;
-            r = svcSetDebugThreadContext(ctx->debug, ctx->currentThreadId, &regs, THREADCONTEXT_CONTROL_CPU_SPRS);
+            r = GDB_SetThreadContext(ctx, ctx->currentThreadId, &regs, THREADCONTEXT_CONTROL_CPU_SPRS);
         }
     }
 
@@ -265,6 +286,9 @@ GDB_DECLARE_HANDLER(Continue)
 
 GDB_DECLARE_VERBOSE_HANDLER(Continue)
 {
+    if(ctx->flags & GDB_FLAG_NONSTOP)
+        return GDB_ContinueNonStop(ctx);
+
     const char *pos = ctx->commandData;
     bool currentThreadFound = false;
     while(pos != NULL && *pos != 0 && !currentThreadFound)
@@ -317,6 +341,8 @@ GDB_DECLARE_HANDLER(GetStopReason)
         return GDB_SendFormattedPacket(ctx, "X0f%s", pidbuf);
     } else if (ctx->debug == 0) {
         return GDB_SendFormattedPacket(ctx, "W00%s", pidbuf);
+    } else if (ctx->flags & GDB_FLAG_NONSTOP) {
+        return GDB_SendNonStopStopReason(ctx);
     } else {
         return GDB_SendStopReply(ctx, &ctx->latestDebugEvent);
     }
@@ -324,39 +350,36 @@ GDB_DECLARE_HANDLER(GetStopReason)
 
 static int GDB_ParseCommonThreadInfo(char *out, GDBContext *ctx, int sig)
 {
-    u32 threadId = ctx->currentThreadId;
-    ThreadContext regs;
-    s64 dummy;
-    u32 core;
-    Result r = svcGetDebugThreadContext(&regs, ctx->debug, threadId, THREADCONTEXT_CONTROL_ALL);
+    // Every register is expedited; taken from the snapshot, which then serves the 'g'/'p' packets following the stop
+    ThreadSnapshot scratch;
+    const ThreadSnapshot *snapshot = GDB_GetThreadSnapshot(&scratch, ctx, ctx->currentThreadId, THREADSNAPSHOT_CONTEXT | THREADSNAPSHOT_CREATOR_CORE);
+    const ThreadContext *regs = &snapshot->context;
 
     char tidbuf[32];
     GDB_EncodeThreadId(ctx, tidbuf, ctx->currentThreadId);
     int n = sprintf(out, "T%02xthread:%s;", sig, tidbuf);
 
-    if(R_FAILED(r))
+    if(!(snapshot->validFields & THREADSNAPSHOT_CONTEXT))
         return n;
 
-    r = svcGetDebugThreadParam(&dummy, &core, ctx->debug, ctx->currentThreadId, DBGTHREAD_PARAMETER_CPU_CREATOR); // Creator = "first ran, and running the thread"
-
-    if(R_SUCCEEDED(r))
-        n += sprintf(out + n, "core:%lx;", core);
+    if(snapshot->validFields & THREADSNAPSHOT_CREATOR_CORE)
+        n += sprintf(out + n, "core:%lx;", snapshot->creatorCore);
 
     for(u32 i = 0; i <= 12; i++)
-        n += sprintf(out + n, "%lx:%08lx;", i, __builtin_bswap32(regs.cpu_registers.r[i]));
+        n += sprintf(out + n, "%lx:%08lx;", i, __builtin_bswap32(regs->cpu_registers.r[i]));
 
     n += sprintf(out + n, "d:%08lx;e:%08lx;f:%08lx;19:%08lx;",
-        __builtin_bswap32(regs.cpu_registers.sp), __builtin_bswap32(regs.cpu_registers.lr), __builtin_bswap32(regs.cpu_registers.pc),
-        __builtin_bswap32(regs.cpu_registers.cpsr));
+        __builtin_bswap32(regs->cpu_registers.sp), __builtin_bswap32(regs->cpu_registers.lr), __builtin_bswap32(regs->cpu_registers.pc),
+        __builtin_bswap32(regs->cpu_registers.cpsr));
 
     for(u32 i = 0; i < 16; i++)
     {
         u64 val;
-        memcpy(&val, &regs.fpu_registers.d[i], 8);
+        memcpy(&val, &regs->fpu_registers.d[i], 8);
         n += sprintf(out + n, "%lx:%016llx;", 26 + i, __builtin_bswap64(val));
     }
 
-    n += sprintf(out + n, "2a:%08lx;2b:%08lx;", __builtin_bswap32(regs.fpu_registers.fpscr), __builtin_bswap32(regs.fpu_registers.fpexc));
+    n += sprintf(out + n, "2a:%08lx;2b:%08lx;", __builtin_bswap32(regs->fpu_registers.fpscr), __builtin_bswap32(regs->fpu_registers.fpexc));
 
     return n;
 }
@@ -368,6 +391,8 @@ void GDB_PreprocessDebugEvent(GDBContext *ctx, DebugEventInfo *info)
         case DBGEVENT_ATTACH_PROCESS:
         {
             ctx->pid = info->attach_process.process_id;
+            if(ctx->flags & GDB_FLAG_ATTACHED_AT_START)
+                GDB_NotifyProcessListChanged(); // we've just launched it
             break;
         }
 
@@ -393,6 +418,7 @@ void GDB_PreprocessDebugEvent(GDBContext *ctx, DebugEventInfo *info)
                 svcBreak(USERBREAK_ASSERT);
             else
             {
+                GDB_InvalidateThreadSnapshot(ctx, info->thread_id, ~0u);
                 for(u32 j = i; j < ctx->nbThreads - 1; j++)
                     memcpy(ctx->threadInfos + j, ctx->threadInfos + j + 1, sizeof(ThreadInfo));
                 memset(ctx->threadInfos + --ctx->nbThreads, 0, sizeof(ThreadInfo));
@@ -405,6 +431,7 @@ void GDB_PreprocessDebugEvent(GDBContext *ctx, DebugEventInfo *info)
         {
             ctx->processEnded = true;
             ctx->processExited = info->exit_process.reason == EXITPROCESS_EVENT_EXIT;
+            GDB_NotifyProcessListChanged();
 
             break;
         }
@@ -453,9 +480,10 @@ void GDB_PreprocessDebugEvent(GDBContext *ctx, DebugEventInfo *info)
     }
 }
 
-int GDB_SendStopReply(GDBContext *ctx, const DebugEventInfo *info)
+// Returns the length of the stop reply written to out, 0 if the event isn't reported
+static int GDB_FormatStopReply(GDBContext *ctx, char *out, const DebugEventInfo *info)
 {
-    char buffer[GDB_BUF_LEN + 1];
+    int n;
 
     switch(info->type)
     {
@@ -468,15 +496,14 @@ int GDB_SendStopReply(GDBContext *ctx, const DebugEventInfo *info)
             {
                 // Main thread created
                 ctx->currentThreadId = info->thread_id;
-                GDB_ParseCommonThreadInfo(buffer, ctx, SIGINT);
-                return GDB_SendFormattedPacket(ctx, "%s", buffer);
+                return GDB_ParseCommonThreadInfo(out, ctx, SIGINT);
             }
             else if(info->attach_thread.creator_thread_id == 0 || !ctx->catchThreadEvents)
                 break; // Dismissed
             else
             {
                 ctx->currentThreadId = info->thread_id;
-                return GDB_SendPacket(ctx, "T05create:;", 10);
+                return sprintf(out, "T05create:;");
             }
         }
 
@@ -486,7 +513,7 @@ int GDB_SendStopReply(GDBContext *ctx, const DebugEventInfo *info)
             {
                 // no signal, SIGTERM, SIGQUIT (process exited), SIGTERM (process terminated)
                 static int threadExitRepliesSigs[] = { 0, SIGTERM, SIGQUIT, SIGTERM };
-                return GDB_SendFormattedPacket(ctx, "w%02x;%lx", threadExitRepliesSigs[(u32)info->exit_thread.reason], info->thread_id);
+                return sprintf(out, "w%02x;%lx", threadExitRepliesSigs[(u32)info->exit_thread.reason], info->thread_id);
             }
             break;
         }
@@ -500,7 +527,7 @@ int GDB_SendStopReply(GDBContext *ctx, const DebugEventInfo *info)
                 sprintf(pidbuf, ";process:%lx", GDB_ConvertFromRealPid(ctx->pid));
             else
                 pidbuf[0] = '\0';
-            return GDB_SendFormattedPacket(ctx, "%s%s", processExitReplies[(u32)info->exit_process.reason], pidbuf);
+            return sprintf(out, "%s%s", processExitReplies[(u32)info->exit_process.reason], pidbuf);
         }
 
         case DBGEVENT_EXCEPTION:
@@ -519,23 +546,23 @@ int GDB_SendStopReply(GDBContext *ctx, const DebugEventInfo *info)
                                 (exc.type == EXCEVENT_UNDEFINED_SYSCALL ? SIGSYS : SIGSEGV);
 
                     ctx->currentThreadId = info->thread_id;
-                    GDB_ParseCommonThreadInfo(buffer, ctx, signum);
-                    return GDB_SendFormattedPacket(ctx, "%s", buffer);
+                    return GDB_ParseCommonThreadInfo(out, ctx, signum);
                 }
 
                 case EXCEVENT_ATTACH_BREAK:
                 {
-                    // Try to deduce which thread we can consider "current"
-                    ctx->currentThreadId = ctx->currentThreadId == 0 ? GDB_GetCurrentThread(ctx) : ctx->currentThreadId;
+                    // Try to deduce which thread we can consider "current", unless the event is about a given thread (non-stop mode)
+                    if (info->thread_id != 0)
+                        ctx->currentThreadId = info->thread_id;
+                    else
+                        ctx->currentThreadId = ctx->currentThreadId == 0 ? GDB_GetCurrentThread(ctx) : ctx->currentThreadId;
+
                     if (ctx->currentThreadId != 0)
-                    {
-                        GDB_ParseCommonThreadInfo(buffer, ctx, 0);
-                        return GDB_SendFormattedPacket(ctx, "%s", buffer);
-                    }
+                        return GDB_ParseCommonThreadInfo(out, ctx, 0);
                     else
                     {
                         // Should not happen
-                        return GDB_SendPacket(ctx, "S00", 3);
+                        return sprintf(out, "S00");
                     }
                 }
 
@@ -551,19 +578,19 @@ int GDB_SendStopReply(GDBContext *ctx, const DebugEventInfo *info)
                             // Note: STOPPOINT_BREAKPOINT includes both "bkpt" and hw breakpoints, but we never use the latter...
                             // Use swbreak as a reason for both 'svc 0xFF' and 'bkpt' too (GDB doc mention we should use 'swbreak'
                             // even if the breakpoint was already present/hardcoded).
-                            GDB_ParseCommonThreadInfo(buffer, ctx, SIGTRAP);
-                            return GDB_SendFormattedPacket(ctx, "%sswbreak:;", buffer);
+                            n = GDB_ParseCommonThreadInfo(out, ctx, SIGTRAP);
+                            return n + sprintf(out + n, "swbreak:;");
                         }
 
                         case STOPPOINT_WATCHPOINT:
                         {
                             const char *kinds[] = { "", "r", "", "a" };
                             WatchpointKind kind = GDB_GetWatchpointKind(ctx, exc.stop_point.fault_information);
-                            if(kind == WATCHPOINT_DISABLED)
+                            if(kind == WATCHPOINT_DISABLED && !(ctx->flags & GDB_FLAG_NONSTOP))
                                 GDB_SendDebugString(ctx, "Warning: unknown watchpoint encountered!\n");
 
-                            GDB_ParseCommonThreadInfo(buffer, ctx, SIGTRAP);
-                            return GDB_SendFormattedPacket(ctx, "%s%swatch:%08lx;", buffer, kinds[(u32)kind], exc.stop_point.fault_information);
+                            n = GDB_ParseCommonThreadInfo(out, ctx, SIGTRAP);
+                            return n + sprintf(out + n, "%swatch:%08lx;", kinds[(u32)kind], exc.stop_point.fault_information);
                         }
 
                         default:
@@ -575,8 +602,7 @@ int GDB_SendStopReply(GDBContext *ctx, const DebugEventInfo *info)
                 case EXCEVENT_USER_BREAK:
                 {
                     ctx->currentThreadId = info->thread_id;
-                    GDB_ParseCommonThreadInfo(buffer, ctx, SIGINT);
-                    return GDB_SendFormattedPacket(ctx, "%s", buffer);
+                    return GDB_ParseCommonThreadInfo(out, ctx, SIGINT);
                     //TODO
                 }
 
@@ -585,6 +611,13 @@ int GDB_SendStopReply(GDBContext *ctx, const DebugEventInfo *info)
                     u32 threadIds[4];
                     u32 nbThreads = 0;
 
+                    if(info->thread_id != 0)
+                    {
+                        // Interrupted thread chosen by the non-stop code
+                        ctx->currentThreadId = info->thread_id;
+                        return GDB_ParseCommonThreadInfo(out, ctx, SIGINT);
+                    }
+
                     for(u32 i = 0; i < 4; i++)
                     {
                         if(exc.debugger_break.thread_ids[i] > 0)
@@ -592,12 +625,10 @@ int GDB_SendStopReply(GDBContext *ctx, const DebugEventInfo *info)
                     }
 
                     u32 currentThreadId = nbThreads > 0 ? GDB_GetCurrentThreadFromList(ctx, threadIds, nbThreads) : GDB_GetCurrentThread(ctx);
-                    s64 dummy;
-                    u32 mask = 0;
-
-                    svcGetDebugThreadParam(&dummy, &mask, ctx->debug, currentThreadId, DBGTHREAD_PARAMETER_SCHEDULING_MASK_LOW);
+                    ThreadSnapshot scratch;
+                    const ThreadSnapshot *snapshot = GDB_GetThreadSnapshot(&scratch, ctx, currentThreadId, THREADSNAPSHOT_SCHEDULING_MASK);
 
-                    if(mask == 1)
+                    if((snapshot->validFields & THREADSNAPSHOT_SCHEDULING_MASK) && snapshot->schedulingMask == 1)
                         ctx->currentThreadId = currentThreadId;
                     else
                     {
@@ -611,13 +642,10 @@ int GDB_SendStopReply(GDBContext *ctx, const DebugEventInfo *info)
                     {
                         // No thread.
                         // This should not be happening.
-                        return GDB_SendPacket(ctx, "S02", 3);
+                        return sprintf(out, "S02");
                     }
                     else
-                    {
-                        GDB_ParseCommonThreadInfo(buffer, ctx, SIGINT);
-                        return GDB_SendFormattedPacket(ctx, "%s", buffer);
-                    }
+                        return GDB_ParseCommonThreadInfo(out, ctx, SIGINT);
                 }
 
                 default:
@@ -630,84 +658,102 @@ int GDB_SendStopReply(GDBContext *ctx, const DebugEventInfo *info)
         case DBGEVENT_SYSCALL_IN:
         {
             ctx->currentThreadId = info->thread_id;
-            GDB_ParseCommonThreadInfo(buffer, ctx, SIGTRAP);
-            return GDB_SendFormattedPacket(ctx, "%ssyscall_entry:%02x;", buffer, info->syscall.syscall);
+            n = GDB_ParseCommonThreadInfo(out, ctx, SIGTRAP);
+            return n + sprintf(out + n, "syscall_entry:%02x;", info->syscall.syscall);
         }
 
         case DBGEVENT_SYSCALL_OUT:
         {
             ctx->currentThreadId = info->thread_id;
-            GDB_ParseCommonThreadInfo(buffer, ctx, SIGTRAP);
-            return GDB_SendFormattedPacket(ctx, "%ssyscall_return:%02x;", buffer, info->syscall.syscall);
+            n = GDB_ParseCommonThreadInfo(out, ctx, SIGTRAP);
+            return n + sprintf(out + n, "syscall_return:%02x;", info->syscall.syscall);
         }
 
-        case DBGEVENT_OUTPUT_STRING:
-        {
-            // Regular "output string"
-            if (!GDB_IsHioInProgress(ctx))
-            {
-                u32 addr = info->output_string.string_addr;
-                u32 remaining = info->output_string.string_size;
-                u32 sent = 0;
-                int total = 0;
-                while(remaining > 0)
-                {
-                    u32 pending = (GDB_BUF_LEN - 1) / 2;
-                    pending = pending < remaining ? pending : remaining;
+        default:
+            break;
+    }
 
-                    int res = GDB_SendMemory(ctx, "O", 1, addr + sent, pending);
-                    if(res < 0 || (u32) res != 5 + 2 * pending)
-                        break;
+    return 0;
+}
 
-                    sent += pending;
-                    remaining -= pending;
-                    total += res;
-                }
 
-                return total;
-            }
-            else // HIO
+int GDB_SendStopReply(GDBContext *ctx, const DebugEventInfo *info)
+{
+    char buffer[GDB_BUF_LEN + 1];
+
+    if(info->type == DBGEVENT_OUTPUT_STRING)
+    {
+        // Regular "output string"
+        if (!GDB_IsHioInProgress(ctx))
+        {
+            u32 addr = info->output_string.string_addr;
+            u32 remaining = info->output_string.string_size;
+            u32 sent = 0;
+            int total = 0;
+            while(remaining > 0)
             {
-                return GDB_SendCurrentHioRequest(ctx);
+                u32 pending = (ctx->bufferSize - 1) / 2;
+                pending = pending < remaining ? pending : remaining;
+
+                int res = GDB_SendMemory(ctx, "O", 1, addr + sent, pending);
+                if(res < 0 || (u32) res != 5 + 2 * pending)
+                    break;
+
+                sent += pending;
+                remaining -= pending;
+                total += res;
             }
 
+            return total;
         }
-        default:
-            break;
+        else // HIO
+            return GDB_SendCurrentHioRequest(ctx);
     }
 
-    return 0;
+    int n = GDB_FormatStopReply(ctx, buffer, info);
+    return n > 0 ? GDB_SendPacket(ctx, buffer, n) : 0;
 }
 
 /*
     Only 1 blocking event can be enqueued at a time: they preempt all the other threads.
     The only "non-blocking" event that is implemented is EXIT PROCESS (but it's a very special case)
+
+    In non-stop mode, only the thread the event is about is kept stopped (see below).
 */
-int GDB_HandleDebugEvents(GDBContext *ctx)
-{
-    if(ctx->state == GDB_STATE_DETACHING)
-        return -1;
+static int GDB_QueueStopEvent(GDBContext *ctx, const DebugEventInfo *info);
+static int GDB_HandleNonStopDebugEvent(GDBContext *ctx, const DebugEventInfo *info);
 
-    DebugEventInfo info;
-    Result rdbg = svcGetProcessDebugEvent(&info, ctx->debug);
+static int GDB_ProcessDebugEvent(GDBContext *ctx, DebugEventInfo *info)
+{
+    GDB_PreprocessDebugEvent(ctx, info);
 
-    if(R_FAILED(rdbg))
-        return -1;
+    // Steps over faulting accesses to watched pages, and over breakpoints whose condition doesn't hold
+    if(GDB_HandleWatchpointDebugEvent(ctx, info) || GDB_HandleBreakpointDebugEvent(ctx, info))
+    {
+        if(svcContinueDebugEvent(ctx->debug, ctx->continueFlags) == (Result)0xD8A02008) // process ended
+            return -2;
 
-    GDB_PreprocessDebugEvent(ctx, &info);
+        return -3;
+    }
 
     int ret = 0;
-    bool continueAutomatically = (info.type == DBGEVENT_OUTPUT_STRING  && !GDB_IsHioInProgress(ctx)) ||
-                                info.type == DBGEVENT_ATTACH_PROCESS ||
-                                (info.type == DBGEVENT_ATTACH_THREAD && (info.attach_thread.creator_thread_id == 0 || !ctx->catchThreadEvents)) ||
-                                (info.type == DBGEVENT_EXIT_THREAD && (info.exit_thread.reason >= EXITTHREAD_EVENT_EXIT_PROCESS || !ctx->catchThreadEvents)) ||
-                                info.type == DBGEVENT_EXIT_PROCESS || !(info.flags & 1);
+    bool continueAutomatically = (info->type == DBGEVENT_OUTPUT_STRING  && !GDB_IsHioInProgress(ctx)) ||
+                                info->type == DBGEVENT_ATTACH_PROCESS ||
+                                (info->type == DBGEVENT_ATTACH_THREAD && (info->attach_thread.creator_thread_id == 0 || !ctx->catchThreadEvents)) ||
+                                (info->type == DBGEVENT_EXIT_THREAD && (info->exit_thread.reason >= EXITTHREAD_EVENT_EXIT_PROCESS || !ctx->catchThreadEvents)) ||
+                                info->type == DBGEVENT_EXIT_PROCESS || !(info->flags & 1);
 
     if(continueAutomatically)
     {
         Result r = 0;
-        ret = GDB_SendStopReply(ctx, &info);
-        if(info.flags & 1)
+
+        // Console output can't be sent while the process is running in non-stop mode
+        if(!(ctx->flags & GDB_FLAG_NONSTOP))
+            ret = GDB_SendStopReply(ctx, info);
+        else if(info->type == DBGEVENT_EXIT_PROCESS)
+            GDB_QueueStopEvent(ctx, info);
+
+        if(info->flags & 1)
             r = svcContinueDebugEvent(ctx->debug, ctx->continueFlags);
 
         if(r == (Result)0xD8A02008) // process ended
@@ -722,9 +768,438 @@ int GDB_HandleDebugEvents(GDBContext *ctx)
         if(ctx->processEnded)
             return -2;
 
-        ctx->latestDebugEvent = info;
-        ret = GDB_SendStopReply(ctx, &info);
+        // HIO requests still stop the whole process
+        if((ctx->flags & GDB_FLAG_NONSTOP) && info->type != DBGEVENT_OUTPUT_STRING)
+            return GDB_HandleNonStopDebugEvent(ctx, info);
+
+        // Stopped from here on, so that the stop reply fills the thread snapshots
+        ctx->latestDebugEvent = *info;
         ctx->flags &= ~GDB_FLAG_PROCESS_CONTINUING;
+        ret = GDB_SendStopReply(ctx, info);
         return ret;
     }
 }
+
+int GDB_HandleDebugEvents(GDBContext *ctx)
+{
+    if(ctx->state == GDB_STATE_DETACHING)
+        return -1;
+
+    DebugEventInfo info;
+    Result rdbg = svcGetProcessDebugEvent(&info, ctx->debug);
+
+    if(R_FAILED(rdbg))
+        return -1;
+
+    return GDB_ProcessDebugEvent(ctx, &info);
+}
+
+/*
+    Non-stop mode.
+
+    The kernel stops the whole process while a debug event is pending. The thread an event is about is
+    kept from being scheduled on its own (kernel extension), then the event is continued: the other threads
+    keep running. Stop events are queued; the first one is sent as a %Stop notification and GDB fetches
+    the others with vStopped.
+
+    Thread contexts might only be accessible while the process is stopped; when that's the case, the whole
+    process is briefly stopped to access them.
+*/
+
+static ThreadInfo *GDB_FindThreadInfo(GDBContext *ctx, u32 threadId)
+{
+    for(u32 i = 0; i < ctx->nbThreads; i++)
+    {
+        if(ctx->threadInfos[i].id == threadId)
+            return &ctx->threadInfos[i];
+    }
+
+    return NULL;
+}
+
+static Result GDB_SetThreadStopped(GDBContext *ctx, ThreadInfo *thread, bool stopped)
+{
+    if(thread->stopped == stopped)
+        return 0;
+
+    // A thread held for a step is already kept from running, and stays so until the step ends
+    Result r = thread->heldForStep ? 0 : svcKernelSetState(0x10007, thread->id, stopped);
+    if(R_SUCCEEDED(r))
+        thread->stopped = stopped;
+
+    if(R_SUCCEEDED(r) && !stopped)
+        GDB_InvalidateThreadSnapshot(ctx, thread->id, ~0u);
+
+    return r;
+}
+
+/*
+    Stepping over a breakpoint or a watched access leaves the location unguarded until the thread reaches
+    the next instruction. Meanwhile the other threads are held, so that none of them can go past it unnoticed;
+    steps can be nested, the threads are released when the last one ends. Threads that can't be held
+    (e.g. without the kernel extension) keep running.
+*/
+void GDB_HoldOtherThreadsForStep(GDBContext *ctx, u32 threadId)
+{
+    ctx->nbStepsHoldingThreads++;
+
+    for(u32 i = 0; i < ctx->nbThreads; i++)
+    {
+        ThreadInfo *thread = &ctx->threadInfos[i];
+        if(thread->id != threadId && !thread->stopped && !thread->heldForStep)
+            thread->heldForStep = R_SUCCEEDED(svcKernelSetState(0x10007, thread->id, true));
+    }
+}
+
+void GDB_ReleaseThreadsHeldForStep(GDBContext *ctx)
+{
+    if(ctx->nbStepsHoldingThreads == 0 || --ctx->nbStepsHoldingThreads != 0)
+        return;
+
+    for(u32 i = 0; i < ctx->nbThreads; i++)
+    {
+        ThreadInfo *thread = &ctx->threadInfos[i];
+        if(thread->heldForStep && !thread->stopped)
+            svcKernelSetState(0x10007, thread->id, false);
+        thread->heldForStep = false;
+    }
+}
+
+static inline bool GDB_IsProcessRunningNonStop(GDBContext *ctx)
+{
+    // Otherwise, the whole process is stopped at ctx->latestDebugEvent (fallback when a thread can't be stopped on its own)
+    return (ctx->flags & GDB_FLAG_NONSTOP) && (ctx->flags & GDB_FLAG_PROCESS_CONTINUING);
+}
+
+static inline DebugEventInfo *GDB_GetStopEvent(GDBContext *ctx, u32 i)
+{
+    return &ctx->stopEventQueue[(ctx->stopEventQueueStart + i) % MAX_STOP_EVENT];
+}
+
+static bool GDB_IsStopEventQueued(GDBContext *ctx, u32 threadId, u32 first)
+{
+    for(u32 i = first; i < ctx->nbStopEvents; i++)
+    {
+        if(GDB_GetStopEvent(ctx, i)->thread_id == threadId)
+            return true;
+    }
+
+    return false;
+}
+
+static int GDB_QueueStopEvent(GDBContext *ctx, const DebugEventInfo *info)
+{
+    char buffer[GDB_BUF_LEN + 1];
+
+    if(ctx->nbStopEvents == MAX_STOP_EVENT)
+        return -1;
+
+    *GDB_GetStopEvent(ctx, ctx->nbStopEvents++) = *info;
+    if(ctx->stopNotificationPending)
+        return 0;
+
+    memcpy(buffer, "Stop:", 5);
+    ctx->stopNotificationPending = true;
+    return GDB_SendNotification(ctx, buffer, 5 + GDB_FormatStopReply(ctx, buffer + 5, GDB_GetStopEvent(ctx, 0)));
+}
+
+static int GDB_QueueThreadStoppedEvent(GDBContext *ctx, u32 threadId, ExceptionEventType type)
+{
+    // Reported as signal 0 (attach break) or SIGINT (debugger break) for this thread
+    DebugEventInfo info = { 0 };
+    info.type = DBGEVENT_EXCEPTION;
+    info.thread_id = threadId;
+    info.exception.type = type;
+
+    return GDB_QueueStopEvent(ctx, &info);
+}
+
+static int GDB_HandleNonStopDebugEvent(GDBContext *ctx, const DebugEventInfo *info)
+{
+    ThreadInfo *thread = info->type == DBGEVENT_EXIT_THREAD ? NULL : GDB_FindThreadInfo(ctx, info->thread_id);
+
+    if(thread != NULL && R_FAILED(GDB_SetThreadStopped(ctx, thread, true)))
+    {
+        // Keep the whole process stopped until the next resume action, like in all-stop mode
+        ctx->latestDebugEvent = *info;
+        ctx->flags &= ~GDB_FLAG_PROCESS_CONTINUING;
+        GDB_QueueStopEvent(ctx, info);
+        return 0;
+    }
+
+    GDB_QueueStopEvent(ctx, info);
+    if(svcContinueDebugEvent(ctx->debug, ctx->continueFlags) == (Result)0xD8A02008) // process ended
+        return -2;
+
+    return -3;
+}
+
+// Stops the whole process, handling the debug events received in the meantime. The break event is left pending.
+static Result GDB_BreakProcessNonStop(GDBContext *ctx, DebugEventInfo *breakEvent)
+{
+    DebugEventInfo info;
+    Result r = svcBreakDebugProcess(ctx->debug);
+
+    while(R_SUCCEEDED(r))
+    {
+        r = svcWaitSynchronization(ctx->debug, 100 * 1000 * 1000LL);
+        if(r == (Result)0x09401BFE) // timeout
+            r = -1;
+        else if(R_SUCCEEDED(r))
+            r = svcGetProcessDebugEvent(&info, ctx->debug);
+
+        if(R_FAILED(r))
+            break;
+        else if(info.type == DBGEVENT_EXCEPTION && info.exception.type == EXCEVENT_DEBUGGER_BREAK)
+        {
+            if(breakEvent != NULL)
+                *breakEvent = info;
+            return 0;
+        }
+        else if(GDB_ProcessDebugEvent(ctx, &info) == -2)
+            r = -1;
+    }
+
+    return r;
+}
+
+Result GDB_GetThreadContext(ThreadContext *regs, GDBContext *ctx, u32 threadId, u32 controlFlags)
+{
+    const ThreadContext *snapshot = GDB_GetThreadContextSnapshot(ctx, threadId);
+    if(snapshot != NULL)
+    {
+        *regs = *snapshot;
+        return 0;
+    }
+
+    Result r = svcGetDebugThreadContext(regs, ctx->debug, threadId, (ThreadContextControlFlags)controlFlags);
+
+    if(R_FAILED(r) && GDB_IsProcessRunningNonStop(ctx) && R_SUCCEEDED(r = GDB_BreakProcessNonStop(ctx, NULL)))
+    {
+        r = svcGetDebugThreadContext(regs, ctx->debug, threadId, (ThreadContextControlFlags)controlFlags);
+        svcContinueDebugEvent(ctx->debug, ctx->continueFlags);
+    }
+
+    return r;
+}
+
+Result GDB_SetThreadContext(GDBContext *ctx, u32 threadId, ThreadContext *regs, u32 controlFlags)
+{
+    Result r = svcSetDebugThreadContext(ctx->debug, threadId, regs, (ThreadContextControlFlags)controlFlags);
+    GDB_InvalidateThreadSnapshot(ctx, threadId, THREADSNAPSHOT_CONTEXT);
+
+    if(R_FAILED(r) && GDB_IsProcessRunningNonStop(ctx) && R_SUCCEEDED(r = GDB_BreakProcessNonStop(ctx, NULL)))
+    {
+        r = svcSetDebugThreadContext(ctx->debug, threadId, regs, (ThreadContextControlFlags)controlFlags);
+        svcContinueDebugEvent(ctx->debug, ctx->continueFlags);
+    }
+
+    return r;
+}
+
+static void GDB_InterruptNonStop(GDBContext *ctx)
+{
+    DebugEventInfo info;
+    u32 threadIds[MAX_DEBUG_THREAD];
+    u32 nbThreads = 0;
+
+    if(!GDB_IsProcessRunningNonStop(ctx) || R_FAILED(GDB_BreakProcessNonStop(ctx, &info)))
+        return;
+
+    // Prefer the threads that were running when the process was stopped
+    for(u32 i = 0; i < 4; i++)
+    {
+        ThreadInfo *thread = GDB_FindThreadInfo(ctx, (u32)info.exception.debugger_break.thread_ids[i]);
+        if(info.exception.debugger_break.thread_ids[i] > 0 && thread != NULL && !thread->stopped)
+            threadIds[nbThreads++] = thread->id;
+    }
+
+    for(u32 i = 0; i < ctx->nbThreads && nbThreads == 0; i++)
+    {
+        if(!ctx->threadInfos[i].stopped)
+            threadIds[nbThreads++] = ctx->threadInfos[i].id;
+    }
+
+    if(nbThreads != 0)
+    {
+        u32 threadId = GDB_GetCurrentThreadFromList(ctx, threadIds, nbThreads);
+        if(R_SUCCEEDED(GDB_SetThreadStopped(ctx, GDB_FindThreadInfo(ctx, threadId), true)))
+            GDB_QueueThreadStoppedEvent(ctx, threadId, EXCEVENT_DEBUGGER_BREAK);
+    }
+
+    svcContinueDebugEvent(ctx->debug, ctx->continueFlags);
+}
+
+static int GDB_ContinueNonStop(GDBContext *ctx)
+{
+    // vCont actions apply to the threads no previous action applied to. Threads with stop events
+    // that haven't been reported yet are kept stopped.
+    u32 handledThreadIds[MAX_DEBUG_THREAD];
+    u32 nbHandledThreads = 0;
+    bool resumeProcess = false;
+    const char *pos = ctx->commandData;
+
+    while(pos != NULL && *pos != 0)
+    {
+        char action = *pos;
+        u32 pid = ctx->pid, tid = 0;
+
+        if(action != 'c' && action != 'C' && action != 't')
+            return GDB_ReplyErrno(ctx, EPERM);
+
+        pos += action == 'C' ? 3 : 1; // signal ignored
+        if(*pos == ':')
+        {
+            pos = GDB_ParseThreadId(ctx, &pid, &tid, pos + 1, ';');
+            if(pos == NULL)
+                return GDB_ReplyErrno(ctx, EILSEQ);
+            else if(pid != (u32)-1 && pid != ctx->pid)
+                return GDB_ReplyErrno(ctx, EPERM);
+        }
+
+        if(*pos != ';' && *pos != 0)
+            return GDB_ReplyErrno(ctx, EILSEQ);
+
+        for(u32 i = 0; i < ctx->nbThreads; i++)
+        {
+            ThreadInfo *thread = &ctx->threadInfos[i];
+            u32 j;
+
+            for(j = 0; j < nbHandledThreads && handledThreadIds[j] != thread->id; j++);
+            if(j < nbHandledThreads || (tid != 0 && thread->id != tid))
+                continue;
+
+            handledThreadIds[nbHandledThreads++] = thread->id;
+            if(action == 't')
+            {
+                if(!thread->stopped && R_SUCCEEDED(GDB_SetThreadStopped(ctx, thread, true)))
+                    GDB_QueueThreadStoppedEvent(ctx, thread->id, EXCEVENT_ATTACH_BREAK);
+            }
+            else
+            {
+                if(!GDB_IsStopEventQueued(ctx, thread->id, 1))
+                    GDB_SetThreadStopped(ctx, thread, false);
+                resumeProcess = true;
+            }
+        }
+
+        if(*pos == ';')
+            pos++;
+    }
+
+    if(resumeProcess && !(ctx->flags & GDB_FLAG_PROCESS_CONTINUING))
+        GDB_ContinueExecution(ctx);
+
+    return GDB_ReplyOk(ctx);
+}
+
+static int GDB_SendNonStopStopReason(GDBContext *ctx)
+{
+    // Report every stopped thread: the first one here, the others through vStopped
+    char buffer[GDB_BUF_LEN + 1];
+    ctx->stopNotificationPending = true;
+
+    for(u32 i = 0; i < ctx->nbThreads; i++)
+    {
+        ThreadInfo *thread = &ctx->threadInfos[i];
+        if((thread->stopped || !GDB_IsProcessRunningNonStop(ctx)) && !GDB_IsStopEventQueued(ctx, thread->id, 0))
+            GDB_QueueThreadStoppedEvent(ctx, thread->id, EXCEVENT_ATTACH_BREAK);
+    }
+
+    if(ctx->nbStopEvents == 0)
+    {
+        ctx->stopNotificationPending = false;
+        return GDB_ReplyOk(ctx);
+    }
+
+    return GDB_SendPacket(ctx, buffer, GDB_FormatStopReply(ctx, buffer, GDB_GetStopEvent(ctx, 0)));
+}
+
+static int GDB_SendAttachReply(GDBContext *ctx)
+{
+    if(!(ctx->flags & GDB_FLAG_NONSTOP))
+        return GDB_SendStopReply(ctx, &ctx->latestDebugEvent);
+
+    // GDB asks for the state of the threads with '?'
+    GDB_SwitchToNonStop(ctx);
+    return GDB_ReplyOk(ctx);
+}
+
+void GDB_SwitchToNonStop(GDBContext *ctx)
+{
+    ctx->flags |= GDB_FLAG_NONSTOP;
+
+    if(ctx->debug == 0 || (ctx->flags & GDB_FLAG_PROCESS_CONTINUING))
+        return;
+
+    // Like gdbserver, keep all the threads stopped after attaching. On failure, the whole process stays stopped
+    for(u32 i = 0; i < ctx->nbThreads; i++)
+    {
+        if(R_FAILED(GDB_SetThreadStopped(ctx, &ctx->threadInfos[i], true)))
+            return;
+    }
+
+    GDB_ContinueExecution(ctx);
+}
+
+void GDB_ResetNonStopState(GDBContext *ctx)
+{
+    for(u32 i = 0; i < ctx->nbThreads; i++)
+        GDB_SetThreadStopped(ctx, &ctx->threadInfos[i], false);
+
+    ctx->stopEventQueueStart = ctx->nbStopEvents = 0;
+    ctx->stopNotificationPending = false;
+}
+
+GDB_DECLARE_VERBOSE_HANDLER(Stopped)
+{
+    char buffer[GDB_BUF_LEN + 1];
+
+    if(!(ctx->flags & GDB_FLAG_NONSTOP))
+        return GDB_HandleUnsupported(ctx);
+
+    // The first event has been acknowledged
+    if(ctx->nbStopEvents != 0)
+    {
+        ctx->stopEventQueueStart = (ctx->stopEventQueueStart + 1) % MAX_STOP_EVENT;
+        ctx->nbStopEvents--;
+    }
+
+    if(ctx->nbStopEvents == 0)
+    {
+        ctx->stopNotificationPending = false;
+        return GDB_ReplyOk(ctx);
+    }
+
+    return GDB_SendPacket(ctx, buffer, GDB_FormatStopReply(ctx, buffer, GDB_GetStopEvent(ctx, 0)));
+}
+
+GDB_DECLARE_VERBOSE_HANDLER(CtrlC)
+{
+    if(ctx->flags & GDB_FLAG_NONSTOP)
+        GDB_InterruptNonStop(ctx);
+    else
+        GDB_HandleBreak(ctx);
+
+    return GDB_ReplyOk(ctx);
+}
+
+GDB_DECLARE_QUERY_HANDLER(NonStop)
+{
+    if(strcmp(ctx->commandData, "1") == 0)
+    {
+        GDB_SwitchToNonStop(ctx);
+        return GDB_ReplyOk(ctx);
+    }
+    else if(strcmp(ctx->commandData, "0") == 0)
+    {
+        // GDB doesn't allow changing modes while the process is running
+        if((ctx->flags & GDB_FLAG_NONSTOP) && ctx->debug != 0)
+            return GDB_ReplyErrno(ctx, EPERM);
+
+        ctx->flags &= ~GDB_FLAG_NONSTOP;
+        return GDB_ReplyOk(ctx);
+    }
+    else
+        return GDB_ReplyErrno(ctx, EILSEQ);
+}
@@ -165,25 +165,21 @@ u32 GDB_WriteTargetMemory(GDBContext *ctx, const void *in, u32 addr, u32 len)
 
 int GDB_SendMemory(GDBContext *ctx, const char *prefix, u32 prefixLen, u32 addr, u32 len)
 {
-    char buf[GDB_BUF_LEN];
-    u8 membuf[GDB_BUF_LEN / 2];
-
-    if(prefix != NULL)
-        memcpy(buf, prefix, prefixLen);
-    else
+    if(prefix == NULL)
+    {
+        prefix = "";
         prefixLen = 0;
+    }
 
-    if(prefixLen + 2 * len > GDB_BUF_LEN) // gdb shouldn't send requests which responses don't fit in a packet
-        return prefix == NULL ? GDB_ReplyErrno(ctx, ENOMEM) : -1;
+    // gdb shouldn't send requests which responses don't fit in a packet
+    if(prefixLen > ctx->bufferSize || len > (ctx->bufferSize - prefixLen) / 2)
+        return prefixLen == 0 ? GDB_ReplyErrno(ctx, ENOMEM) : -1;
 
-    u32 total = GDB_ReadTargetMemory(membuf, ctx, addr, len);
+    u32 total = GDB_ReadTargetMemory(ctx->workBuffer, ctx, addr, len);
     if(total == 0)
-        return prefix == NULL ? GDB_ReplyErrno(ctx, EFAULT) : -EFAULT;
+        return prefixLen == 0 ? GDB_ReplyErrno(ctx, EFAULT) : -EFAULT;
     else
-    {
-        GDB_EncodeHex(buf + prefixLen, membuf, total);
-        return GDB_SendPacket(ctx, buf, prefixLen + 2 * total);
-    }
+        return GDB_SendPrefixedHexPacket(ctx, prefix, prefixLen, ctx->workBuffer, total);
 }
 
 int GDB_WriteMemory(GDBContext *ctx, const void *buf, u32 addr, u32 len)
@@ -195,47 +191,201 @@ int GDB_WriteMemory(GDBContext *ctx, const void *buf, u32 addr, u32 len)
         return GDB_ReplyOk(ctx);
 }
 
-u32 GDB_SearchMemory(bool *found, GDBContext *ctx, u32 addr, u32 len, const void *pattern, u32 patternLen)
+typedef struct GDBMemorySearch
 {
-    u8 buf[0x1000 + 0x1000 * ((GDB_BUF_LEN + 0xFFF) / 0x1000)];
-    u32 maxNbPages = 1 + ((GDB_BUF_LEN + 0xFFF) / 0x1000);
-    u32 curAddr = addr;
+    const u8 *pattern;
+    u32 patternLen;
+    u64 searchFrom; // lowest address a match can still start at
+    u64 searchEnd;
+    u32 *foundAddrs;
+    u32 maxFound;
+    u32 nbFound;
+} GDBMemorySearch;
+
+static const u8 *GDB_FindPattern(const u8 *pos, const u8 *last, const u8 *pattern, u32 patternLen)
+{
+    // Looks for the first byte of the pattern one word at a time, only candidates are compared in full
+    u8 first = pattern[0];
+    u32 firstMask = first * 0x01010101u;
 
-    s64 TTBCR;
-    svcGetSystemInfo(&TTBCR, 0x10002, 0);
-    while(curAddr < addr + len)
+    for(; pos < last && ((uintptr_t)pos & 3) != 0; pos++)
     {
-        u32 nbPages;
-        u32 addrBase = curAddr & ~0xFFF, addrDispl = curAddr & 0xFFF;
+        if(*pos == first && memcmp(pos, pattern, patternLen) == 0)
+            return pos;
+    }
 
-        for(nbPages = 0; nbPages < maxNbPages; nbPages++)
+    for(; pos + 4 <= last; pos += 4)
+    {
+        u32 word = *(const u32 *)pos ^ firstMask;
+        if(((word - 0x01010101u) & ~word & 0x80808080u) == 0)
+            continue;
+
+        for(u32 i = 0; i < 4; i++)
         {
-            if(addr >= (1u << (32 - (u32)TTBCR)))
-            {
-                u32 PA = svcConvertVAToPA((const void *)addr, false);
-                if(PA == 0 || (PA >= 0x10000000 && PA <= 0x18000000))
-                    break;
-            }
+            if(pos[i] == first && memcmp(pos + i, pattern, patternLen) == 0)
+                return pos + i;
+        }
+    }
 
-            if(R_FAILED(GDB_ReadTargetMemoryInPage(buf + 0x1000 * nbPages, ctx, addrBase + nbPages * 0x1000, 0x1000)))
-                break;
+    for(; pos < last; pos++)
+    {
+        if(*pos == first && memcmp(pos, pattern, patternLen) == 0)
+            return pos;
+    }
+
+    return NULL;
+}
+
+// Searches a readable view of target memory starting at viewAddr, which must not be past search->searchFrom
+static bool GDB_SearchMemoryView(GDBMemorySearch *search, u32 viewAddr, const u8 *view, u32 viewSize)
+{
+    u64 end = (u64)viewAddr + viewSize;
+    end = end < search->searchEnd ? end : search->searchEnd;
+    if(search->searchFrom + search->patternLen > end)
+        return true;
+
+    const u8 *pos = view + (u32)(search->searchFrom - viewAddr);
+    const u8 *last = view + (u32)(end - search->patternLen - viewAddr) + 1;
+    while((pos = GDB_FindPattern(pos, last, search->pattern, search->patternLen)) != NULL)
+    {
+        search->foundAddrs[search->nbFound++] = viewAddr + (pos - view);
+        if(search->nbFound == search->maxFound)
+            return false;
+        pos++;
+    }
+
+    search->searchFrom = end - search->patternLen + 1;
+    return true;
+}
+
+static bool GDB_SearchCopiedMemory(GDBMemorySearch *search, GDBContext *ctx, u32 userEnd, u64 start, u64 end)
+{
+    // Pages which can't be mapped are copied one at a time, along with the end of the previous page
+    // so that matches can span both. Only patterns of up to a page can span more than two pages, though
+    // Too large for the socket thread's stack; searches are only ever done by that thread
+    static u8 buf[0x2000];
+    u32 maxCarry = search->patternLen - 1 < 0x1000 ? search->patternLen - 1 : 0x1000;
+    u32 carry = 0;
+
+    for(u64 page = start & ~0xFFFull; page < end; page += 0x1000)
+    {
+        bool readable = true;
+        if(page >= userEnd)
+        {
+            u32 PA = svcConvertVAToPA((const void *)(u32)page, false);
+            readable = PA != 0 && (PA < 0x10000000 || PA >= 0x18000000);
         }
 
-        u8 *pos = NULL;
-        if(addrDispl + patternLen <= 0x1000 * nbPages)
-            pos = memsearch(buf + addrDispl, pattern, 0x1000 * nbPages - addrDispl, patternLen);
+        if(!readable || R_FAILED(GDB_ReadTargetMemoryInPage(buf + carry, ctx, (u32)page, 0x1000)))
+        {
+            carry = 0;
+            continue;
+        }
+
+        u32 viewAddr = (u32)page - carry;
+        if(search->searchFrom < viewAddr)
+            search->searchFrom = viewAddr;
+        if(!GDB_SearchMemoryView(search, viewAddr, buf, carry + 0x1000))
+            return false;
+
+        u32 newCarry = carry + 0x1000 < maxCarry ? carry + 0x1000 : maxCarry;
+        memmove(buf, buf + carry + 0x1000 - newCarry, newCarry);
+        carry = newCarry;
+    }
 
-        if(pos != NULL)
+    return true;
+}
+
+static bool GDB_SearchMappedMemory(GDBMemorySearch *search, GDBContext *ctx, Handle process, u64 start, u64 end)
+{
+    // Map as much of the (readable) range as fits in the window, successive windows overlap by less than the pattern length
+    u64 mapEnd = (end + 0xFFF) & ~0xFFFull;
+    if(search->searchFrom < start)
+        search->searchFrom = start;
+
+    while(search->searchFrom + search->patternLen <= end)
+    {
+        u32 chunkAddr = (u32)search->searchFrom & ~0xFFF;
+        u32 chunkSize = mapEnd - chunkAddr > GDB_SEARCH_WINDOW_SIZE ? GDB_SEARCH_WINDOW_SIZE : (u32)(mapEnd - chunkAddr);
+
+        bool more;
+        if(R_SUCCEEDED(svcMapProcessMemoryEx(process, GDB_SEARCH_WINDOW_ADDRESS, chunkAddr, chunkSize)))
+        {
+            more = GDB_SearchMemoryView(search, chunkAddr, (const u8 *)GDB_SEARCH_WINDOW_ADDRESS, chunkSize);
+            svcUnmapProcessMemoryEx(process, GDB_SEARCH_WINDOW_ADDRESS, chunkSize);
+        }
+        else
+            more = GDB_SearchCopiedMemory(search, ctx, 0xFFFFFFFF, chunkAddr, (u64)chunkAddr + chunkSize);
+
+        if(!more)
+            return false;
+        if((u64)chunkAddr + chunkSize >= mapEnd)
+            break;
+    }
+
+    return true;
+}
+
+static bool GDB_IsSearchableRegion(const MemInfo *mem)
+{
+    return mem->state != MEMSTATE_FREE && mem->state != MEMSTATE_IO && (mem->perm & MEMPERM_READ) != 0;
+}
+
+u32 GDB_SearchMemory(u32 *foundAddrs, u32 maxFound, GDBContext *ctx, u32 addr, u32 len, const void *pattern, u32 patternLen)
+{
+    GDBMemorySearch search = {
+        .pattern = (const u8 *)pattern,
+        .patternLen = patternLen,
+        .searchFrom = addr,
+        .searchEnd = (u64)addr + len,
+        .foundAddrs = foundAddrs,
+        .maxFound = maxFound,
+        .nbFound = 0,
+    };
+
+    if(patternLen == 0 || patternLen > GDB_SEARCH_WINDOW_SIZE / 2 || maxFound == 0)
+        return 0;
+
+    s64 TTBCR;
+    svcGetSystemInfo(&TTBCR, 0x10002, 0);
+    u32 userEnd = 1u << (32 - (u32)TTBCR);
+
+    Handle process = 0;
+    if(addr < userEnd && R_FAILED(svcOpenProcess(&process, ctx->pid)))
+        process = 0;
+
+    // Walk the process memory map, searching runs of adjacent readable regions with as few mappings as possible
+    u64 cur = addr;
+    bool more = true;
+    while(more && cur < search.searchEnd && cur < userEnd && process != 0)
+    {
+        MemInfo mem;
+        PageInfo pageInfo;
+        if(R_FAILED(svcQueryProcessMemory(&mem, &pageInfo, process, (u32)cur)))
+            break;
+
+        u64 runEnd = (u64)mem.base_addr + mem.size;
+        if(GDB_IsSearchableRegion(&mem))
         {
-            *found = true;
-            return addrBase + (pos - buf);
+            while(runEnd < search.searchEnd && runEnd < userEnd &&
+                R_SUCCEEDED(svcQueryProcessMemory(&mem, &pageInfo, process, (u32)runEnd)) && GDB_IsSearchableRegion(&mem))
+                runEnd = (u64)mem.base_addr + mem.size;
+
+            more = GDB_SearchMappedMemory(&search, ctx, process, cur, runEnd < search.searchEnd ? runEnd : search.searchEnd);
         }
 
-        curAddr = addrBase + 0x1000;
+        cur = runEnd;
     }
 
-    *found = false;
-    return 0;
+    if(process != 0)
+        svcCloseHandle(process);
+    else if(more && cur < userEnd)
+        more = GDB_SearchCopiedMemory(&search, ctx, userEnd, cur, search.searchEnd < userEnd ? search.searchEnd : userEnd);
+
+    if(more && search.searchEnd > userEnd)
+        GDB_SearchCopiedMemory(&search, ctx, userEnd, cur > userEnd ? cur : userEnd, search.searchEnd);
+
+    return search.nbFound;
 }
 
 GDB_DECLARE_HANDLER(ReadMemory)
@@ -250,6 +400,28 @@ GDB_DECLARE_HANDLER(ReadMemory)
     return GDB_SendMemory(ctx, NULL, 0, addr, len);
 }
 
+GDB_DECLARE_HANDLER(ReadMemoryRaw)
+{
+    u32 lst[2];
+    if(GDB_ParseHexIntegerList(lst, ctx->commandData, 2, 0) == NULL)
+        return GDB_ReplyErrno(ctx, EILSEQ);
+
+    u32 addr = lst[0];
+    u32 len = lst[1];
+
+    // The reply is allowed to be shorter than requested, and "b" alone is the reply to a 0-length read
+    len = len > ctx->bufferSize - 1 ? ctx->bufferSize - 1 : len;
+    if(len == 0)
+        return GDB_SendPacket(ctx, "b", 1);
+
+    u32 total = GDB_ReadTargetMemory(ctx->workBuffer, ctx, addr, len);
+    if(total == 0)
+        return GDB_ReplyErrno(ctx, EFAULT);
+
+    u32 sentCount;
+    return GDB_SendPrefixedBinaryPacket(ctx, &sentCount, "b", 1, ctx->workBuffer, total);
+}
+
 GDB_DECLARE_HANDLER(WriteMemory)
 {
     u32 lst[2];
@@ -261,16 +433,15 @@ GDB_DECLARE_HANDLER(WriteMemory)
     u32 addr = lst[0];
     u32 len = lst[1];
 
-    if(dataStart + 2 * len >= ctx->buffer + 4 + GDB_BUF_LEN)
+    if(len > ctx->bufferSize / 2 || dataStart + 2 * len >= ctx->buffer + 4 + ctx->bufferSize)
         return GDB_ReplyErrno(ctx, ENOMEM);
 
-    u8 data[GDB_BUF_LEN / 2];
-    u32 n = GDB_DecodeHex(data, dataStart, len);
+    u32 n = GDB_DecodeHex(ctx->workBuffer, dataStart, len);
 
     if(n != len)
         return GDB_ReplyErrno(ctx, EILSEQ);
 
-    return GDB_WriteMemory(ctx, data, addr, len);
+    return GDB_WriteMemory(ctx, ctx->workBuffer, addr, len);
 }
 
 GDB_DECLARE_HANDLER(WriteMemoryRaw)
@@ -284,26 +455,25 @@ GDB_DECLARE_HANDLER(WriteMemoryRaw)
     u32 addr = lst[0];
     u32 len = lst[1];
 
-    if(dataStart + len >= ctx->buffer + 4 + GDB_BUF_LEN)
+    if(len > ctx->bufferSize)
         return GDB_ReplyErrno(ctx, ENOMEM);
 
-    u8 data[GDB_BUF_LEN];
-    u32 n = GDB_UnescapeBinaryData(data, dataStart, len);
+    // Escaped data is never shorter than what it decodes to, and the packet fits in the work buffer
+    u32 n = GDB_UnescapeBinaryData(ctx->workBuffer, dataStart, ctx->commandEnd - dataStart);
 
     if(n != len)
-        return GDB_ReplyErrno(ctx, n);
+        return GDB_ReplyErrno(ctx, EILSEQ);
 
-    return GDB_WriteMemory(ctx, data, addr, len);
+    return GDB_WriteMemory(ctx, ctx->workBuffer, addr, len);
 }
 
 GDB_DECLARE_QUERY_HANDLER(SearchMemory)
 {
     u32 lst[2];
     u32 addr, len;
-    u8 pattern[GDB_BUF_LEN];
+    u8 *pattern = ctx->workBuffer;
     const char *patternStart;
     u32 patternLen;
-    bool found;
     u32 foundAddr;
 
     if(strncmp(ctx->commandData, "memory:", 7) != 0)
@@ -322,9 +492,7 @@ GDB_DECLARE_QUERY_HANDLER(SearchMemory)
 
     patternLen = GDB_UnescapeBinaryData(pattern, patternStart, patternLen);
 
-    foundAddr = GDB_SearchMemory(&found, ctx, addr, len, patternStart, patternLen);
-
-    if(found)
+    if(GDB_SearchMemory(&foundAddr, 1, ctx, addr, len, pattern, patternLen) != 0)
         return GDB_SendFormattedPacket(ctx, "1,%x", foundAddr);
     else
         return GDB_SendPacket(ctx, "0", 1);
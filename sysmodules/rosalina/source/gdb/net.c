@@ -61,9 +61,8 @@ u32 GDB_EscapeBinaryData(u32 *encodedCount, void *dst, const void *src, u32 len,
     u8 *dst8 = (u8 *)dst;
     const u8 *src8 = (const u8 *)src;
 
-    maxLen = maxLen >= len ? len : maxLen;
-
-    while((uintptr_t)dst8 < (uintptr_t)dst + maxLen)
+    // maxLen bounds the output: escaped bytes take two bytes of it
+    while((uintptr_t)src8 < (uintptr_t)src + len && (uintptr_t)dst8 < (uintptr_t)dst + maxLen)
     {
         if(*src8 == '$' || *src8 == '#' || *src8 == '}' || *src8 == '*')
         {
@@ -171,75 +170,134 @@ const char *GDB_ParseHexIntegerList64(u64 *dst, const char *src, u32 nb, char la
     return GDB_ParseIntegerList64(dst, src, nb, ',', lastSep, 16, false);
 }
 
-int GDB_ReceivePacket(GDBContext *ctx)
+static void GDB_DiscardReceivedData(GDBContext *ctx, u32 size)
+{
+    // Only pipelined data, if any, has to be moved back
+    ctx->receivedSize -= size;
+    if(ctx->receivedSize != 0)
+        memmove(ctx->buffer, ctx->buffer + size, ctx->receivedSize);
+    ctx->scannedSize = 0;
+}
+
+static int GDB_SendAck(GDBContext *ctx, const char *ack)
 {
-    char backupbuf[GDB_BUF_LEN + 4];
-    memcpy(backupbuf, ctx->buffer, ctx->latestSentPacketSize);
-    memset(ctx->buffer, 0, sizeof(ctx->buffer));
+    if(ctx->flags & GDB_FLAG_NOACK)
+        return 0;
+
+    return socSend(ctx->super.sockfd, ack, 1, 0) == 1 ? 0 : -1;
+}
 
-    int r = socRecv(ctx->super.sockfd, ctx->buffer, sizeof(ctx->buffer), MSG_PEEK);
+int GDB_ReceivePacket(GDBContext *ctx)
+{
+    // Packets are framed in place by GDB_FramePacket, a single recv is enough
+    u32 bufferSize = ctx->bufferSize + 4;
+    int r = socRecv(ctx->super.sockfd, ctx->buffer + ctx->receivedSize, bufferSize - ctx->receivedSize, 0);
     if(r < 1)
         return -1;
-    if(ctx->buffer[0] == '+') // GDB sometimes acknowleges TCP acknowledgment packets (yes...). IDA does it properly
-    {
-        if(ctx->flags & GDB_FLAG_NOACK)
-            return -1;
-
-        // Consume it
-        r = socRecv(ctx->super.sockfd, ctx->buffer, 1, 0);
-        if(r != 1)
-            return -1;
 
-        ctx->buffer[0] = 0;
+    ctx->receivedSize += r;
+    return r;
+}
 
-        r = socRecv(ctx->super.sockfd, ctx->buffer, sizeof(ctx->buffer), MSG_PEEK);
+int GDB_FramePacket(GDBContext *ctx)
+{
+    u32 bufferSize = ctx->bufferSize + 4;
 
-        if(r == -1)
-            goto packet_error;
-    }
-    else if(ctx->buffer[0] == '-')
+    // The packet handled last is only discarded now, handlers work in place on the receive buffer
+    if(ctx->packetSize != 0)
     {
-        socSend(ctx->super.sockfd, backupbuf, ctx->latestSentPacketSize, 0);
-        return 0;
+        GDB_DiscardReceivedData(ctx, ctx->packetSize);
+        ctx->packetSize = 0;
     }
-    int maxlen = r > (int)sizeof(ctx->buffer) ? (int)sizeof(ctx->buffer) : r;
 
-    if(ctx->buffer[0] == '$') // normal packet
+    while(ctx->receivedSize > 0)
     {
-        char *pos;
-        for(pos = ctx->buffer; pos < ctx->buffer + maxlen && *pos != '#'; pos++);
-
-        if(pos == ctx->buffer + maxlen) // malformed packet
-            return -1;
-
-        else
+        char *buf = ctx->buffer;
+        if(ctx->oversizedPacketTrailerLeft != 0)
         {
-            u8 checksum;
-            r = socRecv(ctx->super.sockfd, ctx->buffer, 3 + pos - ctx->buffer, 0);
-            if(r != 3 + pos - ctx->buffer || GDB_DecodeHex(&checksum, pos + 1, 1) != 1)
-                goto packet_error;
-            else if(GDB_ComputeChecksum(ctx->buffer + 1, pos - ctx->buffer - 1) != checksum)
-                goto packet_error;
+            // Drop the rest of an oversized packet up to and including its checksum before NAKing it, as its data
+            // may contain bytes that would otherwise be taken for an interrupt, a NAK or the start of a packet
+            u32 n = 0;
+            if(ctx->oversizedPacketTrailerLeft == 3)
+            {
+                char *pos = (char *)memchr(buf, '#', ctx->receivedSize);
+                if(pos == NULL)
+                {
+                    GDB_DiscardReceivedData(ctx, ctx->receivedSize);
+                    continue;
+                }
+
+                n = pos + 1 - buf;
+                ctx->oversizedPacketTrailerLeft = 2;
+            }
+
+            u32 checksumSize = ctx->receivedSize - n;
+            if(checksumSize > ctx->oversizedPacketTrailerLeft)
+                checksumSize = ctx->oversizedPacketTrailerLeft;
+
+            ctx->oversizedPacketTrailerLeft -= checksumSize;
+            GDB_DiscardReceivedData(ctx, n + checksumSize);
+            if(ctx->oversizedPacketTrailerLeft == 0 && GDB_SendAck(ctx, "-") != 0)
+                return -1;
+        }
+        else if(buf[0] == '$') // normal packet
+        {
+            u32 scanPos = ctx->scannedSize > 1 ? ctx->scannedSize : 1;
+            char *pos = (char *)memchr(buf + scanPos, '#', ctx->receivedSize - scanPos);
+            if(pos == NULL || pos + 3 > buf + ctx->receivedSize)
+            {
+                ctx->scannedSize = pos == NULL ? ctx->receivedSize : (u32)(pos - buf);
+                if(ctx->receivedSize < bufferSize && (pos == NULL || pos + 3 <= buf + bufferSize))
+                    return 0; // wait for the rest of the packet
+
+                // Malformed (too large) packet, its trailer ('#' and checksum) may not have been received yet
+                ctx->oversizedPacketTrailerLeft = pos == NULL ? 3 : (u32)(pos + 3 - (buf + ctx->receivedSize));
+                GDB_DiscardReceivedData(ctx, ctx->receivedSize);
+                continue;
+            }
 
+            u8 checksum;
+            u32 packetSize = pos + 3 - buf;
+            if(GDB_DecodeHex(&checksum, pos + 1, 1) != 1 || GDB_ComputeChecksum(buf + 1, pos - buf - 1) != checksum)
+            {
+                GDB_DiscardReceivedData(ctx, packetSize);
+                if(GDB_SendAck(ctx, "-") != 0)
+                    return -1;
+                continue;
+            }
+
+            ctx->packetSize = packetSize;
             ctx->commandEnd = pos;
             *pos = 0; // replace trailing '#' by a NUL character
+            break;
+        }
+        else if(buf[0] == '\x03')
+        {
+            ctx->packetSize = 1;
+            ctx->commandEnd = buf;
+            break;
+        }
+        else if(buf[0] == '-')
+        {
+            GDB_DiscardReceivedData(ctx, 1);
+            if(ctx->latestSentPacketSize > 0)
+                socSend(ctx->super.sockfd, ctx->sendBuffer, ctx->latestSentPacketSize, 0);
+        }
+        else
+        {
+            // GDB sometimes acknowleges TCP acknowledgment packets (yes...). IDA does it properly
+            // Skip these and any other stray byte
+            u32 n;
+            for(n = 1; n < ctx->receivedSize && buf[n] != '$' && buf[n] != '\x03' && buf[n] != '-'; n++);
+            GDB_DiscardReceivedData(ctx, n);
         }
     }
-    else if(ctx->buffer[0] == '\x03')
-    {
-        r = socRecv(ctx->super.sockfd, ctx->buffer, 1, 0);
-        if(r != 1)
-            goto packet_error;
 
-        ctx->commandEnd = ctx->buffer;
-    }
+    if(ctx->packetSize == 0)
+        return 0;
 
-    if(!(ctx->flags & GDB_FLAG_NOACK))
-    {
-        int r2 = socSend(ctx->super.sockfd, "+", 1, 0);
-        if(r2 != 1)
-            return -1;
-    }
+    if(GDB_SendAck(ctx, "+") != 0)
+        return -1;
 
     if(ctx->noAckSent)
     {
@@ -247,24 +305,12 @@ int GDB_ReceivePacket(GDBContext *ctx)
         ctx->noAckSent = false;
     }
 
-    return r;
-
-packet_error:
-    if(!(ctx->flags & GDB_FLAG_NOACK))
-    {
-        r = socSend(ctx->super.sockfd, "-", 1, 0);
-        if(r != 1)
-            return -1;
-        else
-            return 0;
-    }
-    else
-        return -1;
+    return 1;
 }
 
 static int GDB_DoSendPacket(GDBContext *ctx, u32 len)
 {
-    int r = socSend(ctx->super.sockfd, ctx->buffer, len, 0);
+    int r = socSend(ctx->super.sockfd, ctx->sendBuffer, len, 0);
 
     if(r > 0)
         ctx->latestSentPacketSize = r;
@@ -273,17 +319,38 @@ static int GDB_DoSendPacket(GDBContext *ctx, u32 len)
 
 int GDB_SendPacket(GDBContext *ctx, const char *packetData, u32 len)
 {
-    ctx->buffer[0] = '$';
+    if(len > ctx->bufferSize)
+        return -1;
 
-    memcpy(ctx->buffer + 1, packetData, len);
+    ctx->sendBuffer[0] = '$';
 
-    char *checksumLoc = ctx->buffer + len + 1;
+    memcpy(ctx->sendBuffer + 1, packetData, len);
+
+    char *checksumLoc = ctx->sendBuffer + len + 1;
     *checksumLoc++ = '#';
 
     hexItoa(GDB_ComputeChecksum(packetData, len), checksumLoc, 2, false);
     return GDB_DoSendPacket(ctx, 4 + len);
 }
 
+int GDB_SendNotification(GDBContext *ctx, const char *packetData, u32 len)
+{
+    // Notifications aren't acknowledged: keep the latest sent packet around in case it has to be sent again
+    char *notification = ctx->notificationBuffer;
+    if(len > GDB_BUF_LEN)
+        return -1;
+
+    notification[0] = '%';
+
+    memcpy(notification + 1, packetData, len);
+
+    char *checksumLoc = notification + len + 1;
+    *checksumLoc++ = '#';
+
+    hexItoa(GDB_ComputeChecksum(packetData, len), checksumLoc, 2, false);
+    return socSend(ctx->super.sockfd, notification, 4 + len, 0);
+}
+
 int GDB_SendFormattedPacket(GDBContext *ctx, const char *packetDataFmt, ...)
 {
     // It goes without saying you shouldn't use that with user-controlled data...
@@ -297,19 +364,67 @@ int GDB_SendFormattedPacket(GDBContext *ctx, const char *packetDataFmt, ...)
     else return GDB_SendPacket(ctx, buf, (u32)n);
 }
 
-int GDB_SendHexPacket(GDBContext *ctx, const void *packetData, u32 len)
+int GDB_SendPrefixedHexPacket(GDBContext *ctx, const char *prefix, u32 prefixLen, const void *packetData, u32 len)
 {
-    if(4 + 2 * len > GDB_BUF_LEN)
+    if(prefixLen > ctx->bufferSize || len > (ctx->bufferSize - prefixLen) / 2)
         return -1;
 
-    ctx->buffer[0] = '$';
-    GDB_EncodeHex(ctx->buffer + 1, packetData, len);
+    ctx->sendBuffer[0] = '$';
+    memcpy(ctx->sendBuffer + 1, prefix, prefixLen);
+    GDB_EncodeHex(ctx->sendBuffer + 1 + prefixLen, packetData, len);
 
-    char *checksumLoc = ctx->buffer + 2 * len + 1;
+    u32 dataLen = prefixLen + 2 * len;
+    char *checksumLoc = ctx->sendBuffer + dataLen + 1;
     *checksumLoc++ = '#';
 
-    hexItoa(GDB_ComputeChecksum(ctx->buffer + 1, 2 * len), checksumLoc, 2, false);
-    return GDB_DoSendPacket(ctx, 4 + 2 * len);
+    hexItoa(GDB_ComputeChecksum(ctx->sendBuffer + 1, dataLen), checksumLoc, 2, false);
+    return GDB_DoSendPacket(ctx, 4 + dataLen);
+}
+
+int GDB_SendHexPacket(GDBContext *ctx, const void *packetData, u32 len)
+{
+    return GDB_SendPrefixedHexPacket(ctx, "", 0, packetData, len);
+}
+
+static int GDB_FinishBinaryPacket(GDBContext *ctx, u32 prefixLen, u32 encodedCount)
+{
+    u32 dataLen = prefixLen + encodedCount;
+    char *checksumLoc = ctx->sendBuffer + dataLen + 1;
+    *checksumLoc++ = '#';
+
+    hexItoa(GDB_ComputeChecksum(ctx->sendBuffer + 1, dataLen), checksumLoc, 2, false);
+    return GDB_DoSendPacket(ctx, 4 + dataLen);
+}
+
+int GDB_SendPrefixedBinaryPacket(GDBContext *ctx, u32 *sentCount, const char *prefix, u32 prefixLen, const void *packetData, u32 len)
+{
+    if(prefixLen > ctx->bufferSize)
+        return -1;
+
+    // Escaping is done in place; as much data as fits is sent, the caller is told how much
+    u32 encodedCount;
+    ctx->sendBuffer[0] = '$';
+    memcpy(ctx->sendBuffer + 1, prefix, prefixLen);
+    *sentCount = GDB_EscapeBinaryData(&encodedCount, ctx->sendBuffer + 1 + prefixLen, packetData, len, ctx->bufferSize - prefixLen);
+
+    return GDB_FinishBinaryPacket(ctx, prefixLen, encodedCount);
+}
+
+int GDB_SendCountPrefixedBinaryPacket(GDBContext *ctx, u32 *sentCount, const char *prefixFmt, u32 prefixLen, const void *packetData, u32 len)
+{
+    char prefix[32];
+    if(prefixLen >= sizeof(prefix) || prefixLen > ctx->bufferSize)
+        return -1;
+
+    // The prefix holds the number of bytes actually sent, which is only known once the data is escaped
+    u32 encodedCount;
+    ctx->sendBuffer[0] = '$';
+    *sentCount = GDB_EscapeBinaryData(&encodedCount, ctx->sendBuffer + 1 + prefixLen, packetData, len, ctx->bufferSize - prefixLen);
+    if((u32)sprintf(prefix, prefixFmt, *sentCount) != prefixLen)
+        return -1;
+    memcpy(ctx->sendBuffer + 1, prefix, prefixLen);
+
+    return GDB_FinishBinaryPacket(ctx, prefixLen, encodedCount);
 }
 
 int GDB_SendStreamData(GDBContext *ctx, const char *streamData, u32 offset, u32 length, u32 totalSize, bool forceEmptyLast)
@@ -339,8 +454,8 @@ int GDB_SendDebugString(GDBContext *ctx, const char *fmt, ...) // unsecure
         return 0;*/
 
     char formatted[(GDB_BUF_LEN - 1) / 2 + 1];
-    ctx->buffer[0] = '$';
-    ctx->buffer[1] = 'O';
+    ctx->sendBuffer[0] = '$';
+    ctx->sendBuffer[1] = 'O';
 
     va_list args;
     va_start(args, fmt);
@@ -348,12 +463,12 @@ int GDB_SendDebugString(GDBContext *ctx, const char *fmt, ...) // unsecure
     va_end(args);
 
     if(n <= 0) return n;
-    GDB_EncodeHex(ctx->buffer + 2, formatted, 2 * n);
+    GDB_EncodeHex(ctx->sendBuffer + 2, formatted, 2 * n);
 
-    char *checksumLoc = ctx->buffer + 2 * n + 2;
+    char *checksumLoc = ctx->sendBuffer + 2 * n + 2;
     *checksumLoc++ = '#';
 
-    hexItoa(GDB_ComputeChecksum(ctx->buffer + 1, 2 * n + 1), checksumLoc, 2, false);
+    hexItoa(GDB_ComputeChecksum(ctx->sendBuffer + 1, 2 * n + 1), checksumLoc, 2, false);
 
     return GDB_DoSendPacket(ctx, 5 + 2 * n);
 }
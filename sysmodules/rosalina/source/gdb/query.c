@@ -12,6 +12,7 @@
 #include "gdb/mem.h"
 #include "gdb/net.h"
 #include "gdb/remote_command.h"
+#include "gdb/debug.h"
 
 typedef enum GDBQueryDirection
 {
@@ -36,6 +37,7 @@ static const struct
     GDB_QUERY_HANDLER_LIST_ITEM(Supported, READ),
     GDB_QUERY_HANDLER_LIST_ITEM(Xfer, READ),
     GDB_QUERY_HANDLER_LIST_ITEM(StartNoAckMode, WRITE),
+    GDB_QUERY_HANDLER_LIST_ITEM(NonStop, WRITE),
     GDB_QUERY_HANDLER_LIST_ITEM(Attached, READ),
     GDB_QUERY_HANDLER_LIST_ITEM(fThreadInfo, READ),
     GDB_QUERY_HANDLER_LIST_ITEM(sThreadInfo, READ),
@@ -105,10 +107,10 @@ GDB_DECLARE_QUERY_HANDLER(Supported)
     return GDB_SendFormattedPacket(ctx,
         "PacketSize=%x;"
         "qXfer:features:read+;qXfer:osdata:read+;"
-        "QStartNoAckMode+;QThreadEvents+;QCatchSyscalls+;"
-        "vContSupported+;swbreak+;multiprocess+",
+        "QStartNoAckMode+;QNonStop+;QThreadEvents+;QCatchSyscalls+;"
+        "vContSupported+;swbreak+;multiprocess+;binary-upload+;ConditionalBreakpoints+",
 
-        GDB_BUF_LEN // should have been sizeof(ctx->buffer) but GDB memory functions are bugged
+        ctx->bufferSize // GDB_LARGE_BUF_LEN unless the packet buffers couldn't be allocated
     );
 }
 
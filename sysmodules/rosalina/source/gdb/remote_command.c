@@ -10,6 +10,9 @@
 #include "csvc.h"
 #include "fmt.h"
 #include "gdb/breakpoints.h"
+#include "gdb/debug.h"
+#include "gdb/mem.h"
+#include "memory_scan.h"
 
 #include "../utils.h"
 
@@ -25,6 +28,9 @@ struct
     { "getmemregions"     , GDB_REMOTE_COMMAND_HANDLER(GetMemRegions) },
     { "flushcaches"       , GDB_REMOTE_COMMAND_HANDLER(FlushCaches) },
     { "toggleextmemaccess", GDB_REMOTE_COMMAND_HANDLER(ToggleExternalMemoryAccess) },
+    { "searchmemory"      , GDB_REMOTE_COMMAND_HANDLER(SearchMemory) },
+    { "valuescan"         , GDB_REMOTE_COMMAND_HANDLER(ValueScan) },
+    { "breakpoints"       , GDB_REMOTE_COMMAND_HANDLER(Breakpoints) },
 };
 
 static const char *GDB_SkipSpaces(const char *pos)
@@ -66,7 +72,7 @@ GDB_DECLARE_REMOTE_COMMAND_HANDLER(SyncRequestInfo)
 
     for(id = 0; id < MAX_DEBUG_THREAD && ctx->threadInfos[id].id != ctx->selectedThreadId; id++);
 
-    r = svcGetDebugThreadContext(&regs, ctx->debug, ctx->selectedThreadId, THREADCONTEXT_CONTROL_CPU_REGS);
+    r = GDB_GetThreadContext(&regs, ctx, ctx->selectedThreadId, THREADCONTEXT_CONTROL_CPU_REGS);
 
     if(R_FAILED(r) || id == MAX_DEBUG_THREAD)
     {
@@ -249,6 +255,224 @@ GDB_DECLARE_REMOTE_COMMAND_HANDLER(ToggleExternalMemoryAccess)
     return GDB_SendHexPacket(ctx, outbuf, n);
 }
 
+GDB_DECLARE_REMOTE_COMMAND_HANDLER(SearchMemory)
+{
+    // searchmemory <address> <length> <hex pattern>: lists every match instead of only the first one
+    bool ok;
+    char *end;
+    u32 addr, len, patternLen, nbFound;
+    u8 pattern[GDB_BUF_LEN / 4];
+    u32 foundAddrs[32];
+    int n;
+    char outbuf[GDB_BUF_LEN / 2 + 1];
+
+    addr = xstrtoul(ctx->commandData, &end, 0, true, &ok);
+    if(!ok || end == ctx->commandData)
+        return GDB_ReplyErrno(ctx, EILSEQ);
+
+    const char *pos = GDB_SkipSpaces(end);
+    len = xstrtoul(pos, &end, 0, true, &ok);
+    if(!ok || end == pos)
+        return GDB_ReplyErrno(ctx, EILSEQ);
+
+    pos = GDB_SkipSpaces(end);
+    for(patternLen = 0; pos[2 * patternLen] != 0 && pos[2 * patternLen] != ' '; patternLen++);
+    if(patternLen == 0 || patternLen > sizeof(pattern) || *GDB_SkipSpaces(pos + 2 * patternLen) != 0 ||
+        GDB_DecodeHex(pattern, pos, patternLen) != patternLen)
+        return GDB_ReplyErrno(ctx, EILSEQ);
+
+    nbFound = GDB_SearchMemory(foundAddrs, sizeof(foundAddrs) / sizeof(foundAddrs[0]), ctx, addr, len, pattern, patternLen);
+
+    n = sprintf(outbuf, "%lu match%s%s\n", nbFound, nbFound == 1 ? "" : "es",
+        nbFound == sizeof(foundAddrs) / sizeof(foundAddrs[0]) ? " (search stopped)" : "");
+    for(u32 i = 0; i < nbFound; i++)
+        n += sprintf(outbuf + n, "0x%08lx\n", foundAddrs[i]);
+
+    return GDB_SendHexPacket(ctx, outbuf, n);
+}
+
+typedef struct GDBMemoryScanRegions
+{
+    Handle process;
+    u64 address;
+    u64 end;
+    u32 mappedSize;
+} GDBMemoryScanRegions;
+
+static bool GDB_NextMemoryScanChunk(MemoryScanChunk *chunk, void *userData)
+{
+    GDBMemoryScanRegions *regions = (GDBMemoryScanRegions *)userData;
+    MemInfo mem;
+    PageInfo pageInfo;
+
+    if(regions->mappedSize != 0)
+    {
+        svcUnmapProcessMemoryEx(regions->process, GDB_SEARCH_WINDOW_ADDRESS, regions->mappedSize);
+        regions->mappedSize = 0;
+    }
+
+    // Only memory the target can write to is scanned, one window at a time
+    while(regions->address < regions->end && R_SUCCEEDED(svcQueryProcessMemory(&mem, &pageInfo, regions->process, (u32)regions->address)))
+    {
+        u64 regionEnd = (u64)mem.base_addr + mem.size;
+        if(mem.state == MEMSTATE_FREE || mem.state == MEMSTATE_IO || (mem.perm & MEMPERM_WRITE) == 0)
+        {
+            regions->address = regionEnd;
+            continue;
+        }
+
+        u32 size = regionEnd - regions->address > GDB_SEARCH_WINDOW_SIZE ? GDB_SEARCH_WINDOW_SIZE : (u32)(regionEnd - regions->address);
+        u32 address = (u32)regions->address;
+        regions->address += size;
+
+        if(R_SUCCEEDED(svcMapProcessMemoryEx(regions->process, GDB_SEARCH_WINDOW_ADDRESS, address, size)))
+        {
+            regions->mappedSize = size;
+            chunk->address = address;
+            chunk->size = size;
+            chunk->data = (const void *)GDB_SEARCH_WINDOW_ADDRESS;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static const char *GDB_GetWordEnd(const char *pos)
+{
+    for(; *pos != 0 && !(*pos >= 9 && *pos <= 13) && *pos != ' '; pos++);
+    return pos;
+}
+
+GDB_DECLARE_REMOTE_COMMAND_HANDLER(ValueScan)
+{
+    /*
+        valuescan first <u8|u16|u32|float> <equal|unknown> [value]
+        valuescan next <equal|changed|unchanged|increased|decreased> [value]
+        valuescan list [index]
+        valuescan reset
+
+        Values are integers (float bit patterns for floats)
+    */
+    bool ok = true, hasNumber = false;
+    char *end;
+    int n = 0;
+    char outbuf[GDB_BUF_LEN / 2 + 1];
+    MemoryScanResult results[16]; // 23 bytes per line at most, the whole reply has to fit in half a packet
+    MemoryScanValueType type = MEMSCAN_TYPE_U32;
+    MemoryScanFilter filter = MEMSCAN_FILTER_EQUAL;
+    u32 value = 0, first = 0;
+    Result r = 0;
+
+    const char *pos = ctx->commandData;
+    const char *wordEnd = GDB_GetWordEnd(pos);
+    u32 verbLen = wordEnd - pos;
+    bool isFirst = verbLen == 5 && strncmp(pos, "first", 5) == 0;
+    bool isNext = verbLen == 4 && strncmp(pos, "next", 4) == 0;
+    bool isList = verbLen == 4 && strncmp(pos, "list", 4) == 0;
+
+    pos = GDB_SkipSpaces(wordEnd);
+    if(isFirst)
+    {
+        wordEnd = GDB_GetWordEnd(pos);
+        ok = MemoryScan_ParseType(&type, pos, wordEnd - pos);
+        pos = GDB_SkipSpaces(wordEnd);
+    }
+
+    if(ok && (isFirst || isNext))
+    {
+        wordEnd = GDB_GetWordEnd(pos);
+        ok = MemoryScan_ParseFilter(&filter, pos, wordEnd - pos);
+        pos = GDB_SkipSpaces(wordEnd);
+    }
+
+    if(ok && *pos != 0 && (isFirst || isNext || isList))
+    {
+        u32 val = xstrtoul(pos, &end, 0, true, &ok);
+        if(isList)
+            first = val;
+        else
+            value = val;
+        hasNumber = end != pos;
+        pos = GDB_SkipSpaces(end);
+    }
+
+    bool needsValue = (isFirst || isNext) && filter == MEMSCAN_FILTER_EQUAL;
+    if(!ok || *pos != 0 || (needsValue && !hasNumber) || (!isFirst && !isNext && !isList && !(verbLen == 5 && strncmp(ctx->commandData, "reset", 5) == 0)))
+        return GDB_ReplyErrno(ctx, EILSEQ);
+
+    if(isFirst || isNext)
+    {
+        s64 TTBCR;
+        svcGetSystemInfo(&TTBCR, 0x10002, 0);
+
+        GDBMemoryScanRegions regions = { .address = 0, .end = 1ull << (32 - (u32)TTBCR), .mappedSize = 0 };
+        r = svcOpenProcess(&regions.process, ctx->pid);
+        if(R_FAILED(r))
+        {
+            n = sprintf(outbuf, "Invalid process (wtf?)\n");
+            return GDB_SendHexPacket(ctx, outbuf, n);
+        }
+
+        if(isFirst)
+            r = MemoryScan_FirstScan(ctx->pid, type, filter, value, GDB_NextMemoryScanChunk, &regions);
+        else
+            r = MemoryScan_NextScan(ctx->pid, filter, value, GDB_NextMemoryScanChunk, &regions);
+
+        // The scan can stop before all chunks have been consumed
+        if(regions.mappedSize != 0)
+            svcUnmapProcessMemoryEx(regions.process, GDB_SEARCH_WINDOW_ADDRESS, regions.mappedSize);
+        svcCloseHandle(regions.process);
+    }
+    else if(!isList)
+    {
+        MemoryScan_Reset();
+        return GDB_ReplyOk(ctx);
+    }
+
+    if(R_FAILED(r))
+    {
+        if(R_DESCRIPTION(r) == RD_OUT_OF_MEMORY)
+            n = sprintf(outbuf, "Too many results, try a narrower filter.\n");
+        else if(R_DESCRIPTION(r) == RD_NOT_INITIALIZED)
+            n = sprintf(outbuf, "No scan in progress for this process.\n");
+        else
+            n = sprintf(outbuf, "Scan failed (0x%08lx).\n", (u32)r);
+        return GDB_SendHexPacket(ctx, outbuf, n);
+    }
+
+    if(!MemoryScan_IsActive(ctx->pid, &type))
+    {
+        n = sprintf(outbuf, "No scan in progress for this process.\n");
+        return GDB_SendHexPacket(ctx, outbuf, n);
+    }
+
+    u32 count = MemoryScan_GetResultCount();
+    u32 nbResults = MemoryScan_GetResults(results, first, sizeof(results) / sizeof(results[0]));
+    int valueDigits = type == MEMSCAN_TYPE_U8 ? 2 : type == MEMSCAN_TYPE_U16 ? 4 : 8;
+
+    if(count != 0 && nbResults == 0 && first == 0)
+        n = sprintf(outbuf, "%lu values saved, use \"valuescan next\" to compare them.\n", count);
+    else
+        n = sprintf(outbuf, "%lu result%s\n", count, count == 1 ? "" : "s");
+
+    // Keep room for the "more results" line
+    static const u32 moreResultsLineSize = 48;
+    u32 i;
+    for(i = 0; i < nbResults; i++)
+    {
+        int lineLen = snprintf(outbuf + n, sizeof(outbuf) - n, "0x%08lx: 0x%.*lx\n", results[i].address, valueDigits, results[i].value);
+        if(lineLen < 0 || (u32)(n + lineLen) + moreResultsLineSize >= sizeof(outbuf))
+            break;
+        n += lineLen;
+    }
+
+    if(i != 0 && first + i < count)
+        n += snprintf(outbuf + n, sizeof(outbuf) - n, "More results: \"valuescan list %lu\".\n", first + i);
+
+    return GDB_SendHexPacket(ctx, outbuf, n);
+}
+
 GDB_DECLARE_QUERY_HANDLER(Rcmd)
 {
     char commandData[GDB_BUF_LEN / 2 + 1];
@@ -256,6 +480,8 @@ GDB_DECLARE_QUERY_HANDLER(Rcmd)
     const char *errstr = "Unrecognized command.\n";
     u32 len = strlen(ctx->commandData);
 
+    if(len / 2 >= sizeof(commandData))
+        return GDB_ReplyErrno(ctx, ENOMEM);
     if(len == 0 || (len % 2) == 1 || GDB_DecodeHex(commandData, ctx->commandData, len / 2) != len / 2)
         return GDB_ReplyErrno(ctx, EILSEQ);
     commandData[len / 2] = 0;
@@ -276,3 +502,56 @@ GDB_DECLARE_QUERY_HANDLER(Rcmd)
 
     return GDB_SendHexPacket(ctx, errstr, strlen(errstr));
 }
+
+GDB_DECLARE_REMOTE_COMMAND_HANDLER(Breakpoints)
+{
+    /*
+        breakpoints add <address>...
+        breakpoints remove <address>...
+
+        Sets or clears many breakpoints in a single round-trip. Odd addresses are Thumb.
+    */
+    bool ok = true;
+    char *end;
+    int n;
+    char outbuf[GDB_BUF_LEN / 2 + 1];
+    u32 failedAddrs[32];
+    u32 nbDone = 0, nbFailed = 0;
+
+    const char *pos = ctx->commandData;
+    const char *wordEnd = GDB_GetWordEnd(pos);
+    bool isAdd = wordEnd - pos == 3 && strncmp(pos, "add", 3) == 0;
+    bool isRemove = wordEnd - pos == 6 && strncmp(pos, "remove", 6) == 0;
+
+    if(!isAdd && !isRemove)
+        return GDB_ReplyErrno(ctx, EILSEQ);
+
+    // Validate everything first so that a typo doesn't leave the batch half-applied
+    for(pos = GDB_SkipSpaces(wordEnd); ok && *pos != 0; pos = GDB_SkipSpaces(end))
+    {
+        xstrtoul(pos, &end, 0, true, &ok);
+        ok = ok && end != pos;
+    }
+
+    if(!ok)
+        return GDB_ReplyErrno(ctx, EILSEQ);
+
+    for(pos = GDB_SkipSpaces(wordEnd); *pos != 0; pos = GDB_SkipSpaces(end))
+    {
+        u32 addr = xstrtoul(pos, &end, 0, true, &ok);
+        int r = isAdd ? GDB_AddBreakpoint(ctx, addr, (addr & 1) != 0, false) : GDB_RemoveBreakpoint(ctx, addr);
+
+        if(r == 0)
+            nbDone++;
+        else if(nbFailed < sizeof(failedAddrs) / sizeof(failedAddrs[0]))
+            failedAddrs[nbFailed++] = addr;
+        else
+            nbFailed++;
+    }
+
+    n = sprintf(outbuf, "%lu breakpoint%s %s, %lu failed\n", nbDone, nbDone == 1 ? "" : "s", isAdd ? "set" : "removed", nbFailed);
+    for(u32 i = 0; i < nbFailed && i < sizeof(failedAddrs) / sizeof(failedAddrs[0]); i++)
+        n += sprintf(outbuf + n, "0x%08lx\n", failedAddrs[i]);
+
+    return GDB_SendHexPacket(ctx, outbuf, n);
+}
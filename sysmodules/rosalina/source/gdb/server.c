@@ -14,6 +14,7 @@
 #include "gdb/regs.h"
 #include "gdb/mem.h"
 #include "gdb/hio.h"
+#include "gdb/tio.h"
 #include "gdb/watchpoints.h"
 #include "gdb/breakpoints.h"
 #include "gdb/stop_point.h"
@@ -168,6 +169,11 @@ int GDB_AcceptClient(GDBContext *ctx)
     RecursiveLock_Lock(&ctx->lock);
     ctx->state = GDB_STATE_CONNECTED;
     ctx->latestSentPacketSize = 0;
+    ctx->receivedSize = ctx->scannedSize = ctx->packetSize = 0;
+    ctx->oversizedPacketTrailerLeft = 0;
+
+    // Falls back to GDB_BUF_LEN-sized packets on failure
+    GDB_AllocatePacketBuffers(ctx);
 
     if (ctx->flags & GDB_FLAG_SELECTED)
         r = GDB_AttachToProcess(ctx);
@@ -202,13 +208,12 @@ int GDB_CloseClient(GDBContext *ctx)
     ctx->multiprocessExtEnabled = false;
 
     memset(&ctx->latestDebugEvent, 0, sizeof(DebugEventInfo));
-    memset(ctx->memoryOsInfoXmlData, 0, sizeof(ctx->memoryOsInfoXmlData));
-    memset(ctx->processesOsInfoXmlData, 0, sizeof(ctx->processesOsInfoXmlData));
+    ctx->memoryOsDataGeneration = 0;
+    ctx->processesOsDataGeneration = 0;
+
+    GDB_TioCloseAllFiles(ctx);
 
-    for (u32 i = 0; i < MAX_TIO_OPEN_FILE; i++)
-        IFile_Close(&ctx->openTioFileInfos[i].f);
-    memset(ctx->openTioFileInfos, 0, sizeof(ctx->openTioFileInfos));
-    ctx->numOpenTioFiles = 0;
+    GDB_FreePacketBuffers(ctx);
 
     RecursiveLock_Unlock(&ctx->lock);
     return 0;
@@ -308,6 +313,7 @@ static const struct
     { 'R', GDB_HANDLER(Restart) },
     { 'T', GDB_HANDLER(IsThreadAlive) },
     { 'v', GDB_HANDLER(VerboseCommand) },
+    { 'x', GDB_HANDLER(ReadMemoryRaw) },
     { 'X', GDB_HANDLER(WriteMemoryRaw) },
     { 'z', GDB_HANDLER(ToggleStopPoint) },
     { 'Z', GDB_HANDLER(ToggleStopPoint) },
@@ -323,48 +329,32 @@ static inline GDBCommandHandler GDB_GetCommandHandler(char command)
     return i < nbHandlers ? gdbCommandHandlers[i].handler : GDB_HANDLER(Unsupported);
 }
 
-int GDB_DoPacket(GDBContext *ctx)
+static int GDB_HandlePacket(GDBContext *ctx)
 {
     int ret;
-
-    RecursiveLock_Lock(&ctx->lock);
     u32 oldFlags = ctx->flags;
 
-    if(ctx->state == GDB_STATE_DISCONNECTED)
-        return -1;
-
-    int r = GDB_ReceivePacket(ctx);
-    if(r == 0)
-        ret = 0;
-    else if(r == -1)
-        ret = -1;
-    else if(ctx->buffer[0] == '\x03')
+    if(ctx->buffer[0] == '\x03')
     {
         GDB_HandleBreak(ctx);
         ret = 0;
     }
-    else if(ctx->buffer[0] == '$')
+    else
     {
         GDBCommandHandler handler = GDB_GetCommandHandler(ctx->buffer[1]);
         ctx->commandData = ctx->buffer + 2;
         ret = handler(ctx);
     }
-    else
-        ret = 0;
 
     if(ctx->state == GDB_STATE_DETACHING)
     {
         if(ctx->flags & GDB_FLAG_EXTENDED_REMOTE)
         {
             ctx->state = GDB_STATE_CONNECTED;
-            RecursiveLock_Unlock(&ctx->lock);
             return ret;
         }
         else
-        {
-            RecursiveLock_Unlock(&ctx->lock);
             return -1;
-        }
     }
 
     if((oldFlags & GDB_FLAG_PROCESS_CONTINUING) && !(ctx->flags & GDB_FLAG_PROCESS_CONTINUING))
@@ -375,6 +365,26 @@ int GDB_DoPacket(GDBContext *ctx)
     else if(!(oldFlags & GDB_FLAG_PROCESS_CONTINUING) && (ctx->flags & GDB_FLAG_PROCESS_CONTINUING))
         svcSignalEvent(ctx->continuedEvent);
 
+    return ret;
+}
+
+int GDB_DoPacket(GDBContext *ctx)
+{
+    int ret, r;
+
+    RecursiveLock_Lock(&ctx->lock);
+
+    if(ctx->state == GDB_STATE_DISCONNECTED)
+    {
+        RecursiveLock_Unlock(&ctx->lock);
+        return -1;
+    }
+
+    // Handle every complete packet received so far (usually just one)
+    ret = GDB_ReceivePacket(ctx) == -1 ? -1 : 0;
+    while(ret != -1 && (r = GDB_FramePacket(ctx)) != 0)
+        ret = r == -1 ? -1 : GDB_HandlePacket(ctx);
+
     RecursiveLock_Unlock(&ctx->lock);
     return ret;
 }
@@ -10,34 +10,78 @@
 #include "gdb/watchpoints.h"
 #include "gdb/breakpoints.h"
 
+// Parses ";X<len>,<bytecode>X<len>,<bytecode>...", keeping each expression preceded by its 16-bit length
+static int GDB_ParseBreakpointConditions(u8 *bytecode, u32 *size, const char **pos)
+{
+    *size = 0;
+    if(strncmp(*pos, ";X", 2) != 0)
+        return 0;
+
+    const char *p = *pos + 1;
+    while(*p == 'X')
+    {
+        u32 len;
+        p = GDB_ParseIntegerList(&len, p + 1, 1, 0, ',', 16, false);
+        if(p == NULL || *p != ',')
+            return -EILSEQ;
+        else if(len == 0 || len > BREAKPOINT_CONDITION_MAX_LEN - 2 - *size)
+            return -ENOSPC;
+
+        bytecode[*size] = len & 0xFF;
+        bytecode[*size + 1] = len >> 8;
+        if(GDB_DecodeHex(bytecode + *size + 2, p + 1, len) != len)
+            return -EILSEQ;
+
+        *size += 2 + len;
+        p += 1 + 2 * len;
+    }
+
+    if(*p != ';' && *p != 0)
+        return -EILSEQ;
+
+    *pos = p;
+    return 0;
+}
+
 GDB_DECLARE_HANDLER(ToggleStopPoint)
 {
     bool add = ctx->commandData[-1] == 'Z';
     u32 lst[3];
+    u8 condition[BREAKPOINT_CONDITION_MAX_LEN];
+    u32 conditionSize;
 
     const char *pos = GDB_ParseHexIntegerList(lst, ctx->commandData, 3, ';');
     if(pos == NULL)
         return GDB_ReplyErrno(ctx, EILSEQ);
+
+    int res = GDB_ParseBreakpointConditions(condition, &conditionSize, &pos);
+    if(res != 0)
+        return GDB_ReplyErrno(ctx, -res);
     bool persist = *pos != 0 && strncmp(pos, ";cmds:1", 7) == 0;
 
     u32 kind = lst[0];
     u32 addr = lst[1];
     u32 size = lst[2];
 
-    int res;
     static const WatchpointKind kinds[3] = { WATCHPOINT_WRITE, WATCHPOINT_READ, WATCHPOINT_READWRITE };
     switch(kind)
     {
         case 0: // software breakpoint
             if(size != 2 && size != 4)
                 return GDB_ReplyEmpty(ctx);
+            else if(!add)
+                res = GDB_RemoveBreakpoint(ctx, addr);
             else
             {
-                res = add ? GDB_AddBreakpoint(ctx, addr, size == 2, persist) :
-                            GDB_RemoveBreakpoint(ctx, addr);
-                return res == 0 ? GDB_ReplyOk(ctx) : GDB_ReplyErrno(ctx, -res);
+                // The condition list is sent again in full whenever it changes, an empty one removing it
+                bool existed = GDB_FindBreakpoint(ctx, addr & ~1) != NULL;
+                res = GDB_AddBreakpoint(ctx, addr, size == 2, persist);
+                if(res == 0 && (res = GDB_SetBreakpointCondition(ctx, addr, condition, conditionSize)) != 0 && !existed)
+                    GDB_RemoveBreakpoint(ctx, addr);
             }
 
+            return res == 0 ? GDB_ReplyOk(ctx) : GDB_ReplyErrno(ctx, -res);
+
         // Watchpoints
         case 2:
         case 3:
@@ -7,6 +7,7 @@
 
 #include "gdb/thread.h"
 #include "gdb/net.h"
+#include "gdb/server.h"
 #include "fmt.h"
 #include <stdlib.h>
 
@@ -107,71 +108,202 @@ int GDB_EncodeThreadId(GDBContext *ctx, char *outbuf, u32 tid)
         return sprintf(outbuf, "%lx", tid);
 }
 
-static s32 GDB_GetDynamicThreadPriority(GDBContext *ctx, u32 threadId)
+#define THREAD_SNAPSHOTS_SIZE   ((MAX_DEBUG_THREAD * sizeof(ThreadSnapshot) + 0xFFF) & ~0xFFF)
+#define THREAD_SNAPSHOTS_STRIDE 0x10000
+
+_Static_assert(THREAD_SNAPSHOTS_SIZE <= THREAD_SNAPSHOTS_STRIDE, "Thread snapshot area too small");
+
+// Threads can be snapshotted while they're stopped: all of them, or the ones kept stopped in non-stop mode
+static bool GDB_CanSnapshotThread(GDBContext *ctx, u32 threadId)
+{
+    if(ctx->debug == 0)
+        return false;
+    else if(!(ctx->flags & GDB_FLAG_PROCESS_CONTINUING))
+        return true;
+
+    for(u32 i = 0; i < ctx->nbThreads; i++)
+    {
+        if(ctx->threadInfos[i].id == threadId)
+            return ctx->threadInfos[i].stopped;
+    }
+
+    return false;
+}
+
+static ThreadSnapshot *GDB_FindThreadSnapshot(GDBContext *ctx, u32 threadId, bool create)
+{
+    if(!GDB_CanSnapshotThread(ctx, threadId))
+        return NULL;
+
+    for(u32 i = 0; i < ctx->nbThreadSnapshots; i++)
+    {
+        if(ctx->threadSnapshots[i].id == threadId)
+            return &ctx->threadSnapshots[i];
+    }
+
+    if(!create || ctx->nbThreadSnapshots == MAX_DEBUG_THREAD)
+        return NULL;
+
+    if(ctx->threadSnapshots == NULL)
+    {
+        u32 tmp;
+        u32 addr = GDB_THREAD_SNAPSHOTS_ADDRESS + THREAD_SNAPSHOTS_STRIDE * (ctx - ctx->parent->ctxs);
+        if(R_FAILED(svcControlMemoryEx(&tmp, addr, 0, THREAD_SNAPSHOTS_SIZE, MEMOP_ALLOC, MEMREGION_SYSTEM | MEMPERM_READWRITE, true)))
+            return NULL;
+
+        ctx->threadSnapshots = (ThreadSnapshot *)addr;
+    }
+
+    ThreadSnapshot *snapshot = &ctx->threadSnapshots[ctx->nbThreadSnapshots++];
+    memset(snapshot, 0, sizeof(ThreadSnapshot));
+    snapshot->id = threadId;
+
+    return snapshot;
+}
+
+static void GDB_FetchThreadSnapshotFields(GDBContext *ctx, ThreadSnapshot *snapshot, u32 fields)
+{
+    u32 missing = fields & ~snapshot->fetchedFields;
+    u32 fetched = 0;
+    s64 dummy;
+
+    if((missing & THREADSNAPSHOT_CONTEXT) &&
+       R_SUCCEEDED(svcGetDebugThreadContext(&snapshot->context, ctx->debug, snapshot->id, THREADCONTEXT_CONTROL_ALL)))
+        fetched |= THREADSNAPSHOT_CONTEXT;
+
+    if((missing & THREADSNAPSHOT_SCHEDULING_MASK) &&
+       R_SUCCEEDED(svcGetDebugThreadParam(&dummy, &snapshot->schedulingMask, ctx->debug, snapshot->id, DBGTHREAD_PARAMETER_SCHEDULING_MASK_LOW)))
+        fetched |= THREADSNAPSHOT_SCHEDULING_MASK;
+
+    if((missing & THREADSNAPSHOT_STATIC_PRIORITY) &&
+       R_SUCCEEDED(svcGetDebugThreadParam(&dummy, (u32 *)&snapshot->staticPriority, ctx->debug, snapshot->id, DBGTHREAD_PARAMETER_PRIORITY)))
+        fetched |= THREADSNAPSHOT_STATIC_PRIORITY;
+
+    if((missing & THREADSNAPSHOT_IDEAL_CORE) &&
+       R_SUCCEEDED(svcGetDebugThreadParam(&dummy, &snapshot->idealCore, ctx->debug, snapshot->id, DBGTHREAD_PARAMETER_CPU_IDEAL)))
+        fetched |= THREADSNAPSHOT_IDEAL_CORE;
+
+    // Creator = "first ran, and running the thread"
+    if((missing & THREADSNAPSHOT_CREATOR_CORE) &&
+       R_SUCCEEDED(svcGetDebugThreadParam(&dummy, &snapshot->creatorCore, ctx->debug, snapshot->id, DBGTHREAD_PARAMETER_CPU_CREATOR)))
+        fetched |= THREADSNAPSHOT_CREATOR_CORE;
+
+    if(missing & THREADSNAPSHOT_DYNAMIC_PRIORITY)
+    {
+        Handle process, thread;
+        if(R_SUCCEEDED(svcOpenProcess(&process, ctx->pid)))
+        {
+            if(R_SUCCEEDED(svcOpenThread(&thread, process, snapshot->id)))
+            {
+                if(R_SUCCEEDED(svcGetThreadPriority(&snapshot->dynamicPriority, thread)))
+                    fetched |= THREADSNAPSHOT_DYNAMIC_PRIORITY;
+                svcCloseHandle(thread);
+            }
+            svcCloseHandle(process);
+        }
+    }
+
+    snapshot->fetchedFields |= missing;
+    snapshot->validFields |= fetched;
+}
+
+const ThreadSnapshot *GDB_GetThreadSnapshot(ThreadSnapshot *scratch, GDBContext *ctx, u32 threadId, u32 fields)
+{
+    ThreadSnapshot *snapshot = GDB_FindThreadSnapshot(ctx, threadId, true);
+
+    // Running threads are queried every time
+    if(snapshot == NULL)
+    {
+        snapshot = scratch;
+        memset(snapshot, 0, sizeof(ThreadSnapshot));
+        snapshot->id = threadId;
+    }
+
+    GDB_FetchThreadSnapshotFields(ctx, snapshot, fields);
+    return snapshot;
+}
+
+const ThreadContext *GDB_GetThreadContextSnapshot(GDBContext *ctx, u32 threadId)
+{
+    ThreadSnapshot *snapshot = GDB_FindThreadSnapshot(ctx, threadId, true);
+    if(snapshot == NULL)
+        return NULL;
+
+    GDB_FetchThreadSnapshotFields(ctx, snapshot, THREADSNAPSHOT_CONTEXT);
+    return (snapshot->validFields & THREADSNAPSHOT_CONTEXT) ? &snapshot->context : NULL;
+}
+
+void GDB_InvalidateThreadSnapshot(GDBContext *ctx, u32 threadId, u32 fields)
 {
-    Handle process, thread;
-    Result r;
-    s32 prio = 65;
+    for(u32 i = 0; i < ctx->nbThreadSnapshots; i++)
+    {
+        ThreadSnapshot *snapshot = &ctx->threadSnapshots[i];
+        if(snapshot->id != threadId)
+            continue;
 
-    r = svcOpenProcess(&process, ctx->pid);
-    if(R_FAILED(r))
-        return 65;
+        snapshot->fetchedFields &= ~fields;
+        snapshot->validFields &= ~fields;
+        if(snapshot->fetchedFields == 0)
+            *snapshot = ctx->threadSnapshots[--ctx->nbThreadSnapshots];
 
-    r = svcOpenThread(&thread, process, threadId);
-    if(R_FAILED(r))
-        goto cleanup;
+        return;
+    }
+}
 
-    r = svcGetThreadPriority(&prio, thread);
+void GDB_InvalidateThreadSnapshots(GDBContext *ctx)
+{
+    ctx->nbThreadSnapshots = 0;
+}
 
-cleanup:
-    svcCloseHandle(thread);
-    svcCloseHandle(process);
+void GDB_ReleaseThreadSnapshots(GDBContext *ctx)
+{
+    u32 tmp;
+    if(ctx->threadSnapshots != NULL)
+        svcControlMemory(&tmp, (u32)ctx->threadSnapshots, 0, THREAD_SNAPSHOTS_SIZE, MEMOP_FREE, 0);
 
-    return prio;
+    ctx->threadSnapshots = NULL;
+    ctx->nbThreadSnapshots = 0;
 }
 
-struct ThreadIdWithCtx
+struct ThreadIdWithParams
 {
-    GDBContext *ctx;
     u32 id;
+    u32 mask;
+    s32 dynamicPriority, staticPriority;
 };
 
 static int thread_compare_func(const void *a_, const void *b_)
 {
-    const struct ThreadIdWithCtx *a = (const struct ThreadIdWithCtx *)a_;
-    const struct ThreadIdWithCtx *b = (const struct ThreadIdWithCtx *)b_;
+    const struct ThreadIdWithParams *a = (const struct ThreadIdWithParams *)a_;
+    const struct ThreadIdWithParams *b = (const struct ThreadIdWithParams *)b_;
 
-    u32 maskA = 2, maskB = 2;
-    s32 prioAStatic = 65, prioBStatic = 65;
-    s32 prioADynamic = GDB_GetDynamicThreadPriority(a->ctx, a->id);
-    s32 prioBDynamic = GDB_GetDynamicThreadPriority(b->ctx, b->id);
-    s64 dummy;
-
-    svcGetDebugThreadParam(&dummy, &maskA, a->ctx->debug, a->id, DBGTHREAD_PARAMETER_SCHEDULING_MASK_LOW);
-    svcGetDebugThreadParam(&dummy, &maskB, b->ctx->debug, b->id, DBGTHREAD_PARAMETER_SCHEDULING_MASK_LOW);
-    svcGetDebugThreadParam(&dummy, (u32 *)&prioAStatic, a->ctx->debug, a->id, DBGTHREAD_PARAMETER_PRIORITY);
-    svcGetDebugThreadParam(&dummy, (u32 *)&prioBStatic, b->ctx->debug, b->id, DBGTHREAD_PARAMETER_PRIORITY);
-
-    if(maskA == 1 && maskB != 1)
+    if(a->mask == 1 && b->mask != 1)
         return -1;
-    else if(maskA != 1 && maskB == 1)
+    else if(a->mask != 1 && b->mask == 1)
         return 1;
-    else if(prioADynamic != prioBDynamic)
-        return prioADynamic - prioBDynamic;
+    else if(a->dynamicPriority != b->dynamicPriority)
+        return a->dynamicPriority - b->dynamicPriority;
     else
-        return prioAStatic - prioBStatic;
+        return a->staticPriority - b->staticPriority;
 }
 
 u32 GDB_GetCurrentThreadFromList(GDBContext *ctx, u32 *threadIds, u32 nbThreads)
 {
-    struct ThreadIdWithCtx lst[MAX_DEBUG_THREAD];
+    // Parameters are gathered once per thread rather than on every comparison
+    struct ThreadIdWithParams lst[MAX_DEBUG_THREAD];
     for(u32 i = 0; i < nbThreads; i++)
     {
-        lst[i].ctx = ctx;
+        ThreadSnapshot scratch;
+        const ThreadSnapshot *snapshot = GDB_GetThreadSnapshot(&scratch, ctx, threadIds[i],
+            THREADSNAPSHOT_SCHEDULING_MASK | THREADSNAPSHOT_DYNAMIC_PRIORITY | THREADSNAPSHOT_STATIC_PRIORITY);
+
         lst[i].id = threadIds[i];
+        lst[i].mask = (snapshot->validFields & THREADSNAPSHOT_SCHEDULING_MASK) ? snapshot->schedulingMask : 2;
+        lst[i].dynamicPriority = (snapshot->validFields & THREADSNAPSHOT_DYNAMIC_PRIORITY) ? snapshot->dynamicPriority : 65;
+        lst[i].staticPriority = (snapshot->validFields & THREADSNAPSHOT_STATIC_PRIORITY) ? snapshot->staticPriority : 65;
     }
 
-    qsort(lst, nbThreads, sizeof(struct ThreadIdWithCtx), thread_compare_func);
+    qsort(lst, nbThreads, sizeof(struct ThreadIdWithParams), thread_compare_func);
     return lst[0].id;
 }
 
@@ -225,15 +357,14 @@ GDB_DECLARE_HANDLER(SetThreadId)
 
 GDB_DECLARE_HANDLER(IsThreadAlive)
 {
-    s64 dummy;
-    u32 mask;
+    ThreadSnapshot scratch;
 
     u32 tid = GDB_ParseDecodeSingleThreadId(ctx, ctx->commandData, 0);
     if (tid == 0)
         return GDB_ReplyErrno(ctx, EILSEQ);
 
-    Result r = svcGetDebugThreadParam(&dummy, &mask, ctx->debug, tid, DBGTHREAD_PARAMETER_SCHEDULING_MASK_LOW);
-    if(R_SUCCEEDED(r) && mask != 2)
+    const ThreadSnapshot *snapshot = GDB_GetThreadSnapshot(&scratch, ctx, tid, THREADSNAPSHOT_SCHEDULING_MASK);
+    if((snapshot->validFields & THREADSNAPSHOT_SCHEDULING_MASK) && snapshot->schedulingMask != 2)
         return GDB_ReplyOk(ctx);
     else
         return GDB_ReplyErrno(ctx, EPERM);
@@ -256,11 +387,9 @@ static void GDB_GenerateThreadListData(GDBContext *ctx)
 
     for(u32 i = 0; i < ctx->nbThreads; i++)
     {
-        s64 dummy;
-        u32 mask;
-
-        Result r = svcGetDebugThreadParam(&dummy, &mask, ctx->debug, ctx->threadInfos[i].id, DBGTHREAD_PARAMETER_SCHEDULING_MASK_LOW);
-        if(R_SUCCEEDED(r) && mask != 2)
+        ThreadSnapshot scratch;
+        const ThreadSnapshot *snapshot = GDB_GetThreadSnapshot(&scratch, ctx, ctx->threadInfos[i].id, THREADSNAPSHOT_SCHEDULING_MASK);
+        if((snapshot->validFields & THREADSNAPSHOT_SCHEDULING_MASK) && snapshot->schedulingMask != 2)
             aliveThreadIds[nbAliveThreads++] = ctx->threadInfos[i].id;
     }
 
@@ -336,9 +465,6 @@ GDB_DECLARE_QUERY_HANDLER(ThreadEvents)
 GDB_DECLARE_QUERY_HANDLER(ThreadExtraInfo)
 {
     u32 id;
-    s64 dummy;
-    u32 val;
-    Result r;
     int n;
 
     const char *sStatus;
@@ -358,32 +484,31 @@ GDB_DECLARE_QUERY_HANDLER(ThreadExtraInfo)
             tls = ctx->threadInfos[i].tls;
     }
 
-    r = svcGetDebugThreadParam(&dummy, &val, ctx->debug, id, DBGTHREAD_PARAMETER_SCHEDULING_MASK_LOW);
-    sStatus = R_SUCCEEDED(r) ? (val == 1 ? ", running, " : ", idle, ") : "";
+    ThreadSnapshot scratch;
+    const ThreadSnapshot *snapshot = GDB_GetThreadSnapshot(&scratch, ctx, id, THREADSNAPSHOT_PARAMS);
+    u32 valid = snapshot->validFields;
+
+    sStatus = (valid & THREADSNAPSHOT_SCHEDULING_MASK) ? (snapshot->schedulingMask == 1 ? ", running, " : ", idle, ") : "";
 
-    val = (u32)GDB_GetDynamicThreadPriority(ctx, id);
-    if(val == 65)
+    if(!(valid & THREADSNAPSHOT_DYNAMIC_PRIORITY) || snapshot->dynamicPriority == 65)
         sThreadDynamicPriority[0] = 0;
     else
-        sprintf(sThreadDynamicPriority, "dynamic prio.: %ld, ", (s32)val);
+        sprintf(sThreadDynamicPriority, "dynamic prio.: %ld, ", snapshot->dynamicPriority);
 
-    r = svcGetDebugThreadParam(&dummy, &val, ctx->debug, id, DBGTHREAD_PARAMETER_PRIORITY);
-    if(R_FAILED(r))
+    if(!(valid & THREADSNAPSHOT_STATIC_PRIORITY))
         sThreadStaticPriority[0] = 0;
     else
-        sprintf(sThreadStaticPriority, "static prio.: %ld, ", (s32)val);
+        sprintf(sThreadStaticPriority, "static prio.: %ld, ", snapshot->staticPriority);
 
-    r = svcGetDebugThreadParam(&dummy, &val, ctx->debug, id, DBGTHREAD_PARAMETER_CPU_IDEAL);
-    if(R_FAILED(r))
+    if(!(valid & THREADSNAPSHOT_IDEAL_CORE))
         sCoreIdeal[0] = 0;
     else
-        sprintf(sCoreIdeal, "ideal core: %lu, ", val);
+        sprintf(sCoreIdeal, "ideal core: %lu, ", snapshot->idealCore);
 
-    r = svcGetDebugThreadParam(&dummy, &val, ctx->debug, id, DBGTHREAD_PARAMETER_CPU_CREATOR); // Creator = "first ran, and running the thread"
-    if(R_FAILED(r))
+    if(!(valid & THREADSNAPSHOT_CREATOR_CORE))
         sCoreCreator[0] = 0;
     else
-        sprintf(sCoreCreator, "running on core %lu", val);
+        sprintf(sCoreCreator, "running on core %lu", snapshot->creatorCore);
 
     n = sprintf(buf, "TLS: 0x%08lx%s%s%s%s%s", tls, sStatus, sThreadDynamicPriority, sThreadStaticPriority,
                 sCoreIdeal, sCoreCreator);
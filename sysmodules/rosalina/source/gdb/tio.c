@@ -10,6 +10,7 @@
 #include "gdb/tio.h"
 #include "gdb/hio.h"
 #include "gdb/net.h"
+#include "gdb/server.h"
 #include "gdb/mem.h"
 #include "gdb/debug.h"
 #include "fmt.h"
@@ -78,6 +79,11 @@
 #define GDBHIO_ENAMETOOLONG        91
 #define GDBHIO_EUNKNOWN          9999
 
+// Whole packets of file data are read at once, for "remote get" & co. to be bound by the network rather than the SD card
+#define TIO_READ_AHEAD_SIZE         0x10000
+#define MAX_TIO_READ_AHEAD          2
+#define TIO_READ_AHEAD_STRIDE       (MAX_TIO_READ_AHEAD * TIO_READ_AHEAD_SIZE)
+
 #define GDB_TIO_HANDLER(name)               GDB_HANDLER(Tio##name)
 #define GDB_DECLARE_TIO_HANDLER(name)       GDB_DECLARE_HANDLER(Tio##name)
 
@@ -162,10 +168,106 @@ static int GDB_TioRegisterFile(GDBContext *ctx, Handle h, int gdbOpenFlags)
     return fd;
 }
 
+static u8 *GDB_TioAllocateReadAheadBuffer(GDBContext *ctx)
+{
+    u32 base = GDB_TIO_READ_AHEAD_ADDRESS + TIO_READ_AHEAD_STRIDE * (ctx - ctx->parent->ctxs);
+
+    for (u32 slot = 0; slot < MAX_TIO_READ_AHEAD; slot++)
+    {
+        u8 *buffer = (u8 *)(base + slot * TIO_READ_AHEAD_SIZE);
+        bool used = false;
+        for (u32 i = 0; i < MAX_TIO_OPEN_FILE && !used; i++)
+            used = ctx->openTioFileInfos[i].readAheadBuffer == buffer;
+
+        u32 tmp;
+        if (!used)
+            return R_SUCCEEDED(svcControlMemoryEx(&tmp, (u32)buffer, 0, TIO_READ_AHEAD_SIZE, MEMOP_ALLOC, MEMREGION_SYSTEM | MEMPERM_READWRITE, true)) ? buffer : NULL;
+    }
+
+    return NULL;
+}
+
+static void GDB_TioCloseFile(GDBContext *ctx, GdbTioFileInfo *fi)
+{
+    u32 tmp;
+    if (fi->readAheadBuffer != NULL)
+        svcControlMemory(&tmp, (u32)fi->readAheadBuffer, 0, TIO_READ_AHEAD_SIZE, MEMOP_FREE, 0);
+
+    memset(fi, 0, sizeof(GdbTioFileInfo));
+    ctx->numOpenTioFiles--;
+}
+
+void GDB_TioCloseAllFiles(GDBContext *ctx)
+{
+    for (u32 i = 0; i < MAX_TIO_OPEN_FILE; i++)
+    {
+        GdbTioFileInfo *fi = &ctx->openTioFileInfos[i];
+        if (fi->f.handle != 0)
+        {
+            IFile_Close(&fi->f);
+            GDB_TioCloseFile(ctx, fi);
+        }
+    }
+
+    ctx->numOpenTioFiles = 0;
+}
+
+// Gets up to count bytes at offset, from the read-ahead buffer when the file has one (refilled as needed), from the work buffer otherwise
+static int GDB_TioReadAt(GDBContext *ctx, GdbTioFileInfo *fi, const u8 **data, u32 *numRead, u64 offset, u32 count)
+{
+    u64 total = 0;
+
+    if (fi->readAheadBuffer == NULL && (fi->flags & GDBHIO_O_ACCMODE) == GDBHIO_O_RDONLY)
+        fi->readAheadBuffer = GDB_TioAllocateReadAheadBuffer(ctx);
+
+    if (fi->readAheadBuffer == NULL)
+    {
+        fi->f.pos = offset;
+        int err = GDB_TioConvertResult(IFile_Read(&fi->f, &total, ctx->workBuffer, count));
+        *data = ctx->workBuffer;
+        *numRead = (u32)total;
+        return err;
+    }
+
+    u64 end = fi->readAheadOffset + fi->readAheadSize;
+    u32 kept = offset >= fi->readAheadOffset && offset < end ? (u32)(end - offset) : 0;
+
+    // A short buffer means the end of the file was reached
+    if (kept < count && (kept == 0 || fi->readAheadSize == TIO_READ_AHEAD_SIZE))
+    {
+        if (kept != 0)
+            memmove(fi->readAheadBuffer, fi->readAheadBuffer + (u32)(offset - fi->readAheadOffset), kept);
+
+        fi->f.pos = offset + kept;
+        int err = GDB_TioConvertResult(IFile_Read(&fi->f, &total, fi->readAheadBuffer + kept, TIO_READ_AHEAD_SIZE - kept));
+        if (err != 0)
+        {
+            fi->readAheadSize = 0;
+            return err;
+        }
+
+        fi->readAheadOffset = offset;
+        fi->readAheadSize = kept + (u32)total;
+        kept = fi->readAheadSize;
+    }
+
+    *data = fi->readAheadBuffer + (u32)(offset - fi->readAheadOffset);
+    *numRead = kept < count ? kept : count;
+    return 0;
+}
+
+static void GDB_TioInvalidateReadAhead(GDBContext *ctx)
+{
+    // The same file may be open more than once
+    for (u32 i = 0; i < MAX_TIO_OPEN_FILE; i++)
+        ctx->openTioFileInfos[i].readAheadSize = 0;
+}
+
 static int GDB_MakeUtf16Path(FS_Path *outPath, const char *pathData)
 {
     size_t pathDataLen = strlen(pathData);
     if (pathDataLen % 2 == 1) return GDBHIO_EINVAL;
+    if (pathDataLen / 2 > PATH_MAX) return GDBHIO_ENAMETOOLONG;
 
     char path[PATH_MAX + 1];
     u32 count = GDB_DecodeHex(path, pathData, pathDataLen / 2);
@@ -303,7 +405,7 @@ GDB_DECLARE_TIO_HANDLER(Close)
         return GDB_TioReplyErrno(ctx, GDBHIO_EBADF);
 
     int err = GDB_TioConvertResult(IFile_Close(&fi->f));
-    memset(fi, 0, sizeof(GdbTioFileInfo));
+    GDB_TioCloseFile(ctx, fi);
 
     if (err != 0)
         return GDB_TioReplyErrno(ctx, err);
@@ -313,42 +415,35 @@ GDB_DECLARE_TIO_HANDLER(Close)
 
 GDB_DECLARE_TIO_HANDLER(Read)
 {
-    // GDB, with it code quality we're all aware of, always ask to read GDB_BUF_LEN, even if the packet can't fit...
+    // GDB, with it code quality we're all aware of, always ask to read PacketSize bytes, even if the packet can't fit...
     // "$F<num>;<data>#XX"
-    char buf2[GDB_BUF_LEN - 4];
-    u8 buf[sizeof(buf2) - 2 - 8];
-
     u32 args[3];
     if (GDB_ParseHexIntegerList(args, ctx->commandData, 3, 0) == NULL)
         return GDB_ReplyErrno(ctx, EILSEQ);
 
-    u64 numRead = 0;
     int fd = (int)args[0];
-    u32 count = args[1] > sizeof(buf) ? sizeof(buf) : args[1];
+    u32 maxCount = ctx->bufferSize - 10;
+    u32 count = args[1] > maxCount ? maxCount : args[1];
     u32 offset = args[2];
 
     GdbTioFileInfo *fi = GDB_TioConvertFd(ctx, fd);
     if (fi == NULL)
         return GDB_TioReplyErrno(ctx, GDBHIO_EBADF);
 
-    fi->f.pos = offset;
-
-    int err = GDB_TioConvertResult(IFile_Read(&fi->f, &numRead, buf, count));
+    const u8 *data;
+    u32 numRead;
+    int err = GDB_TioReadAt(ctx, fi, &data, &numRead, offset, count);
     if (err != 0)
         return GDB_TioReplyErrno(ctx, err);
 
-    char hdr[16];
-    u32 encodedCount;
-    u32 actualCount = GDB_EscapeBinaryData(&encodedCount, buf2 + 10, buf, (u32)numRead, sizeof(buf));
-    sprintf(hdr, "F%08lx;", (u32)actualCount); // buffer might not fit the entire read data
-    memcpy(buf2, hdr, 10);
-
-    return GDB_SendPacket(ctx, buf2, 10 + encodedCount);
+    // The packet might not fit the entire read data once escaped, the count we reply with is what actually fits
+    u32 sentCount;
+    return GDB_SendCountPrefixedBinaryPacket(ctx, &sentCount, "F%08lx;", 10, data, numRead);
 }
 
 GDB_DECLARE_TIO_HANDLER(Write)
 {
-    u8 buf[GDB_BUF_LEN];
+    u8 *buf = ctx->workBuffer;
     u32 args[2];
     const char *comma = GDB_ParseHexIntegerList(args, ctx->commandData, 2, ',');
     if (comma == NULL)
@@ -365,7 +460,7 @@ GDB_DECLARE_TIO_HANDLER(Write)
         return GDB_TioReplyErrno(ctx, GDBHIO_EBADF);
     
     fi->f.pos = offset;
-
+    GDB_TioInvalidateReadAhead(ctx);
 
     u64 written;
     int err = GDB_TioConvertResult(IFile_Write(&fi->f, &written, buf, count, 0));
@@ -434,7 +529,7 @@ GDB_DECLARE_TIO_HANDLER(Stat)
 
     char buf[3 + 2 * sizeof(struct gdbhio_stat)] = "F0;";
     u32 encodedCount;
-    GDB_EscapeBinaryData(&encodedCount, buf + 3, buf, sizeof(struct gdbhio_stat), 2 * sizeof(struct gdbhio_stat));
+    GDB_EscapeBinaryData(&encodedCount, buf + 3, &gdbStFinal, sizeof(struct gdbhio_stat), 2 * sizeof(struct gdbhio_stat));
 
     return GDB_SendPacket(ctx, buf, 3 + encodedCount);
 }
@@ -19,10 +19,12 @@ static const struct
     { "Attach", GDB_VERBOSE_HANDLER(Attach) },
     { "Cont?", GDB_VERBOSE_HANDLER(ContinueSupported) },
     { "Cont",  GDB_VERBOSE_HANDLER(Continue) },
+    { "CtrlC", GDB_VERBOSE_HANDLER(CtrlC) },
     { "File", GDB_VERBOSE_HANDLER(File) },
     { "MustReplyEmpty", GDB_HANDLER(Unsupported) },
     { "Run", GDB_VERBOSE_HANDLER(Run) },
     { "Kill", GDB_VERBOSE_HANDLER(Kill) },
+    { "Stopped", GDB_VERBOSE_HANDLER(Stopped) },
 };
 
 GDB_DECLARE_HANDLER(VerboseCommand)
@@ -55,5 +57,6 @@ GDB_DECLARE_HANDLER(VerboseCommand)
 
 GDB_DECLARE_VERBOSE_HANDLER(ContinueSupported)
 {
-    return GDB_SendPacket(ctx, "vCont;c;C", 9);
+    // 't' is only used in non-stop mode
+    return GDB_SendPacket(ctx, "vCont;c;C;t", 11);
 }
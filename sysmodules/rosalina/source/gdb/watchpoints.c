@@ -6,6 +6,9 @@
 */
 
 #include "gdb/watchpoints.h"
+#include "gdb/breakpoints.h"
+#include "gdb/server.h"
+#include "gdb/debug.h"
 #include "csvc.h"
 
 #define _REENT_ONLY
@@ -16,8 +19,23 @@
     and only 2 Breakpoint Register Pairs with context ID capabilities (BRP4-5) as well.
 
     We'll reserve and use all 4 of them
+
+    Once they're taken (or for ranges they can't cover), watchpoints are implemented in software
+    by removing access permissions from the pages they're on, and looking at the resulting data aborts.
+    The faulting access is then stepped over with the page unprotected, using a temporary breakpoint
+    on the next instruction. An access can span two pages (LDM/STM, LDRD, unaligned accesses) and fault on
+    either of them, so the pages next to the faulting one are unprotected during the step as well.
+
+    Only the accesses made by the process itself trap: when the kernel or a service accesses a protected page
+    on its behalf (e.g. an FS read into a watched buffer, or an IPC buffer), the request fails with an error
+    instead, which the process might not expect.
 */
 
+#define NB_HARDWARE_WATCHPOINTS     2
+#define MAX_SOFTWARE_WATCHPOINTS    (MAX_DEBUG * MAX_WATCHPOINT)
+#define MAX_WATCHED_PAGES           (2 * MAX_SOFTWARE_WATCHPOINTS)
+#define MAX_SOFTWARE_WATCHPOINT_LEN 0x1000
+
 RecursiveLock watchpointManagerLock;
 
 typedef struct Watchpoint
@@ -28,10 +46,31 @@ typedef struct Watchpoint
     Handle debug; // => context ID
 } Watchpoint;
 
+typedef struct WatchedPage
+{
+    u32 address;
+    Handle debug;
+    u32 originalPerm;
+    u32 perm;
+} WatchedPage;
+
+typedef struct WatchpointStep
+{
+    bool pending;
+    bool hasBreakpoint;
+    bool userBreakpoint;
+    bool holdsThreads;
+    u32 threadId;
+    u32 pageAddress; // faulting page, the pages next to it are unprotected as well
+    u32 breakpointAddress;
+} WatchpointStep;
+
 typedef struct WatchpointManager
 {
     u32 total;
-    Watchpoint watchpoints[2];
+    Watchpoint watchpoints[NB_HARDWARE_WATCHPOINTS + MAX_SOFTWARE_WATCHPOINTS]; // hardware ones first
+    WatchedPage pages[MAX_WATCHED_PAGES];
+    WatchpointStep steps[MAX_DEBUG];
 } WatchpointManager;
 
 static WatchpointManager manager;
@@ -55,23 +94,118 @@ void GDB_ResetWatchpoints(void)
     RecursiveLock_Unlock(&watchpointManagerLock);
 }
 
-int GDB_AddWatchpoint(GDBContext *ctx, u32 address, u32 size, WatchpointKind kind)
+static inline WatchpointStep *GDB_GetWatchpointStep(GDBContext *ctx)
 {
-    RecursiveLock_Lock(&watchpointManagerLock);
+    return &manager.steps[ctx - ctx->parent->ctxs];
+}
 
-    u32 offset = address - (address & ~3);
+static Watchpoint *GDB_FindWatchpoint(GDBContext *ctx, u32 address)
+{
+    for(u32 id = 0; id < NB_HARDWARE_WATCHPOINTS + MAX_SOFTWARE_WATCHPOINTS; id++)
+    {
+        Watchpoint *watchpoint = &manager.watchpoints[id];
+        if(watchpoint->kind != WATCHPOINT_DISABLED && watchpoint->address == address && watchpoint->debug == ctx->debug)
+            return watchpoint;
+    }
 
-    if(manager.total == 2)
-        return -EBUSY;
+    return NULL;
+}
 
-    if(size == 0 || (offset + size) > 4 || kind == WATCHPOINT_DISABLED)
-        return -EINVAL;
+static WatchedPage *GDB_FindWatchedPage(Handle debug, u32 address)
+{
+    for(u32 i = 0; i < MAX_WATCHED_PAGES; i++)
+    {
+        if(manager.pages[i].debug == debug && manager.pages[i].address == address)
+            return &manager.pages[i];
+    }
 
-    if(GDB_GetWatchpointKind(ctx, address) != WATCHPOINT_DISABLED)
-        // Disallow duplicate watchpoints: the kernel doesn't give us sufficient info to differentiate them by kind (DFSR)
-        return -EINVAL;
+    return NULL;
+}
+
+static inline bool GDB_IsWatchpointOnPage(const Watchpoint *watchpoint, const WatchedPage *page)
+{
+    return watchpoint->kind != WATCHPOINT_DISABLED && watchpoint->debug == page->debug &&
+           watchpoint->address < page->address + 0x1000 && watchpoint->address + watchpoint->size > page->address;
+}
+
+static inline bool GDB_IsPageBeingStepped(const WatchpointStep *step, u32 pageAddress)
+{
+    return step->pending && pageAddress - (step->pageAddress - 0x1000) <= 0x2000;
+}
+
+static Result GDB_ProtectWatchedPage(GDBContext *ctx, WatchedPage *page, u32 perm)
+{
+    if(perm == page->perm)
+        return 0;
+
+    Handle process;
+    Result r = svcOpenProcess(&process, ctx->pid);
+    if(R_SUCCEEDED(r))
+    {
+        r = svcControlProcessMemory(process, page->address, page->address, 0x1000, MEMOP_PROT, perm);
+        svcCloseHandle(process);
+    }
+
+    if(R_SUCCEEDED(r))
+        page->perm = perm;
+
+    return r;
+}
+
+// Write watchpoints only need the page to be read-only, read and access watchpoints need it to be inaccessible
+static Result GDB_UpdateWatchedPage(GDBContext *ctx, WatchedPage *page)
+{
+    u32 perm = page->originalPerm;
+    for(u32 id = NB_HARDWARE_WATCHPOINTS; id < NB_HARDWARE_WATCHPOINTS + MAX_SOFTWARE_WATCHPOINTS; id++)
+    {
+        const Watchpoint *watchpoint = &manager.watchpoints[id];
+        if(GDB_IsWatchpointOnPage(watchpoint, page))
+            perm &= watchpoint->kind == WATCHPOINT_WRITE ? ~MEMPERM_WRITE : ~(MEMPERM_READ | MEMPERM_WRITE);
+    }
+
+    // The page is left as it is while the faulting access is being stepped over
+    WatchpointStep *step = GDB_GetWatchpointStep(ctx);
+    bool stepped = GDB_IsPageBeingStepped(step, page->address);
+    if(stepped)
+        perm = page->originalPerm;
+
+    Result r = GDB_ProtectWatchedPage(ctx, page, perm);
+    if(R_SUCCEEDED(r) && perm == page->originalPerm && !stepped)
+        memset(page, 0, sizeof(WatchedPage));
+
+    return r;
+}
+
+static WatchedPage *GDB_GetWatchedPage(GDBContext *ctx, u32 address)
+{
+    WatchedPage *page = GDB_FindWatchedPage(ctx->debug, address);
+    if(page != NULL)
+        return page;
 
-    u32 id = manager.watchpoints[0].kind == WATCHPOINT_DISABLED ? 0 : 1;
+    page = GDB_FindWatchedPage(0, 0);
+    if(page == NULL)
+        return NULL;
+
+    Handle process;
+    MemInfo memInfo;
+    PageInfo pageInfo;
+    if(R_FAILED(svcOpenProcess(&process, ctx->pid)))
+        return NULL;
+
+    Result r = svcQueryProcessMemory(&memInfo, &pageInfo, process, address);
+    svcCloseHandle(process);
+    if(R_FAILED(r) || memInfo.state == MEMSTATE_FREE || memInfo.state == MEMSTATE_IO)
+        return NULL;
+
+    page->address = address;
+    page->debug = ctx->debug;
+    page->originalPerm = page->perm = memInfo.perm;
+    return page;
+}
+
+static int GDB_AddHardwareWatchpoint(GDBContext *ctx, u32 id, u32 address, u32 size, WatchpointKind kind)
+{
+    u32 offset = address - (address & ~3);
     u32 selectMask = ((1 << size) - 1) << offset;
 
     u32 WCR = (1          << 20) | /* linked */
@@ -84,68 +218,390 @@ int GDB_AddWatchpoint(GDBContext *ctx, u32 address, u32 size, WatchpointKind kin
     s64 out;
 
     Result r = svcGetHandleInfo(&out, ctx->debug, 0x10000); // context ID
+    if(R_FAILED(r))
+        return -EINVAL;
 
-    if(R_SUCCEEDED(r))
+    svcKernelSetState(id == 0 ? 0x10005 : 0x10006, address, WCR, (u32)out); // set watchpoint
+    return 0;
+}
+
+static int GDB_AddSoftwareWatchpoint(GDBContext *ctx, u32 address, u32 size)
+{
+    // At most 2 pages per watchpoint
+    if(size > MAX_SOFTWARE_WATCHPOINT_LEN)
+        return -EINVAL;
+
+    u32 firstPage = address & ~0xFFF, lastPage = (address + size - 1) & ~0xFFF;
+    WatchedPage *pages[2] = { GDB_GetWatchedPage(ctx, firstPage), NULL };
+    if(pages[0] != NULL && lastPage != firstPage)
+        pages[1] = GDB_GetWatchedPage(ctx, lastPage);
+
+    if(pages[0] == NULL || (lastPage != firstPage && pages[1] == NULL))
+        return -EFAULT;
+
+    for(u32 i = 0; i < 2 && pages[i] != NULL; i++)
+    {
+        if(R_FAILED(GDB_UpdateWatchedPage(ctx, pages[i])))
+            return -EFAULT;
+    }
+
+    return 0;
+}
+
+int GDB_AddWatchpoint(GDBContext *ctx, u32 address, u32 size, WatchpointKind kind)
+{
+    RecursiveLock_Lock(&watchpointManagerLock);
+
+    u32 offset = address - (address & ~3);
+    int res = 0;
+
+    if(size == 0 || kind == WATCHPOINT_DISABLED)
+        res = -EINVAL;
+    else if(ctx->nbWatchpoints == MAX_WATCHPOINT)
+        res = -EBUSY;
+    else if(GDB_FindWatchpoint(ctx, address) != NULL)
+        // Disallow duplicate watchpoints: the kernel doesn't give us sufficient info to differentiate them by kind (DFSR)
+        res = -EINVAL;
+
+    if(res != 0)
     {
-        svcKernelSetState(id == 0 ? 0x10005 : 0x10006, address, WCR, (u32)out); // set watchpoint
-        Watchpoint *watchpoint = &manager.watchpoints[id];
-        manager.total++;
-        watchpoint->address = address;
-        watchpoint->size = size;
-        watchpoint->kind = kind;
-        watchpoint->debug = ctx->debug;
-        ctx->watchpoints[ctx->nbWatchpoints++] = address;
         RecursiveLock_Unlock(&watchpointManagerLock);
-        return 0;
+        return res;
     }
+
+    // Prefer the hardware watchpoints when the range fits in them
+    u32 id;
+    if(offset + size <= 4 && manager.watchpoints[0].kind == WATCHPOINT_DISABLED)
+        id = 0;
+    else if(offset + size <= 4 && manager.watchpoints[1].kind == WATCHPOINT_DISABLED)
+        id = 1;
     else
+        for(id = NB_HARDWARE_WATCHPOINTS; id < NB_HARDWARE_WATCHPOINTS + MAX_SOFTWARE_WATCHPOINTS && manager.watchpoints[id].kind != WATCHPOINT_DISABLED; id++);
+
+    if(id == NB_HARDWARE_WATCHPOINTS + MAX_SOFTWARE_WATCHPOINTS)
     {
         RecursiveLock_Unlock(&watchpointManagerLock);
-        return -EINVAL;
+        return -EBUSY;
+    }
+
+    Watchpoint *watchpoint = &manager.watchpoints[id];
+    watchpoint->address = address;
+    watchpoint->size = size;
+    watchpoint->kind = kind;
+    watchpoint->debug = ctx->debug;
+
+    res = id < NB_HARDWARE_WATCHPOINTS ? GDB_AddHardwareWatchpoint(ctx, id, address, size, kind) : GDB_AddSoftwareWatchpoint(ctx, address, size);
+
+    if(res == 0)
+    {
+        manager.total++;
+        ctx->watchpoints[ctx->nbWatchpoints++] = address;
+    }
+    else
+    {
+        memset(watchpoint, 0, sizeof(Watchpoint));
+        if(id >= NB_HARDWARE_WATCHPOINTS)
+        {
+            // Give the pages their permissions back
+            for(u32 i = 0; i < MAX_WATCHED_PAGES; i++)
+            {
+                if(manager.pages[i].debug == ctx->debug)
+                    GDB_UpdateWatchedPage(ctx, &manager.pages[i]);
+            }
+        }
+    }
+
+    RecursiveLock_Unlock(&watchpointManagerLock);
+    return res;
+}
+
+static void GDB_FinishWatchpointStep(GDBContext *ctx, WatchpointStep *step)
+{
+    if(!step->pending)
+        return;
+
+    if(step->hasBreakpoint && !step->userBreakpoint)
+        GDB_RemoveBreakpoint(ctx, step->breakpointAddress);
+
+    step->pending = false;
+
+    for(u32 address = step->pageAddress - 0x1000, i = 0; i < 3; address += 0x1000, i++)
+    {
+        WatchedPage *page = GDB_FindWatchedPage(ctx->debug, address);
+        if(page != NULL)
+            GDB_UpdateWatchedPage(ctx, page);
     }
+
+    // Only once the pages are protected again
+    if(step->holdsThreads)
+        GDB_ReleaseThreadsHeldForStep(ctx);
+    step->holdsThreads = false;
 }
 
 int GDB_RemoveWatchpoint(GDBContext *ctx, u32 address, WatchpointKind kind)
 {
     RecursiveLock_Lock(&watchpointManagerLock);
 
-    u32 id;
-    for(id = 0; id < 2 && manager.watchpoints[id].address != address && manager.watchpoints[id].debug != ctx->debug; id++);
+    Watchpoint *watchpoint = GDB_FindWatchpoint(ctx, address);
 
-    if(id == 2 || (kind != WATCHPOINT_DISABLED && manager.watchpoints[id].kind != kind))
+    if(watchpoint == NULL || (kind != WATCHPOINT_DISABLED && watchpoint->kind != kind))
     {
         RecursiveLock_Unlock(&watchpointManagerLock);
         return -EINVAL;
     }
-    else
+
+    u32 id = watchpoint - manager.watchpoints;
+    if(id < NB_HARDWARE_WATCHPOINTS)
     {
         svcKernelSetState(0x10004, id); // disable watchpoint
+        memset(watchpoint, 0, sizeof(Watchpoint));
+    }
+    else
+    {
+        // The access being stepped over may not be watched anymore
+        GDB_FinishWatchpointStep(ctx, GDB_GetWatchpointStep(ctx));
 
-        memset(&manager.watchpoints[id], 0, sizeof(Watchpoint));
-        manager.total--;
-
-        if(ctx->watchpoints[0] == address)
+        memset(watchpoint, 0, sizeof(Watchpoint));
+        for(u32 i = 0; i < MAX_WATCHED_PAGES; i++)
         {
-            ctx->watchpoints[0] = ctx->watchpoints[1];
-            ctx->watchpoints[1] = 0;
-            ctx->nbWatchpoints--;
+            if(manager.pages[i].debug == ctx->debug)
+                GDB_UpdateWatchedPage(ctx, &manager.pages[i]);
         }
-        else if(ctx->watchpoints[1] == address)
+    }
+
+    manager.total--;
+
+    u32 i;
+    for(i = 0; i < ctx->nbWatchpoints && ctx->watchpoints[i] != address; i++);
+    if(i < ctx->nbWatchpoints)
+    {
+        for(; i < ctx->nbWatchpoints - 1; i++)
+            ctx->watchpoints[i] = ctx->watchpoints[i + 1];
+        ctx->watchpoints[--ctx->nbWatchpoints] = 0;
+    }
+
+    RecursiveLock_Unlock(&watchpointManagerLock);
+
+    return 0;
+}
+
+void GDB_RemoveAllWatchpoints(GDBContext *ctx)
+{
+    RecursiveLock_Lock(&watchpointManagerLock);
+
+    while(ctx->nbWatchpoints > 0)
+    {
+        if(GDB_RemoveWatchpoint(ctx, ctx->watchpoints[0], WATCHPOINT_DISABLED) != 0)
         {
-            ctx->watchpoints[1] = 0;
-            ctx->nbWatchpoints--;
+            // Shouldn't happen, forget about it
+            for(u32 i = 0; i < ctx->nbWatchpoints - 1; i++)
+                ctx->watchpoints[i] = ctx->watchpoints[i + 1];
+            ctx->watchpoints[--ctx->nbWatchpoints] = 0;
         }
+    }
 
-        RecursiveLock_Unlock(&watchpointManagerLock);
+    GDB_FinishWatchpointStep(ctx, GDB_GetWatchpointStep(ctx));
 
-        return 0;
+    // The process may be gone already, in which case the pages couldn't be given their permissions back
+    for(u32 i = 0; i < MAX_WATCHED_PAGES; i++)
+    {
+        if(manager.pages[i].debug == ctx->debug)
+            memset(&manager.pages[i], 0, sizeof(WatchedPage));
     }
+
+    RecursiveLock_Unlock(&watchpointManagerLock);
 }
 
 WatchpointKind GDB_GetWatchpointKind(GDBContext *ctx, u32 address)
 {
-    u32 id;
-    for(id = 0; id < 2 && (manager.watchpoints[id].address != address || manager.watchpoints[id].debug != ctx->debug); id++);
+    RecursiveLock_Lock(&watchpointManagerLock);
+
+    // The reported address is the one that was accessed, which can be anywhere in the watched range
+    Watchpoint *watchpoint = GDB_FindWatchpoint(ctx, address);
+    for(u32 id = 0; watchpoint == NULL && id < NB_HARDWARE_WATCHPOINTS + MAX_SOFTWARE_WATCHPOINTS; id++)
+    {
+        Watchpoint *wp = &manager.watchpoints[id];
+        u32 start = id < NB_HARDWARE_WATCHPOINTS ? wp->address & ~3 : wp->address;
+        u32 end = id < NB_HARDWARE_WATCHPOINTS ? start + 4 : wp->address + wp->size;
+        if(wp->kind != WATCHPOINT_DISABLED && wp->debug == ctx->debug && address >= start && address < end)
+            watchpoint = wp;
+    }
+
+    WatchpointKind kind = watchpoint == NULL ? WATCHPOINT_DISABLED : watchpoint->kind;
+
+    RecursiveLock_Unlock(&watchpointManagerLock);
+    return kind;
+}
+
+// Classifies the load/store instruction that caused a data abort, and tells whether it might write to PC
+static void GDB_DecodeDataAccess(u32 instr, bool thumb, u32 *instrSize, bool *isStore, bool *writesPc)
+{
+    *isStore = false;
+    *writesPc = false;
+
+    if(!thumb)
+    {
+        *instrSize = 4;
+        bool L = (instr & (1 << 20)) != 0;
+
+        if((instr & 0x0C000000) == 0x04000000) // LDR/STR(B)
+        {
+            *isStore = !L;
+            *writesPc = L && ((instr >> 12) & 0xF) == 15;
+        }
+        else if((instr & 0x0E000000) == 0x08000000) // LDM/STM
+        {
+            *isStore = !L;
+            *writesPc = L && (instr & (1 << 15)) != 0;
+        }
+        else if((instr & 0x0FB00FF0) == 0x01000090) // SWP(B)
+            *isStore = true;
+        else if((instr & 0x0F8000F0) == 0x01800090) // LDREX/STREX
+            *isStore = !L;
+        else if((instr & 0x0E000090) == 0x00000090 && (instr & 0x60) != 0) // LDRH/STRH/LDRSB/LDRSH/LDRD/STRD
+            *isStore = !L && (instr & 0x60) != 0x40;
+        else if((instr & 0x0E000000) == 0x0C000000) // LDC/STC (VFP loads and stores)
+            *isStore = !L;
+
+        return;
+    }
+
+    u16 hw1 = instr & 0xFFFF, hw2 = instr >> 16;
+    if((hw1 >> 11) >= 0x1D)
+    {
+        *instrSize = 4;
+        bool L = (hw1 & (1 << 4)) != 0;
+
+        if((hw1 & 0xFFF0) == 0xE8D0 && (hw2 & 0xFFE0) == 0xF000) // TBB/TBH
+            *writesPc = true;
+        else if((hw1 & 0xFE00) == 0xE800) // LDM/STM, LDRD/STRD, LDREX/STREX
+        {
+            *isStore = !L;
+            *writesPc = L && (hw1 & 0x0040) == 0 && (hw2 & (1 << 15)) != 0;
+        }
+        else if((hw1 & 0xFE00) == 0xF800) // LDR/STR(B/H)
+        {
+            *isStore = !L;
+            *writesPc = L && (hw2 >> 12) == 15;
+        }
+        else if((hw1 & 0xEE00) == 0xEC00) // LDC/STC (VFP loads and stores)
+            *isStore = !L;
+    }
+    else
+    {
+        *instrSize = 2;
+        bool L = (hw1 & (1 << 11)) != 0;
+
+        if((hw1 >> 12) == 5) // register offset
+            *isStore = ((hw1 >> 9) & 7) <= 2;
+        else if((hw1 >> 13) == 3 || (hw1 >> 12) == 8 || (hw1 >> 12) == 9 || (hw1 >> 12) == 12) // immediate offset, SP-relative, LDM/STM
+            *isStore = !L;
+        else if((hw1 & 0xF600) == 0xB400) // PUSH/POP
+        {
+            *isStore = !L;
+            *writesPc = L && (hw1 & (1 << 8)) != 0;
+        }
+    }
+}
+
+static void GDB_StartWatchpointStep(GDBContext *ctx, WatchpointStep *step, u32 threadId, u32 pc, bool thumb, u32 instrSize, bool writesPc, u32 pageAddress)
+{
+    GDB_FinishWatchpointStep(ctx, step);
+
+    step->pending = true;
+    step->threadId = threadId;
+    step->pageAddress = pageAddress;
+    step->hasBreakpoint = step->userBreakpoint = false;
+
+    for(u32 address = pageAddress - 0x1000, i = 0; i < 3; address += 0x1000, i++)
+    {
+        WatchedPage *page = GDB_FindWatchedPage(ctx->debug, address);
+        if(page != NULL)
+            GDB_ProtectWatchedPage(ctx, page, page->originalPerm);
+    }
+
+    // Without a breakpoint, the page is protected again on the next event of the thread
+    if(!writesPc)
+    {
+        step->breakpointAddress = pc + instrSize;
+        step->userBreakpoint = GDB_GetBreakpointInstruction(NULL, ctx, step->breakpointAddress) == 0;
+        step->hasBreakpoint = step->userBreakpoint || GDB_AddBreakpoint(ctx, step->breakpointAddress, thumb, false) == 0;
+    }
+
+    // The other threads can't access the page while it's unprotected. Without a breakpoint to end the step,
+    // they aren't held: the step may only end on the next event of the thread, which may never come
+    step->holdsThreads = step->hasBreakpoint;
+    if(step->holdsThreads)
+        GDB_HoldOtherThreadsForStep(ctx, threadId);
+}
+
+bool GDB_HandleWatchpointDebugEvent(GDBContext *ctx, DebugEventInfo *info)
+{
+    RecursiveLock_Lock(&watchpointManagerLock);
+
+    WatchpointStep *step = GDB_GetWatchpointStep(ctx);
+    bool isException = info->type == DBGEVENT_EXCEPTION;
+    bool consumed = false;
+
+    if(step->pending)
+    {
+        bool isStepBreakpoint = isException && info->exception.type == EXCEVENT_STOP_POINT &&
+                                info->exception.stop_point.type == STOPPOINT_SVC_FF &&
+                                step->hasBreakpoint && info->exception.address == step->breakpointAddress;
+
+        if(isStepBreakpoint || info->thread_id == step->threadId || !step->hasBreakpoint)
+        {
+            consumed = isStepBreakpoint && !step->userBreakpoint;
+            GDB_FinishWatchpointStep(ctx, step);
+        }
+    }
+
+    if(!consumed && isException && info->exception.type == EXCEVENT_DATA_ABORT)
+    {
+        u32 faultAddress = info->exception.fault.fault_information;
+        WatchedPage *page = GDB_FindWatchedPage(ctx->debug, faultAddress & ~0xFFF);
+        ThreadContext regs;
+        u32 instr = 0;
+
+        if(page != NULL && page->perm != page->originalPerm &&
+           R_SUCCEEDED(svcGetDebugThreadContext(&regs, ctx->debug, info->thread_id, THREADCONTEXT_CONTROL_CPU_SPRS)))
+        {
+            u32 pc = regs.cpu_registers.pc;
+            bool thumb = (regs.cpu_registers.cpsr & 0x20) != 0;
+            u32 instrSize;
+            bool isStore, writesPc;
+
+            svcReadProcessMemory(&instr, ctx->debug, pc, (pc & 0xFFF) == 0xFFE ? 2 : 4);
+            GDB_DecodeDataAccess(instr, thumb, &instrSize, &isStore, &writesPc);
+
+            // Read-only pages can only fault on writes
+            if((page->perm & MEMPERM_READ) != 0)
+                isStore = true;
 
-    return id == 2 ? WATCHPOINT_DISABLED : manager.watchpoints[id].kind;
+            Watchpoint *hit = NULL;
+            for(u32 id = NB_HARDWARE_WATCHPOINTS; hit == NULL && id < NB_HARDWARE_WATCHPOINTS + MAX_SOFTWARE_WATCHPOINTS; id++)
+            {
+                Watchpoint *watchpoint = &manager.watchpoints[id];
+                if(watchpoint->kind != WATCHPOINT_DISABLED && watchpoint->debug == ctx->debug &&
+                   faultAddress >= watchpoint->address && faultAddress - watchpoint->address < watchpoint->size &&
+                   (watchpoint->kind == WATCHPOINT_READWRITE || (watchpoint->kind == WATCHPOINT_WRITE) == isStore))
+                    hit = watchpoint;
+            }
+
+            GDB_StartWatchpointStep(ctx, step, info->thread_id, pc, thumb, instrSize, writesPc, page->address);
+
+            if(hit != NULL)
+            {
+                // Report it the same way as hardware watchpoints
+                info->exception.type = EXCEVENT_STOP_POINT;
+                info->exception.stop_point.type = STOPPOINT_WATCHPOINT;
+                info->exception.stop_point.fault_information = faultAddress;
+            }
+            else
+                consumed = true; // something else on the same page
+        }
+    }
+
+    RecursiveLock_Unlock(&watchpointManagerLock);
+    return consumed;
 }
@@ -79,42 +79,236 @@ GDB_DECLARE_XFER_OSDATA_HANDLER(CfwVersion)
     }
 }
 
+/*
+    The memory and processes osdata are snapshotted into caches shared by all clients. A snapshot is only (re)taken
+    when a read starts at offset 0, and only if what it describes has changed; the following chunks of the read are
+    served from the snapshot the read started from, identified by its generation. Two snapshots of each kind are kept,
+    so that a refresh caused by a client doesn't pull the rug from under another one being in the middle of a read.
+
+    The caches are only accessed from the server thread. Process creation and exit may be notified from the debug
+    event monitor thread, hence the atomic counter.
+*/
+
+#define MAX_OSDATA_PROCESSES        0x80
+
+typedef struct OsDataMemorySnapshot
+{
+    u32 generation;
+    u32 used[3]; // application, system, base
+    u32 size;
+    char xml[0x800];
+} OsDataMemorySnapshot;
+
+typedef struct OsDataProcess
+{
+    u32 pid;
+    u32 itemSize;
+    char name[9];
+} OsDataProcess;
+
+typedef struct OsDataProcessesSnapshot
+{
+    u32 generation;
+    u32 notifiedGeneration;
+    u32 nbProcesses;
+    u32 size;
+    OsDataProcess processes[MAX_OSDATA_PROCESSES];
+} OsDataProcessesSnapshot;
+
+static OsDataMemorySnapshot memoryOsData[2];
+static u32 memoryOsDataCurrent;
+static u32 memoryOsDataGeneration;
+
+static OsDataProcessesSnapshot processesOsData[2];
+static u32 processesOsDataCurrent;
+static u32 processesOsDataGeneration;
+static u32 processesOsDataNotifiedGeneration;
+
+static const char processesOsDataHeader[] =
+/*"<?xml version=\"1.0\"?>"
+"<!DOCTYPE target SYSTEM \"osdata.dtd\">" IDA rejects the xml header*/
+"<osdata type=\"processes\">";
+
+static const char processesOsDataItem[] =
+"<item>"
+"<column name=\"pid\">%lu</column>"
+"<column name=\"command\">%s</column>"
+"</item>";
+
+static const char processesOsDataFooter[] = "</osdata>";
+
+void GDB_NotifyProcessListChanged(void)
+{
+    __atomic_add_fetch(&processesOsDataNotifiedGeneration, 1, __ATOMIC_RELAXED);
+}
+
+static const OsDataMemorySnapshot *GDB_UpdateMemoryOsData(void)
+{
+    s64 out;
+    u32 used[3];
+    const OsDataMemorySnapshot *current = &memoryOsData[memoryOsDataCurrent];
+
+    for(u32 i = 0; i < 3; i++)
+    {
+        svcGetSystemInfo(&out, 0, 1 + i);
+        used[i] = (u32)out;
+    }
+
+    if(current->generation != 0 && memcmp(current->used, used, sizeof(used)) == 0)
+        return current;
+
+    OsDataMemorySnapshot *snapshot = &memoryOsData[memoryOsDataCurrent ^ 1];
+    u32 applicationTotal = *(vu32 *)0x1FF80040, systemTotal = *(vu32 *)0x1FF80044, baseTotal = *(vu32 *)0x1FF80048;
+    u32 applicationUsed = used[0], systemUsed = used[1], baseUsed = used[2];
+
+    memcpy(snapshot->used, used, sizeof(used));
+    snapshot->size = (u32)sprintf(snapshot->xml, (const char *)osdata_memory_template_xml,
+        applicationUsed, applicationTotal - applicationUsed, applicationTotal, (u32)((5ULL + ((1000ULL * applicationUsed) / applicationTotal)) / 10ULL),
+        systemUsed, systemTotal - systemUsed, systemTotal, (u32)((5ULL + ((1000ULL * systemUsed) / systemTotal)) / 10ULL),
+        baseUsed, baseTotal - baseUsed, baseTotal, (u32)((5ULL + ((1000ULL * baseUsed) / baseTotal)) / 10ULL)
+    );
+
+    snapshot->generation = ++memoryOsDataGeneration == 0 ? ++memoryOsDataGeneration : memoryOsDataGeneration;
+    memoryOsDataCurrent ^= 1;
+    return snapshot;
+}
+
 GDB_DECLARE_XFER_OSDATA_HANDLER(Memory)
 {
     if(write)
         return GDB_HandleUnsupported(ctx);
     else
     {
-        if(ctx->memoryOsInfoXmlData[0] == 0)
+        const OsDataMemorySnapshot *snapshot = NULL;
+        if(offset == 0)
         {
-            s64 out;
-            u32 applicationUsed, systemUsed, baseUsed;
-            u32 applicationTotal = *(vu32 *)0x1FF80040, systemTotal = *(vu32 *)0x1FF80044, baseTotal = *(vu32 *)0x1FF80048;
+            snapshot = GDB_UpdateMemoryOsData();
+            ctx->memoryOsDataGeneration = snapshot->generation;
+        }
+        else
+        {
+            for(u32 i = 0; i < 2 && ctx->memoryOsDataGeneration != 0 && snapshot == NULL; i++)
+                snapshot = memoryOsData[i].generation == ctx->memoryOsDataGeneration ? &memoryOsData[i] : NULL;
+        }
+
+        if(snapshot == NULL)
+            return GDB_ReplyErrno(ctx, EAGAIN); // replaced since the read started
+
+        return GDB_SendStreamData(ctx, snapshot->xml, offset, length, snapshot->size, false);
+    }
+}
+
+static const OsDataProcess *GDB_FindOsDataProcess(const OsDataProcessesSnapshot *snapshot, u32 pid)
+{
+    for(u32 i = 0; i < snapshot->nbProcesses; i++)
+    {
+        if(snapshot->processes[i].pid == pid)
+            return &snapshot->processes[i];
+    }
 
-            svcGetSystemInfo(&out, 0, 1);
-            applicationUsed = (u32)out;
+    return NULL;
+}
 
-            svcGetSystemInfo(&out, 0, 2);
-            systemUsed = (u32)out;
+static const OsDataProcessesSnapshot *GDB_UpdateProcessesOsData(void)
+{
+    u32 pidList[MAX_OSDATA_PROCESSES];
+    s32 processAmount;
+    const OsDataProcessesSnapshot *current = &processesOsData[processesOsDataCurrent];
+    u32 notifiedGeneration = __atomic_load_n(&processesOsDataNotifiedGeneration, __ATOMIC_RELAXED);
 
-            svcGetSystemInfo(&out, 0, 3);
-            baseUsed = (u32)out;
+    if(R_FAILED(svcGetProcessList(&processAmount, pidList, MAX_OSDATA_PROCESSES)))
+        processAmount = 0;
 
-            sprintf(ctx->memoryOsInfoXmlData, (const char *)osdata_memory_template_xml,
-                applicationUsed, applicationTotal - applicationUsed, applicationTotal, (u32)((5ULL + ((1000ULL * applicationUsed) / applicationTotal)) / 10ULL),
-                systemUsed, systemTotal - systemUsed, systemTotal, (u32)((5ULL + ((1000ULL * systemUsed) / systemTotal)) / 10ULL),
-                baseUsed, baseTotal - baseUsed, baseTotal, (u32)((5ULL + ((1000ULL * baseUsed) / baseTotal)) / 10ULL)
-            );
+    if(current->generation != 0 && current->notifiedGeneration == notifiedGeneration && current->nbProcesses == (u32)processAmount)
+    {
+        s32 i;
+        for(i = 0; i < processAmount && current->processes[i].pid == pidList[i]; i++);
+        if(i == processAmount)
+            return current;
+    }
+
+    // Only the processes we haven't seen before need to be opened
+    OsDataProcessesSnapshot *snapshot = &processesOsData[processesOsDataCurrent ^ 1];
+    char item[sizeof(processesOsDataItem) + 16];
+    u32 n = 0;
+
+    snapshot->size = sizeof(processesOsDataHeader) - 1 + sizeof(processesOsDataFooter) - 1;
+    for(s32 i = 0; i < processAmount; i++)
+    {
+        OsDataProcess *process = &snapshot->processes[n];
+        const OsDataProcess *known = current->generation != 0 ? GDB_FindOsDataProcess(current, pidList[i]) : NULL;
+
+        if(known != NULL)
+            *process = *known;
+        else
+        {
+            s64 out;
+            Handle processHandle;
+            if(R_FAILED(svcOpenProcess(&processHandle, pidList[i])))
+                continue;
+
+            memset(process, 0, sizeof(OsDataProcess));
+            process->pid = pidList[i];
+            svcGetProcessInfo(&out, processHandle, 0x10000);
+            memcpy(process->name, &out, 8);
+            svcCloseHandle(processHandle);
+
+            process->itemSize = (u32)sprintf(item, processesOsDataItem, GDB_ConvertFromRealPid(process->pid), process->name);
         }
 
-        u32 size = strlen(ctx->memoryOsInfoXmlData);
-        int n = GDB_SendStreamData(ctx, ctx->memoryOsInfoXmlData, offset, length, size, false);
+        snapshot->size += process->itemSize;
+        n++;
+    }
+
+    snapshot->nbProcesses = n;
+    snapshot->notifiedGeneration = notifiedGeneration;
+    snapshot->generation = ++processesOsDataGeneration == 0 ? ++processesOsDataGeneration : processesOsDataGeneration;
+    processesOsDataCurrent ^= 1;
+    return snapshot;
+}
+
+// Appends the part of text[0..size) overlapping the requested range to the chunk being built
+static void GDB_AppendOsDataChunk(char *chunk, u32 *chunkPos, u32 *pos, u32 offset, u32 length, const char *text, u32 size)
+{
+    u32 start = *pos, end = *pos + size;
+    *pos = end;
 
-        if(offset + length >= size)
-            ctx->memoryOsInfoXmlData[0] = 0; // we're done, invalidate
+    if(end <= offset || start >= offset + length)
+        return;
+
+    u32 from = offset > start ? offset - start : 0;
+    u32 to = offset + length < end ? offset + length - start : size;
+    memcpy(chunk + *chunkPos, text + from, to - from);
+    *chunkPos += to - from;
+}
 
-        return n;
+// The XML is never stored as a whole: only the items the chunk overlaps are formatted
+static int GDB_SendProcessesOsDataChunk(GDBContext *ctx, const OsDataProcessesSnapshot *processes, u32 offset, u32 length)
+{
+    char *chunk = (char *)ctx->workBuffer;
+    char item[sizeof(processesOsDataItem) + 16];
+    u32 chunkPos = 0, pos = 0;
+
+    if(length > GDB_BUF_LEN - 1)
+        length = GDB_BUF_LEN - 1;
+    if(offset >= processes->size)
+        return GDB_SendStreamData(ctx, chunk, 0, length, 0, false);
+
+    GDB_AppendOsDataChunk(chunk, &chunkPos, &pos, offset, length, processesOsDataHeader, sizeof(processesOsDataHeader) - 1);
+    for(u32 i = 0; i < processes->nbProcesses && pos < offset + length; i++)
+    {
+        const OsDataProcess *process = &processes->processes[i];
+        if(pos + process->itemSize <= offset)
+            pos += process->itemSize;
+        else
+        {
+            sprintf(item, processesOsDataItem, GDB_ConvertFromRealPid(process->pid), process->name);
+            GDB_AppendOsDataChunk(chunk, &chunkPos, &pos, offset, length, item, process->itemSize);
+        }
     }
+    GDB_AppendOsDataChunk(chunk, &chunkPos, &pos, offset, length, processesOsDataFooter, sizeof(processesOsDataFooter) - 1);
+
+    return GDB_SendStreamData(ctx, chunk, 0, chunkPos, processes->size - offset, false);
 }
 
 GDB_DECLARE_XFER_OSDATA_HANDLER(Processes)
@@ -123,60 +317,22 @@ GDB_DECLARE_XFER_OSDATA_HANDLER(Processes)
         return GDB_HandleUnsupported(ctx);
     else
     {
-        if(ctx->processesOsInfoXmlData[0] == 0)
+        const OsDataProcessesSnapshot *snapshot = NULL;
+        if(offset == 0)
         {
-            static const char header[] =
-            /*"<?xml version=\"1.0\"?>"
-            "<!DOCTYPE target SYSTEM \"osdata.dtd\">" IDA rejects the xml header*/
-            "<osdata type=\"processes\">";
-
-            static const char item[] =
-            "<item>"
-            "<column name=\"pid\">%lu</column>"
-            "<column name=\"command\">%s</column>"
-            "</item>";
-
-            static const char footer[] = "</osdata>";
-
-            int n;
-            u32 pos = 0;
-
-            u32 pidList[0x40];
-            s32 processAmount;
-
-            strcpy(ctx->processesOsInfoXmlData, header);
-            pos = sizeof(header) - 1;
-            svcGetProcessList(&processAmount, pidList, 0x40);
-
-            for(s32 i = 0; i < processAmount; i++)
-            {
-                u32 pid = pidList[i];
-                char name[9] = { 0 };
-                s64 out;
-                Handle processHandle;
-                Result res = svcOpenProcess(&processHandle, pidList[i]);
-                if(R_FAILED(res))
-                    continue;
-
-                svcGetProcessInfo(&out, processHandle, 0x10000);
-                memcpy(name, &out, 8);
-                svcCloseHandle(processHandle);
-
-                n = sprintf(ctx->processesOsInfoXmlData + pos, item, GDB_ConvertFromRealPid(pid), name);
-                pos += (u32)n;
-            }
-
-            strcpy(ctx->processesOsInfoXmlData + pos, footer);
-            pos = sizeof(footer) - 1;
+            snapshot = GDB_UpdateProcessesOsData();
+            ctx->processesOsDataGeneration = snapshot->generation;
+        }
+        else
+        {
+            for(u32 i = 0; i < 2 && ctx->processesOsDataGeneration != 0 && snapshot == NULL; i++)
+                snapshot = processesOsData[i].generation == ctx->processesOsDataGeneration ? &processesOsData[i] : NULL;
         }
 
-        u32 size = strlen(ctx->processesOsInfoXmlData);
-        int n = GDB_SendStreamData(ctx, ctx->processesOsInfoXmlData, offset, length, size, false);
-
-        if(offset + length >= size)
-            ctx->processesOsInfoXmlData[0] = 0; // we're done, invalidate
+        if(snapshot == NULL)
+            return GDB_ReplyErrno(ctx, EAGAIN); // replaced since the read started
 
-        return n;
+        return GDB_SendProcessesOsDataChunk(ctx, snapshot, offset, length);
     }
 }
 
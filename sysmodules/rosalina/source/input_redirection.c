@@ -52,6 +52,105 @@ static u32 hidData[] = { 0x00000FFF, 0x02000000, 0x007FF7FF, 0x00000000, 0x00000
 static u32 irData[] = { 0x80800081 }; // Default: C-Stick at the center, no buttons.
 
 int inputRedirectionStartResult;
+InputRedirectionStats inputRedirectionStats;
+
+/*
+    Protocol, all fields being little-endian:
+    - v1: pad state, touch screen state, circle pad state (12 bytes), optionally followed by
+      the IR state (C-stick and ZL/ZR) and the special buttons (HOME, POWER, POWER held long), 20 bytes in total.
+    - v2: a 16-byte header followed by nbSamples samples having the full v1 layout, oldest first. The sequence number
+      and the timestamp (in microseconds, sender clock) are those of the latest sample, the samples before it having
+      consecutive sequence numbers. Sending a few of the previous samples along makes up for lost packets
+      (button presses and releases aren't missed), and packets older than the latest one received are dropped.
+      tools/input_redirection_sender.c is a host sender for testing it.
+    Datagrams longer than 20 bytes without the v2 magic are padded v1 ones, as some senders pad their packets:
+    their first 20 bytes are used, like before v2 existed.
+*/
+
+#define INPUT_REDIRECTION_V2_MAGIC          0x32445249 // "IRD2"
+#define INPUT_REDIRECTION_MAX_SAMPLES       8
+#define INPUT_REDIRECTION_SEQUENCE_WINDOW   0x100 // anything further behind means the sender has restarted
+
+typedef struct InputRedirectionSample
+{
+    u32 pad;
+    u32 touchScreen;
+    u32 circlePad;
+    u32 ir;
+    u32 specialButtons;
+} InputRedirectionSample;
+
+typedef struct InputRedirectionPacketHeader
+{
+    u32 magic;
+    u32 sequence;
+    u32 timestamp;
+    u8 nbSamples;
+    u8 reserved[3];
+} InputRedirectionPacketHeader;
+
+typedef struct InputRedirectionSession
+{
+    bool active;
+    u32 lastSequence;
+    u32 minDelay; // local clock minus sender clock, lowest seen
+} InputRedirectionSession;
+
+static void InputRedirection_PublishSpecialButtons(u32 oldSpecialButtons, u32 specialButtons)
+{
+    if(!(oldSpecialButtons & 1) && (specialButtons & 1)) // HOME button pressed
+        srvPublishToSubscriber(0x204, 0);
+    else if((oldSpecialButtons & 1) && !(specialButtons & 1)) // HOME button released
+        srvPublishToSubscriber(0x205, 0);
+
+    if(!(oldSpecialButtons & 2) && (specialButtons & 2)) // POWER button pressed
+        srvPublishToSubscriber(0x202, 0);
+
+    if(!(oldSpecialButtons & 4) && (specialButtons & 4)) // POWER button held long
+        srvPublishToSubscriber(0x203, 0);
+}
+
+static void InputRedirection_RecordLatency(InputRedirectionSession *session, u32 timestamp)
+{
+    u32 delay = (u32)(svcGetSystemTick() / (SYSCLOCK_ARM11 / 1000000)) - timestamp;
+    if((s32)(delay - session->minDelay) < 0)
+        session->minDelay = delay;
+
+    u32 ms = (delay - session->minDelay) / 1000, bucket;
+    for(bucket = 0; bucket < INPUT_REDIRECTION_NB_LATENCY_BUCKETS - 1 && ms >= (1u << bucket); bucket++);
+    inputRedirectionStats.latencyHistogram[bucket]++;
+}
+
+// Returns the number of samples to apply, these being the last ones of the packet
+static u32 InputRedirection_ProcessPacketHeader(InputRedirectionSession *session, const InputRedirectionPacketHeader *hdr, int size)
+{
+    u32 nbSamples = hdr->nbSamples;
+    if(hdr->magic != INPUT_REDIRECTION_V2_MAGIC || nbSamples == 0 || nbSamples > INPUT_REDIRECTION_MAX_SAMPLES ||
+       (u32)size < sizeof(InputRedirectionPacketHeader) + nbSamples * sizeof(InputRedirectionSample))
+        return 0;
+
+    inputRedirectionStats.nbPackets++;
+
+    s32 diff = (s32)(hdr->sequence - session->lastSequence);
+    if(!session->active || diff <= -INPUT_REDIRECTION_SEQUENCE_WINDOW)
+    {
+        session->active = true;
+        session->minDelay = (u32)(svcGetSystemTick() / (SYSCLOCK_ARM11 / 1000000)) - hdr->timestamp;
+        diff = (s32)nbSamples;
+    }
+    else if(diff <= 0)
+    {
+        inputRedirectionStats.nbStalePackets++;
+        return 0;
+    }
+    else if((u32)diff > nbSamples)
+        inputRedirectionStats.nbLostSamples += (u32)diff - nbSamples;
+
+    session->lastSequence = hdr->sequence;
+    InputRedirection_RecordLatency(session, hdr->timestamp);
+
+    return (u32)diff < nbSamples ? (u32)diff : nbSamples;
+}
 
 void inputRedirectionThreadMain(void)
 {
@@ -112,8 +211,12 @@ void inputRedirectionThreadMain(void)
 
     u32 *irDataPhys = PA_FROM_VA_PTR(irData);
 
-    char buf[20];
-    u32 oldSpecialButtons = 0, specialButtons = 0;
+    u8 ALIGN(4) buf[sizeof(InputRedirectionPacketHeader) + INPUT_REDIRECTION_MAX_SAMPLES * sizeof(InputRedirectionSample)];
+    u32 specialButtons = 0;
+    InputRedirectionSession session = { 0 };
+
+    memset(&inputRedirectionStats, 0, sizeof(InputRedirectionStats));
+
     while(inputRedirectionEnabled && !preTerminationRequested)
     {
         struct pollfd pfd;
@@ -121,33 +224,44 @@ void inputRedirectionThreadMain(void)
         pfd.events = POLLIN;
         pfd.revents = 0;
 
+        // The timeout only bounds how long it takes to notice we're being disabled, poll returns as soon as a packet arrives
         int pollres = socPoll(&pfd, 1, 10);
         if(pollres > 0 && (pfd.revents & POLLIN))
         {
-            int n = socRecvfrom(sock, buf, 20, 0, NULL, 0);
+            int n = socRecvfrom(sock, buf, sizeof(buf), 0, NULL, 0);
             if(n < 0)
                 break;
             else if(n < 12)
                 continue;
+            else if(n > 20 && ((const InputRedirectionPacketHeader *)buf)->magic == INPUT_REDIRECTION_V2_MAGIC)
+            {
+                const InputRedirectionPacketHeader *hdr = (const InputRedirectionPacketHeader *)buf;
+                const InputRedirectionSample *samples = (const InputRedirectionSample *)(buf + sizeof(InputRedirectionPacketHeader));
+                u32 nbNewSamples = InputRedirection_ProcessPacketHeader(&session, hdr, n);
+
+                for(u32 i = hdr->nbSamples - nbNewSamples; i < hdr->nbSamples; i++)
+                {
+                    InputRedirection_PublishSpecialButtons(specialButtons, samples[i].specialButtons);
+                    specialButtons = samples[i].specialButtons;
+                }
+
+                if(nbNewSamples != 0)
+                {
+                    const InputRedirectionSample *latest = &samples[hdr->nbSamples - 1];
+                    memcpy(hidDataPhys, latest, 12);
+                    memcpy(irDataPhys, &latest->ir, 4);
+                }
+                continue;
+            }
 
             memcpy(hidDataPhys, buf, 12);
             if(n >= 20)
             {
-                memcpy(irDataPhys, buf + 12, 4);
+                u32 oldSpecialButtons = specialButtons;
 
-                oldSpecialButtons = specialButtons;
+                memcpy(irDataPhys, buf + 12, 4);
                 memcpy(&specialButtons, buf + 16, 4);
-
-                if(!(oldSpecialButtons & 1) && (specialButtons & 1)) // HOME button pressed
-                    srvPublishToSubscriber(0x204, 0);
-                else if((oldSpecialButtons & 1) && !(specialButtons & 1)) // HOME button released
-                    srvPublishToSubscriber(0x205, 0);
-
-                if(!(oldSpecialButtons & 2) && (specialButtons & 2)) // POWER button pressed
-                    srvPublishToSubscriber(0x202, 0);
-
-                if(!(oldSpecialButtons & 4) && (specialButtons & 4)) // POWER button held long
-                    srvPublishToSubscriber(0x203, 0);
+                InputRedirection_PublishSpecialButtons(oldSpecialButtons, specialButtons);
             }
         }
         else if(pollres < -10000)
@@ -46,6 +46,7 @@
 #include "minisoc.h"
 #include "draw.h"
 #include "bootdiag.h"
+#include "memory_scan.h"
 
 #include "task_runner.h"
 
@@ -264,6 +265,8 @@ int main(void)
         svcBreak(USERBREAK_ASSERT);
 
     Draw_Init();
+    Cheat_Init();
+    MemoryScan_Init();
     Cheat_SeedRng(svcGetSystemTick());
 
     MyThread *menuThread = menuCreateThread();
@@ -0,0 +1,643 @@
+/*
+*   This file is part of Luma3DS
+*   Copyright (C) 2016-2020 Aurora Wright, TuxSH
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+#include <3ds.h>
+#include "memory_scan.h"
+#include "memory.h"
+#include "ifile.h"
+
+// Candidates are kept as a delta-encoded (LEB128) address stream plus a packed array of their last known values,
+// each in its own arena committed on demand. Unknown-value first scans are snapshotted to the SD card instead.
+#define MEMSCAN_ADDRESSES_ADDRESS   0x0F400000
+#define MEMSCAN_VALUES_ADDRESS      0x0F600000
+#define MEMSCAN_ARENA_MAX_SIZE      0x200000
+#define MEMSCAN_ARENA_GROWTH        0x4000
+#define MEMSCAN_MAX_DELTA_SIZE      5
+
+#define MEMSCAN_SNAPSHOT_PATH       "/luma/cache/memscan.bin"
+
+typedef enum MemoryScanState
+{
+    MEMSCAN_STATE_NONE = 0,
+    MEMSCAN_STATE_SNAPSHOT,
+    MEMSCAN_STATE_LIST,
+} MemoryScanState;
+
+typedef struct MemoryScanArena
+{
+    u32 base;
+    u32 committed;
+    u32 used;
+} MemoryScanArena;
+
+typedef struct MemoryScanSnapshotRecord
+{
+    u32 address;
+    u32 size;
+} MemoryScanSnapshotRecord;
+
+typedef struct MemoryScanPass
+{
+    MemoryScanFilter filter;
+    u32 value;
+    u32 valueSize;
+
+    // Candidates of the previous scan
+    bool hasNext;
+    u32 nextAddress;
+    u32 nextValue;
+    u32 readOffset;
+    u32 readValueOffset;
+    u32 readRemaining;
+
+    // Candidates of this scan. When refining a list, they are written over the ones already read
+    u32 writeOffset;
+    u32 writeValueOffset;
+    u32 writeAddress;
+    u32 count;
+    bool overflow;
+} MemoryScanPass;
+
+static RecursiveLock memoryScanLock;
+static MemoryScanArena memoryScanAddresses = { MEMSCAN_ADDRESSES_ADDRESS, 0, 0 };
+static MemoryScanArena memoryScanValues = { MEMSCAN_VALUES_ADDRESS, 0, 0 };
+static MemoryScanState memoryScanState = MEMSCAN_STATE_NONE;
+static MemoryScanValueType memoryScanType;
+static u32 memoryScanPid;
+static u32 memoryScanCount;
+
+static u8 memoryScanSnapshotBuffer[0x2000];
+
+static const char *memoryScanTypeNames[MEMSCAN_TYPE_MAX] = { "u8", "u16", "u32", "float" };
+static const char *memoryScanFilterNames[MEMSCAN_FILTER_MAX] = { "equal", "unknown", "changed", "unchanged", "increased", "decreased" };
+
+void MemoryScan_Init(void)
+{
+    RecursiveLock_Init(&memoryScanLock);
+}
+
+static inline u32 MemoryScan_GetValueSize(MemoryScanValueType type)
+{
+    return type == MEMSCAN_TYPE_U8 ? 1 : type == MEMSCAN_TYPE_U16 ? 2 : 4;
+}
+
+static inline u32 MemoryScan_ReadValue(const u8 *data, u32 valueSize)
+{
+    switch(valueSize)
+    {
+        case 1: return *data;
+        case 2: return *(const u16 *)data;
+        default: return *(const u32 *)data;
+    }
+}
+
+static inline float MemoryScan_ToFloat(u32 value)
+{
+    union { u32 u; float f; } conv = { .u = value };
+    return conv.f;
+}
+
+static bool MemoryScan_ArenaCommit(MemoryScanArena *arena, u32 end)
+{
+    if(end <= arena->committed)
+        return true;
+
+    u32 newCommitted = (end + MEMSCAN_ARENA_GROWTH - 1) & ~(MEMSCAN_ARENA_GROWTH - 1);
+    if(newCommitted > MEMSCAN_ARENA_MAX_SIZE)
+        return false;
+
+    u32 tmp;
+    Result res = svcControlMemoryEx(&tmp, arena->base + arena->committed, 0, newCommitted - arena->committed,
+                                    MEMOP_ALLOC, MEMREGION_SYSTEM | MEMPERM_READWRITE, true);
+    if(R_FAILED(res))
+        return false;
+
+    arena->committed = newCommitted;
+    return true;
+}
+
+static void MemoryScan_ArenaReset(MemoryScanArena *arena)
+{
+    u32 tmp;
+    if(arena->committed != 0)
+        svcControlMemory(&tmp, arena->base, 0, arena->committed, MEMOP_FREE, 0);
+
+    arena->committed = arena->used = 0;
+}
+
+static void MemoryScan_DeleteSnapshot(void)
+{
+    FS_Archive archive;
+    if(R_SUCCEEDED(FSUSER_OpenArchive(&archive, ARCHIVE_SDMC, fsMakePath(PATH_EMPTY, ""))))
+    {
+        FSUSER_DeleteFile(archive, fsMakePath(PATH_ASCII, MEMSCAN_SNAPSHOT_PATH));
+        FSUSER_CloseArchive(archive);
+    }
+}
+
+static void MemoryScan_ResetState(void)
+{
+    if(memoryScanState == MEMSCAN_STATE_SNAPSHOT)
+        MemoryScan_DeleteSnapshot();
+
+    MemoryScan_ArenaReset(&memoryScanAddresses);
+    MemoryScan_ArenaReset(&memoryScanValues);
+    memoryScanState = MEMSCAN_STATE_NONE;
+    memoryScanCount = 0;
+    memoryScanPid = 0;
+}
+
+void MemoryScan_Reset(void)
+{
+    RecursiveLock_Lock(&memoryScanLock);
+    MemoryScan_ResetState();
+    RecursiveLock_Unlock(&memoryScanLock);
+}
+
+static void MemoryScan_ReadNextCandidate(MemoryScanPass *pass)
+{
+    if(pass->readRemaining == 0)
+    {
+        pass->hasNext = false;
+        return;
+    }
+
+    const u8 *pos = (const u8 *)memoryScanAddresses.base + pass->readOffset;
+    u32 delta = 0;
+    u32 shift = 0;
+    u8 b;
+    do
+    {
+        b = *pos++;
+        delta |= (u32)(b & 0x7F) << shift;
+        shift += 7;
+    }
+    while(b & 0x80);
+
+    pass->readOffset = (u32)pos - memoryScanAddresses.base;
+    pass->nextAddress += delta;
+    pass->nextValue = MemoryScan_ReadValue((const u8 *)memoryScanValues.base + pass->readValueOffset, pass->valueSize);
+    pass->readValueOffset += pass->valueSize;
+    pass->readRemaining--;
+    pass->hasNext = true;
+}
+
+// Writing an entry never catches up with the read position when refining in place, as the
+// encoded size of a sum of deltas is never larger than the sum of their encoded sizes
+static void MemoryScan_WriteCandidate(MemoryScanPass *pass, u32 address, u32 value)
+{
+    if(pass->overflow)
+        return;
+
+    if(!MemoryScan_ArenaCommit(&memoryScanAddresses, pass->writeOffset + MEMSCAN_MAX_DELTA_SIZE) ||
+       !MemoryScan_ArenaCommit(&memoryScanValues, pass->writeValueOffset + pass->valueSize))
+    {
+        pass->overflow = true;
+        return;
+    }
+
+    u8 *pos = (u8 *)memoryScanAddresses.base + pass->writeOffset;
+    u32 delta = address - pass->writeAddress;
+    while(delta >= 0x80)
+    {
+        *pos++ = (u8)(delta | 0x80);
+        delta >>= 7;
+    }
+    *pos++ = (u8)delta;
+    pass->writeOffset = (u32)pos - memoryScanAddresses.base;
+    pass->writeAddress = address;
+
+    u8 *valuePos = (u8 *)memoryScanValues.base + pass->writeValueOffset;
+    switch(pass->valueSize)
+    {
+        case 1: *valuePos = (u8)value; break;
+        case 2: *(u16 *)valuePos = (u16)value; break;
+        default: *(u32 *)valuePos = value; break;
+    }
+    pass->writeValueOffset += pass->valueSize;
+    pass->count++;
+}
+
+static bool MemoryScan_Matches(const MemoryScanPass *pass, u32 value, u32 previousValue)
+{
+    if(memoryScanType == MEMSCAN_TYPE_FLOAT)
+    {
+        switch(pass->filter)
+        {
+            case MEMSCAN_FILTER_EQUAL: return MemoryScan_ToFloat(value) == MemoryScan_ToFloat(pass->value);
+            case MEMSCAN_FILTER_INCREASED: return MemoryScan_ToFloat(value) > MemoryScan_ToFloat(previousValue);
+            case MEMSCAN_FILTER_DECREASED: return MemoryScan_ToFloat(value) < MemoryScan_ToFloat(previousValue);
+            default: break;
+        }
+    }
+
+    switch(pass->filter)
+    {
+        case MEMSCAN_FILTER_EQUAL: return value == pass->value;
+        case MEMSCAN_FILTER_CHANGED: return value != previousValue;
+        case MEMSCAN_FILTER_UNCHANGED: return value == previousValue;
+        case MEMSCAN_FILTER_INCREASED: return value > previousValue;
+        case MEMSCAN_FILTER_DECREASED: return value < previousValue;
+        default: return true;
+    }
+}
+
+// First scan for a known value: integers are matched a word at a time, only looking at the
+// individual values of words that contain a match
+static void MemoryScan_FindValue(MemoryScanPass *pass, u32 address, const u8 *data, u32 size)
+{
+    u32 valueSize = pass->valueSize;
+    u32 i = 0;
+
+    if(memoryScanType != MEMSCAN_TYPE_FLOAT && ((u32)data & 3) == 0)
+    {
+        u32 lows = valueSize == 1 ? 0x01010101 : 0x00010001;
+        u32 highs = lows << (8 * valueSize - 1);
+        u32 pattern = valueSize == 4 ? pass->value : pass->value * lows;
+
+        for(; i + 4 <= size && !pass->overflow; i += 4)
+        {
+            u32 word = *(const u32 *)(data + i) ^ pattern;
+            if(valueSize == 4 ? word != 0 : ((word - lows) & ~word & highs) == 0)
+                continue;
+
+            for(u32 j = 0; j < 4; j += valueSize)
+            {
+                if(MemoryScan_ReadValue(data + i + j, valueSize) == pass->value)
+                    MemoryScan_WriteCandidate(pass, address + i + j, pass->value);
+            }
+        }
+    }
+
+    for(; i + valueSize <= size && !pass->overflow; i += valueSize)
+    {
+        u32 value = MemoryScan_ReadValue(data + i, valueSize);
+        if(MemoryScan_Matches(pass, value, value))
+            MemoryScan_WriteCandidate(pass, address + i, value);
+    }
+}
+
+static void MemoryScan_RefineList(MemoryScanPass *pass, u32 address, const u8 *data, u32 size)
+{
+    while(pass->hasNext && pass->nextAddress < address)
+        MemoryScan_ReadNextCandidate(pass);
+
+    while(pass->hasNext && size >= pass->valueSize && pass->nextAddress - address <= size - pass->valueSize)
+    {
+        u32 value = MemoryScan_ReadValue(data + (pass->nextAddress - address), pass->valueSize);
+        u32 candidateAddress = pass->nextAddress;
+        bool matches = MemoryScan_Matches(pass, value, pass->nextValue);
+
+        MemoryScan_ReadNextCandidate(pass);
+        if(matches)
+            MemoryScan_WriteCandidate(pass, candidateAddress, value);
+    }
+}
+
+static Result MemoryScan_WriteSnapshot(MemoryScanPass *pass, MemoryScanNextChunkFunc nextChunk, void *userData)
+{
+    FS_Archive archive;
+    IFile file;
+    u64 total;
+    MemoryScanChunk chunk;
+
+    Result res = FSUSER_OpenArchive(&archive, ARCHIVE_SDMC, fsMakePath(PATH_EMPTY, ""));
+    if(R_FAILED(res))
+        return res;
+
+    FSUSER_CreateDirectory(archive, fsMakePath(PATH_ASCII, "/luma/cache"), 0);
+    res = IFile_OpenFromArchive(&file, archive, fsMakePath(PATH_ASCII, MEMSCAN_SNAPSHOT_PATH), FS_OPEN_CREATE | FS_OPEN_WRITE);
+    if(R_SUCCEEDED(res))
+    {
+        res = IFile_SetSize(&file, 0);
+        while(R_SUCCEEDED(res) && nextChunk(&chunk, userData))
+        {
+            MemoryScanSnapshotRecord record = { chunk.address, chunk.size };
+            res = IFile_Write(&file, &total, &record, sizeof(record), 0);
+            if(R_SUCCEEDED(res))
+                res = IFile_Write(&file, &total, chunk.data, chunk.size, 0);
+            if(R_SUCCEEDED(res))
+                pass->count += chunk.size / pass->valueSize;
+        }
+
+        IFile_Close(&file);
+    }
+
+    FSUSER_CloseArchive(archive);
+    return res;
+}
+
+static Result MemoryScan_RefineSnapshot(MemoryScanPass *pass, MemoryScanNextChunkFunc nextChunk, void *userData)
+{
+    FS_Archive archive;
+    IFile file;
+    u64 total, size;
+    MemoryScanChunk chunk;
+    MemoryScanSnapshotRecord record = { 0 };
+
+    Result res = FSUSER_OpenArchive(&archive, ARCHIVE_SDMC, fsMakePath(PATH_EMPTY, ""));
+    if(R_FAILED(res))
+        return res;
+
+    res = IFile_OpenFromArchive(&file, archive, fsMakePath(PATH_ASCII, MEMSCAN_SNAPSHOT_PATH), FS_OPEN_READ);
+    if(R_FAILED(res))
+    {
+        FSUSER_CloseArchive(archive);
+        return res;
+    }
+
+    // Merge-join the snapshot records with the chunks, both in ascending address order
+    res = IFile_GetSize(&file, &size);
+    bool done = R_FAILED(res);
+    while(!done && !pass->overflow && nextChunk(&chunk, userData))
+    {
+        u32 chunkEnd = chunk.address + chunk.size;
+        while(!pass->overflow)
+        {
+            if(record.size == 0)
+            {
+                if(file.pos >= size)
+                {
+                    done = true;
+                    break;
+                }
+
+                res = IFile_Read(&file, &total, &record, sizeof(record));
+                if(R_FAILED(res) || total != sizeof(record))
+                {
+                    done = true;
+                    break;
+                }
+            }
+
+            if(record.address >= chunkEnd)
+                break;
+
+            u32 skipped = record.address + record.size <= chunk.address ? record.size :
+                          record.address < chunk.address ? chunk.address - record.address : 0;
+            file.pos += skipped;
+            record.address += skipped;
+            record.size -= skipped;
+            if(record.size == 0)
+                continue;
+
+            u32 overlap = chunkEnd - record.address < record.size ? chunkEnd - record.address : record.size;
+            while(overlap >= pass->valueSize && !pass->overflow)
+            {
+                u32 len = overlap < sizeof(memoryScanSnapshotBuffer) ? overlap : sizeof(memoryScanSnapshotBuffer);
+                res = IFile_Read(&file, &total, memoryScanSnapshotBuffer, len);
+                if(R_FAILED(res) || total != len)
+                {
+                    done = true;
+                    break;
+                }
+
+                const u8 *data = (const u8 *)chunk.data + (record.address - chunk.address);
+                for(u32 i = 0; i + pass->valueSize <= len; i += pass->valueSize)
+                {
+                    u32 value = MemoryScan_ReadValue(data + i, pass->valueSize);
+                    if(MemoryScan_Matches(pass, value, MemoryScan_ReadValue(memoryScanSnapshotBuffer + i, pass->valueSize)))
+                        MemoryScan_WriteCandidate(pass, record.address + i, value);
+                }
+
+                record.address += len;
+                record.size -= len;
+                overlap -= len;
+            }
+
+            if(done)
+                break;
+
+            // Drop what is left of the overlap (a partial value)
+            file.pos += overlap;
+            record.address += overlap;
+            record.size -= overlap;
+            if(record.address >= chunkEnd)
+                break;
+        }
+    }
+
+    IFile_Close(&file);
+    FSUSER_CloseArchive(archive);
+    return res;
+}
+
+static void MemoryScan_InitPass(MemoryScanPass *pass, MemoryScanFilter filter, u32 value)
+{
+    memset(pass, 0, sizeof(MemoryScanPass));
+    pass->filter = filter;
+    pass->valueSize = MemoryScan_GetValueSize(memoryScanType);
+    pass->value = pass->valueSize == 4 ? value : value & ((1u << (8 * pass->valueSize)) - 1);
+}
+
+Result MemoryScan_FirstScan(u32 pid, MemoryScanValueType type, MemoryScanFilter filter, u32 value, MemoryScanNextChunkFunc nextChunk, void *userData)
+{
+    MemoryScanPass pass;
+    MemoryScanChunk chunk;
+    Result res = 0;
+
+    if(type >= MEMSCAN_TYPE_MAX || (filter != MEMSCAN_FILTER_EQUAL && filter != MEMSCAN_FILTER_UNKNOWN))
+        return MAKERESULT(RL_PERMANENT, RS_INVALIDARG, RM_APPLICATION, RD_INVALID_COMBINATION);
+
+    RecursiveLock_Lock(&memoryScanLock);
+
+    MemoryScan_ResetState();
+    memoryScanType = type;
+    MemoryScan_InitPass(&pass, filter, value);
+
+    if(filter == MEMSCAN_FILTER_UNKNOWN)
+    {
+        res = MemoryScan_WriteSnapshot(&pass, nextChunk, userData);
+        memoryScanState = MEMSCAN_STATE_SNAPSHOT;
+    }
+    else
+    {
+        while(!pass.overflow && nextChunk(&chunk, userData))
+            MemoryScan_FindValue(&pass, chunk.address, (const u8 *)chunk.data, chunk.size);
+
+        if(pass.overflow)
+            res = MAKERESULT(RL_PERMANENT, RS_OUTOFRESOURCE, RM_APPLICATION, RD_OUT_OF_MEMORY);
+
+        memoryScanAddresses.used = pass.writeOffset;
+        memoryScanValues.used = pass.writeValueOffset;
+        memoryScanState = MEMSCAN_STATE_LIST;
+    }
+
+    memoryScanCount = pass.count;
+    memoryScanPid = pid;
+    if(R_FAILED(res))
+        MemoryScan_ResetState();
+
+    RecursiveLock_Unlock(&memoryScanLock);
+    return res;
+}
+
+Result MemoryScan_NextScan(u32 pid, MemoryScanFilter filter, u32 value, MemoryScanNextChunkFunc nextChunk, void *userData)
+{
+    MemoryScanPass pass;
+    MemoryScanChunk chunk;
+    Result res = 0;
+
+    if(filter >= MEMSCAN_FILTER_MAX || filter == MEMSCAN_FILTER_UNKNOWN)
+        return MAKERESULT(RL_PERMANENT, RS_INVALIDARG, RM_APPLICATION, RD_INVALID_COMBINATION);
+
+    RecursiveLock_Lock(&memoryScanLock);
+
+    if(memoryScanState == MEMSCAN_STATE_NONE || memoryScanPid != pid)
+    {
+        RecursiveLock_Unlock(&memoryScanLock);
+        return MAKERESULT(RL_PERMANENT, RS_INVALIDSTATE, RM_APPLICATION, RD_NOT_INITIALIZED);
+    }
+
+    MemoryScan_InitPass(&pass, filter, value);
+
+    if(memoryScanState == MEMSCAN_STATE_SNAPSHOT)
+    {
+        res = MemoryScan_RefineSnapshot(&pass, nextChunk, userData);
+        if(R_SUCCEEDED(res) && pass.overflow)
+            res = MAKERESULT(RL_PERMANENT, RS_OUTOFRESOURCE, RM_APPLICATION, RD_OUT_OF_MEMORY);
+
+        if(R_SUCCEEDED(res))
+        {
+            MemoryScan_DeleteSnapshot();
+            memoryScanAddresses.used = pass.writeOffset;
+            memoryScanValues.used = pass.writeValueOffset;
+            memoryScanCount = pass.count;
+            memoryScanState = MEMSCAN_STATE_LIST;
+        }
+        else
+        {
+            // Keep the snapshot so that a narrower filter can be tried
+            MemoryScan_ArenaReset(&memoryScanAddresses);
+            MemoryScan_ArenaReset(&memoryScanValues);
+        }
+    }
+    else
+    {
+        // Refining never grows the list, so it can be done in place
+        pass.readRemaining = memoryScanCount;
+        MemoryScan_ReadNextCandidate(&pass);
+
+        while(pass.hasNext && nextChunk(&chunk, userData))
+            MemoryScan_RefineList(&pass, chunk.address, (const u8 *)chunk.data, chunk.size);
+
+        memoryScanAddresses.used = pass.writeOffset;
+        memoryScanValues.used = pass.writeValueOffset;
+        memoryScanCount = pass.count;
+    }
+
+    RecursiveLock_Unlock(&memoryScanLock);
+    return res;
+}
+
+bool MemoryScan_IsActive(u32 pid, MemoryScanValueType *type)
+{
+    RecursiveLock_Lock(&memoryScanLock);
+    bool active = memoryScanState != MEMSCAN_STATE_NONE && memoryScanPid == pid;
+    if(active && type != NULL)
+        *type = memoryScanType;
+    RecursiveLock_Unlock(&memoryScanLock);
+
+    return active;
+}
+
+u32 MemoryScan_GetResultCount(void)
+{
+    RecursiveLock_Lock(&memoryScanLock);
+    u32 count = memoryScanCount;
+    RecursiveLock_Unlock(&memoryScanLock);
+
+    return count;
+}
+
+u32 MemoryScan_GetResults(MemoryScanResult *out, u32 first, u32 maxResults)
+{
+    MemoryScanPass pass;
+    u32 n = 0;
+
+    RecursiveLock_Lock(&memoryScanLock);
+
+    if(memoryScanState == MEMSCAN_STATE_LIST)
+    {
+        MemoryScan_InitPass(&pass, MEMSCAN_FILTER_EQUAL, 0);
+        pass.readRemaining = memoryScanCount;
+        MemoryScan_ReadNextCandidate(&pass);
+
+        for(u32 i = 0; pass.hasNext && n < maxResults; i++)
+        {
+            if(i >= first)
+            {
+                out[n].address = pass.nextAddress;
+                out[n].value = pass.nextValue;
+                n++;
+            }
+            MemoryScan_ReadNextCandidate(&pass);
+        }
+    }
+
+    RecursiveLock_Unlock(&memoryScanLock);
+    return n;
+}
+
+const char *MemoryScan_GetTypeName(MemoryScanValueType type)
+{
+    return type < MEMSCAN_TYPE_MAX ? memoryScanTypeNames[type] : "?";
+}
+
+const char *MemoryScan_GetFilterName(MemoryScanFilter filter)
+{
+    return filter < MEMSCAN_FILTER_MAX ? memoryScanFilterNames[filter] : "?";
+}
+
+bool MemoryScan_ParseType(MemoryScanValueType *type, const char *name, u32 len)
+{
+    for(u32 i = 0; i < MEMSCAN_TYPE_MAX; i++)
+    {
+        if(strncmp(memoryScanTypeNames[i], name, len) == 0 && memoryScanTypeNames[i][len] == 0)
+        {
+            *type = (MemoryScanValueType)i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool MemoryScan_ParseFilter(MemoryScanFilter *filter, const char *name, u32 len)
+{
+    // Unambiguous prefixes ("eq", "inc", ...) are accepted
+    u32 nbMatches = 0;
+    for(u32 i = 0; i < MEMSCAN_FILTER_MAX; i++)
+    {
+        if(len != 0 && strncmp(memoryScanFilterNames[i], name, len) == 0)
+        {
+            *filter = (MemoryScanFilter)i;
+            nbMatches++;
+        }
+    }
+
+    return nbMatches == 1;
+}
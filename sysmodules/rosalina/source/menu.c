@@ -282,7 +282,8 @@ void menuThreadMain(void)
 
     while(!preTerminationRequested)
     {
-        svcSleepThread(50 * 1000 * 1000LL);
+        // Also continues the debug events of the game cheats are applied to, as they come
+        Cheat_WaitForEvents(50 * 1000 * 1000LL);
         if (menuShouldExit)
             continue;
 
@@ -40,6 +40,7 @@
 #include "fmt.h"
 #include "process_patches.h"
 #include "luminance.h"
+#include "input_redirection.h"
 
 Menu rosalinaMenu = {
     "Rosalina menu",
@@ -138,6 +139,22 @@ void RosalinaMenu_ShowDebugInfo(void)
                 timeToBootHm
             );
         }
+        if (inputRedirectionStats.nbPackets != 0)
+        {
+            const u32 *histogram = inputRedirectionStats.latencyHistogram;
+            posY = Draw_DrawFormattedString(
+                10, posY, COLOR_WHITE, "\nInput redirection: %lu pkts, %lu stale, %lu lost\n",
+                inputRedirectionStats.nbPackets, inputRedirectionStats.nbStalePackets, inputRedirectionStats.nbLostSamples
+            );
+            posY = Draw_DrawFormattedString(
+                10, posY, COLOR_WHITE, "Delay (ms) <1: %lu <2: %lu <4: %lu <8: %lu\n",
+                histogram[0], histogram[1], histogram[2], histogram[3]
+            );
+            posY = Draw_DrawFormattedString(
+                10, posY, COLOR_WHITE, "<16: %lu <32: %lu <64: %lu >=64: %lu\n",
+                histogram[4], histogram[5], histogram[6], histogram[7]
+            );
+        }
         Draw_FlushFramebuffer();
         Draw_Unlock();
     }
@@ -38,6 +38,75 @@
 #define MAKE_QWORD(hi,low) \
     ((u64) ((((u64)(hi)) << 32) | (low)))
 
+typedef enum CheatOpcode
+{
+    CHEAT_OP_INVALID = 0,
+    CHEAT_OP_END,
+    CHEAT_OP_NOP,
+    CHEAT_OP_WRITE32,
+    CHEAT_OP_WRITE16,
+    CHEAT_OP_WRITE8,
+    CHEAT_OP_IF32,
+    CHEAT_OP_IF16,
+    CHEAT_OP_LOAD_OFFSET,
+    CHEAT_OP_LOOP,
+    CHEAT_OP_END_IF,
+    CHEAT_OP_LOOP_BREAK,
+    CHEAT_OP_END_LOOP,
+    CHEAT_OP_END_ALL,
+    CHEAT_OP_RETURN,
+    CHEAT_OP_SET_OFFSET,
+    CHEAT_OP_ADD_DATA,
+    CHEAT_OP_SET_DATA,
+    CHEAT_OP_STORE32,
+    CHEAT_OP_STORE16,
+    CHEAT_OP_STORE8,
+    CHEAT_OP_LOAD32,
+    CHEAT_OP_LOAD16,
+    CHEAT_OP_LOAD8,
+    CHEAT_OP_ADD_OFFSET,
+    CHEAT_OP_IF_KEYS,
+    CHEAT_OP_IF_TOUCH,
+    CHEAT_OP_OFFSET_REGISTER,
+    CHEAT_OP_DATA_REGISTER,
+    CHEAT_OP_STORAGE_REGISTER,
+    CHEAT_OP_DATA_MODE,
+    CHEAT_OP_CONDITIONAL_MODE,
+    CHEAT_OP_TYPE_E,
+    CHEAT_OP_FLOAT_MODE,
+    CHEAT_OP_ADD_MEMORY,
+    CHEAT_OP_MUL_MEMORY,
+    CHEAT_OP_DIV_MEMORY,
+    CHEAT_OP_MUL_DATA,
+    CHEAT_OP_DIV_DATA,
+    CHEAT_OP_AND_DATA,
+    CHEAT_OP_OR_DATA,
+    CHEAT_OP_XOR_DATA,
+    CHEAT_OP_NOT_DATA,
+    CHEAT_OP_SHL_DATA,
+    CHEAT_OP_SHR_DATA,
+    CHEAT_OP_COPY,
+    CHEAT_OP_SEARCH,
+    CHEAT_OP_RANDOM,
+} CheatOpcode;
+
+enum
+{
+    CHEAT_CMP_LT = 0,
+    CHEAT_CMP_GT,
+    CHEAT_CMP_EQ,
+    CHEAT_CMP_NE,
+};
+
+// One pre-decoded code line. Operands are still read from the matching line in codes[].
+// target is the resolved resume line for loop breaks and the payload length for searches.
+typedef struct CheatInstruction
+{
+    u8 opcode;
+    u8 arg;
+    u32 target;
+} CheatInstruction;
+
 typedef struct CheatDescription
 {
     struct {
@@ -48,9 +117,11 @@ typedef struct CheatDescription
     };
     char name[39];
     u32 codesCount;
+    u32 codesIndex;
     u32 storage1;
     u32 storage2;
-    u64 codes[0];
+    u64* codes; // NULL until loaded from the cheat database
+    CheatInstruction* program; // NULL until the cheat is first enabled
 } CheatDescription;
 
 typedef struct BufferedFile
@@ -58,11 +129,52 @@ typedef struct BufferedFile
     IFile file;
     u64 curPos;
     u64 maxPos;
-    char buffer[512];
+    char buffer[0x1000];
 } BufferedFile;
 
-CheatDescription* cheats[1024] = { 0 };
-u8 cheatBuffer[32768] = { 0 };
+// Cheat descriptions and codes live in two growable arenas, committed page by page
+#define CHEAT_DESCRIPTIONS_ADDRESS  0x0E000000
+#define CHEAT_CODES_ADDRESS         0x0E800000
+#define CHEAT_ARENA_MAX_SIZE        0x00800000
+#define CHEAT_ARENA_GROWTH          0x4000
+
+typedef struct CheatArena
+{
+    u32 base;
+    u32 committed;
+    u32 used;
+} CheatArena;
+
+// Pre-parsed cheats, one file per title, rebuilt whenever the cheat text file changes
+#define CHEAT_DATABASE_MAGIC    0x42444843 // "CHDB"
+#define CHEAT_DATABASE_VERSION  1
+#define CHEAT_DATABASE_PATH     "/luma/cache/cheats/%016llX.bin"
+
+typedef struct CheatDatabaseHeader
+{
+    u32 magic;
+    u16 version;
+    u16 reserved;
+    u64 sourceSize;
+    u64 sourceTimestamp;
+    u32 cheatCount;
+    u32 codesCount;
+} CheatDatabaseHeader;
+
+typedef struct CheatDatabaseEntry
+{
+    char name[39];
+    u8 hasKeyCode;
+    u32 codesCount;
+    u32 codesIndex;
+} CheatDatabaseEntry;
+
+static CheatArena cheatDescriptionArena = { CHEAT_DESCRIPTIONS_ADDRESS, 0, 0 };
+static CheatArena cheatCodeArena = { CHEAT_CODES_ADDRESS, 0, 0 };
+static BufferedFile cheatFile;
+static u32 cheatDatabaseCodesOffset = 0;
+
+CheatDescription* cheats = (CheatDescription*) CHEAT_DESCRIPTIONS_ADDRESS;
 u8 cheatPage[0x1000] = { 0 };
 
 typedef struct CheatState
@@ -80,8 +192,6 @@ typedef struct CheatState
         u8 data2Mode : 1;
         u8 floatMode : 1;
     };
-    u8 typeELine;
-    u8 typeEIdx;
 
     s8 loopLine;
     u32 loopCount;
@@ -94,7 +204,7 @@ typedef struct CheatState
 } CheatState;
 
 CheatState cheat_state = { 0 };
-u8 cheatCount = 0;
+s32 cheatCount = 0;
 u64 cheatTitleInfo = -1ULL;
 u64 cheatRngState = 0;
 
@@ -121,21 +231,179 @@ static u32 Cheat_GetRandomNumber(void)
     return (u32)(cheatRngState >> 32);
 }
 
+#define CHEAT_REGION_CACHE_SIZE 8
+#define CHEAT_PAGE_SIZE         0x1000
+
+typedef struct CheatMemoryRegion
+{
+    u32 base;
+    u32 size;
+} CheatMemoryRegion;
+
+// Process memory seen by the current cheat pass: the regions already queried, and one page
+// used to serve reads and to coalesce adjacent writes into a single transfer.
+typedef struct CheatMemoryCache
+{
+    CheatMemoryRegion regions[CHEAT_REGION_CACHE_SIZE];
+    u32 regionCount;
+    u32 nextRegion;
+
+    u32 pageAddr;
+    bool pageLoaded;
+    u32 dirtyStart;
+    u32 dirtyEnd;
+    u8 pageData[CHEAT_PAGE_SIZE];
+} CheatMemoryCache;
+
+static CheatMemoryCache cheatMemoryCache = { 0 };
+static u32 ReadWriteBuffer = 0;
+
+static void Cheat_ResetMemoryCache(void)
+{
+    cheatMemoryCache.regionCount = 0;
+    cheatMemoryCache.nextRegion = 0;
+    cheatMemoryCache.pageAddr = 0;
+    cheatMemoryCache.pageLoaded = false;
+    cheatMemoryCache.dirtyStart = 0;
+    cheatMemoryCache.dirtyEnd = 0;
+}
+
 static bool Cheat_IsValidAddress(const Handle processHandle, u32 address, u32 size)
 {
+    for (u32 i = 0; i < cheatMemoryCache.regionCount; i++)
+    {
+        CheatMemoryRegion* region = &cheatMemoryCache.regions[i];
+        if (region->base <= address && address <= region->base + region->size - size)
+        {
+            return true;
+        }
+    }
+
     MemInfo info;
     PageInfo out;
 
     Result res = svcQueryDebugProcessMemory(&info, &out, processHandle, address);
     if (R_SUCCEEDED(res) && info.state != MEMSTATE_FREE && info.base_addr > 0 && info.base_addr <= address && address <= info.base_addr + info.size - size) {
+        CheatMemoryRegion* region = &cheatMemoryCache.regions[cheatMemoryCache.nextRegion];
+        region->base = info.base_addr;
+        region->size = info.size;
+        cheatMemoryCache.nextRegion = (cheatMemoryCache.nextRegion + 1) % CHEAT_REGION_CACHE_SIZE;
+        if (cheatMemoryCache.regionCount < CHEAT_REGION_CACHE_SIZE)
+        {
+            cheatMemoryCache.regionCount++;
+        }
         return true;
     }
     return false;
 }
 
-static u32 ReadWriteBuffer32 = 0;
-static u16 ReadWriteBuffer16 = 0;
-static u8 ReadWriteBuffer8 = 0;
+static bool Cheat_FlushMemoryCache(const Handle processHandle)
+{
+    u32 start = cheatMemoryCache.dirtyStart;
+    u32 end = cheatMemoryCache.dirtyEnd;
+
+    if (start == end)
+    {
+        return true;
+    }
+
+    cheatMemoryCache.dirtyStart = cheatMemoryCache.dirtyEnd = 0;
+    return R_SUCCEEDED(svcWriteProcessMemory(processHandle, cheatMemoryCache.pageData + start, cheatMemoryCache.pageAddr + start, end - start));
+}
+
+static bool Cheat_WriteMemory(const Handle processHandle, u32 addr, u32 value, u32 size)
+{
+    u32 page = addr & ~(CHEAT_PAGE_SIZE - 1);
+    u32 pageOffset = addr & (CHEAT_PAGE_SIZE - 1);
+
+    if (!Cheat_IsValidAddress(processHandle, addr, size))
+    {
+        return false;
+    }
+
+    if (pageOffset + size > CHEAT_PAGE_SIZE)
+    {
+        // Straddles two pages, write it through and drop the cached page
+        if (!Cheat_FlushMemoryCache(processHandle))
+        {
+            return false;
+        }
+        cheatMemoryCache.pageAddr = 0;
+        cheatMemoryCache.pageLoaded = false;
+        memcpy(&ReadWriteBuffer, &value, size);
+        return R_SUCCEEDED(svcWriteProcessMemory(processHandle, &ReadWriteBuffer, addr, size));
+    }
+
+    if (page != cheatMemoryCache.pageAddr)
+    {
+        if (!Cheat_FlushMemoryCache(processHandle))
+        {
+            return false;
+        }
+        cheatMemoryCache.pageAddr = page;
+        cheatMemoryCache.pageLoaded = false;
+    }
+    else if (cheatMemoryCache.dirtyStart != cheatMemoryCache.dirtyEnd &&
+             (pageOffset > cheatMemoryCache.dirtyEnd || pageOffset + size < cheatMemoryCache.dirtyStart))
+    {
+        // Only merge writes that touch the pending run, so that untouched bytes are never written back
+        if (!Cheat_FlushMemoryCache(processHandle))
+        {
+            return false;
+        }
+    }
+
+    memcpy(cheatMemoryCache.pageData + pageOffset, &value, size);
+
+    if (cheatMemoryCache.dirtyStart == cheatMemoryCache.dirtyEnd)
+    {
+        cheatMemoryCache.dirtyStart = pageOffset;
+        cheatMemoryCache.dirtyEnd = pageOffset + size;
+    }
+    else
+    {
+        cheatMemoryCache.dirtyStart = pageOffset < cheatMemoryCache.dirtyStart ? pageOffset : cheatMemoryCache.dirtyStart;
+        cheatMemoryCache.dirtyEnd = pageOffset + size > cheatMemoryCache.dirtyEnd ? pageOffset + size : cheatMemoryCache.dirtyEnd;
+    }
+    return true;
+}
+
+static bool Cheat_ReadMemory(const Handle processHandle, u32 addr, void* retValue, u32 size)
+{
+    u32 page = addr & ~(CHEAT_PAGE_SIZE - 1);
+    u32 pageOffset = addr & (CHEAT_PAGE_SIZE - 1);
+
+    if (!Cheat_IsValidAddress(processHandle, addr, size))
+    {
+        return false;
+    }
+
+    if (pageOffset + size > CHEAT_PAGE_SIZE || page != cheatMemoryCache.pageAddr || !cheatMemoryCache.pageLoaded)
+    {
+        if (!Cheat_FlushMemoryCache(processHandle))
+        {
+            return false;
+        }
+
+        cheatMemoryCache.pageAddr = 0;
+        cheatMemoryCache.pageLoaded = false;
+        if (pageOffset + size <= CHEAT_PAGE_SIZE && R_SUCCEEDED(svcReadProcessMemory(cheatMemoryCache.pageData, processHandle, page, CHEAT_PAGE_SIZE)))
+        {
+            cheatMemoryCache.pageAddr = page;
+            cheatMemoryCache.pageLoaded = true;
+        }
+        else
+        {
+            // Straddles two pages (even the cached one) or the page can't be read as a whole, read only what was asked
+            Result res = svcReadProcessMemory(&ReadWriteBuffer, processHandle, addr, size);
+            memcpy(retValue, &ReadWriteBuffer, size);
+            return R_SUCCEEDED(res);
+        }
+    }
+
+    memcpy(retValue, cheatMemoryCache.pageData + pageOffset, size);
+    return true;
+}
 
 static bool Cheat_Write8(const Handle processHandle, u32 offset, u8 value)
 {
@@ -145,12 +413,7 @@ static bool Cheat_Write8(const Handle processHandle, u32 offset, u8 value)
         cheatPage[addr - 0x01E81000] = value;
         return true;
     }
-    if (Cheat_IsValidAddress(processHandle, addr, 1))
-    {
-        *((u8*) (&ReadWriteBuffer8)) = value;
-        return R_SUCCEEDED(svcWriteProcessMemory(processHandle, &ReadWriteBuffer8, addr, 1));
-    }
-    return false;
+    return Cheat_WriteMemory(processHandle, addr, value, 1);
 }
 
 static bool Cheat_Write16(const Handle processHandle, u32 offset, u16 value)
@@ -161,12 +424,7 @@ static bool Cheat_Write16(const Handle processHandle, u32 offset, u16 value)
         *(u16*)(cheatPage + addr - 0x01E81000) = value;
         return true;
     }
-    if (Cheat_IsValidAddress(processHandle, addr, 2))
-    {
-        *((u16*) (&ReadWriteBuffer16)) = value;
-        return R_SUCCEEDED(svcWriteProcessMemory(processHandle, &ReadWriteBuffer16, addr, 2));
-    }
-    return false;
+    return Cheat_WriteMemory(processHandle, addr, value, 2);
 }
 
 static bool Cheat_Write32(const Handle processHandle, u32 offset, u32 value)
@@ -177,12 +435,7 @@ static bool Cheat_Write32(const Handle processHandle, u32 offset, u32 value)
         *(u32*)(cheatPage + addr - 0x01E81000) = value;
         return true;
     }
-    if (Cheat_IsValidAddress(processHandle, addr, 4))
-    {
-        *((u32*) (&ReadWriteBuffer32)) = value;
-        return R_SUCCEEDED(svcWriteProcessMemory(processHandle, &ReadWriteBuffer32, addr, 4));
-    }
-    return false;
+    return Cheat_WriteMemory(processHandle, addr, value, 4);
 }
 
 static bool Cheat_Read8(const Handle processHandle, u32 offset, u8* retValue)
@@ -193,13 +446,7 @@ static bool Cheat_Read8(const Handle processHandle, u32 offset, u8* retValue)
         *retValue = cheatPage[addr - 0x01E81000];
         return true;
     }
-    if (Cheat_IsValidAddress(processHandle, addr, 1))
-    {
-        Result res = svcReadProcessMemory(&ReadWriteBuffer8, processHandle, addr, 1);
-        *retValue = *((u8*) (&ReadWriteBuffer8));
-        return R_SUCCEEDED(res);
-    }
-    return false;
+    return Cheat_ReadMemory(processHandle, addr, retValue, 1);
 }
 
 static bool Cheat_Read16(const Handle processHandle, u32 offset, u16* retValue)
@@ -210,13 +457,7 @@ static bool Cheat_Read16(const Handle processHandle, u32 offset, u16* retValue)
         *retValue = *(u16*)(cheatPage + addr - 0x01E81000);
         return true;
     }
-    if (Cheat_IsValidAddress(processHandle, addr, 2))
-    {
-        Result res = svcReadProcessMemory(&ReadWriteBuffer16, processHandle, addr, 2);
-        *retValue = *((u16*) (&ReadWriteBuffer16));
-        return R_SUCCEEDED(res);
-    }
-    return false;
+    return Cheat_ReadMemory(processHandle, addr, retValue, 2);
 }
 
 static bool Cheat_Read32(const Handle processHandle, u32 offset, u32* retValue)
@@ -227,395 +468,409 @@ static bool Cheat_Read32(const Handle processHandle, u32 offset, u32* retValue)
         *retValue = *(u32*)(cheatPage + addr - 0x01E81000);
         return true;
     }
-    if (Cheat_IsValidAddress(processHandle, addr, 4))
-    {
-        Result res = svcReadProcessMemory(&ReadWriteBuffer32, processHandle, addr, 4);
-        *retValue = *((u32*) (&ReadWriteBuffer32));
-        return R_SUCCEEDED(res);
-    }
-    return false;
+    return Cheat_ReadMemory(processHandle, addr, retValue, 4);
 }
 
 static u8 typeEMapping[] = { 4 << 3, 5 << 3, 6 << 3, 7 << 3, 0 << 3, 1 << 3, 2 << 3, 3 << 3 };
 
-static u8 Cheat_GetNextTypeE(const CheatDescription* cheat)
+static inline u8 Cheat_GetTypeEByte(const CheatDescription* cheat, u32 line, u32 idx)
 {
+    return (u8) ((cheat->codes[line] >> (typeEMapping[idx])) & 0xFF);
+}
 
-    if (cheat_state.typeEIdx == 7)
-    {
-        cheat_state.typeEIdx = 0;
-        cheat_state.typeELine++;
-    }
-    else
+static bool Cheat_Compare(u32 comparison, u32 lhs, u32 rhs)
+{
+    switch (comparison)
     {
-        cheat_state.typeEIdx++;
+        case CHEAT_CMP_LT:
+            return lhs < rhs;
+        case CHEAT_CMP_GT:
+            return lhs > rhs;
+        case CHEAT_CMP_EQ:
+            return lhs == rhs;
+        default:
+            return lhs != rhs;
     }
-    return (u8) ((cheat->codes[cheat_state.typeELine] >> (typeEMapping[cheat_state.typeEIdx])) & 0xFF);
 }
 
-static u32 Cheat_ApplyCheat(const Handle processHandle, CheatDescription* const cheat)
+static inline void Cheat_PushCondition(bool newSkip, bool skipExecution)
 {
-    cheat_state.index = 0;
-    cheat_state.offset1 = 0;
-    cheat_state.offset2 = 0;
-    cheat_state.data1 = 0;
-    cheat_state.data2 = 0;
-    cheat_state.activeOffset = 0;
-    cheat_state.activeData = 0;
-    cheat_state.conditionalMode = 0;
-    cheat_state.data1Mode = 0;
-    cheat_state.data2Mode = 0;
-    cheat_state.floatMode = 0;
-    cheat_state.loopCount = 0;
-    cheat_state.loopLine = -1;
-    cheat_state.ifStack = 0;
-    cheat_state.storedStack = 0;
-    cheat_state.ifCount = 0;
-    cheat_state.storedIfCount = 0;
+    cheat_state.ifStack <<= 1;
+    cheat_state.ifStack |= (newSkip || skipExecution) ? 1 : 0;
+    cheat_state.ifCount++;
+}
 
-    while (cheat_state.index < cheat->codesCount)
+static inline u32 Cheat_GetRegister(u32 codeArg)
+{
+    return codeArg == 0 ? *activeData() : (codeArg == 1 ? cheat_state.data1 : cheat_state.data2);
+}
+
+static inline u32* Cheat_GetRegisterPtr(u32 codeArg)
+{
+    return codeArg == 0 ? activeData() : (codeArg == 1 ? &cheat_state.data1 : &cheat_state.data2);
+}
+
+// Decodes every line of a cheat once, so that the executor doesn't have to do it on every application.
+// Lines that only carry data (type E and search payloads) are decoded too but never executed
+// unless the original interpreter would also have executed them.
+static void Cheat_CompileCheat(CheatDescription* cheat)
+{
+    for (u32 i = 0; i < cheat->codesCount; i++)
     {
-        bool skipExecution = (cheat_state.ifStack & 0x00000001) != 0;
-        u32 arg0 = (u32) ((cheat->codes[cheat_state.index] >> 32) & 0x00000000FFFFFFFFULL);
-        u32 arg1 = (u32) ((cheat->codes[cheat_state.index]) & 0x00000000FFFFFFFFULL);
-        if (arg0 == 0 && arg1 == 0)
-        {
-            return 0;
-        }
+        CheatInstruction* insn = &cheat->program[i];
+        u32 arg0 = (u32) ((cheat->codes[i] >> 32) & 0x00000000FFFFFFFFULL);
+        u32 arg1 = (u32) ((cheat->codes[i]) & 0x00000000FFFFFFFFULL);
         u32 code = ((arg0 >> 28) & 0x0F);
         u32 subcode = ((arg0 >> 24) & 0x0F);
         u32 codeArg = arg0 & 0x0F;
 
+        insn->opcode = CHEAT_OP_INVALID;
+        insn->arg = 0;
+        insn->target = 0;
+
+        if (arg0 == 0 && arg1 == 0)
+        {
+            insn->opcode = CHEAT_OP_END;
+            continue;
+        }
+
         switch (code)
         {
             case 0x0:
-                // 0 Type
-                // Format: 0XXXXXXX YYYYYYYY
-                // Description: 32bit write of YYYYYYYY to 0XXXXXXX.
-                if (!skipExecution)
-                {
-                    if (!Cheat_Write32(processHandle, (arg0 & 0x0FFFFFFF), arg1)) return 0;
-                }
+                insn->opcode = CHEAT_OP_WRITE32;
                 break;
             case 0x1:
-                // 1 Type
-                // Format: 1XXXXXXX 0000YYYY
-                // Description: 16bit write of YYYY to 0XXXXXXX.
-                if (!skipExecution)
-                {
-                    if (!Cheat_Write16(processHandle, (arg0 & 0x0FFFFFFF), (u16) (arg1 & 0xFFFF))) return 0;
-                }
+                insn->opcode = CHEAT_OP_WRITE16;
                 break;
             case 0x2:
-                // 2 Type
-                // Format: 2XXXXXXX 000000YY
-                // Description: 8bit write of YY to 0XXXXXXX.
-                if (!skipExecution)
-                {
-                    if (!Cheat_Write8(processHandle, (arg0 & 0x0FFFFFFF), (u8) (arg1 & 0xFF))) return 0;
-                }
+                insn->opcode = CHEAT_OP_WRITE8;
                 break;
             case 0x3:
-                // 3 Type
-                // Format: 3XXXXXXXX YYYYYYYY
-                // Description: 32bit if less than.
-                // Simple: If the value at address 0XXXXXXX is less than the value YYYYYYYY.
-                // Example: 323D6B28 10000000
-            {
-                bool newSkip;
-                u32 value = 0;
-                switch (cheat_state.conditionalMode)
+            case 0x4:
+            case 0x5:
+            case 0x6:
+                insn->opcode = CHEAT_OP_IF32;
+                insn->arg = code - 0x3;
+                break;
+            case 0x7:
+            case 0x8:
+            case 0x9:
+            case 0xA:
+                insn->opcode = CHEAT_OP_IF16;
+                insn->arg = code - 0x7;
+                break;
+            case 0xB:
+                insn->opcode = CHEAT_OP_LOAD_OFFSET;
+                break;
+            case 0xC:
+                insn->opcode = subcode <= 0x02 ? CHEAT_OP_LOOP : CHEAT_OP_NOP;
+                insn->arg = subcode;
+                break;
+            case 0xD:
+                insn->arg = codeArg;
+                switch (subcode)
                 {
-                    case 0x0:
-                        if (!Cheat_Read32(processHandle, arg0 & 0x0FFFFFFF, &value)) return 0;
-                        newSkip = !(value < arg1);
+                    case 0x00:
+                        if (arg1 == 0)
+                        {
+                            insn->opcode = CHEAT_OP_END_IF;
+                        }
+                        else if (arg1 == 1)
+                        {
+                            // Resolve the line the loop break resumes at: it consumes the next D1/D2 line
+                            // and the line following it.
+                            u32 target = i + 1;
+                            while (target < cheat->codesCount)
+                            {
+                                u64 line = cheat->codes[target++];
+                                if (line == 0xD100000000000000ull || line == 0xD200000000000000ull)
+                                {
+                                    break;
+                                }
+                            }
+                            insn->opcode = CHEAT_OP_LOOP_BREAK;
+                            insn->target = target + 1;
+                        }
+                        else
+                        {
+                            insn->opcode = CHEAT_OP_NOP;
+                        }
                         break;
-                    case 0x1:
-                        if (!Cheat_Read32(processHandle, arg0 & 0x0FFFFFFF, &value)) return 0;
-                        newSkip = !(value < *activeData());
+                    case 0x01:
+                        insn->opcode = CHEAT_OP_END_LOOP;
                         break;
-                    case 0x2:
-                        newSkip = !(*activeData() < arg1);
+                    case 0x02:
+                        insn->opcode = arg1 == 0 ? CHEAT_OP_END_ALL : (arg1 == 1 ? CHEAT_OP_RETURN : CHEAT_OP_NOP);
                         break;
-                    case 0x3:
-                        newSkip = !(*activeStorage(cheat) < arg1);
+                    case 0x03:
+                        insn->opcode = codeArg <= 1 ? CHEAT_OP_SET_OFFSET : CHEAT_OP_NOP;
                         break;
-                    case 0x4:
-                        newSkip = !(*activeData() < *activeStorage(cheat));
+                    case 0x04:
+                        insn->opcode = codeArg <= 2 ? CHEAT_OP_ADD_DATA : CHEAT_OP_NOP;
                         break;
-                    default:
-                        return 0;
-                }
-                cheat_state.ifStack <<= 1;
-                cheat_state.ifStack |= (newSkip || skipExecution) ? 1 : 0;
-                cheat_state.ifCount++;
-            }
-                break;
-            case 0x4:
-                // 4 Type
-                // Format: 4XXXXXXXX YYYYYYYY
-                // Description: 32bit if greater than.
-                // Simple: If the value at address 0XXXXXXX is greater than the value YYYYYYYY.
-                // Example: 423D6B28 10000000
-            {
-                bool newSkip;
-                u32 value = 0;
-                switch (cheat_state.conditionalMode)
-                {
-                    case 0x0:
-                        if (!Cheat_Read32(processHandle, arg0 & 0x0FFFFFFF, &value)) return 0;
-                        newSkip = !(value > arg1);
+                    case 0x05:
+                        insn->opcode = codeArg <= 2 ? CHEAT_OP_SET_DATA : CHEAT_OP_NOP;
                         break;
-                    case 0x1:
-                        if (!Cheat_Read32(processHandle, arg0 & 0x0FFFFFFF, &value)) return 0;
-                        newSkip = !(value > *activeData());
+                    case 0x06:
+                        insn->opcode = codeArg <= 2 ? CHEAT_OP_STORE32 : CHEAT_OP_NOP;
                         break;
-                    case 0x2:
-                        newSkip = !(*activeData() > arg1);
+                    case 0x07:
+                        insn->opcode = codeArg <= 2 ? CHEAT_OP_STORE16 : CHEAT_OP_NOP;
                         break;
-                    case 0x3:
-                        newSkip = !(*activeStorage(cheat) > arg1);
+                    case 0x08:
+                        insn->opcode = codeArg <= 2 ? CHEAT_OP_STORE8 : CHEAT_OP_NOP;
                         break;
-                    case 0x4:
-                        newSkip = !(*activeData() > *activeStorage(cheat));
+                    case 0x09:
+                        insn->opcode = codeArg <= 2 ? CHEAT_OP_LOAD32 : CHEAT_OP_NOP;
                         break;
-                    default:
-                        return 0;
-                }
-                cheat_state.ifStack <<= 1;
-                cheat_state.ifStack |= (newSkip || skipExecution) ? 1 : 0;
-                cheat_state.ifCount++;
-            }
-                break;
-            case 0x5:
-                // 5 Type
-                // Format: 5XXXXXXXX YYYYYYYY
-                // Description: 32bit if equal to.
-                // Simple: If the value at address 0XXXXXXX is equal to the value YYYYYYYY.
-                // Example: 523D6B28 10000000
-            {
-                bool newSkip;
-                u32 value = 0;
-                switch (cheat_state.conditionalMode)
-                {
-                    case 0x0:
-                        if (!Cheat_Read32(processHandle, arg0 & 0x0FFFFFFF, &value)) return 0;
-                        newSkip = !(value == arg1);
+                    case 0x0A:
+                        insn->opcode = codeArg <= 2 ? CHEAT_OP_LOAD16 : CHEAT_OP_NOP;
                         break;
-                    case 0x1:
-                        if (!Cheat_Read32(processHandle, arg0 & 0x0FFFFFFF, &value)) return 0;
-                        newSkip = !(value == *activeData());
+                    case 0x0B:
+                        insn->opcode = codeArg <= 2 ? CHEAT_OP_LOAD8 : CHEAT_OP_NOP;
                         break;
-                    case 0x2:
-                        newSkip = !(*activeData() == arg1);
+                    case 0x0C:
+                        insn->opcode = CHEAT_OP_ADD_OFFSET;
                         break;
-                    case 0x3:
-                        newSkip = !(*activeStorage(cheat) == arg1);
+                    case 0x0D:
+                        insn->opcode = CHEAT_OP_IF_KEYS;
                         break;
-                    case 0x4:
-                        newSkip = !(*activeData() == *activeStorage(cheat));
+                    case 0x0E:
+                        insn->opcode = codeArg <= 1 ? CHEAT_OP_IF_TOUCH : CHEAT_OP_INVALID;
+                        break;
+                    case 0x0F:
+                        switch (codeArg)
+                        {
+                            case 0x00:
+                                insn->opcode = CHEAT_OP_OFFSET_REGISTER;
+                                break;
+                            case 0x01:
+                                insn->opcode = CHEAT_OP_DATA_REGISTER;
+                                break;
+                            case 0x02:
+                                insn->opcode = CHEAT_OP_STORAGE_REGISTER;
+                                break;
+                            case 0x0E:
+                                if (arg1 == 0x0 || arg1 == 0x1 || arg1 == 0x10 || arg1 == 0x11)
+                                {
+                                    insn->opcode = CHEAT_OP_DATA_MODE;
+                                }
+                                break;
+                            case 0x0F:
+                                if (arg1 < 5)
+                                {
+                                    insn->opcode = CHEAT_OP_CONDITIONAL_MODE;
+                                }
+                                break;
+                        }
                         break;
-                    default:
-                        return 0;
                 }
-                cheat_state.ifStack <<= 1;
-                cheat_state.ifStack |= (newSkip || skipExecution) ? 1 : 0;
-                cheat_state.ifCount++;
-            }
                 break;
-            case 0x6:
-                // 6 Type
-                // Format: 3XXXXXXXX YYYYYYYY
-                // Description: 32bit if not equal to.
-                // Simple: If the value at address 0XXXXXXX is not equal to the value YYYYYYYY.
-                // Example: 623D6B28 10000000
-            {
-                bool newSkip;
-                u32 value = 0;
-                switch (cheat_state.conditionalMode)
+            case 0xE:
+                // The payload must not run past the last line of the cheat
+                if ((u64)i + ((u64)arg1 + 7) / 8 < cheat->codesCount)
+                {
+                    insn->opcode = CHEAT_OP_TYPE_E;
+                }
+                break;
+            case 0xF:
+                if (arg0 == 0xF0F00000)
+                {
+                    // I have no clue how to implement this, or if it's even possible. Needs research.
+                    break;
+                }
+                switch (subcode)
                 {
                     case 0x0:
-                        if (!Cheat_Read32(processHandle, arg0 & 0x0FFFFFFF, &value)) return 0;
-                        newSkip = !(value != arg1);
+                        insn->opcode = CHEAT_OP_FLOAT_MODE;
                         break;
                     case 0x1:
-                        if (!Cheat_Read32(processHandle, arg0 & 0x0FFFFFFF, &value)) return 0;
-                        newSkip = !(value != *activeData());
+                        insn->opcode = CHEAT_OP_ADD_MEMORY;
                         break;
                     case 0x2:
-                        newSkip = !(*activeData() != arg1);
+                        insn->opcode = CHEAT_OP_MUL_MEMORY;
                         break;
                     case 0x3:
-                        newSkip = !(*activeStorage(cheat) != arg1);
+                        insn->opcode = CHEAT_OP_DIV_MEMORY;
                         break;
                     case 0x4:
-                        newSkip = !(*activeData() != *activeStorage(cheat));
+                        insn->opcode = CHEAT_OP_MUL_DATA;
                         break;
-                    default:
-                        return 0;
-                }
-                cheat_state.ifStack <<= 1;
-                cheat_state.ifStack |= (newSkip || skipExecution) ? 1 : 0;
-                cheat_state.ifCount++;
-            }
-                break;
-            case 0x7:
-                // 7 Type
-                // Format: 7XXXXXXXX 0000YYYY
-                // Description: 16bit if less than.
-                // Simple: If the value at address 0XXXXXXX is less than the value YYYY.
-                // Example: 723D6B28 00005400
-            {
-                bool newSkip;
-                u16 mask = (u16) ((arg1 >> 16) & 0xFFFF);
-                u16 value = 0;
-
-                switch (cheat_state.conditionalMode)
-                {
-                    case 0x0:
-                        if (!Cheat_Read16(processHandle, arg0 & 0x0FFFFFFF, &value)) return 0;
-                        newSkip = !((value & (~mask)) < (arg1 & 0xFFFF));
+                    case 0x5:
+                        insn->opcode = CHEAT_OP_DIV_DATA;
                         break;
-                    case 0x1:
-                        if (!Cheat_Read16(processHandle, arg0 & 0x0FFFFFFF, &value)) return 0;
-                        newSkip = !((value & (~mask)) < (*activeData() & (~mask)));
+                    case 0x6:
+                        insn->opcode = CHEAT_OP_AND_DATA;
                         break;
-                    case 0x2:
-                        newSkip = !((*activeData() & (~mask)) < (arg1 & 0xFFFF));
+                    case 0x7:
+                        insn->opcode = CHEAT_OP_OR_DATA;
                         break;
-                    case 0x3:
-                        newSkip = !((*activeStorage(cheat) & (~mask)) < (arg1 & 0xFFFF));
+                    case 0x8:
+                        insn->opcode = CHEAT_OP_XOR_DATA;
                         break;
-                    case 0x4:
-                        newSkip = !((*activeData() & (~mask)) < (*activeStorage(cheat) & (~mask)));
+                    case 0x9:
+                        insn->opcode = CHEAT_OP_NOT_DATA;
                         break;
-                    default:
-                        return 0;
-                }
-                cheat_state.ifStack <<= 1;
-                cheat_state.ifStack |= (newSkip || skipExecution) ? 1 : 0;
-                cheat_state.ifCount++;
-            }
-                break;
-            case 0x8:
-                // 8 Type
-                // Format: 8XXXXXXXX 0000YYYY
-                // Description: 16bit if greater than.
-                // Simple: If the value at address 0XXXXXXX is greater than the value YYYY.
-                // Example: 823D6B28 00005400
-            {
-                bool newSkip;
-                u16 mask = (u16) ((arg1 >> 16) & 0xFFFF);
-                u16 value = 0;
-
-                switch (cheat_state.conditionalMode)
-                {
-                    case 0x0:
-                        if (!Cheat_Read16(processHandle, arg0 & 0x0FFFFFFF, &value)) return 0;
-                        newSkip = !((value & (~mask)) > (arg1 & 0xFFFF));
+                    case 0xA:
+                        insn->opcode = CHEAT_OP_SHL_DATA;
                         break;
-                    case 0x1:
-                        if (!Cheat_Read16(processHandle, arg0 & 0x0FFFFFFF, &value)) return 0;
-                        newSkip = !((value & (~mask)) > (*activeData() & (~mask)));
+                    case 0xB:
+                        insn->opcode = CHEAT_OP_SHR_DATA;
                         break;
-                    case 0x2:
-                        newSkip = !((*activeData() & (~mask)) > (arg1 & 0xFFFF));
+                    case 0xC:
+                        insn->opcode = CHEAT_OP_COPY;
                         break;
-                    case 0x3:
-                        newSkip = !((*activeStorage(cheat) & (~mask)) > (arg1 & 0xFFFF));
+                    case 0xE:
+                    {
+                        u32 searchSize = arg0 & 0xFFFF;
+                        if (searchSize <= arg1 && searchSize + i < cheat->codesCount)
+                        {
+                            insn->opcode = CHEAT_OP_SEARCH;
+                            insn->target = (searchSize + 7) / 8;
+                        }
+                    }
                         break;
-                    case 0x4:
-                        newSkip = !((*activeData() & (~mask)) > (*activeStorage(cheat) & (~mask)));
+                    case 0xF:
+                        insn->opcode = CHEAT_OP_RANDOM;
                         break;
-                    default:
-                        return 0;
                 }
+                break;
+        }
+    }
+}
 
-                cheat_state.ifStack <<= 1;
-                cheat_state.ifStack |= (newSkip || skipExecution) ? 1 : 0;
-                cheat_state.ifCount++;
-            }
+static u32 Cheat_ApplyCheat(const Handle processHandle, CheatDescription* const cheat)
+{
+    cheat_state.index = 0;
+    cheat_state.offset1 = 0;
+    cheat_state.offset2 = 0;
+    cheat_state.data1 = 0;
+    cheat_state.data2 = 0;
+    cheat_state.activeOffset = 0;
+    cheat_state.activeData = 0;
+    cheat_state.conditionalMode = 0;
+    cheat_state.data1Mode = 0;
+    cheat_state.data2Mode = 0;
+    cheat_state.floatMode = 0;
+    cheat_state.loopCount = 0;
+    cheat_state.loopLine = -1;
+    cheat_state.ifStack = 0;
+    cheat_state.storedStack = 0;
+    cheat_state.ifCount = 0;
+    cheat_state.storedIfCount = 0;
+
+    while (cheat_state.index < cheat->codesCount)
+    {
+        bool skipExecution = (cheat_state.ifStack & 0x00000001) != 0;
+        const CheatInstruction* insn = &cheat->program[cheat_state.index];
+        u32 arg0 = (u32) ((cheat->codes[cheat_state.index] >> 32) & 0x00000000FFFFFFFFULL);
+        u32 arg1 = (u32) ((cheat->codes[cheat_state.index]) & 0x00000000FFFFFFFFULL);
+
+        switch (insn->opcode)
+        {
+            case CHEAT_OP_END:
+            case CHEAT_OP_INVALID:
+                return 0;
+            case CHEAT_OP_NOP:
                 break;
-            case 0x9:
-                // 9 Type
-                // Format: 9XXXXXXXX 0000YYYY
-                // Description: 16bit if equal to.
-                // Simple: If the value at address 0XXXXXXX is equal to the value YYYY.
-                // Example: 923D6B28 00005400
+            case CHEAT_OP_WRITE32:
+                // 0 Type
+                // Format: 0XXXXXXX YYYYYYYY
+                // Description: 32bit write of YYYYYYYY to 0XXXXXXX.
+                if (!skipExecution)
+                {
+                    if (!Cheat_Write32(processHandle, (arg0 & 0x0FFFFFFF), arg1)) return 0;
+                }
+                break;
+            case CHEAT_OP_WRITE16:
+                // 1 Type
+                // Format: 1XXXXXXX 0000YYYY
+                // Description: 16bit write of YYYY to 0XXXXXXX.
+                if (!skipExecution)
+                {
+                    if (!Cheat_Write16(processHandle, (arg0 & 0x0FFFFFFF), (u16) (arg1 & 0xFFFF))) return 0;
+                }
+                break;
+            case CHEAT_OP_WRITE8:
+                // 2 Type
+                // Format: 2XXXXXXX 000000YY
+                // Description: 8bit write of YY to 0XXXXXXX.
+                if (!skipExecution)
+                {
+                    if (!Cheat_Write8(processHandle, (arg0 & 0x0FFFFFFF), (u8) (arg1 & 0xFF))) return 0;
+                }
+                break;
+            case CHEAT_OP_IF32:
+                // 3-6 Types
+                // Format: 3XXXXXXXX YYYYYYYY
+                // Description: 32bit if less than (3), greater than (4), equal to (5), not equal to (6).
+                // Simple: If the value at address 0XXXXXXX is less than the value YYYYYYYY.
+                // Example: 323D6B28 10000000
             {
                 bool newSkip;
-                u16 mask = (u16) ((arg1 >> 16) & 0xFFFF);
-                u16 value = 0;
-				
+                u32 value = 0;
                 switch (cheat_state.conditionalMode)
                 {
                     case 0x0:
-                        if (!Cheat_Read16(processHandle, arg0 & 0x0FFFFFFF, &value)) return 0;
-                        newSkip = !((value & (~mask)) == (arg1 & 0xFFFF));
+                        if (!Cheat_Read32(processHandle, arg0 & 0x0FFFFFFF, &value)) return 0;
+                        newSkip = !Cheat_Compare(insn->arg, value, arg1);
                         break;
                     case 0x1:
-                        if (!Cheat_Read16(processHandle, arg0 & 0x0FFFFFFF, &value)) return 0;
-                        newSkip = !((value & (~mask)) == (*activeData() & (~mask)));
+                        if (!Cheat_Read32(processHandle, arg0 & 0x0FFFFFFF, &value)) return 0;
+                        newSkip = !Cheat_Compare(insn->arg, value, *activeData());
                         break;
                     case 0x2:
-                        newSkip = !((*activeData() & (~mask)) == (arg1 & 0xFFFF));
+                        newSkip = !Cheat_Compare(insn->arg, *activeData(), arg1);
                         break;
                     case 0x3:
-                        newSkip = !((*activeStorage(cheat) & (~mask)) == (arg1 & 0xFFFF));
+                        newSkip = !Cheat_Compare(insn->arg, *activeStorage(cheat), arg1);
                         break;
                     case 0x4:
-                        newSkip = !((*activeData() & (~mask)) == (*activeStorage(cheat) & (~mask)));
+                        newSkip = !Cheat_Compare(insn->arg, *activeData(), *activeStorage(cheat));
                         break;
                     default:
                         return 0;
                 }
-
-                cheat_state.ifStack <<= 1;
-                cheat_state.ifStack |= (newSkip || skipExecution) ? 1 : 0;
-                cheat_state.ifCount++;
+                Cheat_PushCondition(newSkip, skipExecution);
             }
                 break;
-            case 0xA:
-                // A Type
-                // Format: AXXXXXXXX 0000YYYY
-                // Description: 16bit if not equal to.
-                // Simple: If the value at address 0XXXXXXX is not equal to the value YYYY.
-                // Example: A23D6B28 00005400
+            case CHEAT_OP_IF16:
+                // 7-A Types
+                // Format: 7XXXXXXXX ZZZZYYYY
+                // Description: 16bit if less than (7), greater than (8), equal to (9), not equal to (A), with mask ZZZZ.
+                // Simple: If the value at address 0XXXXXXX is less than the value YYYY.
+                // Example: 723D6B28 00005400
             {
                 bool newSkip;
-                u16 mask = (u16) ((arg1 >> 16) & 0xFFFF);
+                u32 notMask = ~(u32) ((arg1 >> 16) & 0xFFFF);
                 u16 value = 0;
 
                 switch (cheat_state.conditionalMode)
                 {
                     case 0x0:
                         if (!Cheat_Read16(processHandle, arg0 & 0x0FFFFFFF, &value)) return 0;
-                        newSkip = !((value & (~mask)) != (arg1 & 0xFFFF));
+                        newSkip = !Cheat_Compare(insn->arg, value & notMask, arg1 & 0xFFFF);
                         break;
                     case 0x1:
                         if (!Cheat_Read16(processHandle, arg0 & 0x0FFFFFFF, &value)) return 0;
-                        newSkip = !((value & (~mask)) != (*activeData() & (~mask)));
+                        newSkip = !Cheat_Compare(insn->arg, value & notMask, *activeData() & notMask);
                         break;
                     case 0x2:
-                        newSkip = !((*activeData() & (~mask)) != (arg1 & 0xFFFF));
+                        newSkip = !Cheat_Compare(insn->arg, *activeData() & notMask, arg1 & 0xFFFF);
                         break;
                     case 0x3:
-                        newSkip = !((*activeStorage(cheat) & (~mask)) != (arg1 & 0xFFFF));
+                        newSkip = !Cheat_Compare(insn->arg, *activeStorage(cheat) & notMask, arg1 & 0xFFFF);
                         break;
                     case 0x4:
-                        newSkip = !((*activeData() & (~mask)) != (*activeStorage(cheat) & (~mask)));
+                        newSkip = !Cheat_Compare(insn->arg, *activeData() & notMask, *activeStorage(cheat) & notMask);
                         break;
                     default:
                         return 0;
                 }
-
-                cheat_state.ifStack <<= 1;
-                cheat_state.ifStack |= (newSkip || skipExecution) ? 1 : 0;
-                cheat_state.ifCount++;
+                Cheat_PushCondition(newSkip, skipExecution);
             }
                 break;
-
-            case 0xB:
+            case CHEAT_OP_LOAD_OFFSET:
                 // B Type
                 // Format: BXXXXXXX 00000000
                 // Description: Loads offset register with value at given XXXXXXX
@@ -626,659 +881,433 @@ static u32 Cheat_ApplyCheat(const Handle processHandle, CheatDescription* const
                     *activeOffset() = value;
                 }
                 break;
-            case 0xC:
+            case CHEAT_OP_LOOP:
                 // C Type
                 // Format: C0000000 ZZZZZZZZ
                 // Description: Repeat following lines at specified offset.
                 // Simple: used to write a value to an address, and then continues to write that value Z number of times to all addresses at an offset determined by the (D6, D7, D8, or DC) type following it.
                 // Note: used with the D6, D7, D8, and DC types. C types can not be nested.
+                // C1 and C2 use the data registers as the repeat count instead.
                 // Example:
 
                 // C0000000 00000005
                 // 023D6B28 0009896C
                 // DC000000 00000010
                 // D2000000 00000000
-                switch (subcode)
-                {
-                    case 0x00:
-                        cheat_state.loopLine = cheat_state.index;
-                        cheat_state.loopCount = arg1;
-                        cheat_state.storedStack = cheat_state.ifStack;
-                        cheat_state.storedIfCount = cheat_state.ifCount;
-                        break;
-                    case 0x01:
-                        cheat_state.loopLine = cheat_state.index;
-                        cheat_state.loopCount = cheat_state.data1;
-                        cheat_state.storedStack = cheat_state.ifStack;
-                        cheat_state.storedIfCount = cheat_state.ifCount;
-                        break;
-                    case 0x02:
-                        cheat_state.loopLine = cheat_state.index;
-                        cheat_state.loopCount = cheat_state.data2;
-                        cheat_state.storedStack = cheat_state.ifStack;
-                        cheat_state.storedIfCount = cheat_state.ifCount;
-                        break;
-                }
+                cheat_state.loopLine = cheat_state.index;
+                cheat_state.loopCount = insn->arg == 0 ? arg1 : (insn->arg == 1 ? cheat_state.data1 : cheat_state.data2);
+                cheat_state.storedStack = cheat_state.ifStack;
+                cheat_state.storedIfCount = cheat_state.ifCount;
                 break;
-            case 0xD:
-                switch (subcode)
-                {
-                    case 0x00:
-                        // D0 Type
-                        // Format: D0000000 00000000
-                        // Description: ends most recent conditional.
-                        // Simple: type 3 through A are all "conditionals," the conditional most recently executed before this line will be terminated by it.
-                        // Example:
-
-                        // 94000130 FFFB0000
-                        // 74000100 FF00000C
-                        // 023D6B28 0009896C
-                        // D0000000 00000000
-
-                        // The 7 type line would be terminated.
-                        if (arg1 == 0)
-                        {
-                            if (cheat_state.loopLine != -1)
-                            {
-                                if (cheat_state.ifCount > 0 && cheat_state.ifCount > cheat_state.storedIfCount)
-                                {
-                                    cheat_state.ifStack >>= 1;
-                                    cheat_state.ifCount--;
-                                }
-                                else
-                                {
+            case CHEAT_OP_END_IF:
+                // D0 Type
+                // Format: D0000000 00000000
+                // Description: ends most recent conditional.
+                // Simple: type 3 through A are all "conditionals," the conditional most recently executed before this line will be terminated by it.
+                // Example:
 
-                                    if (cheat_state.loopCount > 0)
-                                    {
-                                        cheat_state.loopCount--;
-                                        if (cheat_state.loopCount == 0)
-                                        {
-                                            cheat_state.loopLine = -1;
-                                        }
-                                        else if (cheat_state.loopLine != -1)
-                                        {
-                                            cheat_state.index = cheat_state.loopLine;
-                                        }
-                                    }
-                                }
-                            }
-                            else
-                            {
-                                if (cheat_state.ifCount > 0)
-                                {
-                                    cheat_state.ifStack >>= 1;
-                                    cheat_state.ifCount--;
-                                }
-                            }
-                        }
-                        // D0000000 00000001
-                        // Loop break
-                        else if (!skipExecution && arg1 == 1)
+                // 94000130 FFFB0000
+                // 74000100 FF00000C
+                // 023D6B28 0009896C
+                // D0000000 00000000
+
+                // The 7 type line would be terminated.
+                if (cheat_state.loopLine != -1)
+                {
+                    if (cheat_state.ifCount > 0 && cheat_state.ifCount > cheat_state.storedIfCount)
+                    {
+                        cheat_state.ifStack >>= 1;
+                        cheat_state.ifCount--;
+                    }
+                    else if (cheat_state.loopCount > 0)
+                    {
+                        cheat_state.loopCount--;
+                        if (cheat_state.loopCount == 0)
                         {
-                            cheat_state.loopCount = 0;
                             cheat_state.loopLine = -1;
-                            cheat_state.index++;
-                            while (cheat_state.index < cheat->codesCount)
-                            {
-                                u64 code = cheat->codes[cheat_state.index++];
-                                if (code == 0xD100000000000000ull || code == 0xD200000000000000ull)
-                                {
-                                    break;
-                                }
-                            }
                         }
-                        break;
-                    case 0x01:
-                        // D1 Type
-                        // Format: D1000000 00000000
-                        // Description: ends repeat block.
-                        // Simple: will end all conditionals within a C type code, along with the C type itself.
-                        // Example:
-
-                        // 94000130 FFFB0000
-                        // C0000000 00000010
-                        // 8453DA0C 00000200
-                        // 023D6B28 0009896C
-                        // D6000000 00000005
-                        // D1000000 00000000
-
-                        // The C line, 8 line, 0 line, and D6 line would be terminated.
-                        if (cheat_state.loopCount > 0)
+                        else
                         {
-                            cheat_state.ifStack = cheat_state.storedStack;
-                            cheat_state.ifCount = cheat_state.storedIfCount;
-                            cheat_state.loopCount--;
-                            if (cheat_state.loopCount == 0)
-                            {
-                                cheat_state.loopLine = -1;
-                            }
-                            else
-                            {
-                                if (cheat_state.loopLine != -1)
-                                {
-                                    cheat_state.index = cheat_state.loopLine;
-                                }
-                            }
+                            cheat_state.index = cheat_state.loopLine;
                         }
-                        break;
-                    case 0x02:
-                        // D2 Type
-                        // Format: D2000000 00000000
-                        // Description: ends all conditionals/repeats before it and sets offset and stored to zero.
-                        // Simple: ends all lines.
-                        // Example:
-
-                        // 94000130 FEEF0000
-                        // C0000000 00000010
-                        // 8453DA0C 00000200
-                        // 023D6B28 0009896C
-                        // D6000000 00000005
-                        // D2000000 00000000
-
-                        // All lines would terminate.
-                        if (arg1 == 0)
-                        {
-                            if (cheat_state.loopCount > 0)
-                            {
-                                cheat_state.loopCount--;
-                                if (cheat_state.loopCount == 0)
-                                {
-                                    *activeData() = 0;
-                                    *activeOffset() = 0;
-                                    cheat_state.loopLine = -1;
+                    }
+                }
+                else if (cheat_state.ifCount > 0)
+                {
+                    cheat_state.ifStack >>= 1;
+                    cheat_state.ifCount--;
+                }
+                break;
+            case CHEAT_OP_LOOP_BREAK:
+                // D0000000 00000001
+                // Loop break: resumes after the next D1/D2 line, whose position is resolved at load time
+                if (!skipExecution)
+                {
+                    cheat_state.loopCount = 0;
+                    cheat_state.loopLine = -1;
+                    cheat_state.index = insn->target;
+                    continue;
+                }
+                break;
+            case CHEAT_OP_END_LOOP:
+                // D1 Type
+                // Format: D1000000 00000000
+                // Description: ends repeat block.
+                // Simple: will end all conditionals within a C type code, along with the C type itself.
+                // Example:
 
-                                    cheat_state.ifStack = 0;
-                                    cheat_state.ifCount = 0;
-                                }
-                                else
-                                {
-                                    if (cheat_state.loopLine != -1)
-                                    {
-                                        cheat_state.index = cheat_state.loopLine;
-                                    }
-                                }
-                            }
-                            else
-                            {
-                                *activeData() = 0;
-                                *activeOffset() = 0;
-                                cheat_state.ifStack = 0;
-                                cheat_state.ifCount = 0;
-                            }
-                        }
-                        // D2000000 00000001
-                        // Return
-                        else if (!skipExecution && arg1 == 1)
-                        {
-                            cheat_state.index = cheat->codesCount;
-                        }
-                        break;
-                    case 0x03:
-                        // D3 Type
-                        // Format: D3000000 XXXXXXXX
-                        // Description: sets offset.
-                        // Simple: loads the address X so that lines after can modify the value at address X.
-                        // Note: used with the D4, D5, D6, D7, D8, and DC types.
-                        // Example: D3000000 023D6B28
-                        if (!skipExecution)
-                        {
-                            if (codeArg == 0)
-                            {
-                                cheat_state.offset1 = arg1;
-                            }
-                            else if (codeArg == 1)
-                            {
-                                cheat_state.offset2 = arg1;
-                            }
-                        }
-                        break;
-                    case 0x04:
-                        // D4 Type
-                        // Format: D4000000 YYYYYYYY
-                        // Description: adds to the stored address' value.
-                        // Simple: adds to the value at the address defined by lines D3, D9, DA, and DB.
-                        // Note: used with the D3, D9, DA, DB, DC types.
-                        // Example: D4000000 00000025
-                        if (!skipExecution)
-                        {
-                            if (codeArg == 0)
-                            {
-                                *activeData() += arg1;
-                            }
-                            else if (codeArg == 1)
-                            {
-                                cheat_state.data1 += arg1 + cheat_state.data2;
-                            }
-                            else if (codeArg == 2)
-                            {
-                                cheat_state.data2 += arg1 + cheat_state.data1;
-                            }
-                        }
-                        break;
-                    case 0x05:
-                        // D5 Type
-                        // Format: D5000000 YYYYYYYY
-                        // Description: sets the stored address' value.
-                        // Simple: makes the value at the address defined by lines D3, D9, DA, and DB to YYYYYYYY.
-                        // Note: used with the D3, D9, DA, DB, and DC types.
-                        // Example: D5000000 34540099
-                        if (!skipExecution)
-                        {
-                            if (codeArg == 0)
-                            {
-                                *activeData() = arg1;
-                            }
-                            else if (codeArg == 1)
-                            {
-                                cheat_state.data1 = arg1;
-                            }
-                            else if (codeArg == 2)
-                            {
-                                cheat_state.data2 = arg1;
-                            }
-                        }
-                        break;
-                    case 0x06:
-                        // D6 Type
-                        // Format: D6000000 XXXXXXXX
-                        // Description: 32bit store and increment by 4.
-                        // Simple: stores the value at address XXXXXXXX and to addresses in increments of 4.
-                        // Note: used with the C, D3, and D9 types.
-                        // Example: D3000000 023D6B28
-                        if (!skipExecution)
-                        {
-                            if (codeArg == 0)
-                            {
-                                if (!Cheat_Write32(processHandle, arg1, *activeData())) return 0;
-                                *activeOffset() += 4;
-                            }
-                            else if (codeArg == 1)
-                            {
-                                if (!Cheat_Write32(processHandle, arg1, cheat_state.data1)) return 0;
-                                *activeOffset() += 4;
-                            }
-                            else if (codeArg == 2)
-                            {
-                                if (!Cheat_Write32(processHandle, arg1, cheat_state.data2)) return 0;
-                                *activeOffset() += 4;
-                            }
-                        }
-                        break;
-                    case 0x07:
-                        // D7 Type
-                        // Format: D7000000 XXXXXXXX
-                        // Description: 16bit store and increment by 2.
-                        // Simple: stores 2 bytes of the value at address XXXXXXXX and to addresses in increments of 2.
-                        // Note: used with the C, D3, and DA types.
-                        // Example: D7000000 023D6B28
-                        if (!skipExecution)
-                        {
-                            if (codeArg == 0)
-                            {
-                                if (!Cheat_Write16(processHandle, arg1, (u16) (*activeData() & 0xFFFF))) return 0;
-                                *activeOffset() += 2;
-                            }
-                            else if (codeArg == 1)
-                            {
-                                if (!Cheat_Write16(processHandle, arg1, (u16) (cheat_state.data1 & 0xFFFF))) return 0;
-                                *activeOffset() += 2;
-                            }
-                            else if (codeArg == 2)
-                            {
-                                if (!Cheat_Write16(processHandle, arg1, (u16) (cheat_state.data2 & 0xFFFF))) return 0;
-                                *activeOffset() += 2;
-                            }
-                        }
-                        break;
-                    case 0x08:
-                        // D8 Type
-                        // Format: D8000000 XXXXXXXX
-                        // Description: 8bit store and increment by 1.
-                        // Simple: stores 1 byte of the value at address XXXXXXXX and to addresses in increments of 1.
-                        // Note: used with the C, D3, and DB types.
-                        // Example: D8000000 023D6B28
-                        if (!skipExecution)
-                        {
-                            if (codeArg == 0)
-                            {
-                                if (!Cheat_Write8(processHandle, arg1, (u8) (*activeData() & 0xFF))) return 0;
-                                *activeOffset() += 1;
-                            }
-                            else if (codeArg == 1)
-                            {
-                                if (!Cheat_Write8(processHandle, arg1, (u8) (cheat_state.data1 & 0xFF))) return 0;
-                                *activeOffset() += 1;
-                            }
-                            else if (codeArg == 2)
-                            {
-                                if (!Cheat_Write8(processHandle, arg1, (u8) (cheat_state.data2 & 0xFF))) return 0;
-                                *activeOffset() += 1;
-                            }
-                        }
-                        break;
-                    case 0x09:
-                        // D9 Type
-                        // Format: D9000000 XXXXXXXX
-                        // Description: 32bit load.
-                        // Simple: loads the value from address X.
-                        // Note: used with the D5 and D6 types.
-                        // Example: D9000000 023D6B28
-                        if (!skipExecution)
-                        {
-                            if (codeArg == 0)
-                            {
-                                u32 value = 0;
-                                if (!Cheat_Read32(processHandle, arg1, &value)) return 0;
-                                *activeData() = value;
-                            }
-                            else if (codeArg == 1)
-                            {
-                                u32 value = 0;
-                                if (!Cheat_Read32(processHandle, arg1, &value)) return 0;
-                                cheat_state.data1 = value;
-                            }
-                            else if (codeArg == 2)
-                            {
-                                u32 value = 0;
-                                if (!Cheat_Read32(processHandle, arg1, &value)) return 0;
-                                cheat_state.data2 = value;
-                            }
-                        }
-                        break;
-                    case 0x0A:
-                        // DA Type
-                        // Format: DA000000 XXXXXXXX
-                        // Description: 16bit load.
-                        // Simple: loads 2 bytes from address X.
-                        // Note: used with the D5 and D7 types.
-                        // Example: DA000000 023D6B28
-                        if (!skipExecution)
-                        {
-                            if (codeArg == 0)
-                            {
-                                u16 value = 0;
-                                if (!Cheat_Read16(processHandle, arg1, &value)) return 0;
-                                *activeData() = value;
-                            }
-                            else if (codeArg == 1)
-                            {
-                                u16 value = 0;
-                                if (!Cheat_Read16(processHandle, arg1, &value)) return 0;
-                                cheat_state.data1 = value;
-                            }
-                            else if (codeArg == 2)
-                            {
-                                u16 value = 0;
-                                if (!Cheat_Read16(processHandle, arg1, &value)) return 0;
-                                cheat_state.data2 = value;
-                            }
-                        }
-                        break;
-                    case 0x0B:
-                        // DB Type
-                        // Format: DB000000 XXXXXXXX
-                        // Description: 8bit load.
-                        // Simple: loads 1 byte from address X.
-                        // Note: used with the D5 and D8 types.
-                        // Example: DB000000 023D6B28
-                        if (!skipExecution)
-                        {
-                            if (codeArg == 0)
-                            {
-                                u8 value = 0;
-                                if (!Cheat_Read8(processHandle, arg1, &value)) return 0;
-                                *activeData() = value;
-                            }
-                            else if (codeArg == 1)
-                            {
-                                u8 value = 0;
-                                if (!Cheat_Read8(processHandle, arg1, &value)) return 0;
-                                cheat_state.data1 = value;
-                            }
-                            else if (codeArg == 2)
-                            {
-                                u8 value = 0;
-                                if (!Cheat_Read8(processHandle, arg1, &value)) return 0;
-                                cheat_state.data2 = value;
-                            }
-                        }
-                        break;
-                    case 0x0C:
-                        // DC Type
-                        // Format: DC000000 VVVVVVVV
-                        // Description: 32bit store and increment by V.
-                        // Simple: stores the value at address(es) before it and to addresses in increments of V.
-                        // Note: used with the C, D3, D5, D9, D8, DB types.
-                        // Example: DC000000 00000100
-                        if (!skipExecution)
-                        {
-                            *activeOffset() += arg1;
-                        }
-                        break;
-                    case 0x0D:
-                        // DD Type
+                // 94000130 FFFB0000
+                // C0000000 00000010
+                // 8453DA0C 00000200
+                // 023D6B28 0009896C
+                // D6000000 00000005
+                // D1000000 00000000
+
+                // The C line, 8 line, 0 line, and D6 line would be terminated.
+                if (cheat_state.loopCount > 0)
+                {
+                    cheat_state.ifStack = cheat_state.storedStack;
+                    cheat_state.ifCount = cheat_state.storedIfCount;
+                    cheat_state.loopCount--;
+                    if (cheat_state.loopCount == 0)
+                    {
+                        cheat_state.loopLine = -1;
+                    }
+                    else if (cheat_state.loopLine != -1)
+                    {
+                        cheat_state.index = cheat_state.loopLine;
+                    }
+                }
+                break;
+            case CHEAT_OP_END_ALL:
+                // D2 Type
+                // Format: D2000000 00000000
+                // Description: ends all conditionals/repeats before it and sets offset and stored to zero.
+                // Simple: ends all lines.
+                // Example:
+
+                // 94000130 FEEF0000
+                // C0000000 00000010
+                // 8453DA0C 00000200
+                // 023D6B28 0009896C
+                // D6000000 00000005
+                // D2000000 00000000
+
+                // All lines would terminate.
+                if (cheat_state.loopCount > 0)
+                {
+                    cheat_state.loopCount--;
+                    if (cheat_state.loopCount == 0)
                     {
-                        bool newSkip = !(arg1 == 0 || (HID_PAD & arg1) == arg1);
+                        *activeData() = 0;
+                        *activeOffset() = 0;
+                        cheat_state.loopLine = -1;
 
-                        cheat_state.ifStack <<= 1;
-                        cheat_state.ifStack |= (newSkip || skipExecution) ? 1 : 0;;
-                        cheat_state.ifCount++;
+                        cheat_state.ifStack = 0;
+                        cheat_state.ifCount = 0;
                     }
-                        break;
-                    case 0x0E:
-                        // Touchpad conditional
-                        // DE000000 AAAABBBB: AAAA >= X position >= BBBB
-                        // DE000001 AAAABBBB: AAAA >= Y position >= BBBB
+                    else if (cheat_state.loopLine != -1)
                     {
-                        bool newSkip;
-                        u32 highBound = arg1 >> 16;
-                        u32 lowBound = arg1 & 0xFFFF;
-                        touchPosition touch;
-                        hidTouchRead(&touch);
-                        if (codeArg == 0)
-                        {
-                            newSkip = !(lowBound <= touch.px && highBound >= touch.px);
-                        }
-                        else if (codeArg == 1)
-                        {
-                            newSkip = !(lowBound <= touch.py && highBound >= touch.py);
-                        }
-                        else
-                        {
-                            return 0;
-                        }
+                        cheat_state.index = cheat_state.loopLine;
+                    }
+                }
+                else
+                {
+                    *activeData() = 0;
+                    *activeOffset() = 0;
+                    cheat_state.ifStack = 0;
+                    cheat_state.ifCount = 0;
+                }
+                break;
+            case CHEAT_OP_RETURN:
+                // D2000000 00000001
+                // Return
+                if (!skipExecution)
+                {
+                    cheat_state.index = cheat->codesCount;
+                }
+                break;
+            case CHEAT_OP_SET_OFFSET:
+                // D3 Type
+                // Format: D3000000 XXXXXXXX
+                // Description: sets offset.
+                // Simple: loads the address X so that lines after can modify the value at address X.
+                // Note: used with the D4, D5, D6, D7, D8, and DC types.
+                // Example: D3000000 023D6B28
+                if (!skipExecution)
+                {
+                    if (insn->arg == 0)
+                    {
+                        cheat_state.offset1 = arg1;
+                    }
+                    else
+                    {
+                        cheat_state.offset2 = arg1;
+                    }
+                }
+                break;
+            case CHEAT_OP_ADD_DATA:
+                // D4 Type
+                // Format: D4000000 YYYYYYYY
+                // Description: adds to the stored address' value.
+                // Simple: adds to the value at the address defined by lines D3, D9, DA, and DB.
+                // Note: used with the D3, D9, DA, DB, DC types.
+                // Example: D4000000 00000025
+                if (!skipExecution)
+                {
+                    if (insn->arg == 0)
+                    {
+                        *activeData() += arg1;
+                    }
+                    else if (insn->arg == 1)
+                    {
+                        cheat_state.data1 += arg1 + cheat_state.data2;
+                    }
+                    else
+                    {
+                        cheat_state.data2 += arg1 + cheat_state.data1;
+                    }
+                }
+                break;
+            case CHEAT_OP_SET_DATA:
+                // D5 Type
+                // Format: D5000000 YYYYYYYY
+                // Description: sets the stored address' value.
+                // Simple: makes the value at the address defined by lines D3, D9, DA, and DB to YYYYYYYY.
+                // Note: used with the D3, D9, DA, DB, and DC types.
+                // Example: D5000000 34540099
+                if (!skipExecution)
+                {
+                    *Cheat_GetRegisterPtr(insn->arg) = arg1;
+                }
+                break;
+            case CHEAT_OP_STORE32:
+                // D6 Type
+                // Format: D6000000 XXXXXXXX
+                // Description: 32bit store and increment by 4.
+                // Simple: stores the value at address XXXXXXXX and to addresses in increments of 4.
+                // Note: used with the C, D3, and D9 types.
+                // Example: D3000000 023D6B28
+                if (!skipExecution)
+                {
+                    if (!Cheat_Write32(processHandle, arg1, Cheat_GetRegister(insn->arg))) return 0;
+                    *activeOffset() += 4;
+                }
+                break;
+            case CHEAT_OP_STORE16:
+                // D7 Type
+                // Format: D7000000 XXXXXXXX
+                // Description: 16bit store and increment by 2.
+                // Simple: stores 2 bytes of the value at address XXXXXXXX and to addresses in increments of 2.
+                // Note: used with the C, D3, and DA types.
+                // Example: D7000000 023D6B28
+                if (!skipExecution)
+                {
+                    if (!Cheat_Write16(processHandle, arg1, (u16) (Cheat_GetRegister(insn->arg) & 0xFFFF))) return 0;
+                    *activeOffset() += 2;
+                }
+                break;
+            case CHEAT_OP_STORE8:
+                // D8 Type
+                // Format: D8000000 XXXXXXXX
+                // Description: 8bit store and increment by 1.
+                // Simple: stores 1 byte of the value at address XXXXXXXX and to addresses in increments of 1.
+                // Note: used with the C, D3, and DB types.
+                // Example: D8000000 023D6B28
+                if (!skipExecution)
+                {
+                    if (!Cheat_Write8(processHandle, arg1, (u8) (Cheat_GetRegister(insn->arg) & 0xFF))) return 0;
+                    *activeOffset() += 1;
+                }
+                break;
+            case CHEAT_OP_LOAD32:
+                // D9 Type
+                // Format: D9000000 XXXXXXXX
+                // Description: 32bit load.
+                // Simple: loads the value from address X.
+                // Note: used with the D5 and D6 types.
+                // Example: D9000000 023D6B28
+                if (!skipExecution)
+                {
+                    u32 value = 0;
+                    if (!Cheat_Read32(processHandle, arg1, &value)) return 0;
+                    *Cheat_GetRegisterPtr(insn->arg) = value;
+                }
+                break;
+            case CHEAT_OP_LOAD16:
+                // DA Type
+                // Format: DA000000 XXXXXXXX
+                // Description: 16bit load.
+                // Simple: loads 2 bytes from address X.
+                // Note: used with the D5 and D7 types.
+                // Example: DA000000 023D6B28
+                if (!skipExecution)
+                {
+                    u16 value = 0;
+                    if (!Cheat_Read16(processHandle, arg1, &value)) return 0;
+                    *Cheat_GetRegisterPtr(insn->arg) = value;
+                }
+                break;
+            case CHEAT_OP_LOAD8:
+                // DB Type
+                // Format: DB000000 XXXXXXXX
+                // Description: 8bit load.
+                // Simple: loads 1 byte from address X.
+                // Note: used with the D5 and D8 types.
+                // Example: DB000000 023D6B28
+                if (!skipExecution)
+                {
+                    u8 value = 0;
+                    if (!Cheat_Read8(processHandle, arg1, &value)) return 0;
+                    *Cheat_GetRegisterPtr(insn->arg) = value;
+                }
+                break;
+            case CHEAT_OP_ADD_OFFSET:
+                // DC Type
+                // Format: DC000000 VVVVVVVV
+                // Description: 32bit store and increment by V.
+                // Simple: stores the value at address(es) before it and to addresses in increments of V.
+                // Note: used with the C, D3, D5, D9, D8, DB types.
+                // Example: DC000000 00000100
+                if (!skipExecution)
+                {
+                    *activeOffset() += arg1;
+                }
+                break;
+            case CHEAT_OP_IF_KEYS:
+                // DD Type
+                Cheat_PushCondition(!(arg1 == 0 || (HID_PAD & arg1) == arg1), skipExecution);
+                break;
+            case CHEAT_OP_IF_TOUCH:
+                // Touchpad conditional
+                // DE000000 AAAABBBB: AAAA >= X position >= BBBB
+                // DE000001 AAAABBBB: AAAA >= Y position >= BBBB
+            {
+                u32 highBound = arg1 >> 16;
+                u32 lowBound = arg1 & 0xFFFF;
+                touchPosition touch;
+                hidTouchRead(&touch);
+                u32 position = insn->arg == 0 ? touch.px : touch.py;
 
-                        cheat_state.ifStack <<= 1;
-                        cheat_state.ifStack |= (newSkip || skipExecution) ? 1 : 0;
-                        cheat_state.ifCount++;
+                Cheat_PushCondition(!(lowBound <= position && highBound >= position), skipExecution);
+            }
+                break;
+            case CHEAT_OP_OFFSET_REGISTER:
+                if (arg1 & 0x00010000)
+                {
+                    if (arg1 & 0x1)
+                    {
+                        cheat_state.offset2 = cheat_state.offset1;
                     }
-                        break;
-                    case 0x0F:
+                    else
                     {
-                        switch (codeArg)
-                        {
-                            case 0x00:
-                            {
-                                if (arg1 & 0x00010000)
-                                {
-                                    if (arg1 & 0x1)
-                                    {
-                                        cheat_state.offset2 = cheat_state.offset1;
-                                    }
-                                    else
-                                    {
-                                        cheat_state.offset1 = cheat_state.offset2;
-                                    }
-                                }
-                                else if (arg1 & 0x00020000)
-                                {
-                                    if (arg1 & 0x1)
-                                    {
-                                        cheat_state.data2 = cheat_state.offset2;
-                                    }
-                                    else
-                                    {
-                                        cheat_state.data1 = cheat_state.offset1;
-                                    }
-                                }
-                                else
-                                {
-                                    cheat_state.activeOffset = arg1 & 0x1;
-                                }
-                            }
-                                break;
-                            case 0x01:
-                            {
-                                if (arg1 & 0x00010000)
-                                {
-                                    if (arg1 & 0x1)
-                                    {
-                                        cheat_state.data2 = cheat_state.data1;
-                                    }
-                                    else
-                                    {
-                                        cheat_state.data1 = cheat_state.data2;
-                                    }
-                                }
-                                else if (arg1 & 0x00020000)
-                                {
-                                    if (arg1 & 0x1)
-                                    {
-                                        cheat_state.offset2 = cheat_state.data2;
-                                    }
-                                    else
-                                    {
-                                        cheat_state.offset1 = cheat_state.data1;
-                                    }
-                                }
-                                else
-                                {
-                                    cheat_state.activeData = arg1 & 0x1;
-                                }
-                            }
-                                break;
-                            case 0x02:
-                            {
-                                if (arg1 & 0x00010000)
-                                {
-                                    if (arg1 & 0x1)
-                                    {
-                                        cheat_state.data2 = cheat->storage2;
-                                    }
-                                    else
-                                    {
-                                        cheat_state.data1 = cheat->storage1;
-                                    }
-                                }
-                                else if (arg1 & 0x00020000)
-                                {
-                                    if (arg1 & 0x1)
-                                    {
-                                        cheat->storage2 = cheat_state.data2;
-                                    }
-                                    else
-                                    {
-                                        cheat->storage1 = cheat_state.data1;
-                                    }
-                                }
-                                else
-                                {
-                                    cheat->activeStorage = arg1 & 0x1;
-                                }
-                            }
-                                break;
-                            case 0x0E:
-                            {
-                                if (cheat_state.activeData)
-                                {
-                                    switch (arg1)
-                                    {
-                                        case 0x0:
-                                        {
-                                            cheat_state.data2Mode = 0;
-                                        }
-                                            break;
-                                        case 0x1:
-                                        {
-                                            cheat_state.data2Mode = 1;
-                                        }
-                                            break;
-                                        case 0x10:
-                                        {
-                                            cheat_state.data2Mode = 0;
-                                            float val;
-                                            memcpy(&val, &cheat_state.data2, sizeof(float));
-                                            cheat_state.data2 = val;
-                                        }
-                                            break;
-                                        case 0x11:
-                                        {
-                                            cheat_state.data2Mode = 1;
-                                            float val = cheat_state.data2;
-                                            memcpy(&cheat_state.data2, &val, sizeof(float));
-                                        }
-                                            break;
-                                        default:
-                                            return 0;
-                                    }
-                                }
-                                else
-                                {
-                                    switch (arg1)
-                                    {
-                                        case 0x0:
-                                        {
-                                            cheat_state.data1Mode = 0;
-                                        }
-                                            break;
-                                        case 0x1:
-                                        {
-                                            cheat_state.data1Mode = 1;
-                                        }
-                                            break;
-                                        case 0x10:
-                                        {
-                                            cheat_state.data1Mode = 0;
-                                            float val;
-                                            memcpy(&val, &cheat_state.data1, sizeof(float));
-                                            cheat_state.data1 = val;
-                                        }
-                                            break;
-                                        case 0x11:
-                                        {
-                                            cheat_state.data1Mode = 1;
-                                            float val = cheat_state.data1;
-                                            memcpy(&cheat_state.data1, &val, sizeof(float));
-                                        }
-                                            break;
-                                        default:
-                                            return 0;
-                                    }
-                                }
-                            }
-                                break;
-                            case 0x0F:
-                            {
-                                if (arg1 < 5)
-                                {
-                                    cheat_state.conditionalMode = (u8)arg1;
-                                }
-                                else
-                                {
-                                    return 0;
-                                }
-                            }
-                                break;
-                            default:
-                                return 0;
-                        }
+                        cheat_state.offset1 = cheat_state.offset2;
+                    }
+                }
+                else if (arg1 & 0x00020000)
+                {
+                    if (arg1 & 0x1)
+                    {
+                        cheat_state.data2 = cheat_state.offset2;
+                    }
+                    else
+                    {
+                        cheat_state.data1 = cheat_state.offset1;
                     }
-                        break;
-                    default:
-                        return 0;
+                }
+                else
+                {
+                    cheat_state.activeOffset = arg1 & 0x1;
                 }
                 break;
-            case 0xE:
+            case CHEAT_OP_DATA_REGISTER:
+                if (arg1 & 0x00010000)
+                {
+                    if (arg1 & 0x1)
+                    {
+                        cheat_state.data2 = cheat_state.data1;
+                    }
+                    else
+                    {
+                        cheat_state.data1 = cheat_state.data2;
+                    }
+                }
+                else if (arg1 & 0x00020000)
+                {
+                    if (arg1 & 0x1)
+                    {
+                        cheat_state.offset2 = cheat_state.data2;
+                    }
+                    else
+                    {
+                        cheat_state.offset1 = cheat_state.data1;
+                    }
+                }
+                else
+                {
+                    cheat_state.activeData = arg1 & 0x1;
+                }
+                break;
+            case CHEAT_OP_STORAGE_REGISTER:
+                if (arg1 & 0x00010000)
+                {
+                    if (arg1 & 0x1)
+                    {
+                        cheat_state.data2 = cheat->storage2;
+                    }
+                    else
+                    {
+                        cheat_state.data1 = cheat->storage1;
+                    }
+                }
+                else if (arg1 & 0x00020000)
+                {
+                    if (arg1 & 0x1)
+                    {
+                        cheat->storage2 = cheat_state.data2;
+                    }
+                    else
+                    {
+                        cheat->storage1 = cheat_state.data1;
+                    }
+                }
+                else
+                {
+                    cheat->activeStorage = arg1 & 0x1;
+                }
+                break;
+            case CHEAT_OP_DATA_MODE:
+            {
+                // DFE0000 000000XY: X = convert the active data register, Y = float mode
+                u32* data = activeData();
+                u8 floatMode = arg1 & 0x1;
+
+                if (arg1 == 0x10)
+                {
+                    float val;
+                    memcpy(&val, data, sizeof(float));
+                    *data = val;
+                }
+                else if (arg1 == 0x11)
+                {
+                    float val = *data;
+                    memcpy(data, &val, sizeof(float));
+                }
+
+                if (cheat_state.activeData)
+                {
+                    cheat_state.data2Mode = floatMode;
+                }
+                else
+                {
+                    cheat_state.data1Mode = floatMode;
+                }
+            }
+                break;
+            case CHEAT_OP_CONDITIONAL_MODE:
+                cheat_state.conditionalMode = (u8)arg1;
+                break;
+            case CHEAT_OP_TYPE_E:
                 // E Type
                 // Format:
                 // EXXXXXXX UUUUUUUU
@@ -1289,340 +1318,316 @@ static u32 Cheat_ApplyCheat(const Handle processHandle, CheatDescription* const
             {
                 u32 beginOffset = (arg0 & 0x0FFFFFFF);
                 u32 count = arg1;
-                cheat_state.typeELine = cheat_state.index;
-                cheat_state.typeEIdx = 7;
-                for (u32 i = 0; i < count; i++)
+                u32 line = cheat_state.index + 1;
+
+                if (!skipExecution)
                 {
-                    u8 byte = Cheat_GetNextTypeE(cheat);
-                    if (!skipExecution)
+                    for (u32 i = 0; i < count; i++)
                     {
-                        if (!Cheat_Write8(processHandle, beginOffset + i, byte)) return 0;
+                        if (!Cheat_Write8(processHandle, beginOffset + i, Cheat_GetTypeEByte(cheat, line + i / 8, i % 8))) return 0;
                     }
                 }
-                cheat_state.index = cheat_state.typeELine;
+                cheat_state.index = line + (count + 7) / 8 - 1;
             }
                 break;
-            case 0xF:
-            {
-                if (arg0 == 0xF0F00000)
+            case CHEAT_OP_FLOAT_MODE:
+                if(!skipExecution)
                 {
-                    // I have no clue how to implement this, or if it's even possible. Needs research.
-                    return 0;
+                    cheat_state.floatMode = arg1 & 0x1;
                 }
-                else
+                break;
+            case CHEAT_OP_ADD_MEMORY:
+            case CHEAT_OP_MUL_MEMORY:
+            case CHEAT_OP_DIV_MEMORY:
+                // F1-F3 Types
+                // Format: F1XXXXXX YYYYYYYY
+                // Description: adds (F1), multiplies (F2) or divides (F3) the 32bit value at XXXXXX by Y,
+                // as floats if the float mode is set by F0.
+                if (!skipExecution)
                 {
-                    switch (subcode)
+                    u32 tmp;
+                    if (!Cheat_Read32(processHandle, arg0 & 0x00FFFFFF, &tmp))
                     {
-                        case 0x0:
+                        return 0;
+                    }
+                    if (cheat_state.floatMode)
+                    {
+                        float flarg1;
+                        memcpy(&flarg1, &arg1, sizeof(float));
+                        float value;
+                        memcpy(&value, &tmp, sizeof(float));
+                        if (insn->opcode == CHEAT_OP_ADD_MEMORY)
                         {
-                            if(!skipExecution)
-                            {
-                                cheat_state.floatMode = arg1 & 0x1;
-                            }
+                            value += flarg1;
                         }
-                            break;
-                        case 0x1:
+                        else if (insn->opcode == CHEAT_OP_MUL_MEMORY)
                         {
-                            if (!skipExecution)
-                            {
-                                if (cheat_state.floatMode)
-                                {
-                                    float flarg1;
-                                    memcpy(&flarg1, &arg1, sizeof(float));
-                                    u32 tmp;
-                                    if (!Cheat_Read32(processHandle, arg0 & 0x00FFFFFF, &tmp))
-                                    {
-                                        return 0;
-                                    }
-                                    float value;
-                                    memcpy(&value, &tmp, sizeof(float));
-                                    value += flarg1;
-                                    memcpy(&tmp, &value, sizeof(u32));
-                                    if (!Cheat_Write32(processHandle, arg0 & 0x00FFFFFF, tmp))
-                                    {
-                                        return 0;
-                                    }
-                                }
-                                else
-                                {
-                                    u32 tmp;
-                                    if (!Cheat_Read32(processHandle, arg0 & 0x00FFFFFF, &tmp))
-                                    {
-                                        return 0;
-                                    }
-                                    tmp += arg1;
-                                    if (!Cheat_Write32(processHandle, arg0 & 0x00FFFFFF, tmp))
-                                    {
-                                        return 0;
-                                    }
-                                }
-                            }
+                            value *= flarg1;
                         }
-                            break;
-                        case 0x2:
+                        else
                         {
-                            if (!skipExecution)
-                            {
-                                if (cheat_state.floatMode)
-                                {
-                                    float flarg1;
-                                    memcpy(&flarg1, &arg1, sizeof(float));
-                                    u32 tmp;
-                                    if (!Cheat_Read32(processHandle, arg0 & 0x00FFFFFF, &tmp))
-                                    {
-                                        return 0;
-                                    }
-                                    float value;
-                                    memcpy(&value, &tmp, sizeof(float));
-                                    value *= flarg1;
-                                    memcpy(&tmp, &value, sizeof(u32));
-                                    if (!Cheat_Write32(processHandle, arg0 & 0x00FFFFFF, tmp))
-                                    {
-                                        return 0;
-                                    }
-                                }
-                                else
-                                {
-                                    u32 tmp;
-                                    if (!Cheat_Read32(processHandle, arg0 & 0x00FFFFFF, &tmp))
-                                    {
-                                        return 0;
-                                    }
-                                    tmp *= arg1;
-                                    if (!Cheat_Write32(processHandle, arg0 & 0x00FFFFFF, tmp))
-                                    {
-                                        return 0;
-                                    }
-                                }
-                            }
+                            value /= flarg1;
                         }
-                            break;
-                        case 0x3:
+                        memcpy(&tmp, &value, sizeof(u32));
+                    }
+                    else
+                    {
+                        if (insn->opcode == CHEAT_OP_ADD_MEMORY)
                         {
-                            if (!skipExecution)
-                            {
-                                if (cheat_state.floatMode)
-                                {
-                                    float flarg1;
-                                    memcpy(&flarg1, &arg1, sizeof(float));
-                                    u32 tmp;
-                                    if (!Cheat_Read32(processHandle, arg0 & 0x00FFFFFF, &tmp))
-                                    {
-                                        return 0;
-                                    }
-                                    float value;
-                                    memcpy(&value, &tmp, sizeof(float));
-                                    value /= flarg1;
-                                    memcpy(&tmp, &value, sizeof(u32));
-                                    if (!Cheat_Write32(processHandle, arg0 & 0x00FFFFFF, tmp))
-                                    {
-                                        return 0;
-                                    }
-                                }
-                                else
-                                {
-                                    u32 tmp;
-                                    if (!Cheat_Read32(processHandle, arg0 & 0x00FFFFFF, &tmp))
-                                    {
-                                        return 0;
-                                    }
-                                    tmp /= arg1;
-                                    if (!Cheat_Write32(processHandle, arg0 & 0x00FFFFFF, tmp))
-                                    {
-                                        return 0;
-                                    }
-                                }
-                            }
+                            tmp += arg1;
                         }
-                            break;
-                        case 0x4:
+                        else if (insn->opcode == CHEAT_OP_MUL_MEMORY)
                         {
-                            if (!skipExecution)
-                            {
-                                if (cheat_state.data1Mode)
-                                {
-                                    float flarg1;
-                                    memcpy(&flarg1, &arg1, sizeof(float));
-                                    float value;
-                                    memcpy(&value, activeData(), sizeof(float));
-                                    value *= flarg1;
-                                    memcpy(activeData(), &value, sizeof(float));
-                                }
-                                else
-                                {
-                                    *activeData() *= arg1;
-                                }
-                            }
+                            tmp *= arg1;
                         }
-                            break;
-                        case 0x5:
+                        else
                         {
-                            if (!skipExecution)
-                            {
-                                if (cheat_state.data1Mode)
-                                {
-                                    float flarg1;
-                                    memcpy(&flarg1, &arg1, sizeof(float));
-                                    float value;
-                                    memcpy(&value, activeData(), sizeof(float));
-                                    value /= flarg1;
-                                    memcpy(activeData(), &value, sizeof(float));
-                                }
-                                else
-                                {
-                                    *activeData() /= arg1;
-                                }
-                            }
+                            tmp /= arg1;
                         }
-                            break;
-                        case 0x6:
-                        {
-                            if (!skipExecution)
-                            {
-                                *activeData() &= arg1;
-                            }
-                        }
-                            break;
-                        case 0x7:
+                    }
+                    if (!Cheat_Write32(processHandle, arg0 & 0x00FFFFFF, tmp))
+                    {
+                        return 0;
+                    }
+                }
+                break;
+            case CHEAT_OP_MUL_DATA:
+                if (!skipExecution)
+                {
+                    if (cheat_state.data1Mode)
+                    {
+                        float flarg1;
+                        memcpy(&flarg1, &arg1, sizeof(float));
+                        float value;
+                        memcpy(&value, activeData(), sizeof(float));
+                        value *= flarg1;
+                        memcpy(activeData(), &value, sizeof(float));
+                    }
+                    else
+                    {
+                        *activeData() *= arg1;
+                    }
+                }
+                break;
+            case CHEAT_OP_DIV_DATA:
+                if (!skipExecution)
+                {
+                    if (cheat_state.data1Mode)
+                    {
+                        float flarg1;
+                        memcpy(&flarg1, &arg1, sizeof(float));
+                        float value;
+                        memcpy(&value, activeData(), sizeof(float));
+                        value /= flarg1;
+                        memcpy(activeData(), &value, sizeof(float));
+                    }
+                    else
+                    {
+                        *activeData() /= arg1;
+                    }
+                }
+                break;
+            case CHEAT_OP_AND_DATA:
+                if (!skipExecution)
+                {
+                    *activeData() &= arg1;
+                }
+                break;
+            case CHEAT_OP_OR_DATA:
+                if (!skipExecution)
+                {
+                    *activeData() |= arg1;
+                }
+                break;
+            case CHEAT_OP_XOR_DATA:
+                if (!skipExecution)
+                {
+                    *activeData() ^= arg1;
+                }
+                break;
+            case CHEAT_OP_NOT_DATA:
+                if (!skipExecution)
+                {
+                    *activeData() = ~*activeData();
+                }
+                break;
+            case CHEAT_OP_SHL_DATA:
+                if (!skipExecution)
+                {
+                    *activeData() <<= arg1;
+                }
+                break;
+            case CHEAT_OP_SHR_DATA:
+                if (!skipExecution)
+                {
+                    *activeData() >>= arg1;
+                }
+                break;
+            case CHEAT_OP_COPY:
+                if (!skipExecution)
+                {
+                    u8 origActiveOffset = cheat_state.activeOffset;
+                    for (size_t i = 0; i < arg1; i++)
+                    {
+                        u8 data;
+                        cheat_state.activeOffset = 1;
+                        if (!Cheat_Read8(processHandle, 0, &data))
                         {
-                            if (!skipExecution)
-                            {
-                                *activeData() |= arg1;
-                            }
+                            return 0;
                         }
-                            break;
-                        case 0x8:
+                        cheat_state.activeOffset = 0;
+                        if (!Cheat_Write8(processHandle, 0, data))
                         {
-                            if (!skipExecution)
-                            {
-                                *activeData() ^= arg1;
-                            }
+                            return 0;
                         }
-                            break;
-                        case 0x9:
+                    }
+                    cheat_state.activeOffset = origActiveOffset;
+                }
+                break;
+            // Search for pattern
+            case CHEAT_OP_SEARCH:
+            {
+                u32 searchSize = arg0 & 0xFFFF;
+                bool newSkip = true;
+                if (!skipExecution) // Don't do an expensive operation if we don't have to
+                {
+                    u8* searchData = (u8*)(cheat->codes + cheat_state.index + 1);
+                    cheat_state.index += insn->target;
+                    for (size_t i = 0; i < arg1 - searchSize; i++)
+                    {
+                        u8 curVal;
+                        newSkip = false;
+                        for (size_t j = 0; j < searchSize; j++)
                         {
-                            if (!skipExecution)
+                            if (!Cheat_Read8(processHandle, i + j, &curVal))
                             {
-                                *activeData() = ~*activeData();
+                                return 0;
                             }
-                        }
-                            break;
-                        case 0xA:
-                        {
-                            if (!skipExecution)
+                            if (curVal != searchData[j])
                             {
-                                *activeData() <<= arg1;
+                                newSkip = 1;
+                                break;
                             }
                         }
-                            break;
-                        case 0xB:
+                        if (!newSkip)
                         {
-                            if (!skipExecution)
-                            {
-                                *activeData() >>= arg1;
-                            }
-                        }
                             break;
-                        case 0xC:
-                        {
-                            if (!skipExecution)
-                            {
-                                u8 origActiveOffset = cheat_state.activeOffset;
-                                for (size_t i = 0; i < arg1; i++)
-                                {
-                                    u8 data;
-                                    cheat_state.activeOffset = 1;
-                                    if (!Cheat_Read8(processHandle, 0, &data))
-                                    {
-                                        return 0;
-                                    }
-                                    cheat_state.activeOffset = 0;
-                                    if (!Cheat_Write8(processHandle, 0, data))
-                                    {
-                                        return 0;
-                                    }
-                                }
-                                cheat_state.activeOffset = origActiveOffset;
-                            }
                         }
-                            break;
-                        // Search for pattern
-                        case 0xE:
-                        {
-                            u32 searchSize = arg0 & 0xFFFF;
-                            if (searchSize <= arg1 && searchSize + cheat_state.index < cheat->codesCount)
-                            {
-                                bool newSkip = true;
-                                if (!skipExecution) // Don't do an expensive operation if we don't have to
-                                {
-                                    u8* searchData = (u8*)(cheat->codes + cheat_state.index + 1);
-                                    cheat_state.index += searchSize / 8;
-                                    if (searchSize & 0x7)
-                                    {
-                                        cheat_state.index++;
-                                    }
-                                    for (size_t i = 0; i < arg1 - searchSize; i++)
-                                    {
-                                        u8 curVal;
-                                        newSkip = false;
-                                        for (size_t j = 0; j < searchSize; j++)
-                                        {
-                                            if (!Cheat_Read8(processHandle, i + j, &curVal))
-                                            {
-                                                return 0;
-                                            }
-                                            if (curVal != searchData[j])
-                                            {
-                                                newSkip = 1;
-                                                break;
-                                            }
-                                        }
-                                        if (!newSkip)
-                                        {
-                                            break;
-                                        }
-                                    }
-                                }
+                    }
+                }
+
+                Cheat_PushCondition(newSkip, skipExecution);
+            }
+                break;
+            case CHEAT_OP_RANDOM:
+                if (!skipExecution)
+                {
+                    u32 range = arg1 - (arg0 & 0xFFFFFF);
+                    u32 number = Cheat_GetRandomNumber() % range;
+                    *activeData() = (arg0 & 0xFFFFFF) + number;
+                }
+                break;
+        }
+        cheat_state.index++;
+    }
+    return 1;
+}
+
+static void* Cheat_ArenaAlloc(CheatArena* arena, u32 size)
+{
+    u32 offset = (arena->used + 7) & ~7;
+
+    if (offset + size > arena->committed)
+    {
+        u32 tmp;
+        u32 growth = (offset + size - arena->committed + CHEAT_ARENA_GROWTH - 1) & ~(CHEAT_ARENA_GROWTH - 1);
+        if (arena->committed + growth > CHEAT_ARENA_MAX_SIZE ||
+            R_FAILED(svcControlMemoryEx(&tmp, arena->base + arena->committed, 0, growth, MEMOP_ALLOC, MEMREGION_SYSTEM | MEMPERM_READWRITE, true)))
+        {
+            return NULL;
+        }
+        arena->committed += growth;
+    }
+
+    arena->used = offset + size;
+    return (void*) (arena->base + offset);
+}
+
+static void Cheat_ArenaReset(CheatArena* arena)
+{
+    u32 tmp;
+    if (arena->committed != 0)
+    {
+        svcControlMemory(&tmp, arena->base, 0, arena->committed, MEMOP_FREE, 0);
+    }
+    arena->committed = 0;
+    arena->used = 0;
+}
+
+// Reads the codes of a cheat from the cheat database if needed, and compiles them the first time the cheat is enabled
+static Result Cheat_LoadCheatCodes(CheatDescription* const cheat)
+{
+    Result res = 0;
 
-                                cheat_state.ifStack <<= 1;
-                                cheat_state.ifStack |= (newSkip || skipExecution) ? 1 : 0;
-                                cheat_state.ifCount++;
-                            }
-                            else
-                            {
-                                return 0;
-                            }
-                        }
-                            break;
-                        case 0xF:
-                        {
-                            if (!skipExecution)
-                            {
-                                u32 range = arg1 - (arg0 & 0xFFFFFF);
-                                u32 number = Cheat_GetRandomNumber() % range;
-                                *activeData() = (arg0 & 0xFFFFFF) + number;
-                            }
-                        }
-                            break;
-                        default:
-                            return 0;
-                    }
-                }
+    if (cheat->program != NULL)
+    {
+        return 0;
+    }
+
+    if (cheat->codes == NULL)
+    {
+        IFile file;
+        u64 total = 0;
+        u32 size = cheat->codesCount * sizeof(u64);
+        char path[64] = { 0 };
+        u32 arenaUsed = cheatCodeArena.used;
+
+        cheat->codes = (u64*) Cheat_ArenaAlloc(&cheatCodeArena, size);
+        if (cheat->codes == NULL)
+        {
+            sprintf(failureReason, "Out of memory");
+            return MAKERESULT(RL_PERMANENT, RS_OUTOFRESOURCE, RM_APPLICATION, RD_OUT_OF_MEMORY);
+        }
+
+        sprintf(path, CHEAT_DATABASE_PATH, cheatTitleInfo);
+        res = IFile_Open(&file, ARCHIVE_SDMC, fsMakePath(PATH_EMPTY, ""), fsMakePath(PATH_ASCII, path), FS_OPEN_READ);
+        if (R_SUCCEEDED(res))
+        {
+            file.pos = cheatDatabaseCodesOffset + cheat->codesIndex * sizeof(u64);
+            res = IFile_Read(&file, &total, cheat->codes, size);
+            if (R_SUCCEEDED(res) && total != size)
+            {
+                res = MAKERESULT(RL_PERMANENT, RS_INVALIDSTATE, RM_APPLICATION, RD_INVALID_SIZE);
             }
-                break;
-            // This should now not be possible
-            default:
-                return 0;
+            IFile_Close(&file);
+        }
+
+        if (R_FAILED(res))
+        {
+            // Give the space back, it's the latest allocation
+            cheatCodeArena.used = arenaUsed;
+            cheat->codes = NULL;
+            sprintf(failureReason, "Cheat database read failed");
+            return res;
         }
-        cheat_state.index++;
     }
-    return 1;
+
+    cheat->program = (CheatInstruction*) Cheat_ArenaAlloc(&cheatCodeArena, cheat->codesCount * sizeof(CheatInstruction));
+    if (cheat->program == NULL)
+    {
+        sprintf(failureReason, "Out of memory");
+        return MAKERESULT(RL_PERMANENT, RS_OUTOFRESOURCE, RM_APPLICATION, RD_OUT_OF_MEMORY);
+    }
+    Cheat_CompileCheat(cheat);
+    return 0;
 }
 
-static void Cheat_EatEvents(Handle debug)
+// Continues every pending debug event, returns false once the process has exited
+static bool Cheat_EatEvents(Handle debug)
 {
     DebugEventInfo info;
     Result r;
+    bool exited = false;
 
     while(true)
     {
@@ -1633,167 +1638,238 @@ static void Cheat_EatEvents(Handle debug)
                 break;
             }
         }
-        svcContinueDebugEvent(debug, 3);
+        else if(info.type == DBGEVENT_EXIT_PROCESS)
+        {
+            exited = true;
+        }
+        svcContinueDebugEvent(debug, 0);
     }
+
+    return !exited;
 }
 
-static Result Cheat_MapMemoryAndApplyCheat(u32 pid, CheatDescription* const cheat)
+// The debug handle is kept across passes for as long as the same application runs, so that applying cheats
+// doesn't attach to and detach from the game on every tick. While attached, the game is suspended on every debug
+// event it raises (thread creation, module loads, ...): Cheat_WaitForEvents continues them as soon as they are
+// signaled. The lock keeps the GDB server from attaching in the middle of a pass, a process can only have one
+// debugger.
+typedef struct CheatSession
 {
-    Handle processHandle;
-    Handle debugHandle;
-    Result res;
-    res = svcOpenProcess(&processHandle, pid);
-    if (R_SUCCEEDED(res))
+    Handle debug;
+    u32 pid;
+} CheatSession;
+
+static CheatSession cheatSession = { 0 };
+static RecursiveLock cheatSessionLock;
+
+void Cheat_Init(void)
+{
+    RecursiveLock_Init(&cheatSessionLock);
+}
+
+void Cheat_LockSession(void)
+{
+    RecursiveLock_Lock(&cheatSessionLock);
+}
+
+void Cheat_UnlockSession(void)
+{
+    RecursiveLock_Unlock(&cheatSessionLock);
+}
+
+void Cheat_EndSession(void)
+{
+    Cheat_LockSession();
+    if (cheatSession.debug != 0)
     {
-        res = svcDebugActiveProcess(&debugHandle, pid);
-        if (R_SUCCEEDED(res))
-        {
-            Cheat_EatEvents(debugHandle);
-            cheat->valid = Cheat_ApplyCheat(debugHandle, cheat);
+        svcCloseHandle(cheatSession.debug);
+        cheatSession.debug = 0;
+        cheatSession.pid = 0;
+    }
+    Cheat_UnlockSession();
+}
+
+void Cheat_WaitForEvents(s64 timeout)
+{
+    u64 startTick = svcGetSystemTick();
+    s64 remaining = timeout;
 
-            svcCloseHandle(debugHandle);
-            svcCloseHandle(processHandle);
-            cheat->active = 1;
+    // Holding the lock delays a GDB attach by at most the timeout
+    Cheat_LockSession();
+    while (cheatSession.debug != 0 && remaining > 0)
+    {
+        if (svcWaitSynchronization(cheatSession.debug, remaining) != 0)
+        {
+            break; // timeout
         }
-        else
+
+        if (!Cheat_EatEvents(cheatSession.debug))
         {
-            sprintf(failureReason, "Debug process failed");
-            svcCloseHandle(processHandle);
+            Cheat_EndSession();
         }
+
+        remaining = timeout - (s64)(1000 * 1000 * 1000 * (svcGetSystemTick() - startTick) / SYSCLOCK_ARM11);
     }
-    else
+    Cheat_UnlockSession();
+
+    if (remaining > 0)
     {
-        sprintf(failureReason, "Open process failed");
+        svcSleepThread(remaining);
     }
-    return res;
 }
 
-static CheatDescription* Cheat_AllocCheat()
+static Result Cheat_BeginSession(u32 pid)
 {
-    CheatDescription* cheat;
-    if (cheatCount == 0)
+    Handle processHandle;
+    Result res;
+
+    if (cheatSession.debug != 0 && cheatSession.pid == pid)
     {
-        cheat = (CheatDescription*) cheatBuffer;
+        return 0;
     }
-    else
+
+    Cheat_EndSession();
+
+    res = svcOpenProcess(&processHandle, pid);
+    if (R_FAILED(res))
     {
-        CheatDescription* prev = cheats[cheatCount - 1];
-        cheat = (CheatDescription *) ((u8*) (prev) + sizeof(CheatDescription) + sizeof(u64) * (prev->codesCount));
+        sprintf(failureReason, "Open process failed");
+        return res;
     }
-    cheat->active = 0;
-    cheat->valid = 1;
-    cheat->codesCount = 0;
-    cheat->hasKeyCode = 0;
-    cheat->storage1 = 0;
-    cheat->storage2 = 0;
-    cheat->name[0] = '\0';
 
-    cheats[cheatCount] = cheat;
-    cheatCount++;
-    return cheat;
+    res = svcDebugActiveProcess(&cheatSession.debug, pid);
+    svcCloseHandle(processHandle);
+    if (R_FAILED(res))
+    {
+        cheatSession.debug = 0;
+        sprintf(failureReason, "Debug process failed");
+        return res;
+    }
+
+    cheatSession.pid = pid;
+    Cheat_EatEvents(cheatSession.debug);
+    return 0;
 }
 
-static void Cheat_AddCode(CheatDescription* cheat, u64 code)
+static void Cheat_ApplyCheatInSession(CheatDescription* const cheat)
 {
-    if (cheat)
+    cheat->valid = Cheat_ApplyCheat(cheatSession.debug, cheat);
+    if (!Cheat_FlushMemoryCache(cheatSession.debug))
     {
-        cheat->codes[cheat->codesCount] = code;
-        (cheat->codesCount)++;
+        cheat->valid = 0;
     }
 }
 
-static Result BufferedFile_Open(BufferedFile* file, FS_ArchiveID archiveId, FS_Path archivePath, FS_Path filePath, u32 flags)
+static Result Cheat_MapMemoryAndApplyCheat(u32 pid, CheatDescription* const cheat)
 {
-    Result res = 0;
-    memset(file->buffer, '\0', sizeof(file->buffer));
-    res = IFile_Open(&file->file, archiveId, archivePath, filePath, flags);
+    Result res = Cheat_LoadCheatCodes(cheat);
+    if (R_FAILED(res))
+    {
+        return res;
+    }
+
+    Cheat_LockSession();
+    res = Cheat_BeginSession(pid);
     if (R_SUCCEEDED(res))
     {
-        file->curPos = 0;
-        res = IFile_Read(&file->file, &file->maxPos, file->buffer, sizeof(file->buffer));
+        Cheat_ResetMemoryCache();
+        Cheat_ApplyCheatInSession(cheat);
+        cheat->active = 1;
     }
+    Cheat_UnlockSession();
     return res;
 }
 
-static Result BufferedFile_Read(BufferedFile* file, u64* totalRead, void* buffer, u32 len)
+static CheatDescription* Cheat_AllocCheat(void)
 {
-    Result res = 0;
-    if (len == 0)
+    CheatDescription* cheat = (CheatDescription*) Cheat_ArenaAlloc(&cheatDescriptionArena, sizeof(CheatDescription));
+    if (cheat == NULL)
     {
-        *totalRead = 0;
-        return 0;
+        return NULL;
     }
-    else if (file->curPos + len < file->maxPos)
+
+    memset(cheat, 0, sizeof(CheatDescription));
+    cheat->valid = 1;
+
+    cheatCount++;
+    return cheat;
+}
+
+static bool Cheat_AddCode(CheatDescription* cheat, u64 code)
+{
+    // Codes are only allocated while parsing, so the codes of a given cheat are contiguous
+    u64* slot = (u64*) Cheat_ArenaAlloc(&cheatCodeArena, sizeof(u64));
+    if (slot == NULL)
     {
-        memcpy(buffer, file->buffer + file->curPos, len);
-        file->curPos += len;
-        *totalRead = len;
+        return false;
     }
-    else
+
+    if (cheat->codes == NULL)
     {
-        *totalRead = 0;
-        while(R_SUCCEEDED(res) && file->maxPos != 0 && *totalRead < len)
-        {
-            u32 toRead = file->maxPos - file->curPos < len - *totalRead ? file->maxPos - file->curPos : len - *totalRead;
-            memcpy(buffer + *totalRead, file->buffer + file->curPos, toRead);
-            *totalRead += toRead;
-            file->curPos += toRead;
-            if (file->curPos >= file->maxPos)
-            {
-                res = IFile_Read(&file->file, &file->maxPos, file->buffer, sizeof(file->buffer));
-                file->curPos = 0;
-            }
-        }
+        cheat->codes = slot;
     }
-    return res;
+    *slot = code;
+    (cheat->codesCount)++;
+    return true;
 }
 
-static Result Cheat_ReadLine(BufferedFile* file, char* line, u32 lineSize)
+static Result BufferedFile_Open(BufferedFile* file, FS_Archive archive, FS_Path filePath, u32 flags)
 {
-    Result res = 0;
+    file->curPos = 0;
+    file->maxPos = 0;
+    return IFile_OpenFromArchive(&file->file, archive, filePath, flags);
+}
 
+static Result Cheat_ReadLine(BufferedFile* file, char* line, u32 lineSize)
+{
     u32 idx = 0;
-    u64 total = 0;
-    bool lastWasCarriageReturn = false;
-    while (R_SUCCEEDED(res) && idx < lineSize)
+
+    while (true)
     {
-        res = BufferedFile_Read(file, &total, line + idx, 1);
-        if (total == 0)
-        {
-            line[idx] = '\0';
-            return -1;
-        }
-        if (R_SUCCEEDED(res))
+        if (file->curPos >= file->maxPos)
         {
-            if (line[idx] == '\r')
-            {
-                lastWasCarriageReturn = true;
-            }
-            else if (line[idx] == '\n')
+            Result res = IFile_Read(&file->file, &file->maxPos, file->buffer, sizeof(file->buffer));
+            file->curPos = 0;
+            if (R_FAILED(res))
             {
-                if (lastWasCarriageReturn)
-                {
-                    line[--idx] = '\0';
-                    return idx;
-                }
-                else
-                {
-                    line[idx] = '\0';
-                    return idx;
-                }
+                line[idx] = '\0';
+                return res;
             }
-            else if (line[idx] == '\0')
+            if (file->maxPos == 0)
             {
+                line[idx] = '\0';
                 return -1;
             }
-            else
-            {
-                lastWasCarriageReturn = false;
-            }
-            idx++;
+        }
+
+        const char* start = file->buffer + file->curPos;
+        const char* newLine = memchr(start, '\n', file->maxPos - file->curPos);
+        u32 count = (newLine != NULL ? newLine : file->buffer + file->maxPos) - start;
+        u32 toCopy = count < lineSize - 1 - idx ? count : lineSize - 1 - idx;
+
+        // Overlong lines are truncated
+        memcpy(line + idx, start, toCopy);
+        idx += toCopy;
+        file->curPos += count;
+
+        if (newLine != NULL)
+        {
+            file->curPos++;
+            break;
         }
     }
-    return res;
+
+    if (memchr(line, '\0', idx) != NULL)
+    {
+        return -1;
+    }
+
+    if (idx > 0 && line[idx - 1] == '\r')
+    {
+        idx--;
+    }
+    line[idx] = '\0';
+    return idx;
 }
 
 static bool Cheat_IsCodeLine(const char *line)
@@ -1893,30 +1969,143 @@ static char* stripWhitespace(char* in)
     return ret;
 }
 
-static void Cheat_LoadCheatsIntoMemory(u64 titleId)
+static u64 Cheat_GetFileTimestamp(FS_Archive archive, const char* path)
 {
-    cheatCount = 0;
-    cheatTitleInfo = titleId;
+    u16 utf16Path[64] = { 0 };
+    u64 timestamp = 0;
 
-    char path[64] = { 0 };
-    sprintf(path, "/luma/titles/%016llX/cheats.txt", titleId);
+    ssize_t len = utf8_to_utf16(utf16Path, (const u8*) path, 63);
+    if (len < 0 || R_FAILED(FSUSER_ControlArchive(archive, ARCHIVE_ACTION_GET_TIMESTAMP, utf16Path, 2 * (len + 1), &timestamp, sizeof(timestamp))))
+    {
+        return 0;
+    }
+    return timestamp;
+}
 
-    BufferedFile file;
+static bool Cheat_LoadCheatDatabase(FS_Archive archive, const char* path, u64 sourceSize, u64 sourceTimestamp)
+{
+    IFile file;
+    CheatDatabaseHeader header;
+    u64 total = 0;
 
-    if (R_FAILED(BufferedFile_Open(&file, ARCHIVE_SDMC, fsMakePath(PATH_EMPTY, ""), fsMakePath(PATH_ASCII, path), FS_OPEN_READ)))
+    if (R_FAILED(IFile_OpenFromArchive(&file, archive, fsMakePath(PATH_ASCII, path), FS_OPEN_READ)))
     {
-        // OK, let's try another source
-        sprintf(path, "/cheats/%016llX.txt", titleId);
-        if (R_FAILED(BufferedFile_Open(&file, ARCHIVE_SDMC, fsMakePath(PATH_EMPTY, ""), fsMakePath(PATH_ASCII, path), FS_OPEN_READ))) return;
-    };
+        return false;
+    }
+
+    Result res = IFile_Read(&file, &total, &header, sizeof(header));
+    bool ok = R_SUCCEEDED(res) && total == sizeof(header) && header.magic == CHEAT_DATABASE_MAGIC &&
+              header.version == CHEAT_DATABASE_VERSION && header.sourceSize == sourceSize && header.sourceTimestamp == sourceTimestamp;
+
+    // Only the descriptions are loaded here, the codes are read when a cheat is enabled
+    CheatDatabaseEntry* entries = (CheatDatabaseEntry*) cheatFile.buffer;
+    u32 entriesPerRead = sizeof(cheatFile.buffer) / sizeof(CheatDatabaseEntry);
+    for (u32 i = 0; ok && i < header.cheatCount; i += entriesPerRead)
+    {
+        u32 count = header.cheatCount - i < entriesPerRead ? header.cheatCount - i : entriesPerRead;
+        res = IFile_Read(&file, &total, entries, count * sizeof(CheatDatabaseEntry));
+        ok = R_SUCCEEDED(res) && total == count * sizeof(CheatDatabaseEntry);
+
+        for (u32 j = 0; ok && j < count; j++)
+        {
+            CheatDescription* cheat = Cheat_AllocCheat();
+            ok = cheat != NULL && entries[j].codesCount != 0 && entries[j].codesIndex + entries[j].codesCount <= header.codesCount;
+            if (ok)
+            {
+                memcpy(cheat->name, entries[j].name, sizeof(cheat->name));
+                cheat->name[38] = '\0';
+                cheat->hasKeyCode = entries[j].hasKeyCode;
+                cheat->codesCount = entries[j].codesCount;
+                cheat->codesIndex = entries[j].codesIndex;
+            }
+        }
+    }
+
+    IFile_Close(&file);
+
+    if (!ok)
+    {
+        cheatCount = 0;
+        Cheat_ArenaReset(&cheatDescriptionArena);
+        return false;
+    }
+
+    cheatDatabaseCodesOffset = sizeof(CheatDatabaseHeader) + header.cheatCount * sizeof(CheatDatabaseEntry);
+    return true;
+}
+
+static void Cheat_WriteCheatDatabase(FS_Archive archive, const char* path, u64 sourceSize, u64 sourceTimestamp)
+{
+    IFile file;
+    CheatDatabaseHeader header = { 0 };
+    u64 total = 0;
+    u32 numCheats = cheatCount;
+
+    FSUSER_CreateDirectory(archive, fsMakePath(PATH_ASCII, "/luma/cache"), 0);
+    FSUSER_CreateDirectory(archive, fsMakePath(PATH_ASCII, "/luma/cache/cheats"), 0);
+    if (R_FAILED(IFile_OpenFromArchive(&file, archive, fsMakePath(PATH_ASCII, path), FS_OPEN_CREATE | FS_OPEN_WRITE)))
+    {
+        return;
+    }
+
+    // The header is written last, so that an incomplete database is never considered valid
+    Result res = IFile_SetSize(&file, 0);
+    if (R_SUCCEEDED(res))
+    {
+        res = IFile_Write(&file, &total, &header, sizeof(header), 0);
+    }
 
+    CheatDatabaseEntry* entries = (CheatDatabaseEntry*) cheatFile.buffer;
+    u32 entriesPerWrite = sizeof(cheatFile.buffer) / sizeof(CheatDatabaseEntry);
+    for (u32 i = 0; R_SUCCEEDED(res) && i < numCheats; i += entriesPerWrite)
+    {
+        u32 count = numCheats - i < entriesPerWrite ? numCheats - i : entriesPerWrite;
+        for (u32 j = 0; j < count; j++)
+        {
+            CheatDescription* cheat = &cheats[i + j];
+            memset(&entries[j], 0, sizeof(CheatDatabaseEntry));
+            memcpy(entries[j].name, cheat->name, sizeof(entries[j].name));
+            entries[j].hasKeyCode = cheat->hasKeyCode;
+            entries[j].codesCount = cheat->codesCount;
+            entries[j].codesIndex = header.codesCount;
+            cheat->codesIndex = header.codesCount;
+            header.codesCount += cheat->codesCount;
+        }
+        res = IFile_Write(&file, &total, entries, count * sizeof(CheatDatabaseEntry), 0);
+    }
+
+    // Parsing allocated the codes of every cheat one after the other, in order, so they go in a single write
+    if (R_SUCCEEDED(res) && numCheats > 0)
+    {
+        res = IFile_Write(&file, &total, cheats[0].codes, header.codesCount * sizeof(u64), 0);
+    }
+
+    if (R_SUCCEEDED(res))
+    {
+        header.magic = CHEAT_DATABASE_MAGIC;
+        header.version = CHEAT_DATABASE_VERSION;
+        header.sourceSize = sourceSize;
+        header.sourceTimestamp = sourceTimestamp;
+        header.cheatCount = numCheats;
+        file.pos = 0;
+        res = IFile_Write(&file, &total, &header, sizeof(header), FS_WRITE_FLUSH);
+    }
+
+    if (R_FAILED(res))
+    {
+        IFile_SetSize(&file, 0);
+    }
+    IFile_Close(&file);
+}
+
+static void Cheat_ParseCheatFile(void)
+{
     char line[1024] = { 0 };
     Result res = 0;
     CheatDescription* cheat = 0;
-    u32 cheatSize = 0;
     do
     {
-        res = Cheat_ReadLine(&file, line, 1024);
+        res = Cheat_ReadLine(&cheatFile, line, 1024);
         // -1 is special; it can't be a normal result because of how results are constructed
         // So let's just use it as a signal that this is the final line of a file
         if (R_SUCCEEDED(res) || res == -1)
@@ -1933,16 +2122,20 @@ static void Cheat_LoadCheatsIntoMemory(u64 titleId)
             }
             if (Cheat_IsCodeLine(strippedLine))
             {
-                if (cheatSize + sizeof(u64) >= sizeof(cheatBuffer))
-                {
-                    cheatCount--;
-                    break;
-                }
                 if (cheat)
                 {
                     u64 tmp = Cheat_GetCode(strippedLine);
-                    Cheat_AddCode(cheat, tmp);
-                    cheatSize += sizeof(u64);
+                    if (!Cheat_AddCode(cheat, tmp))
+                    {
+                        // Drop the partial cheat, and the space its codes and description took
+                        if (cheat->codes != NULL)
+                        {
+                            cheatCodeArena.used = (u32) cheat->codes - cheatCodeArena.base;
+                        }
+                        cheatDescriptionArena.used = (u32) cheat - cheatDescriptionArena.base;
+                        cheatCount--;
+                        break;
+                    }
                     if (((tmp >> 32) & 0xFFFFFFFF) == 0xDD000000)
                     {
                         cheat->hasKeyCode = 1;
@@ -1953,27 +2146,70 @@ static void Cheat_LoadCheatsIntoMemory(u64 titleId)
             {
                 if (!cheat || cheat->codesCount > 0)
                 {
-                    if (cheatSize + sizeof(CheatDescription) >= sizeof(cheatBuffer))
+                    cheat = Cheat_AllocCheat();
+                    if (cheat == NULL)
                     {
                         break;
                     }
-                    cheat = Cheat_AllocCheat();
-                    cheatSize += sizeof(CheatDescription);
                 }
                 strncpy(cheat->name, line, 38);
                 cheat->name[38] = '\0';
             }
         }
-    } while (R_SUCCEEDED(res) && cheatSize < sizeof(cheatBuffer));
-
-    IFile_Close(&file.file);
+    } while (R_SUCCEEDED(res));
 
-    if ((cheatCount > 0) && (cheats[cheatCount - 1]->codesCount == 0))
+    if ((cheatCount > 0) && (cheats[cheatCount - 1].codesCount == 0))
     {
         cheatCount--; // Remove last empty cheat
     }
+}
 
+static void Cheat_LoadCheatsIntoMemory(u64 titleId)
+{
+    cheatCount = 0;
+    cheatTitleInfo = titleId;
+    Cheat_ArenaReset(&cheatDescriptionArena);
+    Cheat_ArenaReset(&cheatCodeArena);
     memset(cheatPage, 0, 0x1000);
+
+    FS_Archive archive;
+    if (R_FAILED(FSUSER_OpenArchive(&archive, ARCHIVE_SDMC, fsMakePath(PATH_EMPTY, ""))))
+    {
+        return;
+    }
+
+    char path[64] = { 0 };
+    sprintf(path, "/luma/titles/%016llX/cheats.txt", titleId);
+
+    if (R_FAILED(BufferedFile_Open(&cheatFile, archive, fsMakePath(PATH_ASCII, path), FS_OPEN_READ)))
+    {
+        // OK, let's try another source
+        sprintf(path, "/cheats/%016llX.txt", titleId);
+        if (R_FAILED(BufferedFile_Open(&cheatFile, archive, fsMakePath(PATH_ASCII, path), FS_OPEN_READ)))
+        {
+            FSUSER_CloseArchive(archive);
+            return;
+        }
+    }
+
+    u64 sourceSize = 0;
+    u64 sourceTimestamp = Cheat_GetFileTimestamp(archive, path);
+    char databasePath[64] = { 0 };
+    sprintf(databasePath, CHEAT_DATABASE_PATH, titleId);
+
+    if (R_FAILED(IFile_GetSize(&cheatFile.file, &sourceSize)) || sourceTimestamp == 0)
+    {
+        // Without a timestamp, the database can't be trusted to match the text file
+        Cheat_ParseCheatFile();
+    }
+    else if (!Cheat_LoadCheatDatabase(archive, databasePath, sourceSize, sourceTimestamp))
+    {
+        Cheat_ParseCheatFile();
+        Cheat_WriteCheatDatabase(archive, databasePath, sourceSize, sourceTimestamp);
+    }
+
+    IFile_Close(&cheatFile.file);
+    FSUSER_CloseArchive(archive);
 }
 
 static u32 Cheat_GetCurrentProcessAndTitleId(u64* titleId)
@@ -2000,6 +2236,7 @@ void Cheat_ApplyCheats(void)
 {
     if (!cheatCount)
     {
+        Cheat_EndSession();
         return;
     }
 
@@ -2009,22 +2246,42 @@ void Cheat_ApplyCheats(void)
     if (!titleId)
     {
         cheatCount = 0;
+        Cheat_EndSession();
         return;
     }
 
     if (titleId != cheatTitleInfo)
     {
         cheatCount = 0;
+        Cheat_EndSession();
         return;
     }
 
+    bool hasActiveCheats = false;
     for (int i = 0; i < cheatCount; i++)
     {
-        if (cheats[i]->active)
+        hasActiveCheats = hasActiveCheats || cheats[i].active;
+    }
+
+    if (!hasActiveCheats)
+    {
+        Cheat_EndSession();
+        return;
+    }
+
+    Cheat_LockSession();
+    if (R_SUCCEEDED(Cheat_BeginSession(pid)))
+    {
+        Cheat_ResetMemoryCache();
+        for (int i = 0; i < cheatCount; i++)
         {
-            Cheat_MapMemoryAndApplyCheat(pid, cheats[i]);
-        } 
+            if (cheats[i].active)
+            {
+                Cheat_ApplyCheatInSession(&cheats[i]);
+            }
+        }
     }
+    Cheat_UnlockSession();
 }
 
 void RosalinaMenu_Cheats(void)
@@ -2084,11 +2341,11 @@ void RosalinaMenu_Cheats(void)
                 {
                     char buf[65] = { 0 };
                     s32 j = page * CHEATS_PER_MENU_PAGE + i;
-                    const char * checkbox = (cheats[j]->active ? "(x) " : "( ) ");
-                    const char * keyAct = (cheats[j]->hasKeyCode ? "*" : " ");
-                    sprintf(buf, "%s%s%s", checkbox, keyAct, cheats[j]->name);
+                    const char * checkbox = (cheats[j].active ? "(x) " : "( ) ");
+                    const char * keyAct = (cheats[j].hasKeyCode ? "*" : " ");
+                    sprintf(buf, "%s%s%s", checkbox, keyAct, cheats[j].name);
 
-                    Draw_DrawString(30, 30 + i * SPACING_Y, cheats[j]->valid ? COLOR_WHITE : COLOR_RED, buf);
+                    Draw_DrawString(30, 30 + i * SPACING_Y, cheats[j].valid ? COLOR_WHITE : COLOR_RED, buf);
                     Draw_DrawCharacter(10, 30 + i * SPACING_Y, COLOR_TITLE, j == selected ? '>' : ' ');
                 }
             }
@@ -2113,13 +2370,13 @@ void RosalinaMenu_Cheats(void)
                 break;
             else if ((pressed & KEY_A) && R_SUCCEEDED(r))
             {
-                if (cheats[selected]->active)
+                if (cheats[selected].active)
                 {
-                    cheats[selected]->active = 0;
+                    cheats[selected].active = 0;
                 }
                 else
                 {
-                    r = Cheat_MapMemoryAndApplyCheat(pid, cheats[selected]);
+                    r = Cheat_MapMemoryAndApplyCheat(pid, &cheats[selected]);
                 }
             }
             else if (pressed & KEY_DOWN)
@@ -128,7 +128,20 @@ void DebuggerMenu_EnableDebugger(void)
         Draw_DrawString(10, 10, COLOR_TITLE, "Debugger options menu");
 
         if(alreadyEnabled)
-            Draw_DrawString(10, 30, COLOR_WHITE, "Already enabled!");
+        {
+            u32 posY = Draw_DrawString(10, 30, COLOR_WHITE, "Already enabled!") + SPACING_Y;
+            for(u32 i = 0; i < MAX_DEBUG; i++)
+            {
+                GDBContext *ctx = &gdbServer.ctxs[i];
+                const sock_latency_stats *latency = &ctx->super.latency;
+                if(!(ctx->flags & GDB_FLAG_USED) || latency->nb_events == 0)
+                    continue;
+
+                posY = Draw_DrawFormattedString(10, posY + SPACING_Y, COLOR_WHITE, "Port %u: %lu pkts, avg %lu us, max %lu us",
+                    ctx->localPort, latency->nb_events, (u32)(1000 * 1000 * latency->total / latency->nb_events / SYSCLOCK_ARM11),
+                    (u32)(1000 * 1000 * latency->max / SYSCLOCK_ARM11));
+            }
+        }
         else if(!isSocURegistered)
             Draw_DrawString(10, 30, COLOR_WHITE, "Can't start the debugger before the system has fi-\nnished loading.");
         else
@@ -32,6 +32,7 @@
 #include "menus/process_list.h"
 #include "process_patches.h"
 #include "memory.h"
+#include "memory_scan.h"
 #include "csvc.h"
 #include "draw.h"
 #include "menu.h"
@@ -217,6 +218,212 @@ end:
 #undef TRY
 }
 
+typedef struct ProcessListMenuScanRegions
+{
+    MemoryScanChunk chunks[2];
+    u32 count;
+    u32 index;
+} ProcessListMenuScanRegions;
+
+static bool ProcessListMenu_NextScanChunk(MemoryScanChunk *chunk, void *userData)
+{
+    ProcessListMenuScanRegions *regions = (ProcessListMenuScanRegions *)userData;
+    if(regions->index >= regions->count)
+        return false;
+
+    *chunk = regions->chunks[regions->index++];
+    return true;
+}
+
+static inline bool ProcessListMenu_IsScanFilterValid(MemoryScanFilter filter, bool nextScan)
+{
+    return filter == MEMSCAN_FILTER_EQUAL || (nextScan ? filter != MEMSCAN_FILTER_UNKNOWN : filter == MEMSCAN_FILTER_UNKNOWN);
+}
+
+static MemoryScanFilter ProcessListMenu_CycleScanFilter(MemoryScanFilter filter, bool nextScan, u32 step)
+{
+    do
+        filter = (MemoryScanFilter)((filter + step) % MEMSCAN_FILTER_MAX);
+    while(!ProcessListMenu_IsScanFilterValid(filter, nextScan));
+
+    return filter;
+}
+
+// Returns the address of the result to go to, or 0
+static u32 ProcessListMenu_ValueScanner(const ProcessInfo *info, const MemoryScanChunk *chunks, u32 nbChunks)
+{
+    #define SCAN_RESULTS_PER_SCREEN 12
+
+    static MemoryScanResult results[SCAN_RESULTS_PER_SCREEN];
+    ProcessListMenuScanRegions regions = { .count = nbChunks };
+    memcpy(regions.chunks, chunks, nbChunks * sizeof(MemoryScanChunk));
+
+    MemoryScanValueType type = MEMSCAN_TYPE_U32;
+    MemoryScanFilter filter = MEMSCAN_FILTER_EQUAL;
+    bool active = MemoryScan_IsActive(info->pid, &type);
+    bool editing = false;
+    bool scanning = false;
+    u32 value = 0, digit = 0, selected = 0;
+    Result res = 0;
+
+    Draw_Lock();
+    Draw_ClearFramebuffer();
+    Draw_FlushFramebuffer();
+    Draw_Unlock();
+
+    do
+    {
+        u32 valueDigits = 2 * (type == MEMSCAN_TYPE_U8 ? 1 : type == MEMSCAN_TYPE_U16 ? 2 : 4);
+        u32 count = active ? MemoryScan_GetResultCount() : 0;
+        if(selected >= count)
+            selected = count != 0 ? count - 1 : 0;
+
+        u32 nbResults = active ? MemoryScan_GetResults(results, selected - selected % SCAN_RESULTS_PER_SCREEN, SCAN_RESULTS_PER_SCREEN) : 0;
+        // While the values are only saved in the snapshot, there's nothing to select
+        u32 nbSelectable = nbResults != 0 ? count : 0;
+
+        Draw_Lock();
+        Draw_DrawString(10, 10, COLOR_TITLE, "Memory viewer -- Value scanner");
+        Draw_DrawString(10, 30, COLOR_WHITE, "A to scan, X to edit the value, Y to go to result.");
+        Draw_DrawString(10, 30 + SPACING_Y, COLOR_WHITE, "L/R for the type, LEFT/RIGHT for the filter.");
+        Draw_DrawString(10, 30 + 2 * SPACING_Y, COLOR_WHITE, "START to start a new scan, B to go back.");
+
+        u32 posY = 30 + 4 * SPACING_Y;
+        Draw_DrawFormattedString(10, posY, COLOR_WHITE, "Type: %-5s  Filter: %-9s  Value: ", MemoryScan_GetTypeName(type), MemoryScan_GetFilterName(filter));
+        for(u32 i = 0; i < 8; i++)
+        {
+            u32 x = 10 + SPACING_X * (39 + i);
+            if(i < valueDigits)
+                Draw_DrawCharacter(x, posY, editing && i == digit ? COLOR_RED : COLOR_WHITE, "0123456789ABCDEF"[(value >> (4 * (valueDigits - 1 - i))) & 0xF]);
+            else
+                Draw_DrawCharacter(x, posY, COLOR_WHITE, ' ');
+        }
+
+        posY += 2 * SPACING_Y;
+        if(scanning)
+            Draw_DrawString(10, posY, COLOR_WHITE, "Scanning...                                     ");
+        else if(R_FAILED(res))
+        {
+            if(R_DESCRIPTION(res) == RD_OUT_OF_MEMORY)
+                Draw_DrawString(10, posY, COLOR_RED, "Too many results, try a narrower filter.        ");
+            else
+                Draw_DrawFormattedString(10, posY, COLOR_RED, "Scan failed (0x%08lx).                  ", (u32)res);
+        }
+        else if(!active)
+            Draw_DrawString(10, posY, COLOR_WHITE, "Press A to start scanning.                      ");
+        else if(count != 0 && nbResults == 0)
+            Draw_DrawFormattedString(10, posY, COLOR_WHITE, "%lu values saved, scan again to compare.        ", count);
+        else
+            Draw_DrawFormattedString(10, posY, COLOR_WHITE, "%lu result(s).                                  ", count);
+
+        posY += 2 * SPACING_Y;
+        for(u32 i = 0; i < SCAN_RESULTS_PER_SCREEN; i++)
+        {
+            u32 y = posY + i * SPACING_Y;
+            if(i < nbResults)
+            {
+                bool isSelected = selected % SCAN_RESULTS_PER_SCREEN == i;
+                Draw_DrawCharacter(10, y, COLOR_TITLE, isSelected ? '>' : ' ');
+                Draw_DrawFormattedString(30, y, isSelected ? COLOR_GREEN : COLOR_WHITE, "%.8lx | %.*lx          ", results[i].address, (int)valueDigits, results[i].value);
+            }
+            else
+                Draw_DrawString(10, y, COLOR_WHITE, "                              ");
+        }
+
+        Draw_FlushFramebuffer();
+        Draw_Unlock();
+
+        if(scanning)
+        {
+            if(!active || filter == MEMSCAN_FILTER_UNKNOWN)
+                res = MemoryScan_FirstScan(info->pid, type, filter, value, ProcessListMenu_NextScanChunk, &regions);
+            else
+                res = MemoryScan_NextScan(info->pid, filter, value, ProcessListMenu_NextScanChunk, &regions);
+
+            regions.index = 0;
+            scanning = false;
+            selected = 0;
+
+            bool wasActive = active;
+            active = MemoryScan_IsActive(info->pid, NULL);
+            if(active && !wasActive && filter == MEMSCAN_FILTER_UNKNOWN)
+                filter = MEMSCAN_FILTER_CHANGED;
+            continue;
+        }
+
+        u32 pressed = waitInputWithTimeout(1000);
+
+        if(pressed & KEY_A)
+        {
+            editing = false;
+            scanning = true;
+        }
+        else if(pressed & KEY_X)
+            editing = !editing;
+        else if(pressed & KEY_Y)
+        {
+            if(nbResults != 0)
+                return results[selected % SCAN_RESULTS_PER_SCREEN].address;
+        }
+        else if(pressed & KEY_START)
+        {
+            MemoryScan_Reset();
+            active = false;
+            res = 0;
+            selected = 0;
+            if(!ProcessListMenu_IsScanFilterValid(filter, false))
+                filter = MEMSCAN_FILTER_EQUAL;
+        }
+        else if(pressed & (KEY_L | KEY_R))
+        {
+            // The type can't change while refining a scan
+            if(!active)
+            {
+                type = (MemoryScanValueType)((type + ((pressed & KEY_L) ? MEMSCAN_TYPE_MAX - 1 : 1)) % MEMSCAN_TYPE_MAX);
+                valueDigits = 2 * (type == MEMSCAN_TYPE_U8 ? 1 : type == MEMSCAN_TYPE_U16 ? 2 : 4);
+                value &= valueDigits == 8 ? 0xFFFFFFFF : (1u << (4 * valueDigits)) - 1;
+                digit = 0;
+            }
+        }
+        else if(editing)
+        {
+            u32 shift = 4 * (valueDigits - 1 - digit);
+            u32 nibble = (value >> shift) & 0xF;
+
+            if(pressed & KEY_LEFT)
+                digit = digit == 0 ? valueDigits - 1 : digit - 1;
+            else if(pressed & KEY_RIGHT)
+                digit = (digit + 1) % valueDigits;
+            else if(pressed & KEY_UP)
+                value = (value & ~(0xFu << shift)) | (((nibble + 1) & 0xF) << shift);
+            else if(pressed & KEY_DOWN)
+                value = (value & ~(0xFu << shift)) | (((nibble - 1) & 0xF) << shift);
+        }
+        else
+        {
+            if(pressed & KEY_LEFT)
+                filter = ProcessListMenu_CycleScanFilter(filter, active, MEMSCAN_FILTER_MAX - 1);
+            else if(pressed & KEY_RIGHT)
+                filter = ProcessListMenu_CycleScanFilter(filter, active, 1);
+            else if((pressed & KEY_UP) && selected > 0)
+                selected--;
+            else if((pressed & KEY_DOWN) && selected + 1 < nbSelectable)
+                selected++;
+        }
+
+        if(pressed & KEY_B)
+        {
+            if(editing)
+                editing = false;
+            else
+                break;
+        }
+    }
+    while(!menuShouldExit);
+
+    return 0;
+}
+
 static void ProcessListMenu_MemoryViewer(const ProcessInfo *info)
 {
     Handle processHandle;
@@ -396,6 +603,35 @@ static void ProcessListMenu_MemoryViewer(const ProcessInfo *info)
             menus[MENU_MODE_SEARCH].buf = searchPattern;
             menus[MENU_MODE_SEARCH].max = 1;
             // ------------------------------------------
+
+            // Value scanning
+            void openValueScanner(void)
+            {
+                MemoryScanChunk chunks[2];
+                u32 nbChunks = 0;
+
+                if(codeAvailable)
+                    chunks[nbChunks++] = (MemoryScanChunk){ codeStartAddress, codeTotalSize, (const void *)codeDestAddress };
+                if(heapAvailable)
+                    chunks[nbChunks++] = (MemoryScanChunk){ heapStartAddress, heapTotalSize, (const void *)heapDestAddress };
+
+                // Chunks have to be scanned in ascending address order
+                if(nbChunks == 2 && chunks[0].address > chunks[1].address)
+                {
+                    MemoryScanChunk tmp = chunks[0];
+                    chunks[0] = chunks[1];
+                    chunks[1] = tmp;
+                }
+
+                u32 address = ProcessListMenu_ValueScanner(info, chunks, nbChunks);
+                if(address != 0)
+                {
+                    gotoAddress = __builtin_bswap32(address);
+                    finishJumping();
+                    menuMode = MENU_MODE_NORMAL;
+                }
+            }
+            // ------------------------------------------
             char u8ToChar(u8 val) {
                 if(val < 32 || val > 126)
                     return '-';
@@ -433,7 +669,9 @@ static void ProcessListMenu_MemoryViewer(const ProcessInfo *info)
                 // Location
                 const u32 infoY = instructionsY + SPACING_Y;
                 viewerY += SPACING_Y;
-                if(codeAvailable && heapAvailable)
+                if(menuMode == MENU_MODE_SEARCH)
+                    Draw_DrawString(10, infoY, COLOR_WHITE, "L/R: pattern size, SELECT: value scanner.    ");
+                else if(codeAvailable && heapAvailable)
                 {
                     Draw_DrawString(10, infoY, COLOR_WHITE, "Press L or R to switch between heap and code.");
                     if((u32)menus[MENU_MODE_NORMAL].buf == heapDestAddress)
@@ -549,7 +787,10 @@ static void ProcessListMenu_MemoryViewer(const ProcessInfo *info)
                 else if(pressed & KEY_SELECT)
                 {
                     clearMenu();
-                    ProcessListMenu_DumpMemory(info->name, menus[MENU_MODE_NORMAL].buf, menus[MENU_MODE_NORMAL].max);
+                    if(menuMode == MENU_MODE_SEARCH)
+                        openValueScanner();
+                    else
+                        ProcessListMenu_DumpMemory(info->name, menus[MENU_MODE_NORMAL].buf, menus[MENU_MODE_NORMAL].max);
                     clearMenu();
                 }
 
@@ -18,66 +18,69 @@ extern Handle preTerminationEvent;
 extern bool preTerminationRequested;
 
 // soc's poll function is odd, and doesn't like -1 as fd.
-// so this compacts everything together
+// so the poll set is kept dense: slots are appended, and the last one is moved into the slot being freed
 
-static void compact(struct sock_server *serv)
+static int server_add_ctx(struct sock_server *serv, struct sock_ctx *ctx, int sockfd)
 {
-    int new_fds[MAX_CTXS];
-    struct sock_ctx *new_ctxs[MAX_CTXS];
-    nfds_t n = 0;
+    int idx = serv->nfds++;
 
-    for(nfds_t i = 0; i < serv->nfds; i++)
-    {
-        if(serv->poll_fds[i].fd != -1)
-        {
-            new_fds[n] = serv->poll_fds[i].fd;
-            new_ctxs[n] = serv->ctx_ptrs[i];
-            n++;
-        }
-    }
+    serv->poll_fds[idx].fd = sockfd;
+    serv->poll_fds[idx].events = POLLIN;
+    serv->poll_fds[idx].revents = 0;
+    serv->ctx_ptrs[idx] = ctx;
+    ctx->sockfd = sockfd;
+    ctx->i = idx;
+
+    return idx;
+}
+
+static void server_remove_ctx(struct sock_server *serv, struct sock_ctx *ctx)
+{
+    nfds_t last = --serv->nfds;
 
-    for(nfds_t i = 0; i < n; i++)
+    if((nfds_t)ctx->i != last)
     {
-        serv->poll_fds[i].fd = new_fds[i];
-        serv->ctx_ptrs[i] = new_ctxs[i];
-        serv->ctx_ptrs[i]->i = i;
+        serv->poll_fds[ctx->i] = serv->poll_fds[last];
+        serv->ctx_ptrs[ctx->i] = serv->ctx_ptrs[last];
+        serv->ctx_ptrs[ctx->i]->i = ctx->i;
     }
-    serv->nfds = n;
-    serv->compact_needed = false;
+
+    serv->poll_fds[last].fd = -1;
+    serv->poll_fds[last].events = 0;
+    serv->poll_fds[last].revents = 0;
+    serv->ctx_ptrs[last] = NULL;
 }
 
 static struct sock_ctx *server_alloc_server_ctx(struct sock_server *serv)
 {
-    for(int i = 0; i < MAX_PORTS; i++)
-    {
-        if(serv->serv_ctxs[i].type == SOCK_NONE)
-            return &serv->serv_ctxs[i];
-    }
+    struct sock_ctx *ctx = serv->free_serv_ctxs;
+    if(ctx != NULL)
+        serv->free_serv_ctxs = ctx->next_free;
 
-    return NULL;
+    return ctx;
 }
 
 static void server_close_ctx(struct sock_server *serv, struct sock_ctx *ctx)
 {
-    serv->compact_needed = true;
-
-    Handle sock = serv->poll_fds[ctx->i].fd;
+    int sock = serv->poll_fds[ctx->i].fd;
     if(ctx->type == SOCK_CLIENT)
     {
         serv->close_cb(ctx);
         serv->free(serv, ctx);
         ctx->serv->n--;
     }
+    else if(ctx->type == SOCK_SERVER)
+    {
+        ctx->next_free = serv->free_serv_ctxs;
+        serv->free_serv_ctxs = ctx;
+    }
 
-    socClose(sock);
+    if(sock != -1)
+        socClose(sock);
     ctx->should_close = false;
 
-    serv->poll_fds[ctx->i].fd = -1;
-    serv->poll_fds[ctx->i].events = 0;
-    serv->poll_fds[ctx->i].revents = 0;
-
+    server_remove_ctx(serv, ctx);
     ctx->type = SOCK_NONE;
-    serv->ctx_ptrs[ctx->i] = NULL;
 }
 
 Result server_init(struct sock_server *serv)
@@ -90,7 +93,11 @@ Result server_init(struct sock_server *serv)
     memset(serv, 0, sizeof(struct sock_server));
 
     for(int i = 0; i < MAX_PORTS; i++)
+    {
         serv->serv_ctxs[i].type = SOCK_NONE;
+        serv->serv_ctxs[i].next_free = i + 1 < MAX_PORTS ? &serv->serv_ctxs[i + 1] : NULL;
+    }
+    serv->free_serv_ctxs = &serv->serv_ctxs[0];
 
     for(int i = 0; i < MAX_CTXS; i++)
         serv->ctx_ptrs[i] = NULL;
@@ -136,18 +143,11 @@ Result server_bind(struct sock_server *serv, u16 port)
         res = socListen(server_sockfd, 2);
         if(res == 0)
         {
-            int idx = serv->nfds;
-            serv->nfds++;
-            serv->poll_fds[idx].fd = server_sockfd;
-            serv->poll_fds[idx].events = POLLIN;
-
             struct sock_ctx *new_ctx = server_alloc_server_ctx(serv);
             memcpy(&new_ctx->addr_in, &saddr, sizeof(struct sockaddr_in));
             new_ctx->type = SOCK_SERVER;
-            new_ctx->sockfd = server_sockfd;
             new_ctx->n = 0;
-            new_ctx->i = idx;
-            serv->ctx_ptrs[idx] = new_ctx;
+            server_add_ctx(serv, new_ctx, server_sockfd);
         }
     }
 
@@ -166,6 +166,50 @@ static bool server_should_exit(struct sock_server *serv)
     return svcWaitSynchronization(serv->shall_terminate_event, 0) == 0 || svcWaitSynchronization(preTerminationEvent, 0) == 0;
 }
 
+static void server_update_latency_stats(struct sock_ctx *ctx, u64 wakeup_tick)
+{
+    u64 latency = svcGetSystemTick() - wakeup_tick;
+
+    ctx->latency.nb_events++;
+    ctx->latency.total += latency;
+    if(latency > ctx->latency.max)
+        ctx->latency.max = latency;
+}
+
+static void server_accept_client(struct sock_server *serv, struct sock_ctx *serv_ctx)
+{
+    struct sockaddr_in saddr;
+    socklen_t len = sizeof(struct sockaddr_in);
+    int client_sockfd = socAccept(serv_ctx->sockfd, (struct sockaddr *)&saddr, &len);
+
+    if(client_sockfd < 0)
+        return;
+
+    struct sock_ctx *new_ctx = NULL;
+    if(serv_ctx->n != serv->clients_per_server && serv->nfds != MAX_CTXS)
+        new_ctx = serv->alloc(serv, ntohs(serv_ctx->addr_in.sin_port));
+
+    if(new_ctx == NULL)
+    {
+        socClose(client_sockfd);
+        return;
+    }
+
+    serv_ctx->n++;
+
+    new_ctx->type = SOCK_CLIENT;
+    new_ctx->serv = serv_ctx;
+    new_ctx->n = 0;
+    new_ctx->should_close = false;
+    memset(&new_ctx->latency, 0, sizeof(sock_latency_stats));
+    server_add_ctx(serv, new_ctx, client_sockfd);
+
+    if(serv->accept_cb(new_ctx) == -1)
+        server_close_ctx(serv, new_ctx);
+
+    memcpy(&new_ctx->addr_in, &saddr, sizeof(struct sockaddr_in));
+}
+
 void server_run(struct sock_server *serv)
 {
     struct pollfd *fds = serv->poll_fds;
@@ -174,87 +218,58 @@ void server_run(struct sock_server *serv)
     svcSignalEvent(serv->started_event);
     while(serv->running && !preTerminationRequested)
     {
-        if(server_should_exit(serv))
-            goto abort_connections;
-
         if(serv->nfds == 0)
         {
-            svcSleepThread(12 * 1000 * 1000LL);
-            continue;
+            // Nothing to poll, the only thing left to do is to wait for termination
+            Handle handles[2] = { preTerminationEvent, serv->shall_terminate_event };
+            s32 idx;
+            svcWaitSynchronizationN(&idx, handles, 2, false, -1LL);
+            goto abort_connections;
         }
 
-        for(nfds_t i = 0; i < serv->nfds; i++)
-            fds[i].revents = 0;
+        /*
+            All soc calls go through the same session, which serves one request at a time: the poll has to time out
+            for the other threads' calls (including the GDB stop replies) to get through. The poll returns as soon as
+            there's activity, so the timeout only bounds how long it takes to notice termination and connections
+            asked to close.
+        */
         int pollres = socPoll(fds, serv->nfds, 50);
+        u64 wakeup_tick = svcGetSystemTick();
 
-        if(server_should_exit(serv) || pollres < -10000)
+        if(pollres < -10000 || server_should_exit(serv))
             goto abort_connections;
 
-        for(nfds_t i = 0; pollres > 0 && i < serv->nfds; i++)
+        for(nfds_t i = 0; i < serv->nfds;)
         {
             struct sock_ctx *curr_ctx = serv->ctx_ptrs[i];
+            short revents = pollres > 0 ? fds[i].revents : 0;
+            fds[i].revents = 0;
 
-            if((fds[i].revents & (POLLHUP | POLLERR | POLLNVAL)) || curr_ctx->should_close)
+            if((revents & (POLLHUP | POLLERR | POLLNVAL)) || curr_ctx->should_close)
+            {
                 server_close_ctx(serv, curr_ctx);
+                continue; // the last slot has been moved into this one
+            }
 
-            else if(fds[i].revents & POLLIN)
+            else if(revents & POLLIN)
             {
                 if(curr_ctx->type == SOCK_SERVER) // Listening socket?
+                    server_accept_client(serv, curr_ctx);
+                else
                 {
-                    struct sockaddr_in saddr;
-                    socklen_t len = sizeof(struct sockaddr_in);
-                    int client_sockfd = socAccept(fds[i].fd, (struct sockaddr *)&saddr, &len);
+                    int res = serv->data_cb(curr_ctx);
+                    server_update_latency_stats(curr_ctx, wakeup_tick);
 
-                    if(server_should_exit(serv))
-                        goto abort_connections;
-
-                    if(client_sockfd < 0 || curr_ctx->n == serv->clients_per_server || serv->nfds == MAX_CTXS)
-                        socClose(client_sockfd);
-
-                    else
+                    if(res == -1)
                     {
-                        struct sock_ctx *new_ctx = serv->alloc(serv, ntohs(curr_ctx->addr_in.sin_port));
-                        if(new_ctx == NULL)
-                            socClose(client_sockfd);
-                        else
-                        {
-                            fds[serv->nfds].fd = client_sockfd;
-                            fds[serv->nfds].events = POLLIN;
-                            fds[serv->nfds].revents = 0;
-
-                            int new_idx = serv->nfds;
-                            serv->nfds++;
-                            curr_ctx->n++;
-
-                            new_ctx->type = SOCK_CLIENT;
-                            new_ctx->sockfd = client_sockfd;
-                            new_ctx->serv = curr_ctx;
-                            new_ctx->i = new_idx;
-                            new_ctx->n = 0;
-                            new_ctx->should_close = false;
-
-                            serv->ctx_ptrs[new_idx] = new_ctx;
-
-                            if(serv->accept_cb(new_ctx) == -1)
-                                server_close_ctx(serv, new_ctx);
-
-                            memcpy(&new_ctx->addr_in, &saddr, sizeof(struct sockaddr_in));
-                        }
-                    }
-                }
-                else
-                {
-                    if(serv->data_cb(curr_ctx) == -1)
                         server_close_ctx(serv, curr_ctx);
+                        continue;
+                    }
                 }
             }
-        }
 
-        if(server_should_exit(serv))
-            goto abort_connections;
-
-        if(serv->compact_needed)
-            compact(serv);
+            i++;
+        }
     }
 
     // Clean up.
@@ -262,6 +277,7 @@ void server_run(struct sock_server *serv)
     {
         if(fds[i].fd != -1)
             socClose(fds[i].fd);
+        fds[i].fd = -1;
     }
 
     serv->running = false;
@@ -308,11 +324,8 @@ void server_kill_connections(struct sock_server *serv)
 
 void server_finalize(struct sock_server *serv)
 {
-    for(nfds_t i = 0; i < MAX_CTXS; i++)
-    {
-        if(serv->ctx_ptrs[i] != NULL)
-            server_close_ctx(serv, serv->ctx_ptrs[i]);
-    }
+    for(nfds_t i = serv->nfds; i > 0; i--)
+        server_close_ctx(serv, serv->ctx_ptrs[i - 1]);
 
     miniSocExit();
 
@@ -0,0 +1,86 @@
+/*
+    Timing helpers for the host benchmarks.
+*/
+
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <3ds/types.h>
+
+static inline u64 benchNowNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * 1000000000ULL + (u64)ts.tv_nsec;
+}
+
+// Best time of a number of runs, in nanoseconds, the body being run once per iteration
+#define BENCH_BEST_NS(nbRuns, body) ({                          \
+    u64 best__ = ~0ULL;                                         \
+    for(u32 run__ = 0; run__ < (u32)(nbRuns); run__++)          \
+    {                                                           \
+        u64 start__ = benchNowNs();                             \
+        body;                                                   \
+        u64 elapsed__ = benchNowNs() - start__;                 \
+        best__ = elapsed__ < best__ ? elapsed__ : best__;       \
+    }                                                           \
+    best__;                                                     \
+})
+
+static inline double benchMBps(u64 size, u64 ns)
+{
+    return ns == 0 ? 0.0 : (double)size * 1000.0 / (double)ns;
+}
+
+// Buffers the firmware code may cast to u32 have to be mapped below 4GB
+static inline void *benchAlloc32(size_t size)
+{
+    void *p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT, -1, 0);
+    if(p == MAP_FAILED)
+    {
+        perror("mmap");
+        exit(1);
+    }
+    return p;
+}
+
+// Whole host file, in a buffer from benchAlloc32. Returns NULL on failure
+static inline u8 *benchReadFile(const char *path, u32 *size)
+{
+    FILE *f = fopen(path, "rb");
+    if(f == NULL)
+        return NULL;
+
+    fseek(f, 0, SEEK_END);
+    long len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    u8 *data = (u8 *)benchAlloc32(len > 0 ? (size_t)len : 1);
+    if(len < 0 || fread(data, 1, (size_t)len, f) != (size_t)len)
+    {
+        fclose(f);
+        return NULL;
+    }
+
+    fclose(f);
+    *size = (u32)len;
+    return data;
+}
+
+// Deterministic pseudo-random data (xorshift32)
+static inline void benchFillRandom(void *dst, u32 size, u32 seed)
+{
+    u8 *p = (u8 *)dst;
+    u32 x = seed != 0 ? seed : 1;
+
+    for(u32 i = 0; i < size; i++)
+    {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        p[i] = (u8)x;
+    }
+}
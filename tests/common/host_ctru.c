@@ -0,0 +1,285 @@
+/*
+    Host implementations of the libctru functions shared by the tests. All of them are weak, tests needing a
+    different behavior (fake processes, failures, ...) simply define their own.
+
+    Every archive is mapped to the same host directory (see hostFsSetRoot), file handles are file descriptors.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "host_ctru.h"
+
+#define WEAK                    __attribute__((weak))
+#define HOST_FILE_HANDLE_BASE   0x10000
+
+static const char *fsRoot = ".";
+
+static Result hostErrnoToResult(int err)
+{
+    switch(err)
+    {
+        case ENOENT:
+            return MAKERESULT(RL_PERMANENT, RS_NOTFOUND, RM_FS, RD_NOT_FOUND);
+        case EEXIST:
+            return MAKERESULT(RL_PERMANENT, RS_NOP, RM_FS, RD_ALREADY_EXISTS);
+        default:
+            return MAKERESULT(RL_PERMANENT, RS_INTERNAL, RM_FS, RD_INVALID_RESULT_VALUE);
+    }
+}
+
+void hostFsSetRoot(const char *root)
+{
+    fsRoot = root;
+}
+
+const char *hostFsGetPath(const char *path)
+{
+    static char hostPath[4096];
+
+    snprintf(hostPath, sizeof(hostPath), "%s/%s", fsRoot, path[0] == '/' ? path + 1 : path);
+    return hostPath;
+}
+
+static const char *hostFsGetArchivePath(FS_Path path)
+{
+    char asciiPath[0x200];
+
+    if(path.type == PATH_UTF16)
+    {
+        const u16 *src = (const u16 *)path.data;
+        u32 i;
+        for(i = 0; i < sizeof(asciiPath) - 1 && src[i] != 0; i++)
+            asciiPath[i] = src[i] < 0x80 ? (char)src[i] : '_';
+        asciiPath[i] = 0;
+    }
+    else if(path.type == PATH_ASCII)
+        snprintf(asciiPath, sizeof(asciiPath), "%s", (const char *)path.data);
+    else
+        return NULL;
+
+    return hostFsGetPath(asciiPath);
+}
+
+WEAK Result FSUSER_OpenArchive(FS_Archive *archive, FS_ArchiveID id, FS_Path path)
+{
+    (void)path;
+    *archive = id;
+    return 0;
+}
+
+WEAK Result FSUSER_CloseArchive(FS_Archive archive)
+{
+    (void)archive;
+    return 0;
+}
+
+// Only the timestamp of a file (its host modification time) is served, the other actions do nothing
+WEAK Result FSUSER_ControlArchive(FS_Archive archive, FS_ArchiveAction action, void *input, u32 inputSize, void *output, u32 outputSize)
+{
+    (void)archive;
+
+    if(action != ARCHIVE_ACTION_GET_TIMESTAMP)
+        return 0;
+
+    struct stat st;
+    const char *hostPath = hostFsGetArchivePath((FS_Path){ PATH_UTF16, inputSize, input });
+    if(hostPath == NULL || outputSize < sizeof(u64) || stat(hostPath, &st) != 0)
+        return hostErrnoToResult(errno);
+
+    u64 timestamp = (u64)st.st_mtim.tv_sec * 1000000000ULL + (u64)st.st_mtim.tv_nsec;
+    memcpy(output, &timestamp, sizeof(timestamp));
+    return 0;
+}
+
+WEAK Result FSUSER_OpenFile(Handle *out, FS_Archive archive, FS_Path path, u32 openFlags, u32 attributes)
+{
+    (void)archive; (void)attributes;
+
+    const char *hostPath = hostFsGetArchivePath(path);
+    if(hostPath == NULL)
+        return MAKERESULT(RL_PERMANENT, RS_INVALIDARG, RM_FS, RD_NOT_IMPLEMENTED);
+
+    int flags = (openFlags & FS_OPEN_WRITE) ? O_RDWR : O_RDONLY;
+    if(openFlags & FS_OPEN_CREATE)
+        flags |= O_CREAT;
+
+    int fd = open(hostPath, flags, 0644);
+    if(fd < 0)
+        return hostErrnoToResult(errno);
+
+    *out = HOST_FILE_HANDLE_BASE + fd;
+    return 0;
+}
+
+WEAK Result FSUSER_OpenFileDirectly(Handle *out, FS_ArchiveID archiveId, FS_Path archivePath, FS_Path filePath, u32 openFlags, u32 attributes)
+{
+    (void)archivePath;
+    return FSUSER_OpenFile(out, archiveId, filePath, openFlags, attributes);
+}
+
+WEAK Result FSUSER_CreateFile(FS_Archive archive, FS_Path path, u32 attributes, u64 fileSize)
+{
+    (void)archive; (void)attributes;
+
+    const char *hostPath = hostFsGetArchivePath(path);
+    int fd = hostPath == NULL ? -1 : open(hostPath, O_RDWR | O_CREAT | O_EXCL, 0644);
+    if(fd < 0)
+        return hostErrnoToResult(errno);
+
+    int res = ftruncate(fd, (off_t)fileSize);
+    close(fd);
+    return res == 0 ? 0 : hostErrnoToResult(errno);
+}
+
+WEAK Result FSUSER_CreateDirectory(FS_Archive archive, FS_Path path, u32 attributes)
+{
+    (void)archive; (void)attributes;
+
+    const char *hostPath = hostFsGetArchivePath(path);
+    return hostPath != NULL && mkdir(hostPath, 0755) == 0 ? 0 : hostErrnoToResult(errno);
+}
+
+WEAK Result FSUSER_DeleteFile(FS_Archive archive, FS_Path path)
+{
+    (void)archive;
+
+    const char *hostPath = hostFsGetArchivePath(path);
+    return hostPath != NULL && unlink(hostPath) == 0 ? 0 : hostErrnoToResult(errno);
+}
+
+WEAK Result FSFILE_Read(Handle handle, u32 *bytesRead, u64 offset, void *buffer, u32 size)
+{
+    ssize_t n = pread((int)(handle - HOST_FILE_HANDLE_BASE), buffer, size, (off_t)offset);
+    if(n < 0)
+        return hostErrnoToResult(errno);
+
+    *bytesRead = (u32)n;
+    return 0;
+}
+
+WEAK Result FSFILE_Write(Handle handle, u32 *bytesWritten, u64 offset, const void *buffer, u32 size, u32 flags)
+{
+    (void)flags;
+
+    ssize_t n = pwrite((int)(handle - HOST_FILE_HANDLE_BASE), buffer, size, (off_t)offset);
+    if(n < 0)
+        return hostErrnoToResult(errno);
+
+    *bytesWritten = (u32)n;
+    return 0;
+}
+
+WEAK Result FSFILE_GetSize(Handle handle, u64 *size)
+{
+    struct stat st;
+    if(fstat((int)(handle - HOST_FILE_HANDLE_BASE), &st) != 0)
+        return hostErrnoToResult(errno);
+
+    *size = (u64)st.st_size;
+    return 0;
+}
+
+WEAK Result FSFILE_SetSize(Handle handle, u64 size)
+{
+    return ftruncate((int)(handle - HOST_FILE_HANDLE_BASE), (off_t)size) == 0 ? 0 : hostErrnoToResult(errno);
+}
+
+WEAK Result FSFILE_Flush(Handle handle)
+{
+    (void)handle;
+    return 0;
+}
+
+WEAK Result FSFILE_Close(Handle handle)
+{
+    return close((int)(handle - HOST_FILE_HANDLE_BASE)) == 0 ? 0 : hostErrnoToResult(errno);
+}
+
+WEAK Result svcCloseHandle(Handle handle)
+{
+    if(handle >= HOST_FILE_HANDLE_BASE)
+        return FSFILE_Close(handle);
+    return 0;
+}
+
+// Only fixed addresses, e.g. the APPLICATION heap at 0x08000000, which is free in a non-PIE executable
+WEAK Result svcControlMemory(u32 *addr_out, u32 addr0, u32 addr1, u32 size, MemOp op, MemPerm perm)
+{
+    (void)addr1;
+    (void)perm;
+
+    switch(op & MEMOP_OP_MASK)
+    {
+        case MEMOP_ALLOC:
+            if(mmap((void *)addr0, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0) == MAP_FAILED)
+                return MAKERESULT(RL_PERMANENT, RS_OUTOFRESOURCE, RM_OS, RD_OUT_OF_MEMORY);
+            *addr_out = addr0;
+            return 0;
+        case MEMOP_FREE:
+            return munmap((void *)addr0, size) == 0 ? 0 : MAKERESULT(RL_PERMANENT, RS_INVALIDARG, RM_OS, RD_INVALID_ADDRESS);
+        default:
+            return MAKERESULT(RL_PERMANENT, RS_NOTSUPPORTED, RM_OS, RD_NOT_IMPLEMENTED);
+    }
+}
+
+WEAK Result svcControlMemoryEx(u32 *addr_out, u32 addr0, u32 addr1, u32 size, MemOp op, MemPerm perm, bool isLoader)
+{
+    (void)isLoader;
+    return svcControlMemory(addr_out, addr0, addr1, size, op, perm);
+}
+
+WEAK u64 svcGetSystemTick(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    // Converted to ARM11 ticks, which is what the tested code expects
+    return ((u64)ts.tv_sec * 1000000000ULL + (u64)ts.tv_nsec) * (SYSCLOCK_ARM11 / 1000000ULL) / 1000ULL;
+}
+
+WEAK u64 osGetTime(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+
+    // Milliseconds since 1900-01-01
+    return ((u64)ts.tv_sec + 2208988800ULL) * 1000ULL + (u64)ts.tv_nsec / 1000000ULL;
+}
+
+WEAK u32 osGetKernelVersion(void)
+{
+    return SYSTEM_VERSION(2, 58, 0); // 11.17
+}
+
+WEAK void svcSleepThread(s64 ns)
+{
+    struct timespec ts = { .tv_sec = ns / 1000000000LL, .tv_nsec = ns % 1000000000LL };
+    nanosleep(&ts, NULL);
+}
+
+WEAK void svcBreak(UserBreakType breakReason)
+{
+    fprintf(stderr, "svcBreak(%d)\n", (int)breakReason);
+    abort();
+}
+
+// Paths are ASCII here
+WEAK ssize_t utf8_to_utf16(u16 *out, const u8 *in, size_t len)
+{
+    size_t i;
+
+    for(i = 0; i < len && in[i] != 0; i++)
+    {
+        if(in[i] >= 0x80)
+            return -1;
+        out[i] = in[i];
+    }
+    return (ssize_t)i;
+}
@@ -0,0 +1,21 @@
+/*
+    Host implementations of the libctru functions shared by the tests (see host_ctru.c).
+*/
+
+#pragma once
+
+#include <3ds.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Directory the FS archives are mapped to, the current one by default
+void hostFsSetRoot(const char *root);
+
+// Host path of an archive path, for the tests to prepare or check files
+const char *hostFsGetPath(const char *path);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,31 @@
+/*
+    Host stand-in for libctru's 3ds.h (see 3ds/types.h).
+*/
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "3ds/types.h"
+#include "3ds/result.h"
+#include "3ds/svc.h"
+#include "3ds/ipc.h"
+#include "3ds/srv.h"
+#include "3ds/os.h"
+#include "3ds/synchronization.h"
+#include "3ds/exheader.h"
+#include "3ds/services/fs.h"
+#include "3ds/services/fsreg.h"
+#include "3ds/services/pxipm.h"
+#include "3ds/services/soc.h"
+#include "3ds/services/pmapp.h"
+#include "3ds/services/pmdbg.h"
+#include "3ds/services/hid.h"
+#include "3ds/services/gspgpu.h"
+#include "3ds/util/utf.h"
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,84 @@
+/*
+    Host stand-in for libctru's exheader.h (see 3ds/types.h), reduced to the fields the tested code uses.
+*/
+
+#pragma once
+
+#include "types.h"
+
+typedef struct
+{
+    u32 address;
+    u32 num_pages;
+    u32 size;
+} ExHeader_CodeSectionInfo;
+
+typedef struct
+{
+    char name[8];
+    struct
+    {
+        u8 reserved[5];
+        u8 compress_exefs_code : 1;
+        u8 is_sd_application : 1;
+        u8 unused : 6;
+        u16 remaster_version;
+    } flags;
+    ExHeader_CodeSectionInfo text;
+    u32 stack_size;
+    ExHeader_CodeSectionInfo rodata;
+    u32 reserved;
+    ExHeader_CodeSectionInfo data;
+    u32 bss_size;
+} ExHeader_CodeSetInfo;
+
+typedef struct
+{
+    ExHeader_CodeSetInfo codeset_info;
+    u64 dependencies[48];
+    u64 savedata_size;
+    u64 jump_id;
+    u8 reserved[0x30];
+} ExHeader_SystemControlInfo;
+
+typedef struct
+{
+    u64 title_id;
+    u32 core_version;
+    u8 reserved[0x170 - 12];
+} ExHeader_Arm11SystemLocalCapabilities;
+
+typedef struct
+{
+    u32 descriptors[28];
+    u8 reserved[0x10];
+} ExHeader_Arm11KernelCapabilities;
+
+typedef struct
+{
+    u8 descriptors[15];
+    u8 descriptor_version;
+} ExHeader_Arm9AccessControl;
+
+typedef struct
+{
+    ExHeader_Arm11SystemLocalCapabilities local_caps;
+    ExHeader_Arm11KernelCapabilities kernel_caps;
+    ExHeader_Arm9AccessControl access_control;
+} ExHeader_AccessControlInfo;
+
+typedef struct
+{
+    ExHeader_SystemControlInfo sci;
+    ExHeader_AccessControlInfo aci;
+} ExHeader_Info;
+
+typedef struct
+{
+    ExHeader_Info info;
+    ExHeader_AccessControlInfo access_descriptor;
+} ExHeader;
+
+#ifndef __cplusplus
+_Static_assert(sizeof(ExHeader_Info) == 0x400, "ExHeader_Info must be 0x400 bytes");
+#endif
@@ -0,0 +1,9 @@
+/*
+    Host stand-in for libctru's gfx.h (see 3ds/types.h).
+*/
+
+#pragma once
+
+#include "types.h"
+
+#define RGB565(r,g,b)  (((b)&0x1f)|(((g)&0x3f)<<5)|(((r)&0x1f)<<11))
@@ -0,0 +1,32 @@
+/*
+    Host stand-in for libctru's ipc.h (see 3ds/types.h).
+*/
+
+#pragma once
+
+#include "types.h"
+
+static inline u32 IPC_MakeHeader(u16 command_id, unsigned normal_params, unsigned translate_params)
+{
+    return ((u32)command_id << 16) | (((u32)normal_params & 0x3F) << 6) | (((u32)translate_params & 0x3F) << 0);
+}
+
+static inline u32 IPC_Desc_SharedHandles(unsigned number)
+{
+    return ((u32)(number - 1) << 26);
+}
+
+static inline u32 IPC_Desc_MoveHandles(unsigned number)
+{
+    return ((u32)(number - 1) << 26) | 0x10;
+}
+
+static inline u32 IPC_Desc_CurProcessId(void)
+{
+    return 0x20;
+}
+
+static inline u32 IPC_Desc_StaticBuffer(size_t size, unsigned buffer_id)
+{
+    return (size << 14) | ((buffer_id & 0xF) << 10) | 0x2;
+}
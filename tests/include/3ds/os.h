@@ -0,0 +1,39 @@
+/*
+    Host stand-in for libctru's os.h (see 3ds/types.h).
+*/
+
+#pragma once
+
+#include "types.h"
+#include "svc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OS_SHAREDCFG_VADDR 0x1FF81000
+
+#define SYSCLOCK_SOC       (16756991)
+#define SYSCLOCK_SYS       (SYSCLOCK_SOC * 2)
+#define SYSCLOCK_SDMMC     (SYSCLOCK_SYS * 2)
+#define SYSCLOCK_ARM9      (SYSCLOCK_SOC * 8)
+#define SYSCLOCK_ARM11     (SYSCLOCK_ARM9 * 2)
+#define SYSCLOCK_ARM11_NEW (SYSCLOCK_ARM11 * 3)
+
+#define CPU_TICKS_PER_MSEC (SYSCLOCK_ARM11 / 1000.0)
+#define CPU_TICKS_PER_USEC (SYSCLOCK_ARM11 / 1000000.0)
+
+#define SYSTEM_VERSION(major, minor, revision) \
+    (((major)<<24)|((minor)<<16)|((revision)<<8))
+
+#define GET_VERSION_MAJOR(version)    ((version) >>24)
+#define GET_VERSION_MINOR(version)    (((version)>>16)&0xFF)
+#define GET_VERSION_REVISION(version) (((version)>> 8)&0xFF)
+
+u64 osGetTime(void);
+u32 osGetKernelVersion(void);
+s64 osGetMemRegionFree(MemRegion region);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,176 @@
+/*
+    Host stand-in for libctru's result.h (see 3ds/types.h).
+*/
+
+#pragma once
+
+#define R_SUCCEEDED(res)   ((res)>=0)
+#define R_FAILED(res)      ((res)<0)
+#define R_LEVEL(res)       (((res)>>27)&0x1F)
+#define R_SUMMARY(res)     (((res)>>21)&0x3F)
+#define R_MODULE(res)      (((res)>>10)&0xFF)
+#define R_DESCRIPTION(res) ((res)&0x3FF)
+
+#define MAKERESULT(level,summary,module,description) \
+    ((((level)&0x1F)<<27) | (((summary)&0x3F)<<21) | (((module)&0xFF)<<10) | ((description)&0x3FF))
+
+enum
+{
+    RL_SUCCESS     = 0,
+    RL_INFO        = 1,
+    RL_FATAL       = 0x1F,
+    RL_RESET       = RL_FATAL - 1,
+    RL_REINITIALIZE = RL_FATAL - 2,
+    RL_USAGE       = RL_FATAL - 3,
+    RL_PERMANENT   = RL_FATAL - 4,
+    RL_TEMPORARY   = RL_FATAL - 5,
+    RL_STATUS      = RL_FATAL - 6,
+};
+
+enum
+{
+    RS_SUCCESS = 0,
+    RS_NOP,
+    RS_WOULDBLOCK,
+    RS_OUTOFRESOURCE,
+    RS_NOTFOUND,
+    RS_INVALIDSTATE,
+    RS_NOTSUPPORTED,
+    RS_INVALIDARG,
+    RS_WRONGARG,
+    RS_CANCELED,
+    RS_STATUSCHANGED,
+    RS_INTERNAL,
+    RS_INVALIDRESVAL = 63,
+};
+
+enum
+{
+    RM_COMMON = 0,
+    RM_KERNEL,
+    RM_UTIL,
+    RM_FILE_SERVER,
+    RM_LOADER_SERVER,
+    RM_TCB,
+    RM_OS,
+    RM_DBG,
+    RM_DMNT,
+    RM_PDN,
+    RM_GSP,
+    RM_I2C,
+    RM_GPIO,
+    RM_DD,
+    RM_CODEC,
+    RM_SPI,
+    RM_PXI,
+    RM_FS,
+    RM_DI,
+    RM_HID,
+    RM_CAM,
+    RM_PI,
+    RM_PM,
+    RM_PM_LOW,
+    RM_FSI,
+    RM_SRV,
+    RM_NDM,
+    RM_NWM,
+    RM_SOC,
+    RM_LDR,
+    RM_ACC,
+    RM_ROMFS,
+    RM_AM,
+    RM_HIO,
+    RM_UPDATER,
+    RM_MIC,
+    RM_FND,
+    RM_MP,
+    RM_MPWL,
+    RM_AC,
+    RM_HTTP,
+    RM_DSP,
+    RM_SND,
+    RM_DLP,
+    RM_HIO_LOW,
+    RM_CSND,
+    RM_SSL,
+    RM_AM_LOW,
+    RM_NEX,
+    RM_FRIENDS,
+    RM_RDT,
+    RM_APPLET,
+    RM_NIM,
+    RM_PTM,
+    RM_MIDI,
+    RM_MC,
+    RM_SWC,
+    RM_FATFS,
+    RM_NGC,
+    RM_CARD,
+    RM_CARDNOR,
+    RM_SDMC,
+    RM_BOSS,
+    RM_DBM,
+    RM_CONFIG,
+    RM_PS,
+    RM_CEC,
+    RM_IR,
+    RM_UDS,
+    RM_PL,
+    RM_CUP,
+    RM_GYROSCOPE,
+    RM_MCU,
+    RM_NS,
+    RM_NEWS,
+    RM_RO,
+    RM_GD,
+    RM_CARD_SPI,
+    RM_EC,
+    RM_WEB_BROWSER,
+    RM_TEST,
+    RM_ENC,
+    RM_PIA,
+    RM_ACT,
+    RM_VCTL,
+    RM_OLV,
+    RM_NEIA,
+    RM_NPNS,
+    RM_AVD = 90,
+    RM_L2B,
+    RM_MVD,
+    RM_NFC,
+    RM_UART,
+    RM_SPM,
+    RM_QTM,
+    RM_NFP,
+    RM_APPLICATION = 254,
+    RM_INVALIDRESVAL = 255,
+};
+
+enum
+{
+    RD_SUCCESS              = 0,
+    RD_INVALID_RESULT_VALUE = 0x3FF,
+    RD_TIMEOUT              = RD_INVALID_RESULT_VALUE - 1,
+    RD_OUT_OF_RANGE         = RD_INVALID_RESULT_VALUE - 2,
+    RD_ALREADY_EXISTS       = RD_INVALID_RESULT_VALUE - 3,
+    RD_CANCEL_REQUESTED     = RD_INVALID_RESULT_VALUE - 4,
+    RD_NOT_FOUND            = RD_INVALID_RESULT_VALUE - 5,
+    RD_ALREADY_INITIALIZED  = RD_INVALID_RESULT_VALUE - 6,
+    RD_NOT_INITIALIZED      = RD_INVALID_RESULT_VALUE - 7,
+    RD_INVALID_HANDLE       = RD_INVALID_RESULT_VALUE - 8,
+    RD_INVALID_POINTER      = RD_INVALID_RESULT_VALUE - 9,
+    RD_INVALID_ADDRESS      = RD_INVALID_RESULT_VALUE - 10,
+    RD_NOT_IMPLEMENTED      = RD_INVALID_RESULT_VALUE - 11,
+    RD_OUT_OF_MEMORY        = RD_INVALID_RESULT_VALUE - 12,
+    RD_MISALIGNED_SIZE      = RD_INVALID_RESULT_VALUE - 13,
+    RD_MISALIGNED_ADDRESS   = RD_INVALID_RESULT_VALUE - 14,
+    RD_BUSY                 = RD_INVALID_RESULT_VALUE - 15,
+    RD_NO_DATA              = RD_INVALID_RESULT_VALUE - 16,
+    RD_INVALID_COMBINATION  = RD_INVALID_RESULT_VALUE - 17,
+    RD_INVALID_ENUM_VALUE   = RD_INVALID_RESULT_VALUE - 18,
+    RD_INVALID_SIZE         = RD_INVALID_RESULT_VALUE - 19,
+    RD_ALREADY_DONE         = RD_INVALID_RESULT_VALUE - 20,
+    RD_NOT_AUTHORIZED       = RD_INVALID_RESULT_VALUE - 21,
+    RD_TOO_LARGE            = RD_INVALID_RESULT_VALUE - 22,
+    RD_INVALID_SELECTION    = RD_INVALID_RESULT_VALUE - 23,
+};
@@ -0,0 +1,150 @@
+/*
+    Host stand-in for libctru's services/fs.h (see 3ds/types.h). tests/common/host_ctru.c implements the archive and
+    file functions on top of a host directory.
+*/
+
+#pragma once
+
+#include <string.h>
+#include "../types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum
+{
+    FS_OPEN_READ   = BIT(0),
+    FS_OPEN_WRITE  = BIT(1),
+    FS_OPEN_CREATE = BIT(2),
+};
+
+enum
+{
+    FS_WRITE_FLUSH       = BIT(0),
+    FS_WRITE_UPDATE_TIME = BIT(8),
+};
+
+enum
+{
+    FS_ATTRIBUTE_DIRECTORY = BIT(0),
+    FS_ATTRIBUTE_HIDDEN    = BIT(8),
+    FS_ATTRIBUTE_ARCHIVE   = BIT(16),
+    FS_ATTRIBUTE_READ_ONLY = BIT(24),
+};
+
+typedef enum
+{
+    MEDIATYPE_NAND      = 0,
+    MEDIATYPE_SD        = 1,
+    MEDIATYPE_GAME_CARD = 2,
+} FS_MediaType;
+
+typedef enum
+{
+    ARCHIVE_ROMFS                    = 0x00000003,
+    ARCHIVE_SAVEDATA                 = 0x00000004,
+    ARCHIVE_EXTDATA                  = 0x00000006,
+    ARCHIVE_SHARED_EXTDATA           = 0x00000007,
+    ARCHIVE_SYSTEM_SAVEDATA          = 0x00000008,
+    ARCHIVE_SDMC                     = 0x00000009,
+    ARCHIVE_SDMC_WRITE_ONLY          = 0x0000000A,
+    ARCHIVE_NAND_RW                  = 0x1234567D,
+    ARCHIVE_NAND_RO                  = 0x1234567C,
+    ARCHIVE_SAVEDATA_AND_CONTENT2    = 0x2345678E,
+} FS_ArchiveID;
+
+typedef enum
+{
+    PATH_INVALID = 0,
+    PATH_EMPTY   = 1,
+    PATH_BINARY  = 2,
+    PATH_ASCII   = 3,
+    PATH_UTF16   = 4,
+} FS_PathType;
+
+typedef enum
+{
+    ARCHIVE_ACTION_COMMIT_SAVE_DATA = 0,
+    ARCHIVE_ACTION_GET_TIMESTAMP    = 1,
+    ARCHIVE_ACTION_UNKNOWN          = 0x789D,
+} FS_ArchiveAction;
+
+typedef struct
+{
+    u64 programId;
+    FS_MediaType mediaType : 8;
+    u8 padding[7];
+} FS_ProgramInfo;
+
+typedef struct
+{
+    u16 name[0x106];
+    char shortName[0x0A];
+    char shortExt[0x04];
+    u8 valid;
+    u8 reserved;
+    u32 attributes;
+    u64 fileSize;
+} FS_DirectoryEntry;
+
+typedef struct
+{
+    FS_PathType type;
+    u32 size;
+    const void *data;
+} FS_Path;
+
+typedef u64 FS_Archive;
+
+static inline FS_Path fsMakePath(FS_PathType type, const void *path)
+{
+    FS_Path p = { type, 0, path };
+    switch(type)
+    {
+        case PATH_ASCII:
+            p.size = strlen((const char *)path) + 1;
+            break;
+        case PATH_UTF16:
+        {
+            const u16 *str = (const u16 *)path;
+            while(*str++) p.size++;
+            p.size = p.size * 2 + 2;
+            break;
+        }
+        case PATH_EMPTY:
+            p.size = 1;
+            p.data = "";
+            break;
+        default:
+            break;
+    }
+    return p;
+}
+
+Result FSUSER_OpenArchive(FS_Archive *archive, FS_ArchiveID id, FS_Path path);
+Result FSUSER_CloseArchive(FS_Archive archive);
+Result FSUSER_ControlArchive(FS_Archive archive, FS_ArchiveAction action, void *input, u32 inputSize, void *output, u32 outputSize);
+Result FSUSER_OpenFile(Handle *out, FS_Archive archive, FS_Path path, u32 openFlags, u32 attributes);
+Result FSUSER_OpenFileDirectly(Handle *out, FS_ArchiveID archiveId, FS_Path archivePath, FS_Path filePath, u32 openFlags, u32 attributes);
+Result FSUSER_OpenDirectory(Handle *out, FS_Archive archive, FS_Path path);
+Result FSUSER_CreateFile(FS_Archive archive, FS_Path path, u32 attributes, u64 fileSize);
+Result FSUSER_CreateDirectory(FS_Archive archive, FS_Path path, u32 attributes);
+Result FSUSER_DeleteFile(FS_Archive archive, FS_Path path);
+Result FSUSER_DeleteDirectory(FS_Archive archive, FS_Path path);
+Result FSUSER_RenameFile(FS_Archive srcArchive, FS_Path srcPath, FS_Archive dstArchive, FS_Path dstPath);
+Result FSUSER_RenameDirectory(FS_Archive srcArchive, FS_Path srcPath, FS_Archive dstArchive, FS_Path dstPath);
+
+Result FSFILE_Read(Handle handle, u32 *bytesRead, u64 offset, void *buffer, u32 size);
+Result FSFILE_Write(Handle handle, u32 *bytesWritten, u64 offset, const void *buffer, u32 size, u32 flags);
+Result FSFILE_GetSize(Handle handle, u64 *size);
+Result FSFILE_SetSize(Handle handle, u64 size);
+Result FSFILE_Flush(Handle handle);
+Result FSFILE_Close(Handle handle);
+
+Result FSDIR_Read(Handle handle, u32 *entriesRead, u32 entryCount, FS_DirectoryEntry *entries);
+Result FSDIR_Close(Handle handle);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,22 @@
+/*
+    Host stand-in for libctru's services/fsreg.h (see 3ds/types.h).
+*/
+
+#pragma once
+
+#include "fs.h"
+#include "../exheader.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+Result FSREG_Register(u32 pid, u64 prog_handle, FS_ProgramInfo *info, void *storageinfo);
+Result FSREG_CheckHostLoadId(u64 prog_handle);
+Result FSREG_LoadProgram(u64 *prog_handle, FS_ProgramInfo *title);
+Result FSREG_GetProgramInfo(ExHeader_Info *exheaderInfos, u32 entryCount, u64 prog_handle);
+Result FSREG_UnloadProgram(u64 prog_handle);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,16 @@
+/*
+    Host stand-in for libctru's services/gspgpu.h (see 3ds/types.h).
+*/
+
+#pragma once
+
+#include "../types.h"
+
+typedef enum
+{
+    GSP_RGBA8_OES = 0,
+    GSP_BGR8_OES = 1,
+    GSP_RGB565_OES = 2,
+    GSP_RGB5_A1_OES = 3,
+    GSP_RGBA4_OES = 4,
+} GSPGPU_FramebufferFormat;
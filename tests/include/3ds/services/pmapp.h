@@ -0,0 +1,18 @@
+/*
+    Host stand-in for libctru's services/pmapp.h (see 3ds/types.h).
+*/
+
+#pragma once
+
+#include "fs.h"
+
+enum
+{
+    PMLAUNCHFLAG_NORMAL_APPLICATION  = BIT(0),
+    PMLAUNCHFLAG_LOAD_DEPENDENCIES   = BIT(1),
+    PMLAUNCHFLAG_NOTIFY_TERMINATION  = BIT(2),
+    PMLAUNCHFLAG_QUEUE_DEBUG_APPLICATION = BIT(3),
+    PMLAUNCHFLAG_TERMINATION_NOTIFICATION_MASK = 0xF0,
+    PMLAUNCHFLAG_FORCE_USE_O3DS_APP_MEM = BIT(8),
+    PMLAUNCHFLAG_USE_UPDATE_TITLE   = BIT(16),
+};
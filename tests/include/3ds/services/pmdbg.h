@@ -0,0 +1,7 @@
+/*
+    Host stand-in for libctru's services/pmdbg.h (see 3ds/types.h).
+*/
+
+#pragma once
+
+#include "fs.h"
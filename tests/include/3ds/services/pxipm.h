@@ -0,0 +1,20 @@
+/*
+    Host stand-in for libctru's services/pxipm.h (see 3ds/types.h).
+*/
+
+#pragma once
+
+#include "fs.h"
+#include "../exheader.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+Result PXIPM_GetProgramInfo(ExHeader_Info *exheaderInfo, u64 programHandle);
+Result PXIPM_RegisterProgram(u64 *programHandle, const FS_ProgramInfo *programInfo, const FS_ProgramInfo *updateInfo);
+Result PXIPM_UnregisterProgram(u64 programHandle);
+
+#ifdef __cplusplus
+}
+#endif
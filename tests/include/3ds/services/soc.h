@@ -0,0 +1,9 @@
+/*
+    Host stand-in for libctru's services/soc.h (see 3ds/types.h): the host socket definitions are used as is.
+*/
+
+#pragma once
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <poll.h>
@@ -0,0 +1,19 @@
+/*
+    Host stand-in for libctru's srv.h (see 3ds/types.h).
+*/
+
+#pragma once
+
+#include "types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+Result srvGetServiceHandle(Handle *out, const char *name);
+Result srvIsServiceRegistered(bool *registered, const char *name);
+Result srvPublishToSubscriber(u32 notificationId, u32 flags);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,43 @@
+/*
+    Host stand-in for libctru's synchronization.h (see 3ds/types.h). The tests are single-threaded unless stated
+    otherwise, the locks only keep track of their owner's recursion.
+*/
+
+#pragma once
+
+#include "types.h"
+
+typedef s32 LightLock;
+
+typedef struct
+{
+    LightLock lock;
+    u32 thread_tag;
+    u32 counter;
+} RecursiveLock;
+
+typedef struct
+{
+    s32 state;
+    LightLock lock;
+} LightEvent;
+
+typedef struct
+{
+    s32 current_count;
+    s16 num_threads_acq;
+    s16 max_count;
+} LightSemaphore;
+
+static inline void LightLock_Init(LightLock *lock) { *lock = 1; }
+static inline void LightLock_Lock(LightLock *lock) { *lock = -1; }
+static inline int LightLock_TryLock(LightLock *lock) { if(*lock < 0) return 1; *lock = -1; return 0; }
+static inline void LightLock_Unlock(LightLock *lock) { *lock = 1; }
+
+static inline void RecursiveLock_Init(RecursiveLock *lock) { lock->lock = 1; lock->thread_tag = 0; lock->counter = 0; }
+static inline void RecursiveLock_Lock(RecursiveLock *lock) { lock->counter++; }
+static inline int RecursiveLock_TryLock(RecursiveLock *lock) { lock->counter++; return 0; }
+static inline void RecursiveLock_Unlock(RecursiveLock *lock) { lock->counter--; }
+
+static inline s32 AtomicPostIncrement(vs32 *ptr) { return __atomic_fetch_add(ptr, 1, __ATOMIC_SEQ_CST); }
+static inline s32 AtomicDecrement(vs32 *ptr) { return __atomic_sub_fetch(ptr, 1, __ATOMIC_SEQ_CST); }
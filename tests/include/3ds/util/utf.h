@@ -0,0 +1,18 @@
+/*
+    Host stand-in for libctru's util/utf.h (see 3ds/types.h).
+*/
+
+#pragma once
+
+#include "../types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+ssize_t utf8_to_utf16(u16 *out, const u8 *in, size_t len);
+ssize_t utf16_to_utf8(u8 *out, const u16 *in, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,269 @@
+/*
+    Throughput of the loader's BPS applier (sysmodules/loader/source/bps_patcher.cpp) against the one it replaced
+    (bps_reference.h): CRC32 alone, then whole patches applied the way ApplyCodeBpsPatch does, from code.bps.
+
+    Usage: bps_bench [code.bin code.bps]
+
+    Without arguments, two synthetic patches of a 4MB code section are measured: a "mod" one, mostly SourceRead
+    with replaced functions (TargetRead), moved ones (SourceCopy) and zero/padding fills (TargetCopy), and a
+    "shifted" one, where 0x1000 bytes inserted early move the rest of the code forward, SourceCopy then reading
+    ranges the target has already overwritten. A real code.bin (decompressed) and its code.bps can be given instead.
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "bench.h"
+#include "host_ctru.h"
+#include "bps_patch_builder.h"
+#include "bps_reference.h"
+#include "bps_patcher.cpp"
+
+namespace
+{
+constexpr u64 BenchProgId = 0x0004000000BEEF00ULL;
+constexpr u32 NbRuns = 10;
+
+u32 seed = 0x3D5;
+
+u32 Random(u32 max) // [0, max]
+{
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return max == 0xFFFFFFFF ? seed : seed % (max + 1);
+}
+
+const char *PatchPath()
+{
+    static char path[] = "/luma/titles/0000000000000000/code.bps";
+    progIdToStr(path + 28, BenchProgId);
+    return path;
+}
+
+std::vector<u8> ModPatch(const u8 *code, u32 size, std::vector<u8> &target)
+{
+    PatchBuilder patch{size, size};
+    s64 sourceRelative = 0, targetRelative = 0;
+
+    for(u32 output = 0; output < size;)
+    {
+        u32 length = std::min(size - output, 0x100 + Random(0x4000));
+        patch.Command(0, length);
+        output += length;
+        if(output == size)
+            break;
+
+        length = std::min(size - output, 4 + Random(0x200));
+        switch(Random(3))
+        {
+        case 0:
+        {
+            std::vector<u8> bytes(length);
+            benchFillRandom(bytes.data(), length, Random(0xFFFFFFFF));
+            patch.Command(1, length);
+            patch.Bytes(bytes.data(), length);
+            break;
+        }
+        case 1:
+        {
+            const s64 offset = Random(size - length);
+            patch.Command(2, length);
+            patch.Offset(offset - sourceRelative);
+            sourceRelative = offset + length;
+            break;
+        }
+        case 2: // fill with the previous byte
+            patch.Command(3, length);
+            patch.Offset(s64(output) - 1 - targetRelative);
+            targetRelative = output - 1 + length;
+            break;
+        default: // copy of something already written
+        {
+            const s64 offset = Random(output - std::min(output, length));
+            patch.Command(3, length);
+            patch.Offset(offset - targetRelative);
+            targetRelative = offset + length;
+            break;
+        }
+        }
+        output += length;
+    }
+
+    const std::vector<u8> &data = patch.Finish(reference::Bps::crc32(code, size), 0);
+    reference::Bps::PatchApplier applier{{code, size}, {target.data(), size}, {data.data(), data.size()}};
+    applier.Apply();
+    return patch.SetFooter(reference::Bps::crc32(code, size), reference::Bps::crc32(target.data(), size));
+}
+
+std::vector<u8> ShiftedPatch(const u8 *code, u32 size, std::vector<u8> &target)
+{
+    constexpr u32 Inserted = 0x1000;
+    PatchBuilder patch{size, size};
+    s64 sourceRelative = 0;
+
+    patch.Command(0, 0x8000);
+    std::vector<u8> bytes(Inserted);
+    benchFillRandom(bytes.data(), Inserted, 0x1234);
+    patch.Command(1, Inserted);
+    patch.Bytes(bytes.data(), Inserted);
+
+    // The rest, with a few relocated words along the way
+    for(u32 output = 0x8000 + Inserted; output < size;)
+    {
+        const u32 length = std::min(size - output, 0x40 + Random(0x1000));
+        const s64 offset = s64(output) - Inserted;
+        patch.Command(2, length);
+        patch.Offset(offset - sourceRelative);
+        sourceRelative = offset + length;
+        output += length;
+
+        if(output + 4 <= size)
+        {
+            const u32 word = Random(0xFFFFFFFF);
+            patch.Command(1, 4);
+            patch.Bytes(reinterpret_cast<const u8 *>(&word), 4);
+            output += 4;
+        }
+    }
+
+    const std::vector<u8> &data = patch.Finish(reference::Bps::crc32(code, size), 0);
+    reference::Bps::PatchApplier applier{{code, size}, {target.data(), size}, {data.data(), data.size()}};
+    applier.Apply();
+    return patch.SetFooter(reference::Bps::crc32(code, size), reference::Bps::crc32(target.data(), size));
+}
+
+// What ApplyCodeBpsPatch used to do: copy the code and read the whole patch to the APPLICATION heap
+bool ApplyReference(u8 *code, u32 size, u8 *heap)
+{
+    util::File file;
+    if(!file.Open(PatchPath(), FS_OPEN_READ))
+        return false;
+    const u32 patchSize = u32(file.GetSize().value_or(0));
+
+    u8 *source = heap, *patch = heap + size;
+    std::memcpy(source, code, size);
+    if(!file.Read(patch, patchSize, 0))
+        return false;
+
+    reference::Bps::PatchApplier applier{{source, size}, {code, size}, {patch, patchSize}};
+    return applier.Apply();
+}
+
+void Run(const char *name, u8 *code, const u8 *source, u32 size, const std::vector<u8> &patch,
+         const std::vector<u8> &expected)
+{
+    FILE *f = fopen(hostFsGetPath(PatchPath()), "wb");
+    if(f == nullptr || fwrite(patch.data(), 1, patch.size(), f) != patch.size() || fclose(f) != 0)
+    {
+        perror("code.bps");
+        exit(1);
+    }
+
+    u8 *heap = static_cast<u8 *>(benchAlloc32(size + patch.size()));
+    bool ok = true;
+
+    // Both start with a copy of the code: the old applier's own one, the restoration of the source for the new one
+    std::memcpy(code, source, size);
+    const u64 referenceNs = BENCH_BEST_NS(NbRuns, ok &= ApplyReference(code, size, heap);
+                                                  if(std::memcmp(code, expected.data(), size) != 0) ok = false;
+                                                  std::memcpy(code, source, size));
+    const u64 inPlaceNs = BENCH_BEST_NS(NbRuns, std::memcpy(code, source, size);
+                                                ok &= patcherApplyCodeBpsPatch(BenchProgId, code, size));
+    if(!ok || std::memcmp(code, expected.data(), size) != 0)
+    {
+        printf("bps_bench: %s: wrong result\n", name);
+        exit(1);
+    }
+
+    munmap(heap, size + patch.size());
+    printf("  %-8s patch %7zu bytes: reference %8.3f ms  %7.1f MB/s, in place %8.3f ms  %7.1f MB/s (x%.1f)\n", name,
+           patch.size(), referenceNs / 1e6, benchMBps(size, referenceNs), inPlaceNs / 1e6, benchMBps(size, inPlaceNs),
+           double(referenceNs) / double(inPlaceNs));
+}
+}  // namespace
+
+int main(int argc, char *argv[])
+{
+    if(argc != 1 && argc != 3)
+    {
+        fprintf(stderr, "Usage: %s [code.bin code.bps]\n", argv[0]);
+        return 1;
+    }
+
+    char root[] = "/tmp/bps_bench.XXXXXX";
+    if(mkdtemp(root) == nullptr)
+    {
+        perror("mkdtemp");
+        return 1;
+    }
+    hostFsSetRoot(root);
+    for(const char *dir : {"/luma", "/luma/titles", "/luma/titles/0004000000BEEF00"})
+        mkdir(hostFsGetPath(dir), 0755);
+
+    u32 size;
+    u8 *source;
+    std::vector<u8> realPatch;
+    if(argc == 3)
+    {
+        u32 patchSize;
+        const u8 *patch = benchReadFile(argv[2], &patchSize);
+        source = benchReadFile(argv[1], &size);
+        if(source == nullptr || patch == nullptr)
+        {
+            perror(source == nullptr ? argv[1] : argv[2]);
+            return 1;
+        }
+        realPatch.assign(patch, patch + patchSize);
+    }
+    else
+    {
+        size = 0x400000;
+        source = static_cast<u8 *>(benchAlloc32(size));
+        benchFillRandom(source, size, 0x3D5);
+    }
+
+    u8 *code = static_cast<u8 *>(benchAlloc32(size));
+    volatile u32 sink = 0;
+    const u64 referenceCrcNs = BENCH_BEST_NS(NbRuns, sink += reference::Bps::crc32(source, size));
+    const u64 crcNs = BENCH_BEST_NS(NbRuns, sink += patcher::Bps::crc32(source, size));
+    if(reference::Bps::crc32(source, size) != patcher::Bps::crc32(source, size))
+    {
+        printf("bps_bench: CRC32 mismatch\n");
+        return 1;
+    }
+
+    printf("bps_bench: %lu bytes of code\n", (unsigned long)size);
+    printf("  CRC32:   reference %8.3f ms  %7.1f MB/s, sliced   %8.3f ms  %7.1f MB/s (x%.1f)\n",
+           referenceCrcNs / 1e6, benchMBps(size, referenceCrcNs), crcNs / 1e6, benchMBps(size, crcNs),
+           double(referenceCrcNs) / double(crcNs));
+
+    std::vector<u8> expected(size);
+    if(argc == 3)
+    {
+        reference::Bps::PatchApplier applier{{source, size}, {expected.data(), size},
+                                             {realPatch.data(), realPatch.size()}};
+        if(!applier.Apply())
+        {
+            printf("bps_bench: %s doesn't apply to %s\n", argv[2], argv[1]);
+            return 1;
+        }
+        Run("code.bps", code, source, size, realPatch, expected);
+    }
+    else
+    {
+        std::vector<u8> patch = ModPatch(source, size, expected);
+        Run("mod", code, source, size, patch, expected);
+        patch = ShiftedPatch(source, size, expected);
+        Run("shifted", code, source, size, patch, expected);
+    }
+
+    unlink(hostFsGetPath(PatchPath()));
+    for(const char *dir : {"/luma/titles/0004000000BEEF00", "/luma/titles", "/luma"})
+        rmdir(hostFsGetPath(dir));
+    rmdir(root);
+    return 0;
+}
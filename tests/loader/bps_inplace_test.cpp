@@ -0,0 +1,320 @@
+/*
+    Differential test of the loader's in-place BPS applier (sysmodules/loader/source/bps_patcher.cpp) against the
+    out-of-place one it replaced (bps_reference.h): random patches mixing all four commands, SourceCopy reading
+    ranges the target has already overwritten, straddling the output offset or ahead of it, TargetCopy copying
+    overlapping runs, run-length fills and not-yet-written bytes. Both appliers have to agree on the outcome and,
+    on success, on every byte of the code buffer. Some patches are corrupted on purpose, a few go through the
+    loader's entry point (patcherApplyCodeBpsPatch) and its APPLICATION memory backup.
+
+    Usage: bps_inplace_test [number of random patches (default 2000)]
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "host_ctru.h"
+#include "bps_patch_builder.h"
+#include "bps_reference.h"
+#include "bps_patcher.cpp"
+
+namespace
+{
+constexpr u64 TestProgId = 0x0004000000BEEF00ULL;
+
+std::mt19937 rng(1);
+
+u32 Random(u32 max) // [0, max]
+{
+    return std::uniform_int_distribution<u32>(0, max)(rng);
+}
+
+struct TestCase
+{
+    std::vector<u8> code; // source, padded to the size of the code buffer
+    std::vector<u8> patch;
+};
+
+// Source data with repeated blocks, for SourceCopy and TargetCopy to have something to find
+std::vector<u8> MakeCode(u32 size)
+{
+    std::vector<u8> code(size);
+    for(u32 i = 0; i < size; i++)
+        code[i] = (i >= 64 && Random(3) == 0) ? code[i - 64] : u8(Random(255));
+    return code;
+}
+
+u32 RandomLength(u32 remaining)
+{
+    const u32 max = Random(7) == 0 ? 0x1000 : (Random(1) == 0 ? 8 : 0x100);
+    return 1 + Random(std::min(remaining, max) - 1);
+}
+
+TestCase MakeTestCase()
+{
+    TestCase test;
+    const u32 codeSize = 1 + Random(Random(3) == 0 ? 0x20000 : 0x2000);
+    const u32 sourceSize = Random(codeSize);
+    const u32 targetSize = 1 + Random(codeSize - 1);
+
+    test.code = MakeCode(codeSize);
+
+    PatchBuilder patch{sourceSize, targetSize};
+    u32 output = 0;
+    s64 sourceRelative = 0, targetRelative = 0;
+
+    while(output < targetSize)
+    {
+        const u32 length = RandomLength(targetSize - output);
+        s64 offset;
+
+        switch(Random(3))
+        {
+        case 0:
+            patch.Command(0, length);
+            break;
+        case 1:
+        {
+            std::vector<u8> bytes(length);
+            for(u8 &b : bytes)
+                b = u8(Random(255));
+            patch.Command(1, length);
+            patch.Bytes(bytes.data(), length);
+            break;
+        }
+        case 2:
+            switch(Random(3))
+            {
+            case 0: // already overwritten by the target
+                offset = output >= length ? Random(output - length) : Random(codeSize - length);
+                break;
+            case 1: // straddling the output offset
+                offset = std::min<s64>(std::max<s64>(s64(output) - Random(length), 0), codeSize - length);
+                break;
+            case 2: // right after the previous one
+                offset = std::min<s64>(sourceRelative, codeSize - length);
+                break;
+            default: // anywhere
+                offset = Random(codeSize - length);
+                break;
+            }
+            patch.Command(2, length);
+            patch.Offset(offset - sourceRelative);
+            sourceRelative = offset + length;
+            break;
+        default:
+            if(output == 0 || Random(7) == 0)
+                offset = output + Random(codeSize - length - output); // not written yet: zeroes
+            else
+            {
+                switch(Random(2))
+                {
+                case 0: // run-length fill of the previous byte
+                    offset = output - 1;
+                    break;
+                case 1: // repeated pattern, overlapping the output when shorter than the copy
+                    offset = output - 1 - Random(std::min(output - 1, 15u));
+                    break;
+                default: // anything written before
+                    offset = Random(output - 1);
+                    break;
+                }
+            }
+            patch.Command(3, length);
+            patch.Offset(offset - targetRelative);
+            targetRelative = offset + length;
+            break;
+        }
+
+        output += length;
+    }
+
+    const u32 sourceCrc = reference::Bps::crc32(test.code.data(), sourceSize);
+    test.patch = patch.Finish(sourceCrc, 0);
+
+    // The reference gives the target, from which the patch gets its actual target checksum
+    std::vector<u8> target(codeSize);
+    reference::Bps::PatchApplier applier{{test.code.data(), codeSize}, {target.data(), codeSize},
+                                         {test.patch.data(), test.patch.size()}};
+    applier.Apply();
+    const u32 targetCrc = reference::Bps::crc32(target.data(), targetSize);
+    test.patch = patch.SetFooter(sourceCrc, targetCrc);
+
+    // Corrupted patches, which both appliers have to reject. Random bytes aren't used: the reference reads out of
+    // bounds on offsets moved before the start of the buffer (see TestInvalidPatches)
+    switch(Random(15))
+    {
+    case 0: // not the expected code
+        test.code[Random(sourceSize == 0 ? codeSize - 1 : sourceSize - 1)] ^= u8(1 + Random(254));
+        if(sourceSize == 0)
+            test.patch = patch.SetFooter(sourceCrc ^ 1, targetCrc);
+        break;
+    case 1:
+        test.patch = patch.SetFooter(sourceCrc, targetCrc ^ (1u << Random(31)));
+        break;
+    default:
+        break;
+    }
+
+    return test;
+}
+
+std::string PatchPath()
+{
+    char path[] = "/luma/titles/0000000000000000/code.bps";
+    progIdToStr(path + 28, TestProgId);
+    return path;
+}
+
+bool ApplyReference(const std::vector<u8> &code, const std::vector<u8> &patch, std::vector<u8> &target)
+{
+    target.assign(code.size(), 0xCC);
+    reference::Bps::PatchApplier applier{{code.data(), code.size()}, {target.data(), target.size()},
+                                         {patch.data(), patch.size()}};
+    return applier.Apply();
+}
+
+void WritePatch(const std::vector<u8> &patch)
+{
+    FILE *f = fopen(hostFsGetPath(PatchPath().c_str()), "wb");
+    if(f == nullptr || fwrite(patch.data(), 1, patch.size(), f) != patch.size() || fclose(f) != 0)
+    {
+        perror("code.bps");
+        exit(1);
+    }
+}
+
+// Stops after the validation pass when prepareOnly is set
+bool ApplyInPlace(std::vector<u8> &code, const std::vector<u8> &patch, bool prepareOnly = false)
+{
+    WritePatch(patch);
+
+    util::File file;
+    if(!file.Open(PatchPath().c_str(), FS_OPEN_READ))
+        return false;
+
+    static u8 window[patcher::Bps::PatchStream::WindowSize];
+    static patcher::Bps::SourceBackup backup;
+
+    patcher::Bps::PatchApplier applier{{code.data(), code.size()}, {file, patch.size(), window}, backup};
+    if(!applier.Prepare())
+        return false;
+    if(prepareOnly)
+        return true;
+
+    std::vector<u8> storage(applier.BackupSize());
+    return applier.Apply(storage.data());
+}
+
+// Invalid patches, some of which the reference doesn't catch (offsets moved before the start of the buffer, read
+// past the end of the code) or doesn't handle (truncated footer). The validation pass has to reject them: the
+// target checksum would hide reads out of bounds, and the code must be left untouched
+bool TestInvalidPatches()
+{
+    const std::vector<u8> code = MakeCode(0x100);
+    const u32 sourceCrc = reference::Bps::crc32(code.data(), code.size());
+    std::vector<std::pair<const char *, std::vector<u8>>> patches;
+
+    for(u32 command : {2u, 3u})
+    {
+        for(s64 offset : {s64(-2), s64(0x100 - 0x10 + 1), s64(0x7FFFFFFF)})
+        {
+            PatchBuilder patch{0x100, 0x100};
+            patch.Command(0, 0x10);
+            patch.Command(command, 0x10);
+            patch.Offset(offset);
+            patch.Command(0, 0x100 - 0x20);
+            patches.emplace_back(command == 2 ? "SourceCopy out of range" : "TargetCopy out of range",
+                                 patch.Finish(sourceCrc, 0));
+        }
+    }
+
+    PatchBuilder tooLong{0x100, 0x100};
+    tooLong.Command(0, 0x100);
+    tooLong.Command(1, 1);
+    tooLong.Bytes(code.data(), 1);
+    patches.emplace_back("Command past the end of the code", tooLong.Finish(sourceCrc, 0));
+
+    PatchBuilder tooLarge{0x101, 0x100};
+    tooLarge.Command(0, 0x100);
+    patches.emplace_back("Source larger than the code", tooLarge.Finish(sourceCrc, 0));
+
+    PatchBuilder truncated{0x100, 0x100};
+    truncated.Command(0, 0x100);
+    std::vector<u8> data = truncated.Finish(sourceCrc, reference::Bps::crc32(code.data(), code.size()));
+    data.resize(7 + 4);
+    patches.emplace_back("Truncated footer", data);
+
+    bool ok = true;
+    for(const auto &[description, patch] : patches)
+    {
+        std::vector<u8> buffer = code;
+        if(ApplyInPlace(buffer, patch, true) || buffer != code)
+        {
+            printf("FAIL: %s: accepted\n", description);
+            ok = false;
+        }
+    }
+    return ok;
+}
+}  // namespace
+
+int main(int argc, char *argv[])
+{
+    const u32 nbTests = argc > 1 ? u32(strtoul(argv[1], nullptr, 0)) : 2000;
+
+    char root[] = "/tmp/bps_inplace_test.XXXXXX";
+    if(mkdtemp(root) == nullptr)
+    {
+        perror("mkdtemp");
+        return 1;
+    }
+    hostFsSetRoot(root);
+    for(const char *dir : {"/luma", "/luma/titles", "/luma/titles/0004000000BEEF00"})
+        mkdir(hostFsGetPath(dir), 0755);
+
+    u32 nbFailures = 0, nbAccepted = 0;
+    for(u32 i = 0; i < nbTests; i++)
+    {
+        TestCase test = MakeTestCase();
+        std::vector<u8> expected, actual = test.code;
+
+        const bool expectedOk = ApplyReference(test.code, test.patch, expected);
+        bool actualOk;
+        if(expectedOk && i % 16 == 0)
+        {
+            WritePatch(test.patch);
+            actualOk = patcherApplyCodeBpsPatch(TestProgId, actual.data(), actual.size()); // panics on failure
+        }
+        else
+            actualOk = ApplyInPlace(actual, test.patch);
+
+        if(actualOk != expectedOk || (expectedOk && actual != expected))
+        {
+            printf("FAIL: patch %lu (%zu bytes of code, %zu bytes of patch): reference %s, in place %s\n",
+                   (unsigned long)i, test.code.size(), test.patch.size(), expectedOk ? "ok" : "failed",
+                   actualOk ? (actual == expected ? "ok" : "ok but different") : "failed");
+            nbFailures++;
+        }
+        nbAccepted += expectedOk;
+    }
+
+    if(!TestInvalidPatches())
+        nbFailures++;
+
+    unlink(hostFsGetPath(PatchPath().c_str()));
+    for(const char *dir : {"/luma/titles/0004000000BEEF00", "/luma/titles", "/luma"})
+        rmdir(hostFsGetPath(dir));
+    rmdir(root);
+
+    if(nbFailures != 0)
+        return 1;
+
+    printf("bps_inplace_test: OK (%lu patches, %lu applied, %lu rejected)\n", (unsigned long)nbTests,
+           (unsigned long)nbAccepted, (unsigned long)(nbTests - nbAccepted));
+    return 0;
+}
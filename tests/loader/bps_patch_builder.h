@@ -0,0 +1,64 @@
+/*
+    Writes BPS patches command by command, for the tests and benchmarks of the loader's applier.
+*/
+
+#pragma once
+
+#include <cstring>
+#include <vector>
+
+#include "bps_reference.h"
+
+class PatchBuilder
+{
+public:
+    explicit PatchBuilder(u32 sourceSize, u32 targetSize)
+    {
+        m_data.insert(m_data.end(), {'B', 'P', 'S', '1'});
+        Number(sourceSize);
+        Number(targetSize);
+        Number(0); // no metadata
+    }
+
+    void Number(u32 n)
+    {
+        while(true)
+        {
+            const u8 x = n & 0x7F;
+            n >>= 7;
+            if(n == 0)
+            {
+                m_data.push_back(0x80 | x);
+                break;
+            }
+            m_data.push_back(x);
+            n--;
+        }
+    }
+
+    void Command(u32 command, u32 length) { Number(((length - 1) << 2) | command); }
+    void Offset(s64 delta) { Number(u32(((delta < 0 ? -delta : delta) << 1) | (delta < 0 ? 1 : 0))); }
+    void Bytes(const u8 *data, u32 length) { m_data.insert(m_data.end(), data, data + length); }
+
+    const std::vector<u8> &Finish(u32 sourceCrc, u32 targetCrc)
+    {
+        for(u32 crc : {sourceCrc, targetCrc, 0u})
+            m_data.insert(m_data.end(), reinterpret_cast<const u8 *>(&crc), reinterpret_cast<const u8 *>(&crc) + 4);
+        SetFooter(sourceCrc, targetCrc);
+        return m_data;
+    }
+
+    // Rewrites the checksums of a finished patch, the patch's own one being kept valid
+    const std::vector<u8> &SetFooter(u32 sourceCrc, u32 targetCrc)
+    {
+        u8 *footer = m_data.data() + m_data.size() - 12;
+        std::memcpy(footer, &sourceCrc, 4);
+        std::memcpy(footer + 4, &targetCrc, 4);
+        const u32 patchCrc = reference::Bps::crc32(m_data.data(), m_data.size() - 4);
+        std::memcpy(footer + 8, &patchCrc, 4);
+        return m_data;
+    }
+
+private:
+    std::vector<u8> m_data;
+};
@@ -0,0 +1,287 @@
+/*
+    Test of the loader's buffered IPS applier (applyCodeIpsPatch in sysmodules/loader/source/patcher.c) against
+    the record by record one it replaced, kept below as it was: both have to succeed or fail on the same patches
+    and, on success, leave the same code. Random patches mix plain and RLE records of all sizes, payloads larger
+    than the read buffer, records straddling its end, out of range, truncated or unterminated patches.
+
+    Usage: ips_test [code.ips...]
+
+    IPS files given on the command line (e.g. a corpus of real ones) are applied to a 16MB random code section,
+    the IPS offsets being 24-bit, and the time both appliers take is reported.
+*/
+
+#include <sys/stat.h>
+#include <unistd.h>
+#include "bench.h"
+#include "host_ctru.h"
+#include "patcher.c"
+
+u32 config, multiConfig, bootConfig;
+bool isN3DS, isSdMode = true;
+
+const u32 romfsRedirPatchSize = 0x140;
+
+#define TEST_PROGID     0x0004000000BEEF00ULL
+#define IPS_PATH        "/luma/titles/0004000000BEEF00/code.ips"
+#define MAX_CODE_SIZE   (0x1000000 + 0x10000)
+
+// The previous applier, a few IFile_Read per record
+static bool applyCodeIpsPatchReference(u64 progId, u8 *code, u32 size)
+{
+    /* Here we look for "/luma/titles/[u64 titleID in hex, uppercase]/code.ips"
+       If it exists it should be an IPS format patch */
+
+    char path[] = "/luma/titles/0000000000000000/code.ips";
+    progIdToStr(path + 28, progId);
+
+    IFile file;
+
+    if(!openLumaFile(&file, path)) return true;
+
+    bool ret = false;
+    u8 buffer[5];
+    u64 total;
+
+    if(R_FAILED(IFile_Read(&file, &total, buffer, 5)) || total != 5 || memcmp(buffer, "PATCH", 5) != 0) goto exit;
+
+    while(R_SUCCEEDED(IFile_Read(&file, &total, buffer, 3)) && total == 3)
+    {
+        if(memcmp(buffer, "EOF", 3) == 0)
+        {
+            ret = true;
+            break;
+        }
+
+        u32 offset = (buffer[0] << 16) | (buffer[1] << 8) | buffer[2];
+
+        if(R_FAILED(IFile_Read(&file, &total, buffer, 2)) || total != 2) break;
+
+        u32 patchSize = (buffer[0] << 8) | buffer[1];
+
+        if(!patchSize)
+        {
+            if(R_FAILED(IFile_Read(&file, &total, buffer, 2)) || total != 2) break;
+
+            u32 rleSize = (buffer[0] << 8) | buffer[1];
+
+            if(offset + rleSize > size) break;
+
+            if(R_FAILED(IFile_Read(&file, &total, buffer, 1)) || total != 1) break;
+
+            for(u32 i = 0; i < rleSize; i++)
+                code[offset + i] = buffer[0];
+
+            continue;
+        }
+
+        if(offset + patchSize > size) break;
+
+        if(R_FAILED(IFile_Read(&file, &total, code + offset, patchSize)) || total != patchSize) break;
+    }
+
+exit:
+    IFile_Close(&file);
+
+    return ret;
+}
+
+static u32 rngState = 1;
+
+static u32 randomU32(u32 max) // [0, max]
+{
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return max == 0xFFFFFFFF ? rngState : rngState % (max + 1);
+}
+
+typedef struct IpsBuilder
+{
+    u8 *data;
+    u32 size;
+} IpsBuilder;
+
+static void ipsPut(IpsBuilder *ips, const void *data, u32 size)
+{
+    memcpy(ips->data + ips->size, data, size);
+    ips->size += size;
+}
+
+static void ipsPutBE(IpsBuilder *ips, u32 value, u32 size)
+{
+    for(u32 i = 0; i < size; i++)
+        ips->data[ips->size++] = (u8)(value >> (8 * (size - 1 - i)));
+}
+
+// Random patch for a code section of the given size, in a buffer large enough for 64 maximal records
+static void makeIps(IpsBuilder *ips, u32 codeSize)
+{
+    u32 nbRecords = randomU32(3) == 0 ? randomU32(2000) : randomU32(64);
+
+    ips->size = 0;
+    ipsPut(ips, "PATCH", 5);
+
+    for(u32 i = 0; i < nbRecords && ips->size < 64 * 0x10008; i++)
+    {
+        u32 length = randomU32(7) == 0 ? 1 + randomU32(0xFFFF) : 1 + randomU32(randomU32(1) ? 0x20 : 0x400),
+            offset;
+
+        if(length > codeSize) length = codeSize;
+        offset = randomU32(codeSize - length);
+        if(randomU32(255) == 0) offset += codeSize - length + 1; // out of range
+        if(offset == 0x454F46) offset--; // would read as "EOF"
+
+        ipsPutBE(ips, offset, 3);
+        if(randomU32(3) == 0)
+        {
+            ipsPutBE(ips, 0, 2);
+            ipsPutBE(ips, length, 2);
+            ipsPutBE(ips, randomU32(255), 1);
+        }
+        else
+        {
+            ipsPutBE(ips, length, 2);
+            benchFillRandom(ips->data + ips->size, length, randomU32(0xFFFFFFFF));
+            ips->size += length;
+        }
+    }
+
+    switch(randomU32(15))
+    {
+        case 0: // unterminated
+            break;
+        case 1: // truncated
+            ips->size = randomU32(ips->size);
+            break;
+        case 2: // trailing data
+            ipsPut(ips, "EOF", 3);
+            ipsPutBE(ips, randomU32(0xFFFFFF), 3);
+            break;
+        default:
+            ipsPut(ips, "EOF", 3);
+            break;
+    }
+}
+
+static void writeIps(const u8 *data, u32 size)
+{
+    FILE *f = fopen(hostFsGetPath(IPS_PATH), "wb");
+
+    if(f == NULL || fwrite(data, 1, size, f) != size || fclose(f) != 0)
+    {
+        perror("code.ips");
+        exit(1);
+    }
+}
+
+static u32 nbApplied;
+
+// Applies the code.ips written last with both, the code being restored from source every time
+static bool compare(const char *name, const u8 *source, u8 *expected, u8 *actual, u32 codeSize, bool timed)
+{
+    u64 referenceNs = 0, bufferedNs = 0;
+    bool expectedOk = false, actualOk = false;
+
+    if(timed)
+    {
+        referenceNs = BENCH_BEST_NS(5, memcpy(expected, source, codeSize); expectedOk = applyCodeIpsPatchReference(TEST_PROGID, expected, codeSize));
+        bufferedNs = BENCH_BEST_NS(5, memcpy(actual, source, codeSize); actualOk = applyCodeIpsPatch(TEST_PROGID, actual, codeSize));
+    }
+    else
+    {
+        memcpy(expected, source, codeSize);
+        memcpy(actual, source, codeSize);
+        expectedOk = applyCodeIpsPatchReference(TEST_PROGID, expected, codeSize);
+        actualOk = applyCodeIpsPatch(TEST_PROGID, actual, codeSize);
+    }
+
+    // On failure, the loader panics: whatever was written doesn't matter
+    if(expectedOk != actualOk || (expectedOk && memcmp(expected, actual, codeSize) != 0))
+    {
+        printf("FAIL: %s (%lu bytes of code): reference %s, buffered %s\n", name, (unsigned long)codeSize,
+               expectedOk ? "ok" : "failed", actualOk ? (expectedOk ? "ok but different" : "ok") : "failed");
+        return false;
+    }
+
+    nbApplied += expectedOk;
+    if(timed)
+        printf("  %s: %s, reference %8.3f ms, buffered %8.3f ms (x%.1f)\n", name, expectedOk ? "applied" : "rejected",
+               referenceNs / 1e6, bufferedNs / 1e6, (double)referenceNs / bufferedNs);
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    u32 nbFailures = 0, nbTests = 500;
+    char root[] = "/tmp/ips_test.XXXXXX";
+
+    if(mkdtemp(root) == NULL)
+    {
+        perror("mkdtemp");
+        return 1;
+    }
+    hostFsSetRoot(root);
+    mkdir(hostFsGetPath("/luma"), 0755);
+    mkdir(hostFsGetPath("/luma/titles"), 0755);
+    mkdir(hostFsGetPath("/luma/titles/0004000000BEEF00"), 0755);
+
+    u8 *source = (u8 *)benchAlloc32(MAX_CODE_SIZE),
+       *expected = (u8 *)benchAlloc32(MAX_CODE_SIZE),
+       *actual = (u8 *)benchAlloc32(MAX_CODE_SIZE);
+    IpsBuilder ips = { (u8 *)benchAlloc32(64 * 0x10008 + 0x10000), 0 };
+
+    benchFillRandom(source, MAX_CODE_SIZE, 0x3D5);
+
+    for(u32 i = 0; i < nbTests; i++)
+    {
+        char name[32];
+        u32 codeSize = 1 + randomU32(randomU32(3) == 0 ? 0x100000 : 0x10000);
+
+        makeIps(&ips, codeSize);
+        writeIps(ips.data, ips.size);
+        sprintf(name, "patch %lu", (unsigned long)i);
+        if(!compare(name, source, expected, actual, codeSize, false))
+            nbFailures++;
+    }
+
+    // No code.ips: nothing to do
+    unlink(hostFsGetPath(IPS_PATH));
+    if(!applyCodeIpsPatch(TEST_PROGID, actual, 0x1000))
+    {
+        printf("FAIL: missing code.ips\n");
+        nbFailures++;
+    }
+
+    if(argc > 1)
+        printf("ips_test: %d IPS file(s), %lu bytes of code\n", argc - 1, (unsigned long)MAX_CODE_SIZE);
+
+    for(int i = 1; i < argc; i++)
+    {
+        u32 size;
+        u8 *data = benchReadFile(argv[i], &size);
+
+        if(data == NULL)
+        {
+            perror(argv[i]);
+            nbFailures++;
+            continue;
+        }
+
+        writeIps(data, size);
+        munmap(data, size > 0 ? size : 1);
+        if(!compare(argv[i], source, expected, actual, MAX_CODE_SIZE, true))
+            nbFailures++;
+    }
+
+    unlink(hostFsGetPath(IPS_PATH));
+    rmdir(hostFsGetPath("/luma/titles/0004000000BEEF00"));
+    rmdir(hostFsGetPath("/luma/titles"));
+    rmdir(hostFsGetPath("/luma"));
+    rmdir(root);
+
+    if(nbFailures != 0)
+        return 1;
+
+    printf("ips_test: OK (%lu random patches, %lu applied)\n", (unsigned long)nbTests, (unsigned long)nbApplied);
+    return 0;
+}
@@ -0,0 +1,263 @@
+/*
+    ExeFS .code compression for the tests and benchmarks of the loader's decoder (lzss_decompress in
+    sysmodules/loader/source/loader.c), along with the decoder it replaced.
+
+    The format is decoded backwards and in place: the buffer holds an uncompressed prefix, then the compressed
+    data, read from its end, then a footer: u32 (compressed size | (footer size << 24)), u32 additional size, the
+    decompressed data ending that many bytes past the end of the buffer. A flag byte precedes (in reading order)
+    each group of 8 tokens, its most significant bit first: 0 for a literal byte, 1 for a back-reference of 2
+    bytes, (count - 3) << 12 | (distance - 3), read from its high byte, copying from higher addresses.
+*/
+
+#pragma once
+
+#include <stdlib.h>
+#include <string.h>
+#include <3ds/types.h>
+
+#define LZSS_MIN_COUNT      3
+#define LZSS_MAX_COUNT      (0xF + 3)
+#define LZSS_MIN_DISTANCE   3
+#define LZSS_MAX_DISTANCE   (0xFFF + 3)
+#define LZSS_FOOTER_SIZE    8
+
+// The decoder the loader used before, as it was decompiled. Only the negated unsigned offsets of v3 and v4 are
+// written as subtractions: they relied on pointers being 32-bit
+static int lzss_decompress_reference(u8 *end)
+{
+    unsigned int v1; // r1@2
+    u8 *v2; // r2@2
+    u8 *v3; // r3@2
+    u8 *v4; // r1@2
+    char v5; // r5@4
+    char v6; // t1@4
+    signed int v7; // r6@4
+    int v9; // t1@7
+    u8 *v11; // r3@8
+    int v12; // r12@8
+    int v13; // t1@8
+    int v14; // t1@8
+    unsigned int v15; // r7@8
+    int v16; // r12@8
+    int ret;
+
+    ret = 0;
+    if ( end )
+    {
+        v1 = *((u32 *)end - 2);
+        v2 = &end[*((u32 *)end - 1)];
+        v3 = end - (v1 >> 24);
+        v4 = end - (v1 & 0xFFFFFF);
+        while ( v3 > v4 )
+        {
+            v6 = *(v3-- - 1);
+            v5 = v6;
+            v7 = 8;
+            while ( 1 )
+            {
+                if ( (v7-- < 1) )
+                    break;
+                if ( v5 & 0x80 )
+                {
+                    v13 = *(v3 - 1);
+                    v11 = v3 - 1;
+                    v12 = v13;
+                    v14 = *(v11 - 1);
+                    v3 = v11 - 1;
+                    v15 = ((v14 | (v12 << 8)) & 0xFFFF0FFF) + 2;
+                    v16 = v12 + 32;
+                    do
+                    {
+                        ret = v2[v15];
+                        *(v2-- - 1) = ret;
+                        v16 -= 16;
+                    }
+                    while ( !(v16 < 0) );
+                }
+                else
+                {
+                    v9 = *(v3-- - 1);
+                    ret = v9;
+                    *(v2-- - 1) = v9;
+                }
+                v5 *= 2;
+                if ( v3 <= v4 )
+                    return ret;
+            }
+        }
+    }
+    return ret;
+}
+
+typedef struct LzssToken
+{
+    u32 count; // 0 for a literal
+    u32 distance;
+} LzssToken;
+
+// Matches are looked for in data read backwards (r[i] = data[size - 1 - i]), through hash chains over 3 bytes
+#define LZSS_HASH_BITS  14
+#define LZSS_MAX_CHAIN  64
+
+static inline u32 lzssHash(const u8 *data, u32 size, u32 i)
+{
+    u32 a = data[size - 1 - i], b = data[size - 2 - i], c = data[size - 3 - i];
+    return ((a << 16 | b << 8 | c) * 2654435761u) >> (32 - LZSS_HASH_BITS);
+}
+
+// Tokens for data, read from its end: each covers the bytes preceding the previous one. Returns their number
+static u32 lzssTokenize(const u8 *data, u32 size, LzssToken *tokens)
+{
+    s32 *head = (s32 *)malloc(sizeof(s32) << LZSS_HASH_BITS), *prev = (s32 *)malloc(sizeof(s32) * (size + 1));
+    u32 nbTokens = 0;
+
+    memset(head, 0xFF, sizeof(s32) << LZSS_HASH_BITS);
+
+    for(u32 i = 0; i < size;)
+    {
+        u32 bestCount = 0, bestDistance = 0;
+
+        if(i + LZSS_MIN_COUNT <= size)
+        {
+            u32 h = lzssHash(data, size, i);
+            s32 candidate = head[h];
+
+            for(u32 chain = 0; candidate >= 0 && chain < LZSS_MAX_CHAIN; chain++, candidate = prev[candidate])
+            {
+                u32 distance = i - (u32)candidate, count = 0;
+
+                if(distance > LZSS_MAX_DISTANCE)
+                    break;
+                if(distance < LZSS_MIN_DISTANCE)
+                    continue;
+
+                // Overlapping the bytes being produced is fine, they're copied one at a time
+                while(count < LZSS_MAX_COUNT && i + count < size && data[size - 1 - i - count] == data[size - 1 - i - count + distance])
+                    count++;
+                if(count > bestCount)
+                {
+                    bestCount = count;
+                    bestDistance = distance;
+                }
+            }
+        }
+
+        u32 advance = bestCount >= LZSS_MIN_COUNT ? bestCount : 1;
+
+        tokens[nbTokens].count = advance == 1 ? 0 : bestCount;
+        tokens[nbTokens++].distance = bestDistance;
+
+        for(u32 end = i + advance; i < end; i++)
+        {
+            if(i + LZSS_MIN_COUNT <= size)
+            {
+                u32 h = lzssHash(data, size, i);
+                prev[i] = head[h];
+                head[h] = (s32)i;
+            }
+        }
+    }
+
+    free(head);
+    free(prev);
+    return nbTokens;
+}
+
+// Compressed stream of tokens, in reading order. Returns its size
+static u32 lzssEncodeTokens(const u8 *data, u32 size, const LzssToken *tokens, u32 nbTokens, u8 *stream)
+{
+    u32 pos = 0, consumed = 0, flagsPos = 0;
+
+    for(u32 t = 0; t < nbTokens; t++)
+    {
+        if(t % 8 == 0)
+        {
+            flagsPos = pos++;
+            stream[flagsPos] = 0;
+        }
+
+        if(tokens[t].count == 0)
+        {
+            stream[pos++] = data[size - 1 - consumed];
+            consumed++;
+        }
+        else
+        {
+            u32 value = (tokens[t].count - LZSS_MIN_COUNT) << 12 | (tokens[t].distance - LZSS_MIN_DISTANCE);
+
+            stream[flagsPos] |= 0x80 >> (t % 8);
+            stream[pos++] = (u8)(value >> 8);
+            stream[pos++] = (u8)value;
+            consumed += tokens[t].count;
+        }
+    }
+
+    return pos;
+}
+
+// Checks that decoding in place never overwrites bytes that haven't been read, for a compressed stream ending
+// "slack" bytes (additional size + footer size) below the end of the decompressed data
+static bool lzssFitsInPlace(const LzssToken *tokens, u32 nbTokens, u32 slack)
+{
+    u32 read = 0, written = 0;
+
+    for(u32 t = 0; t < nbTokens; t++)
+    {
+        read += (t % 8 == 0) + (tokens[t].count == 0 ? 1 : 2);
+        written += tokens[t].count == 0 ? 1 : tokens[t].count;
+
+        // What's been written has to stay above what's left to read
+        if(written > read + slack)
+            return false;
+    }
+
+    return true;
+}
+
+/*
+    Writes data to buf (which must hold size bytes) as .code is stored: the first prefix bytes uncompressed, then the
+    rest as the given tokens. Returns the end of the compressed data, to be given to the decoder, or NULL if it
+    doesn't get smaller or can't be decoded in place.
+*/
+static u8 *lzssLayout(const u8 *data, u32 size, u32 prefix, const LzssToken *tokens, u32 nbTokens, u8 *buf)
+{
+    u8 *stream = (u8 *)malloc(size + size / 8 + 16), *end = NULL;
+    u32 streamSize = lzssEncodeTokens(data + prefix, size - prefix, tokens, nbTokens, stream),
+        footerSize = LZSS_FOOTER_SIZE + ((4 - ((prefix + streamSize) & 3)) & 3); // keeps the footer aligned
+
+    if(prefix + streamSize + footerSize < size)
+    {
+        u32 additional = size - (prefix + streamSize + footerSize);
+
+        if(lzssFitsInPlace(tokens, nbTokens, additional + footerSize))
+        {
+            memcpy(buf, data, prefix);
+            for(u32 i = 0; i < streamSize; i++)
+                buf[prefix + streamSize - 1 - i] = stream[i];
+            memset(buf + prefix + streamSize, 0, footerSize - LZSS_FOOTER_SIZE);
+
+            end = buf + prefix + streamSize + footerSize;
+            u32 footer[2] = { (streamSize + footerSize) | (footerSize << 24), additional };
+            memcpy(end - LZSS_FOOTER_SIZE, footer, LZSS_FOOTER_SIZE);
+        }
+    }
+
+    free(stream);
+    return end;
+}
+
+// Compresses data to buf, the first bytes being left uncompressed when needed. Returns NULL if it doesn't compress
+static u8 *lzssCompress(const u8 *data, u32 size, u8 *buf)
+{
+    LzssToken *tokens = (LzssToken *)malloc(sizeof(LzssToken) * (size + 1));
+    u8 *end = NULL;
+
+    for(u32 prefix = 0; end == NULL && prefix < size; prefix += prefix == 0 ? 16 : prefix)
+    {
+        u32 nbTokens = lzssTokenize(data + prefix, size - prefix, tokens);
+        end = lzssLayout(data, size, prefix, tokens, nbTokens, buf);
+    }
+
+    free(tokens);
+    return end;
+}
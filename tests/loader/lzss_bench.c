@@ -0,0 +1,123 @@
+/*
+    Throughput of the loader's LZSS decoder (lzss_decompress in sysmodules/loader/source/loader.c) against the
+    decompiled one it replaced, in MB/s of decompressed code.
+
+    Usage: lzss_bench [code...]
+
+    Each file is a compressed ExeFS .code, as stored (footer at its end). Without arguments, 4MB of code-like data
+    (words from a small dictionary, runs, repeated blocks and some noise) are compressed first.
+*/
+
+#include "bench.h"
+#include "lzss.h"
+#include "loader.c"
+
+u32 config, multiConfig, bootConfig;
+bool isN3DS, isSdMode;
+
+static void makeCodeLikeData(u8 *data, u32 size)
+{
+    u32 words[64], seed = 0x3D5;
+
+    benchFillRandom(words, sizeof(words), 0x1234);
+    for(u32 i = 0; i < size;)
+    {
+        u32 length, kind;
+
+        benchFillRandom(&seed, 4, seed);
+        length = 4 + seed % 256;
+        kind = (seed >> 8) % 8;
+        if(length > size - i)
+            length = size - i;
+
+        if(kind == 0)
+            benchFillRandom(data + i, length, seed);
+        else if(kind == 1)
+            memset(data + i, 0, length);
+        else if(kind <= 3 && i >= 0x1000)
+            memcpy(data + i, data + i - 0x1000 + (seed >> 16) % 0x800, length);
+        else
+        {
+            for(u32 j = 0; j < length; j++)
+                data[i + j] = (u8)(words[((i + j) / 4 + (seed >> 16)) % 64] >> (8 * ((i + j) % 4)));
+        }
+        i += length;
+    }
+}
+
+static bool bench(const char *name, const u8 *compressed, u32 compressedSize, u8 *work)
+{
+    u32 additional, size;
+    u8 *reference;
+
+    memcpy(&additional, compressed + compressedSize - 4, 4);
+    size = compressedSize + additional;
+    reference = (u8 *)malloc(size);
+
+    // Both decode from a fresh copy of the compressed code every time
+    memcpy(reference, compressed, compressedSize);
+    lzss_decompress_reference(reference + compressedSize);
+    u64 referenceNs = BENCH_BEST_NS(10, memcpy(work, compressed, compressedSize); lzss_decompress_reference(work + compressedSize));
+    u64 newNs = BENCH_BEST_NS(10, memcpy(work, compressed, compressedSize); lzss_decompress(work + compressedSize));
+
+    bool ok = memcmp(work, reference, size) == 0;
+
+    free(reference);
+    if(!ok)
+    {
+        printf("FAIL: %s: the decoders disagree\n", name);
+        return false;
+    }
+
+    printf("  %s: %lu -> %lu bytes, reference %8.3f ms %7.1f MB/s, new %8.3f ms %7.1f MB/s (x%.1f)\n", name,
+           (unsigned long)compressedSize, (unsigned long)size, referenceNs / 1e6, benchMBps(size, referenceNs),
+           newNs / 1e6, benchMBps(size, newNs), (double)referenceNs / newNs);
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    printf("lzss_bench:\n");
+
+    if(argc == 1)
+    {
+        u32 size = 0x400000;
+        u8 *data = (u8 *)benchAlloc32(size), *compressed = (u8 *)benchAlloc32(size), *work = (u8 *)benchAlloc32(size);
+
+        makeCodeLikeData(data, size);
+        u8 *end = lzssCompress(data, size, compressed);
+
+        if(end == NULL)
+        {
+            printf("FAIL: the synthetic code doesn't compress\n");
+            return 1;
+        }
+
+        if(!bench("synthetic code", compressed, (u32)(end - compressed), work))
+            return 1;
+        if(memcmp(work, data, size) != 0)
+        {
+            printf("FAIL: synthetic code: wrong data\n");
+            return 1;
+        }
+        return 0;
+    }
+
+    for(int i = 1; i < argc; i++)
+    {
+        u32 compressedSize, additional;
+        u8 *compressed = benchReadFile(argv[i], &compressedSize);
+
+        if(compressed == NULL || compressedSize < LZSS_FOOTER_SIZE)
+        {
+            fprintf(stderr, "%s: not a compressed code\n", argv[i]);
+            return 1;
+        }
+
+        memcpy(&additional, compressed + compressedSize - 4, 4);
+        if(!bench(argv[i], compressed, compressedSize, (u8 *)benchAlloc32(compressedSize + additional)))
+            return 1;
+    }
+
+    return 0;
+}
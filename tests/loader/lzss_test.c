@@ -0,0 +1,183 @@
+/*
+    Test of the loader's LZSS decoder (lzss_decompress in sysmodules/loader/source/loader.c) against the decompiled
+    one it replaced: both decode the same streams in place, and have to produce the original data without writing
+    outside of the buffer. The streams come from compressing data of various kinds (runs, short periods, words
+    from a small dictionary like code, noise) and from random token sequences, which also have back-references
+    a compressor would not emit.
+
+    Usage: lzss_test [number of streams of each kind (default 300)]
+*/
+
+#include "bench.h"
+#include "lzss.h"
+#include "loader.c"
+
+u32 config, multiConfig, bootConfig;
+bool isN3DS, isSdMode;
+
+#define GUARD_SIZE  64
+#define GUARD_BYTE  0xA5
+
+static u32 rngState = 1;
+
+static u32 randomU32(u32 max) // [0, max]
+{
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return max == 0xFFFFFFFF ? rngState : rngState % (max + 1);
+}
+
+static void makeData(u8 *data, u32 size)
+{
+    u32 words[16];
+
+    for(u32 i = 0; i < 16; i++)
+        words[i] = randomU32(0xFFFFFFFF);
+
+    for(u32 i = 0; i < size;)
+    {
+        u32 length = 1 + randomU32(randomU32(3) == 0 ? 300 : 40), period = 1 + randomU32(randomU32(1) ? 3 : 40);
+
+        if(length > size - i)
+            length = size - i;
+
+        switch(randomU32(4))
+        {
+            case 0: // noise
+                benchFillRandom(data + i, length, randomU32(0xFFFFFFFF));
+                break;
+            case 1: // run
+                memset(data + i, (int)randomU32(255), length);
+                break;
+            case 2: // short period, including the ones below the smallest distance
+                for(u32 j = 0; j < length; j++)
+                    data[i + j] = j < period || i + j < period ? (u8)randomU32(255) : data[i + j - period];
+                break;
+            case 3: // code-like words
+                for(u32 j = 0; j < length; j++)
+                    data[i + j] = (u8)(words[(i + j) / 4 % 16 ^ randomU32(1)] >> (8 * ((i + j) % 4)));
+                break;
+            default: // copy of something earlier
+            {
+                u32 from = i == 0 ? 0 : randomU32(i - 1);
+
+                for(u32 j = 0; j < length; j++)
+                    data[i + j] = i == 0 ? (u8)randomU32(255) : data[from + j];
+                break;
+            }
+        }
+        i += length;
+    }
+}
+
+// Data following random tokens, which the in place layout may not accept. Returns the number of tokens
+static u32 makeRandomTokens(u8 *data, u32 size, LzssToken *tokens)
+{
+    u32 nbTokens = 0;
+
+    for(u32 i = 0; i < size; nbTokens++)
+    {
+        u32 maxCount = size - i < LZSS_MAX_COUNT ? size - i : LZSS_MAX_COUNT,
+            maxDistance = i < LZSS_MAX_DISTANCE ? i : LZSS_MAX_DISTANCE;
+
+        if(maxCount < LZSS_MIN_COUNT || maxDistance < LZSS_MIN_DISTANCE || randomU32(2) == 0)
+        {
+            data[size - 1 - i++] = (u8)randomU32(255);
+            tokens[nbTokens].count = 0;
+            continue;
+        }
+
+        u32 count = LZSS_MIN_COUNT + randomU32(maxCount - LZSS_MIN_COUNT),
+            distance = randomU32(1) ? LZSS_MIN_DISTANCE + randomU32(randomU32(1) ? 5 : maxDistance - LZSS_MIN_DISTANCE) : maxDistance;
+
+        if(distance > maxDistance)
+            distance = maxDistance;
+
+        tokens[nbTokens].count = count;
+        tokens[nbTokens].distance = distance;
+        for(u32 j = 0; j < count; j++, i++)
+            data[size - 1 - i] = data[size - 1 - i + distance];
+    }
+
+    return nbTokens;
+}
+
+// Decodes the stream of buf (size bytes, guard bytes on both sides) with both decoders
+static bool check(const char *kind, u32 index, const u8 *data, u32 size, const u8 *buf, u32 streamEnd, u8 *work)
+{
+    u8 *workBuf = work + GUARD_SIZE;
+    bool ok = true;
+
+    for(u32 decoder = 0; decoder < 2; decoder++)
+    {
+        memset(work, GUARD_BYTE, size + 2 * GUARD_SIZE);
+        memcpy(workBuf, buf, streamEnd);
+
+        if(decoder == 0)
+            lzss_decompress_reference(workBuf + streamEnd);
+        else
+            lzss_decompress(workBuf + streamEnd);
+
+        bool guardsOk = true;
+
+        for(u32 i = 0; i < GUARD_SIZE; i++)
+            guardsOk = guardsOk && work[i] == GUARD_BYTE && workBuf[size + i] == GUARD_BYTE;
+
+        if(!guardsOk || memcmp(workBuf, data, size) != 0)
+        {
+            printf("FAIL: %s stream %lu (%lu bytes): %s decoder: %s\n", kind, (unsigned long)index, (unsigned long)size,
+                   decoder == 0 ? "reference" : "new", guardsOk ? "wrong data" : "wrote outside of the buffer");
+            ok = false;
+        }
+    }
+
+    return ok;
+}
+
+int main(int argc, char *argv[])
+{
+    u32 nbStreams = argc > 1 ? (u32)strtoul(argv[1], NULL, 0) : 300, nbFailures = 0, nbCompressed = 0, nbRandom = 0;
+    u32 maxSize = 0x40000;
+    u8 *data = (u8 *)malloc(maxSize), *buf = (u8 *)malloc(maxSize), *work = (u8 *)malloc(maxSize + 2 * GUARD_SIZE);
+    LzssToken *tokens = (LzssToken *)malloc(sizeof(LzssToken) * maxSize);
+
+    for(u32 i = 0; i < nbStreams; i++)
+    {
+        u32 size = 16 + randomU32(randomU32(3) == 0 ? maxSize - 16 : 0x2000);
+        u8 *end;
+
+        makeData(data, size);
+        end = lzssCompress(data, size, buf);
+        if(end != NULL)
+        {
+            nbCompressed++;
+            if(!check("compressed", i, data, size, buf, (u32)(end - buf), work))
+                nbFailures++;
+        }
+
+        size = 16 + randomU32(0x2000);
+        u32 nbTokens = makeRandomTokens(data, size, tokens);
+
+        // Without a prefix: an uncompressed start is already covered above
+        end = lzssLayout(data, size, 0, tokens, nbTokens, buf);
+        if(end != NULL)
+        {
+            nbRandom++;
+            if(!check("random tokens", i, data, size, buf, (u32)(end - buf), work))
+                nbFailures++;
+        }
+    }
+
+    free(data);
+    free(buf);
+    free(work);
+    free(tokens);
+
+    if(nbFailures != 0)
+        return 1;
+
+    printf("lzss_test: OK (%lu compressed streams, %lu random token streams)\n", (unsigned long)nbCompressed,
+           (unsigned long)nbRandom);
+    return 0;
+}
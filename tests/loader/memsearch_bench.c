@@ -0,0 +1,168 @@
+/*
+    Pattern scans patchCode (sysmodules/loader/source/patcher.c) runs at title launch: one memsearch per pattern
+    as it used to, against a single memsearchMulti pass. The pattern sets are those of the titles concerned,
+    the positions found by both have to be the same.
+
+    Usage: memsearch_bench [code.bin textSize]...
+
+    Each code.bin (decompressed, textSize from its exheader, hexadecimal allowed) is scanned with every pattern
+    set: with a real title, the sets not meant for it give the cost of a full scan. Without arguments, random data
+    stands for a 3MB code section, all .text, with each pattern placed once in its last quarter, except for the update RomFS mount
+    names: only the last one, "rom:", is, which is what the previous code scanned the most for.
+*/
+
+#include "bench.h"
+#include "patcher.c"
+
+u32 config, multiConfig, bootConfig;
+bool isN3DS, isSdMode;
+
+const u32 romfsRedirPatchSize = 0x140;
+
+#define MAX_PATTERNS 8
+
+typedef struct PatternSet
+{
+    const char *name;
+    bool wholeCode; // scanned past .text
+    bool firstOnly; // only the first pattern found, in this order, matters
+    u32 count;
+    PatternSearch searches[MAX_PATTERNS];
+} PatternSet;
+
+// Copied from patchCode, where they are local to each title's case
+static const u8 flashcartPattern[] = { 0x10, 0xD1, 0xE5, 0x08, 0x00, 0x8D },
+                regionFreePattern[] = { 0x0A, 0x0C, 0x00, 0x10 },
+                roPattern[] = { 0x20, 0xA0, 0xE1, 0x8B },
+                roPattern2[] = { 0xE1, 0x30, 0x40, 0x2D },
+                roPattern3[] = { 0x2D, 0xE9, 0x01, 0x70 },
+                dlpPattern[] = { 0x0C, 0xAC, 0xC0, 0xD8 },
+                dlpPattern2[] = { 0x20, 0x82, 0xa8, 0x7e, 0x00, 0x28, 0x00, 0xd0, 0x01, 0x20, 0xa0, 0x77 };
+
+static u8 mountPatterns[UPDATE_ROMFS_MOUNT_COUNT - 1][7];
+
+static PatternSet patternSets[] = {
+    { "Home Menu", false, false, 2, { { flashcartPattern, sizeof(flashcartPattern), NULL }, { regionFreePattern, sizeof(regionFreePattern), NULL } } },
+    { "RO", false, false, 3, { { roPattern, sizeof(roPattern), NULL }, { roPattern2, sizeof(roPattern2), NULL }, { roPattern3, sizeof(roPattern3), NULL } } },
+    { "DLP", false, false, 2, { { dlpPattern, sizeof(dlpPattern), NULL }, { dlpPattern2, sizeof(dlpPattern2), NULL } } },
+    { "LayeredFS update mounts", true, true, UPDATE_ROMFS_MOUNT_COUNT - 1, { { NULL, 0, NULL } } },
+};
+
+#define PATTERN_SET_COUNT (sizeof(patternSets) / sizeof(PatternSet))
+
+static void initMountPatterns(void)
+{
+    PatternSet *set = &patternSets[PATTERN_SET_COUNT - 1];
+
+    // Mount names preceded by a null byte, as locateLayeredFs looks for them
+    for(u32 i = 0; i < set->count; i++)
+    {
+        u32 patternSize = strlen(updateRomFsMounts[i]);
+        mountPatterns[i][0] = 0;
+        memcpy(mountPatterns[i] + 1, updateRomFsMounts[i], patternSize);
+        set->searches[i].pattern = mountPatterns[i];
+        set->searches[i].patternSize = patternSize + 1;
+    }
+}
+
+// The previous code: one scan per pattern
+static void searchEach(u8 *code, u32 size, PatternSearch *searches, u32 count, bool firstOnly)
+{
+    u32 i;
+
+    for(i = 0; i < count; i++)
+    {
+        searches[i].found = memsearch(code, searches[i].pattern, size, searches[i].patternSize);
+        if(firstOnly && searches[i].found != NULL) break;
+    }
+
+    for(i++; i < count; i++)
+        searches[i].found = NULL;
+}
+
+static bool benchImage(const char *name, u8 *code, u32 size, u32 textSize)
+{
+    u64 totalEachNs = 0, totalMultiNs = 0;
+
+    printf("memsearch_bench: %s, %lu bytes (.text: %lu)\n", name, (unsigned long)size, (unsigned long)textSize);
+    for(u32 i = 0; i < PATTERN_SET_COUNT; i++)
+    {
+        PatternSet *set = &patternSets[i];
+        PatternSearch expected[MAX_PATTERNS];
+        u32 nbFound = 0, scanSize = set->wholeCode ? size : textSize;
+
+        memcpy(expected, set->searches, sizeof(expected));
+        u64 eachNs = BENCH_BEST_NS(20, searchEach(code, scanSize, expected, set->count, set->firstOnly));
+        u64 multiNs = BENCH_BEST_NS(20, memsearchMulti(code, scanSize, set->searches, set->count));
+
+        for(u32 j = 0; j < set->count; j++)
+        {
+            if(set->firstOnly && nbFound != 0)
+                break;
+            if(set->searches[j].found != expected[j].found)
+            {
+                printf("FAIL: %s, pattern %lu: found at %p instead of %p\n", set->name, (unsigned long)j,
+                       (void *)set->searches[j].found, (void *)expected[j].found);
+                return false;
+            }
+            nbFound += expected[j].found != NULL;
+        }
+
+        printf("  %-24s %lu/%lu found: memsearch each %8.3f ms, memsearchMulti %8.3f ms (x%.1f)\n", set->name,
+               (unsigned long)nbFound, (unsigned long)set->count, eachNs / 1e6, multiNs / 1e6, (double)eachNs / multiNs);
+        totalEachNs += eachNs;
+        totalMultiNs += multiNs;
+    }
+
+    printf("  %-24s              memsearch each %8.3f ms, memsearchMulti %8.3f ms (x%.1f)\n", "all", totalEachNs / 1e6,
+           totalMultiNs / 1e6, (double)totalEachNs / totalMultiNs);
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    if(argc % 2 == 0)
+    {
+        fprintf(stderr, "Usage: %s [code.bin textSize]...\n", argv[0]);
+        return 1;
+    }
+
+    initMountPatterns();
+
+    if(argc == 1)
+    {
+        u32 textSize = 0x300000;
+        u8 *code = (u8 *)benchAlloc32(textSize);
+        u32 pos = textSize - textSize / 4;
+
+        benchFillRandom(code, textSize, 0x3D5);
+        for(u32 i = 0; i < PATTERN_SET_COUNT; i++)
+        {
+            for(u32 j = patternSets[i].firstOnly ? patternSets[i].count - 1 : 0; j < patternSets[i].count; j++, pos += 0x2000)
+                memcpy(code + pos, patternSets[i].searches[j].pattern, patternSets[i].searches[j].patternSize);
+        }
+
+        return benchImage("random data", code, textSize, textSize) ? 0 : 1;
+    }
+
+    for(int i = 1; i < argc; i += 2)
+    {
+        u32 size, textSize = (u32)strtoul(argv[i + 1], NULL, 0);
+        u8 *code = benchReadFile(argv[i], &size);
+
+        if(code == NULL)
+        {
+            perror(argv[i]);
+            return 1;
+        }
+        if(textSize > size)
+        {
+            fprintf(stderr, ".text doesn't fit in %s\n", argv[i]);
+            return 1;
+        }
+        if(!benchImage(argv[i], code, size, textSize))
+            return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,91 @@
+/*
+    Cost of the key of the loader's patch-location cache ("/luma/cache/patchloc.bin", see patchLayeredFs in
+    sysmodules/loader/source/patcher.c) against the scans a hit saves: computeCodeChecksum runs on every launch of
+    a title with a LayeredFS directory, locateLayeredFs only on misses.
+
+    Usage: patchloc_bench [code.bin textSize roSize dataSize]
+
+    Without arguments, random data stands for a 4MB code section: no symbol is ever found, so .text is scanned
+    entirely, which is what a title lacking one of the patterns costs. A decompressed code.bin and the sizes from
+    its exheader (hexadecimal allowed) give the figures of a real title.
+*/
+
+#include "bench.h"
+#include "patcher.c"
+
+u32 config, multiConfig, bootConfig;
+bool isN3DS, isSdMode;
+
+// Defined by romfsredir.s (ARM), only its size matters here: it's looked for free space to be copied to
+const u32 romfsRedirPatchSize = 0x140;
+
+// The checksum the cache used to be keyed on: a single FNV-1a dependency chain
+static u32 computeCodeChecksumSingleLane(const u8 *code, u32 size)
+{
+    const u32 *code32 = (const u32 *)code;
+    u32 checksum = 0x811C9DC5;
+
+    for(u32 i = 0; i < size / 4; i++)
+        checksum = (checksum ^ code32[i]) * 0x01000193;
+
+    for(u32 i = size & ~3; i < size; i++)
+        checksum = (checksum ^ code[i]) * 0x01000193;
+
+    return checksum;
+}
+
+int main(int argc, char *argv[])
+{
+    u32 size, textSize, roSize, dataSize;
+    u8 *code;
+
+    if(argc == 5)
+    {
+        code = benchReadFile(argv[1], &size);
+        if(code == NULL)
+        {
+            perror(argv[1]);
+            return 1;
+        }
+
+        textSize = (u32)strtoul(argv[2], NULL, 0);
+        roSize = (u32)strtoul(argv[3], NULL, 0);
+        dataSize = (u32)strtoul(argv[4], NULL, 0);
+        if(textSize + roSize + dataSize > size)
+        {
+            fprintf(stderr, "The sections don't fit in %s\n", argv[1]);
+            return 1;
+        }
+    }
+    else if(argc == 1)
+    {
+        textSize = 0x300000;
+        roSize = 0x80000;
+        dataSize = 0x80000;
+        size = textSize + roSize + dataSize;
+        code = (u8 *)benchAlloc32(size);
+        benchFillRandom(code, size, 0x3D5);
+    }
+    else
+    {
+        fprintf(stderr, "Usage: %s [code.bin textSize roSize dataSize]\n", argv[0]);
+        return 1;
+    }
+
+    u32 roAddress = 0x100000 + textSize, dataAddress = roAddress + roSize;
+    volatile u32 sink = 0;
+    bool found = false;
+    LayeredFsLocations loc;
+
+    u64 singleLaneNs = BENCH_BEST_NS(20, sink += computeCodeChecksumSingleLane(code, size));
+    u64 checksumNs = BENCH_BEST_NS(20, sink += computeCodeChecksum(code, size));
+    u64 scanNs = BENCH_BEST_NS(20, found = locateLayeredFs(code, size, textSize, roSize, dataSize, roAddress, dataAddress, &loc));
+
+    printf("patchloc_bench: %lu bytes of code (.text: %lu), symbols %s\n", (unsigned long)size,
+           (unsigned long)textSize, found ? "found" : "not found");
+    printf("  checksum, single lane:  %8.3f ms  %8.1f MB/s\n", singleLaneNs / 1e6, benchMBps(size, singleLaneNs));
+    printf("  checksum, four lanes:   %8.3f ms  %8.1f MB/s\n", checksumNs / 1e6, benchMBps(size, checksumNs));
+    printf("  locateLayeredFs (miss): %8.3f ms\n", scanNs / 1e6);
+    printf("  a hit costs %.1f%% of a miss' scans\n", 100.0 * checksumNs / scanNs);
+    return 0;
+}
@@ -0,0 +1,281 @@
+/*
+    Load times of Rosalina's cheats (Cheat_LoadCheatsIntoMemory and Cheat_LoadCheatCodes in
+    sysmodules/rosalina/source/menus/cheats.c) against the text parser they replaced (cheat_parse_reference.h), on
+    host files: parsing a cheat file the first time (database written), loading it again (names read from the
+    database), and reading and compiling the codes of every cheat, as enabling them does. The cheats loaded have to
+    be the ones the previous parser finds.
+
+    Usage: cheat_parse_bench [cheats.txt...]
+
+    Without arguments, a cheat file of 3000 cheats of 1 to 64 lines is made first.
+*/
+
+#include <unistd.h>
+#include <sys/stat.h>
+#include "menus/cheats.c"
+#include "cheat_parse_reference.h"
+#include "bench.h"
+#include "host_ctru.h"
+
+#define TITLE_ID        0x0004000000055D00ULL
+#define NB_RUNS         10
+
+static char cheatPath[64], databasePath[64];
+
+static u32 randomState = 0x1234;
+
+static u32 randomU32(u32 max) // [0, max]
+{
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return randomState % (max + 1);
+}
+
+// Names, comments, blank lines and codes, some lines ending with CRLF and some with trailing spaces
+static void makeCheatFile(const char *path, u32 nbCheats)
+{
+    FILE *f = fopen(path, "wb");
+
+    for(u32 i = 0; i < nbCheats; i++)
+    {
+        const char *eol = randomU32(3) == 0 ? "\r\n" : "\n";
+        u32 nbCodes = randomU32(7) == 0 ? 16 + randomU32(48) : 1 + randomU32(11);
+
+        if(randomU32(15) == 0)
+            fprintf(f, "# Section %lu%s", (unsigned long)i, eol);
+        fprintf(f, "[Cheat number %lu%s]%s", (unsigned long)i, randomU32(1) ? " (press L+A)" : "", eol);
+        if(randomU32(1))
+            fprintf(f, "DD000000 00000201%s", eol);
+        for(u32 j = 0; j < nbCodes; j++)
+        {
+            u32 left = randomU32(0xFFFFFFFE), right = randomU32(0xFFFFFFFE);
+            fprintf(f, randomU32(1) ? "%08lX %08lX%s%s" : "%08lx %08lx%s%s", (unsigned long)left, (unsigned long)right,
+                    randomU32(7) == 0 ? "  " : "", eol);
+        }
+        fprintf(f, "%s", eol);
+    }
+
+    fclose(f);
+}
+
+static bool checkCheats(const char *name, bool withCodes)
+{
+    if((u32)cheatCount != referenceCheatCount)
+    {
+        printf("FAIL: %s: %ld cheats, expected %lu\n", name, (long)cheatCount, (unsigned long)referenceCheatCount);
+        return false;
+    }
+
+    for(u32 i = 0; i < referenceCheatCount; i++)
+    {
+        CheatDescription *cheat = &cheats[i];
+        ReferenceCheat *expected = &referenceCheats[i];
+
+        if(strcmp(cheat->name, expected->name) != 0 || cheat->hasKeyCode != expected->hasKeyCode ||
+           cheat->codesCount != expected->codesCount ||
+           (withCodes && memcmp(cheat->codes, referenceCodes + expected->codesIndex, cheat->codesCount * sizeof(u64)) != 0))
+        {
+            printf("FAIL: %s: cheat %lu (%s) differs\n", name, (unsigned long)i, expected->name);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// FS calls made, as they are what loading costs on the console (linked with --wrap)
+static u32 fsReads, fsWrites;
+
+Result __real_FSFILE_Read(Handle handle, u32 *bytesRead, u64 offset, void *buffer, u32 size);
+Result __real_FSFILE_Write(Handle handle, u32 *bytesWritten, u64 offset, const void *buffer, u32 size, u32 flags);
+
+Result __wrap_FSFILE_Read(Handle handle, u32 *bytesRead, u64 offset, void *buffer, u32 size)
+{
+    fsReads++;
+    return __real_FSFILE_Read(handle, bytesRead, offset, buffer, size);
+}
+
+Result __wrap_FSFILE_Write(Handle handle, u32 *bytesWritten, u64 offset, const void *buffer, u32 size, u32 flags)
+{
+    fsWrites++;
+    return __real_FSFILE_Write(handle, bytesWritten, offset, buffer, size, flags);
+}
+
+static void previousParse(void)
+{
+    Cheat_LoadCheatsIntoMemoryReference(TITLE_ID);
+}
+
+// What Cheat_LoadCheatsIntoMemory does without a database, less writing it
+static void parse(void)
+{
+    cheatCount = 0;
+    cheatTitleInfo = TITLE_ID;
+    Cheat_ArenaReset(&cheatDescriptionArena);
+    Cheat_ArenaReset(&cheatCodeArena);
+    if(R_SUCCEEDED(BufferedFile_Open(&cheatFile, ARCHIVE_SDMC, fsMakePath(PATH_ASCII, cheatPath), FS_OPEN_READ)))
+    {
+        Cheat_ParseCheatFile();
+        IFile_Close(&cheatFile.file);
+    }
+}
+
+static void firstLoad(void)
+{
+    unlink(hostFsGetPath(databasePath));
+    Cheat_LoadCheatsIntoMemory(TITLE_ID);
+}
+
+static void load(void)
+{
+    Cheat_LoadCheatsIntoMemory(TITLE_ID);
+}
+
+static bool enableAll(void)
+{
+    for(s32 i = 0; i < cheatCount; i++)
+    {
+        if(R_FAILED(Cheat_LoadCheatCodes(&cheats[i])))
+            return false;
+    }
+    return true;
+}
+
+typedef struct StepResult
+{
+    u64 ns;
+    u32 reads, writes;
+} StepResult;
+
+static StepResult runStep(void (*step)(void))
+{
+    StepResult result;
+
+    fsReads = fsWrites = 0;
+    step();
+    result.reads = fsReads;
+    result.writes = fsWrites;
+    result.ns = BENCH_BEST_NS(NB_RUNS, step());
+    return result;
+}
+
+static void printStep(const char *name, StepResult result, u64 referenceNs)
+{
+    printf("    %-22s %8.3f ms, %5lu FS reads %5lu FS writes", name, result.ns / 1e6, (unsigned long)result.reads,
+           (unsigned long)result.writes);
+    if(referenceNs != 0)
+        printf(" (x%.1f)", (double)referenceNs / result.ns);
+    printf("\n");
+}
+
+static bool bench(const char *name)
+{
+    u64 size = 0;
+    struct stat st;
+
+    if(stat(hostFsGetPath(cheatPath), &st) == 0)
+        size = (u64)st.st_size;
+
+    StepResult reference = runStep(previousParse);
+    StepResult parsed = runStep(parse);
+    if(!checkCheats(name, true))
+        return false;
+
+    StepResult first = runStep(firstLoad);
+    if(!checkCheats(name, true))
+        return false;
+
+    StepResult loaded = runStep(load);
+    if(cheatDatabaseCodesOffset == 0 || !checkCheats(name, false))
+    {
+        printf("FAIL: %s: not loaded from the database\n", name);
+        return false;
+    }
+
+    // Only enabling is timed, each run starting from freshly loaded descriptions
+    StepResult enabled = { ~0ULL, 0, 0 };
+    for(u32 run = 0; run < NB_RUNS; run++)
+    {
+        load();
+        fsReads = fsWrites = 0;
+
+        u64 start = benchNowNs();
+        bool ok = enableAll();
+        u64 elapsed = benchNowNs() - start;
+
+        if(!ok)
+        {
+            printf("FAIL: %s: codes not read\n", name);
+            return false;
+        }
+        enabled.ns = elapsed < enabled.ns ? elapsed : enabled.ns;
+        enabled.reads = fsReads;
+        enabled.writes = fsWrites;
+    }
+    if(!checkCheats(name, true))
+        return false;
+
+    printf("  %s: %lu cheats, %lu code lines, %lu KB\n", name, (unsigned long)referenceCheatCount,
+           (unsigned long)referenceCodesCount, (unsigned long)(size / 1024));
+    printStep("previous parser", reference, 0);
+    printStep("parse", parsed, reference.ns);
+    printStep("parse, write database", first, reference.ns);
+    printStep("load from database", loaded, reference.ns);
+    printStep("enable every cheat", enabled, 0);
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    char root[] = "/tmp/cheat_parse_bench.XXXXXX";
+
+    if(mkdtemp(root) == NULL)
+    {
+        perror("mkdtemp");
+        return 1;
+    }
+    hostFsSetRoot(root);
+    sprintf(cheatPath, "/luma/titles/%016llX/cheats.txt", TITLE_ID);
+    sprintf(databasePath, CHEAT_DATABASE_PATH, TITLE_ID);
+    mkdir(hostFsGetPath("/luma"), 0755);
+    mkdir(hostFsGetPath("/luma/titles"), 0755);
+    mkdir(hostFsGetPath("/luma/titles/0004000000055D00"), 0755);
+
+    printf("cheat_parse_bench:\n");
+
+    bool ok = true;
+    if(argc == 1)
+    {
+        makeCheatFile(hostFsGetPath(cheatPath), 3000);
+        ok = bench("synthetic cheats");
+    }
+
+    for(int i = 1; ok && i < argc; i++)
+    {
+        u32 size;
+        u8 *data = benchReadFile(argv[i], &size);
+        FILE *f = fopen(hostFsGetPath(cheatPath), "wb");
+
+        if(data == NULL || f == NULL || fwrite(data, 1, size, f) != size)
+        {
+            fprintf(stderr, "%s: can't be read\n", argv[i]);
+            return 1;
+        }
+        fclose(f);
+        ok = bench(argv[i]);
+    }
+
+    static const char *const created[] = {
+        "/luma/cache/cheats/0004000000055D00.bin", "/luma/titles/0004000000055D00/cheats.txt",
+    }, *const createdDirectories[] = {
+        "/luma/cache/cheats", "/luma/cache", "/luma/titles/0004000000055D00", "/luma/titles", "/luma",
+    };
+    for(u32 i = 0; i < sizeof(created) / sizeof(created[0]); i++)
+        unlink(hostFsGetPath(created[i]));
+    for(u32 i = 0; i < sizeof(createdDirectories) / sizeof(createdDirectories[0]); i++)
+        rmdir(hostFsGetPath(createdDirectories[i]));
+    rmdir(root);
+
+    return ok ? 0 : 1;
+}
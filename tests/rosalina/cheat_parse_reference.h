@@ -0,0 +1,221 @@
+/*
+    The text parser Rosalina's cheat database replaced (Cheat_LoadCheatsIntoMemory in
+    sysmodules/rosalina/source/menus/cheats.c), with its line reader going one byte at a time through a 512-byte
+    buffer, for the host benchmarks. To be included after cheats.c, whose line helpers it shares; the names taken
+    from it have a Reference suffix.
+
+    The cheats it parsed went to a 32 KiB buffer, counted by a u8: they go to growable host arrays instead, so that
+    whole files can be compared.
+*/
+
+#pragma once
+
+typedef struct ReferenceCheat
+{
+    char name[39];
+    bool hasKeyCode;
+    u32 codesCount;
+    u32 codesIndex;
+} ReferenceCheat;
+
+typedef struct ReferenceBufferedFile
+{
+    IFile file;
+    u64 curPos;
+    u64 maxPos;
+    char buffer[512];
+} ReferenceBufferedFile;
+
+static ReferenceCheat *referenceCheats;
+static u32 referenceCheatCount, referenceCheatCapacity;
+static u64 *referenceCodes;
+static u32 referenceCodesCount, referenceCodesCapacity;
+
+static ReferenceCheat *Cheat_AllocCheatReference(void)
+{
+    if(referenceCheatCount == referenceCheatCapacity)
+    {
+        referenceCheatCapacity = referenceCheatCapacity != 0 ? 2 * referenceCheatCapacity : 256;
+        referenceCheats = (ReferenceCheat *)realloc(referenceCheats, referenceCheatCapacity * sizeof(ReferenceCheat));
+    }
+
+    ReferenceCheat *cheat = &referenceCheats[referenceCheatCount++];
+    memset(cheat, 0, sizeof(ReferenceCheat));
+    cheat->codesIndex = referenceCodesCount;
+    return cheat;
+}
+
+static void Cheat_AddCodeReference(ReferenceCheat *cheat, u64 code)
+{
+    if(referenceCodesCount == referenceCodesCapacity)
+    {
+        referenceCodesCapacity = referenceCodesCapacity != 0 ? 2 * referenceCodesCapacity : 4096;
+        referenceCodes = (u64 *)realloc(referenceCodes, referenceCodesCapacity * sizeof(u64));
+    }
+
+    referenceCodes[referenceCodesCount++] = code;
+    cheat->codesCount++;
+}
+
+static Result BufferedFile_OpenReference(ReferenceBufferedFile* file, FS_ArchiveID archiveId, FS_Path archivePath, FS_Path filePath, u32 flags)
+{
+    Result res = 0;
+    memset(file->buffer, '\0', sizeof(file->buffer));
+    res = IFile_Open(&file->file, archiveId, archivePath, filePath, flags);
+    if (R_SUCCEEDED(res))
+    {
+        file->curPos = 0;
+        res = IFile_Read(&file->file, &file->maxPos, file->buffer, sizeof(file->buffer));
+    }
+    return res;
+}
+
+static Result BufferedFile_ReadReference(ReferenceBufferedFile* file, u64* totalRead, void* buffer, u32 len)
+{
+    Result res = 0;
+    if (len == 0)
+    {
+        *totalRead = 0;
+        return 0;
+    }
+    else if (file->curPos + len < file->maxPos)
+    {
+        memcpy(buffer, file->buffer + file->curPos, len);
+        file->curPos += len;
+        *totalRead = len;
+    }
+    else
+    {
+        *totalRead = 0;
+        while(R_SUCCEEDED(res) && file->maxPos != 0 && *totalRead < len)
+        {
+            u32 toRead = file->maxPos - file->curPos < len - *totalRead ? file->maxPos - file->curPos : len - *totalRead;
+            memcpy(buffer + *totalRead, file->buffer + file->curPos, toRead);
+            *totalRead += toRead;
+            file->curPos += toRead;
+            if (file->curPos >= file->maxPos)
+            {
+                res = IFile_Read(&file->file, &file->maxPos, file->buffer, sizeof(file->buffer));
+                file->curPos = 0;
+            }
+        }
+    }
+    return res;
+}
+
+static Result Cheat_ReadLineReference(ReferenceBufferedFile* file, char* line, u32 lineSize)
+{
+    Result res = 0;
+
+    u32 idx = 0;
+    u64 total = 0;
+    bool lastWasCarriageReturn = false;
+    while (R_SUCCEEDED(res) && idx < lineSize)
+    {
+        res = BufferedFile_ReadReference(file, &total, line + idx, 1);
+        if (total == 0)
+        {
+            line[idx] = '\0';
+            return -1;
+        }
+        if (R_SUCCEEDED(res))
+        {
+            if (line[idx] == '\r')
+            {
+                lastWasCarriageReturn = true;
+            }
+            else if (line[idx] == '\n')
+            {
+                if (lastWasCarriageReturn)
+                {
+                    line[--idx] = '\0';
+                    return idx;
+                }
+                else
+                {
+                    line[idx] = '\0';
+                    return idx;
+                }
+            }
+            else if (line[idx] == '\0')
+            {
+                return -1;
+            }
+            else
+            {
+                lastWasCarriageReturn = false;
+            }
+            idx++;
+        }
+    }
+    return res;
+}
+
+static void Cheat_LoadCheatsIntoMemoryReference(u64 titleId)
+{
+    referenceCheatCount = 0;
+    referenceCodesCount = 0;
+
+    char path[64] = { 0 };
+    sprintf(path, "/luma/titles/%016llX/cheats.txt", titleId);
+
+    ReferenceBufferedFile file;
+
+    if (R_FAILED(BufferedFile_OpenReference(&file, ARCHIVE_SDMC, fsMakePath(PATH_EMPTY, ""), fsMakePath(PATH_ASCII, path), FS_OPEN_READ)))
+    {
+        // OK, let's try another source
+        sprintf(path, "/cheats/%016llX.txt", titleId);
+        if (R_FAILED(BufferedFile_OpenReference(&file, ARCHIVE_SDMC, fsMakePath(PATH_EMPTY, ""), fsMakePath(PATH_ASCII, path), FS_OPEN_READ))) return;
+    };
+
+    char line[1024] = { 0 };
+    Result res = 0;
+    ReferenceCheat* cheat = 0;
+    do
+    {
+        res = Cheat_ReadLineReference(&file, line, 1024);
+        // -1 is special; it can't be a normal result because of how results are constructed
+        // So let's just use it as a signal that this is the final line of a file
+        if (R_SUCCEEDED(res) || res == -1)
+        {
+            char* strippedLine = stripWhitespace(line);
+            s32 lineLen = strnlen(strippedLine, 1023);
+            if (!lineLen)
+            {
+                continue;
+            }
+            if (strippedLine[0] == '#')
+            {
+                continue;
+            }
+            if (Cheat_IsCodeLine(strippedLine))
+            {
+                if (cheat)
+                {
+                    u64 tmp = Cheat_GetCode(strippedLine);
+                    Cheat_AddCodeReference(cheat, tmp);
+                    if (((tmp >> 32) & 0xFFFFFFFF) == 0xDD000000)
+                    {
+                        cheat->hasKeyCode = 1;
+                    }
+                }
+            }
+            else
+            {
+                if (!cheat || cheat->codesCount > 0)
+                {
+                    cheat = Cheat_AllocCheatReference();
+                }
+                strncpy(cheat->name, line, 38);
+                cheat->name[38] = '\0';
+            }
+        }
+    } while (R_SUCCEEDED(res));
+
+    IFile_Close(&file.file);
+
+    if ((referenceCheatCount > 0) && (referenceCheats[referenceCheatCount - 1].codesCount == 0))
+    {
+        referenceCheatCount--; // Remove last empty cheat
+    }
+}
@@ -0,0 +1,138 @@
+/*
+    Fake debugged process for the host tests of the cheat engine (sysmodules/rosalina/source/menus/cheats.c): the
+    debug svc calls it makes are served from a few host buffers standing for the memory regions of a game, and the
+    HID register and touch screen it reads are set by the tests.
+*/
+
+#pragma once
+
+#include <string.h>
+#include <sys/mman.h>
+#include "bench.h"
+
+#define CHEAT_PROCESS_HANDLE        0x1234
+
+// .text and heap of a game, both page-aligned. Everything else is free memory
+#define CHEAT_PROCESS_CODE_BASE     0x00100000
+#define CHEAT_PROCESS_CODE_SIZE     0x10000
+#define CHEAT_PROCESS_HEAP_BASE     0x08000000
+#define CHEAT_PROCESS_HEAP_SIZE     0x20000
+
+typedef struct CheatProcessRegion
+{
+    u32 base;
+    u32 size;
+    u8 *data;
+} CheatProcessRegion;
+
+static CheatProcessRegion cheatProcessRegions[] = {
+    { CHEAT_PROCESS_CODE_BASE, CHEAT_PROCESS_CODE_SIZE, NULL },
+    { CHEAT_PROCESS_HEAP_BASE, CHEAT_PROCESS_HEAP_SIZE, NULL },
+};
+
+#define CHEAT_PROCESS_REGION_COUNT (sizeof(cheatProcessRegions) / sizeof(CheatProcessRegion))
+
+// svc calls made, for the benchmarks
+typedef struct CheatProcessStats
+{
+    u64 queries;
+    u64 reads;
+    u64 writes;
+} CheatProcessStats;
+
+static CheatProcessStats cheatProcessStats;
+static touchPosition cheatProcessTouch;
+
+static CheatProcessRegion *cheatProcessFindRegion(u32 addr, u32 size)
+{
+    for(u32 i = 0; i < CHEAT_PROCESS_REGION_COUNT; i++)
+    {
+        CheatProcessRegion *region = &cheatProcessRegions[i];
+        if(addr >= region->base && size <= region->size && addr - region->base <= region->size - size)
+            return region;
+    }
+
+    return NULL;
+}
+
+Result svcQueryDebugProcessMemory(MemInfo *info, PageInfo *out, Handle debug, u32 addr)
+{
+    CheatProcessRegion *region = cheatProcessFindRegion(addr, 1);
+
+    cheatProcessStats.queries++;
+    if(debug != CHEAT_PROCESS_HANDLE)
+        return 0xD8E007F7;
+
+    memset(info, 0, sizeof(MemInfo));
+    out->flags = 0;
+    if(region != NULL)
+    {
+        info->base_addr = region->base;
+        info->size = region->size;
+        info->perm = MEMPERM_READ | MEMPERM_WRITE;
+        info->state = MEMSTATE_PRIVATE;
+    }
+    else
+    {
+        // Not quite the whole free block the kernel would describe, but as far as the cheat engine goes, the same
+        info->base_addr = addr & ~0xFFF;
+        info->size = 0x1000;
+        info->state = MEMSTATE_FREE;
+    }
+
+    return 0;
+}
+
+Result svcReadProcessMemory(void *buffer, Handle debug, u32 addr, u32 size)
+{
+    CheatProcessRegion *region = cheatProcessFindRegion(addr, size);
+
+    cheatProcessStats.reads++;
+    if(debug != CHEAT_PROCESS_HANDLE || region == NULL)
+        return 0xE0E01BF5;
+
+    memcpy(buffer, region->data + (addr - region->base), size);
+    return 0;
+}
+
+Result svcWriteProcessMemory(Handle debug, const void *buffer, u32 addr, u32 size)
+{
+    CheatProcessRegion *region = cheatProcessFindRegion(addr, size);
+
+    cheatProcessStats.writes++;
+    if(debug != CHEAT_PROCESS_HANDLE || region == NULL)
+        return 0xE0E01BF5;
+
+    memcpy(region->data + (addr - region->base), buffer, size);
+    return 0;
+}
+
+void hidTouchRead(touchPosition *pos)
+{
+    *pos = cheatProcessTouch;
+}
+
+// HID_PAD reads the pad register through its physical address, mapped where the firmware would find it
+static vu32 *cheatProcessPad;
+
+static void cheatProcessSetKeys(u32 keys)
+{
+    *cheatProcessPad = keys ^ 0xFFF;
+}
+
+static void cheatProcessInit(void)
+{
+    for(u32 i = 0; i < CHEAT_PROCESS_REGION_COUNT; i++)
+        cheatProcessRegions[i].data = (u8 *)benchAlloc32(cheatProcessRegions[i].size);
+
+    void *pad = mmap(PA_PTR(0x10146000), 0x1000, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+    if(pad != PA_PTR(0x10146000))
+    {
+        perror("mmap (HID registers)");
+        exit(1);
+    }
+
+    cheatProcessPad = (vu32 *)pad;
+    cheatProcessSetKeys(0);
+}
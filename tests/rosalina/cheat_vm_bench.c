@@ -0,0 +1,245 @@
+/*
+    Speed of Rosalina's compiled cheats (Cheat_CompileCheat and Cheat_ApplyCheat in
+    sysmodules/rosalina/source/menus/cheats.c) against the interpreter they replaced (cheats_reference.h), on a fake
+    process (cheat_process.h): passes over a list of enabled cheats, as Cheat_ApplyCheats makes them, per second,
+    along with the code lines they amount to and the debug svc calls each pass makes.
+
+    Usage: cheat_vm_bench
+*/
+
+#include "menus/cheats.c"
+#include "cheats_reference.h"
+#include "cheat_process.h"
+
+#define NB_PASSES   2000
+
+// A list of enabled cheats, in the shapes found in cheat databases
+static const u64 maxMoneyCodes[] = {
+    MAKE_QWORD(0x08001230, 0x0098967F),
+    MAKE_QWORD(0x08001234, 0x0098967F),
+};
+
+static const u64 infiniteHealthCodes[] = {
+    MAKE_QWORD(0xD3000000, 0x00000000),
+    MAKE_QWORD(0xB8000100, 0x00000000), // player, through a pointer
+    MAKE_QWORD(0x00000040, 0x000003E7),
+    MAKE_QWORD(0x00000044, 0x000003E7),
+    MAKE_QWORD(0x10000048, 0x000003E7),
+    MAKE_QWORD(0xD2000000, 0x00000000),
+};
+
+static const u64 moonJumpCodes[] = {
+    MAKE_QWORD(0xDD000000, 0x00000201), // L+A
+    MAKE_QWORD(0xD3000000, 0x00000000),
+    MAKE_QWORD(0xB8000100, 0x00000000),
+    MAKE_QWORD(0x00000080, 0x40A00000),
+    MAKE_QWORD(0x00000084, 0x00000000),
+    MAKE_QWORD(0xD2000000, 0x00000000),
+};
+
+static const u64 allItemsCodes[] = {
+    MAKE_QWORD(0xD3000000, 0x08004000),
+    MAKE_QWORD(0xC0000000, 0x00000063),
+    MAKE_QWORD(0x20000000, 0x00000063),
+    MAKE_QWORD(0xDC000000, 0x00000004),
+    MAKE_QWORD(0xD1000000, 0x00000000),
+    MAKE_QWORD(0xD2000000, 0x00000000),
+};
+
+static const u64 unlockEverythingCodes[] = {
+    MAKE_QWORD(0xE8002000, 0x00000040),
+    MAKE_QWORD(0xFFFFFFFF, 0xFFFFFFFF),
+    MAKE_QWORD(0xFFFFFFFF, 0xFFFFFFFF),
+    MAKE_QWORD(0xFFFFFFFF, 0xFFFFFFFF),
+    MAKE_QWORD(0xFFFFFFFF, 0xFFFFFFFF),
+    MAKE_QWORD(0x0FFFFFFF, 0xFFFFFFFF),
+    MAKE_QWORD(0x0FFFFFFF, 0xFFFFFFFF),
+    MAKE_QWORD(0x00FFFFFF, 0xFFFFFFFF),
+    MAKE_QWORD(0x00FFFFFF, 0xFFFFFFFF),
+};
+
+static const u64 freezeTimerCodes[] = {
+    MAKE_QWORD(0x68003000, 0x00000000), // only in a level
+    MAKE_QWORD(0x08003004, 0x00001C20),
+    MAKE_QWORD(0x18003008, 0x0000003C),
+    MAKE_QWORD(0xD2000000, 0x00000000),
+};
+
+static const u64 maxStatsCodes[] = {
+    MAKE_QWORD(0x18005000, 0x000003E7),
+    MAKE_QWORD(0x18005002, 0x000003E7),
+    MAKE_QWORD(0x18005004, 0x000003E7),
+    MAKE_QWORD(0x18005006, 0x000003E7),
+    MAKE_QWORD(0x18005008, 0x000003E7),
+    MAKE_QWORD(0x1800500A, 0x000003E7),
+    MAKE_QWORD(0x1800500C, 0x000003E7),
+    MAKE_QWORD(0x1800500E, 0x000003E7),
+    MAKE_QWORD(0x18005010, 0x000000FF),
+    MAKE_QWORD(0x18005012, 0x000000FF),
+    MAKE_QWORD(0x18005014, 0x000000FF),
+    MAKE_QWORD(0x18005016, 0x000000FF),
+};
+
+static const u64 experienceCodes[] = {
+    MAKE_QWORD(0xD3000000, 0x08006000),
+    MAKE_QWORD(0xD9000000, 0x00000010),
+    MAKE_QWORD(0xD4000000, 0x00000064),
+    MAKE_QWORD(0xD6000000, 0x00000010),
+    MAKE_QWORD(0xD2000000, 0x00000000),
+};
+
+static const u64 partyCodes[] = {
+    MAKE_QWORD(0x08007000, 0x0000270F), MAKE_QWORD(0x08007004, 0x0000270F),
+    MAKE_QWORD(0x08007100, 0x0000270F), MAKE_QWORD(0x08007104, 0x0000270F),
+    MAKE_QWORD(0x08007200, 0x0000270F), MAKE_QWORD(0x08007204, 0x0000270F),
+    MAKE_QWORD(0x08007300, 0x0000270F), MAKE_QWORD(0x08007304, 0x0000270F),
+    MAKE_QWORD(0x08007400, 0x0000270F), MAKE_QWORD(0x08007404, 0x0000270F),
+    MAKE_QWORD(0x08007500, 0x0000270F), MAKE_QWORD(0x08007504, 0x0000270F),
+    MAKE_QWORD(0x28007008, 0x00000063), MAKE_QWORD(0x28007108, 0x00000063),
+    MAKE_QWORD(0x28007208, 0x00000063), MAKE_QWORD(0x28007308, 0x00000063),
+};
+
+static const u64 codePatchCodes[] = {
+    MAKE_QWORD(0x00104A20, 0xE3A00001), // mov r0, #1
+    MAKE_QWORD(0x00104A24, 0xE12FFF1E), // bx lr
+    MAKE_QWORD(0x0010B3C8, 0xE1A00000), // nop
+};
+
+#define CHEAT(codes) { codes, sizeof(codes) / sizeof(u64) }
+
+static const struct
+{
+    const u64 *codes;
+    u32 count;
+} benchCheats[] = {
+    CHEAT(maxMoneyCodes),
+    CHEAT(infiniteHealthCodes),
+    CHEAT(moonJumpCodes),
+    CHEAT(allItemsCodes),
+    CHEAT(unlockEverythingCodes),
+    CHEAT(freezeTimerCodes),
+    CHEAT(maxStatsCodes),
+    CHEAT(experienceCodes),
+    CHEAT(partyCodes),
+    CHEAT(codePatchCodes),
+};
+
+#define NB_CHEATS (sizeof(benchCheats) / sizeof(benchCheats[0]))
+
+static CheatDescription benchDescriptions[NB_CHEATS];
+static CheatInstruction *benchPrograms[NB_CHEATS];
+static u8 *initialMemory[CHEAT_PROCESS_REGION_COUNT];
+
+static void resetProcess(void)
+{
+    for(u32 i = 0; i < CHEAT_PROCESS_REGION_COUNT; i++)
+        memcpy(cheatProcessRegions[i].data, initialMemory[i], cheatProcessRegions[i].size);
+    memset(cheatPage, 0, sizeof(cheatPage));
+    memset(&cheatProcessStats, 0, sizeof(cheatProcessStats));
+
+    for(u32 i = 0; i < NB_CHEATS; i++)
+    {
+        CheatDescription *cheat = &benchDescriptions[i];
+
+        memset(cheat, 0, sizeof(CheatDescription));
+        cheat->active = 1;
+        cheat->valid = 1;
+        cheat->codesCount = benchCheats[i].count;
+        cheat->codes = (u64 *)benchCheats[i].codes;
+        cheat->program = benchPrograms[i];
+    }
+}
+
+static void referencePass(void)
+{
+    for(u32 i = 0; i < NB_CHEATS; i++)
+        benchDescriptions[i].valid = Cheat_ApplyCheatReference(CHEAT_PROCESS_HANDLE, &benchDescriptions[i]) != 0;
+}
+
+// As Cheat_ApplyCheats does, the cheats having been compiled when enabled
+static void compiledPass(void)
+{
+    Cheat_ResetMemoryCache();
+    for(u32 i = 0; i < NB_CHEATS; i++)
+        Cheat_ApplyCheatInSession(&benchDescriptions[i]);
+}
+
+static bool allValid(void)
+{
+    for(u32 i = 0; i < NB_CHEATS; i++)
+    {
+        if(!benchDescriptions[i].valid)
+            return false;
+    }
+    return true;
+}
+
+int main(void)
+{
+    u8 *expectedMemory[CHEAT_PROCESS_REGION_COUNT];
+    u32 nbLines = 0, pointer = 0x08010000;
+
+    cheatProcessInit();
+    for(u32 i = 0; i < CHEAT_PROCESS_REGION_COUNT; i++)
+    {
+        initialMemory[i] = (u8 *)malloc(cheatProcessRegions[i].size);
+        expectedMemory[i] = (u8 *)malloc(cheatProcessRegions[i].size);
+        benchFillRandom(initialMemory[i], cheatProcessRegions[i].size, 0x1234 + i);
+    }
+    memcpy(initialMemory[1] + 0x100, &pointer, 4);
+
+    for(u32 i = 0; i < NB_CHEATS; i++)
+    {
+        nbLines += benchCheats[i].count;
+        benchPrograms[i] = (CheatInstruction *)malloc(sizeof(CheatInstruction) * benchCheats[i].count);
+    }
+
+    cheatSession.debug = CHEAT_PROCESS_HANDLE;
+    cheatProcessSetKeys(KEY_L | KEY_A);
+
+    // One pass of each from the same memory: same outcome, and the svc calls it takes
+    resetProcess();
+    referencePass();
+    CheatProcessStats referenceStats = cheatProcessStats;
+    bool referenceValid = allValid();
+    for(u32 i = 0; i < CHEAT_PROCESS_REGION_COUNT; i++)
+        memcpy(expectedMemory[i], cheatProcessRegions[i].data, cheatProcessRegions[i].size);
+
+    resetProcess();
+    for(u32 i = 0; i < NB_CHEATS; i++)
+        Cheat_CompileCheat(&benchDescriptions[i]);
+    compiledPass();
+    CheatProcessStats compiledStats = cheatProcessStats;
+
+    if(!referenceValid || !allValid())
+    {
+        printf("FAIL: a cheat of the list is invalid\n");
+        return 1;
+    }
+    for(u32 i = 0; i < CHEAT_PROCESS_REGION_COUNT; i++)
+    {
+        if(memcmp(expectedMemory[i], cheatProcessRegions[i].data, cheatProcessRegions[i].size) != 0)
+        {
+            printf("FAIL: the executors write different memory\n");
+            return 1;
+        }
+    }
+
+    resetProcess();
+    u64 referenceNs = BENCH_BEST_NS(5, for(u32 pass = 0; pass < NB_PASSES; pass++) referencePass());
+    resetProcess();
+    for(u32 i = 0; i < NB_CHEATS; i++)
+        Cheat_CompileCheat(&benchDescriptions[i]);
+    u64 compiledNs = BENCH_BEST_NS(5, for(u32 pass = 0; pass < NB_PASSES; pass++) compiledPass());
+
+    printf("cheat_vm_bench: %lu cheats, %lu code lines\n", (unsigned long)NB_CHEATS, (unsigned long)nbLines);
+    printf("  reference %8.0f passes/s %6.2f M lines/s, %3lu queries %3lu reads %3lu writes per pass\n",
+           NB_PASSES * 1e9 / referenceNs, (double)NB_PASSES * nbLines * 1e3 / referenceNs,
+           (unsigned long)referenceStats.queries, (unsigned long)referenceStats.reads,
+           (unsigned long)referenceStats.writes);
+    printf("  compiled  %8.0f passes/s %6.2f M lines/s, %3lu queries %3lu reads %3lu writes per pass (x%.1f)\n",
+           NB_PASSES * 1e9 / compiledNs, (double)NB_PASSES * nbLines * 1e3 / compiledNs,
+           (unsigned long)compiledStats.queries, (unsigned long)compiledStats.reads,
+           (unsigned long)compiledStats.writes, (double)referenceNs / compiledNs);
+    return 0;
+}
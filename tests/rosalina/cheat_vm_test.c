@@ -0,0 +1,563 @@
+/*
+    Differential test of Rosalina's compiled cheats (Cheat_CompileCheat and Cheat_ApplyCheat in
+    sysmodules/rosalina/source/menus/cheats.c) against the interpreter they replaced (cheats_reference.h), on a fake
+    process (cheat_process.h). Random cheats mix every code type: writes, conditionals on memory, keys, the touch
+    screen and searches, nested blocks, loops and loop breaks, pointers, data and offset registers, type E payloads,
+    copies, and random lines. Sets of cheats are applied for a few passes, as Cheat_ApplyCheats does, the keys and
+    touch position changing between them: both have to report the same cheats as valid, leave the same registers,
+    storage and cheat page and write the same process memory.
+
+    Usage: cheat_vm_test [number of random cheat sets (default 3000)]
+*/
+
+#include "menus/cheats.c"
+#include "cheats_reference.h"
+#include "cheat_process.h"
+
+#define MAX_CHEATS      4
+#define MAX_LINES       200
+#define NB_PASSES       3
+
+typedef struct CheatSet
+{
+    CheatDescription cheats[MAX_CHEATS];
+    u64 codes[MAX_CHEATS][MAX_LINES];
+    CheatInstruction programs[MAX_CHEATS][MAX_LINES];
+    u32 count;
+    u32 keys[NB_PASSES];
+    touchPosition touch[NB_PASSES];
+    u64 rngSeed;
+} CheatSet;
+
+// What a run leaves, compared after each pass
+typedef struct CheatResult
+{
+    bool valid[MAX_CHEATS];
+    u32 storage1[MAX_CHEATS];
+    u32 storage2[MAX_CHEATS];
+    bool activeStorage[MAX_CHEATS];
+    u32 index, offset1, offset2, data1, data2; // of the last cheat
+    u64 rngState;
+} CheatResult;
+
+static u32 rngState = 1;
+
+static u32 randomU32(u32 max) // [0, max]
+{
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return max == 0xFFFFFFFF ? rngState : rngState % (max + 1);
+}
+
+static u8 *initialMemory[CHEAT_PROCESS_REGION_COUNT];
+static u8 *expectedMemory[CHEAT_PROCESS_REGION_COUNT];
+
+// Random game memory, with pointers to the heap every 0x40 bytes for the B type to load
+static void makeMemory(void)
+{
+    for(u32 i = 0; i < CHEAT_PROCESS_REGION_COUNT; i++)
+    {
+        CheatProcessRegion *region = &cheatProcessRegions[i];
+
+        benchFillRandom(initialMemory[i], region->size, randomU32(0xFFFFFFFF));
+        for(u32 j = 0; j < region->size; j += 0x40)
+        {
+            u32 pointer = CHEAT_PROCESS_HEAP_BASE + (randomU32(CHEAT_PROCESS_HEAP_SIZE / 4 - 1) * 4);
+            memcpy(initialMemory[i] + j, &pointer, 4);
+        }
+    }
+}
+
+// Mostly in the game's memory and aligned, sometimes in the cheat page, across a page or out of it
+static u32 randomAddress(u32 size)
+{
+    u32 kind = randomU32(127);
+
+    if(kind == 0)
+        return randomU32(0x0FFFFFFF);
+    else if(kind <= 4)
+        return CHEAT_PROCESS_HEAP_BASE + randomU32(3) * 0x1000 + 0x1000 - randomU32(size);
+    else if(kind <= 12)
+        return 0x01E81000 + randomU32(0x1000 - size);
+    else if(kind <= 44)
+        return CHEAT_PROCESS_CODE_BASE + randomU32(CHEAT_PROCESS_CODE_SIZE - size);
+    else
+        return CHEAT_PROCESS_HEAP_BASE + (randomU32(CHEAT_PROCESS_HEAP_SIZE / size - 1) * size);
+}
+
+typedef struct CheatBuilder
+{
+    u64 *codes;
+    u32 count;
+    u32 max;
+    bool relative; // the offset register was last set to a pointer, as far as lines that aren't skipped go
+} CheatBuilder;
+
+// Address of an access through the offset register
+static u32 builderAddress(CheatBuilder *b, u32 size)
+{
+    if(!b->relative)
+        return randomAddress(size);
+    return randomU32(3) == 0 ? randomU32(0xFFF) : randomU32(0x3F) * size;
+}
+
+static bool emit(CheatBuilder *b, u32 arg0, u32 arg1)
+{
+    if(b->count == b->max)
+        return false;
+    b->codes[b->count++] = MAKE_QWORD(arg0, arg1);
+    return true;
+}
+
+// Comparison value close to whatever is at the address at first, so that both outcomes happen
+static u32 nearbyValue(u32 address, u32 size)
+{
+    u32 value = randomU32(0xFFFFFFFF);
+
+    for(u32 i = 0; i < CHEAT_PROCESS_REGION_COUNT; i++)
+    {
+        CheatProcessRegion *region = &cheatProcessRegions[i];
+        if(address >= region->base && address - region->base <= region->size - size)
+        {
+            value = 0;
+            memcpy(&value, initialMemory[i] + (address - region->base), size);
+            break;
+        }
+    }
+
+    return value + randomU32(2) - 1;
+}
+
+static void emitBlock(CheatBuilder *b, u32 depth);
+
+static void emitConditional(CheatBuilder *b, u32 depth)
+{
+    u32 address;
+
+    switch(randomU32(7))
+    {
+        case 0:
+        case 1:
+            address = builderAddress(b, 4);
+            emit(b, (3 + randomU32(3)) << 28 | (address & 0x0FFFFFFF), nearbyValue(address, 4));
+            break;
+        case 2:
+        case 3:
+            address = builderAddress(b, 2);
+            emit(b, (7 + randomU32(3)) << 28 | (address & 0x0FFFFFFF),
+                 (randomU32(1) ? 0 : randomU32(0xFFFF)) << 16 | (nearbyValue(address, 2) & 0xFFFF));
+            break;
+        case 4:
+            emit(b, 0xDD000000, randomU32(1) ? KEY_A | KEY_B : BIT(randomU32(11)));
+            break;
+        case 5:
+        {
+            u32 low = randomU32(320);
+            emit(b, 0xDE000000 | randomU32(1), (low + randomU32(100)) << 16 | low);
+            break;
+        }
+        case 6:
+        {
+            // Search for a few bytes, found or not, in a small window. The previous interpreter runs the payload
+            // lines as code when skipping: their last byte makes them 8-bit writes, which do nothing then
+            u32 searchSize = randomU32(3) == 0 ? 9 + randomU32(6) : 1 + randomU32(6), lines = (searchSize + 7) / 8;
+            u32 start = CHEAT_PROCESS_HEAP_BASE + randomU32(CHEAT_PROCESS_HEAP_SIZE - 0x100);
+            u64 payload[2];
+
+            if(b->count + 2 + lines > b->max)
+                return;
+            emit(b, 0xD3000000, start);
+            benchFillRandom(payload, sizeof(payload), randomU32(0xFFFFFFFF));
+            if(randomU32(1))
+                memcpy(payload, initialMemory[1] + (start - CHEAT_PROCESS_HEAP_BASE) + randomU32(0x20), searchSize);
+            b->relative = true;
+            emit(b, 0xFE000000 | searchSize, searchSize + randomU32(0x40));
+            for(u32 i = 0; i < lines; i++)
+                emit(b, 0x20000000 | ((u32)(payload[i] >> 32) & 0x00FFFFFF), (u32)payload[i]);
+            break;
+        }
+        default:
+            // Comparing memory, the data register and storage, as the conditional mode set says
+            address = builderAddress(b, 4);
+            emit(b, 0xDF00000F, randomU32(4));
+            emit(b, (3 + randomU32(7)) << 28 | (address & 0x0FFFFFFF), randomU32(0xFFFFFFFF));
+            break;
+    }
+
+    emitBlock(b, depth + 1);
+    if(randomU32(7) != 0)
+        emit(b, 0xD0000000, 0);
+}
+
+static void emitLoop(CheatBuilder *b, u32 depth)
+{
+    switch(randomU32(3))
+    {
+        case 0:
+            // Count from a data register: only where it can't have been loaded from memory
+            if(b->count != 0)
+                return;
+            emit(b, 0xD5000001 + randomU32(1), randomU32(6));
+            emit(b, 0xC1000000 + randomU32(1) * 0x01000000, 0);
+            break;
+        default:
+            emit(b, 0xC0000000, randomU32(6));
+            break;
+    }
+
+    emitBlock(b, depth + 1);
+    if(randomU32(3) == 0)
+    {
+        emit(b, 0xD0000000, 1); // break
+        emitBlock(b, depth + 1);
+    }
+
+    switch(randomU32(7))
+    {
+        case 0:
+            emit(b, 0xD0000000, 0);
+            break;
+        case 1:
+            emit(b, 0xD2000000, 0);
+            break;
+        case 2:
+            break;
+        default:
+            emit(b, 0xD1000000, 0);
+            break;
+    }
+}
+
+static void emitWrite(CheatBuilder *b)
+{
+    u32 size = 4 >> randomU32(2), address = builderAddress(b, size);
+    emit(b, (size == 4 ? 0 : (size == 2 ? 1 : 2)) << 28 | (address & 0x0FFFFFFF), randomU32(0xFFFFFFFF));
+}
+
+static void emitLine(CheatBuilder *b)
+{
+    u32 address, size;
+
+    switch(randomU32(23))
+    {
+        case 0:
+        case 1:
+        case 2:
+            emitWrite(b);
+            break;
+        case 3:
+            // Pointer, loaded from one of those in memory, then an access relative to it
+            if(b->relative)
+                emit(b, 0xD3000000, 0);
+            emit(b, 0xB0000000 | (randomAddress(4) & 0x0FFFFFFF & ~0x3F), 0);
+            b->relative = true;
+            emitWrite(b);
+            break;
+        case 4:
+            address = randomU32(3) == 0 ? 0 : randomAddress(4) & ~0xFFF;
+            emit(b, 0xD3000000, address);
+            b->relative = address != 0;
+            break;
+        case 5:
+            emit(b, 0xD4000000 | randomU32(2), randomU32(0xFF));
+            break;
+        case 6:
+            emit(b, 0xD5000000 | randomU32(2), randomU32(3) == 0 ? randomU32(0xFFFFFFFF) : randomU32(0xFF));
+            break;
+        case 7:
+            size = 4 >> randomU32(2);
+            emit(b, (0xD6000000 + (size == 4 ? 0 : (size == 2 ? 1 : 2)) * 0x01000000) | randomU32(2),
+                 builderAddress(b, size));
+            break;
+        case 8:
+            size = 4 >> randomU32(2);
+            emit(b, (0xD9000000 + (size == 4 ? 0 : (size == 2 ? 1 : 2)) * 0x01000000) | randomU32(2),
+                 builderAddress(b, size));
+            break;
+        case 9:
+            emit(b, 0xDC000000, randomU32(1) ? 4 * randomU32(4) : randomU32(0xFFF));
+            break;
+        case 10:
+            // Register moves, selection of the active ones, data modes
+            switch(randomU32(4))
+            {
+                case 0:
+                    emit(b, 0xDF000000 | randomU32(2), randomU32(2) << 16 | randomU32(1));
+                    break;
+                case 1:
+                {
+                    static const u32 modes[] = { 0x0, 0x1, 0x10, 0x11, 0x2 };
+                    emit(b, 0xDF00000E, modes[randomU32(4)]);
+                    break;
+                }
+                case 2:
+                    emit(b, 0xDF00000F, randomU32(5));
+                    break;
+                default:
+                    emit(b, 0xDF000000 | randomU32(0xF), randomU32(0xFFFFFFFF));
+                    break;
+            }
+            break;
+        case 11:
+            emit(b, 0xF0000000, randomU32(1));
+            break;
+        case 12:
+        {
+            // Arithmetic on memory, divisors and float operands kept away from 0
+            u32 op = 1 + randomU32(2);
+            address = builderAddress(b, 4);
+            emit(b, 0xF0000000 | op << 24 | (address & 0x00FFFFFF), op == 3 ? 1 + randomU32(0xFF) : randomU32(0xFFFFFFFF));
+            break;
+        }
+        case 13:
+        {
+            // Arithmetic on the data register
+            u32 op = 4 + randomU32(7);
+            u32 operand = op == 0xA || op == 0xB ? randomU32(31) : randomU32(0xFFFFFFFF);
+            if(op == 5)
+                operand = 0x3F800000 + randomU32(0xFFFF); // 1.0 and up, or as large an integer
+            emit(b, 0xF0000000 | op << 24, operand);
+            break;
+        }
+        case 14:
+            emit(b, 0xD3000000, randomAddress(1));
+            emit(b, 0xD3000001, randomAddress(1));
+            emit(b, 0xFC000000, randomU32(0x20));
+            b->relative = true;
+            break;
+        case 15:
+        {
+            u32 low = randomU32(0xFFFF);
+            emit(b, 0xFF000000 | low, low + 1 + randomU32(0xFFFF));
+            break;
+        }
+        case 16:
+        {
+            // Type E, payload included. A loop break can resume in the payload: its last byte makes it 8-bit writes
+            // rather than, say, type E lines reaching past the last line, which the previous interpreter read past
+            u32 count = randomU32(1) ? randomU32(16) : randomU32(0x40);
+            address = builderAddress(b, 1);
+            if(b->count + 1 + (count + 7) / 8 > b->max)
+                break;
+            emit(b, 0xE0000000 | (address & 0x0FFFFFFF), count);
+            for(u32 i = 0; i < (count + 7) / 8; i++)
+                emit(b, 0x20000000 | randomU32(0x00FFFFFF), randomU32(0xFFFFFFFF));
+            break;
+        }
+        case 17:
+            emit(b, 0xD2000000, randomU32(7) == 0); // end all, or return
+            b->relative = false;
+            break;
+        case 18:
+            emit(b, 0xD0000000, randomU32(1));
+            break;
+        case 19:
+            emit(b, 0xD1000000, 0);
+            break;
+        case 20:
+            emit(b, 0xDF000002, randomU32(2) << 16 | randomU32(1));
+            break;
+        default:
+        {
+            // Anything, short of what would divide by 0, loop for long or stop the whole cheat
+            if(randomU32(3) != 0)
+            {
+                emitWrite(b);
+                break;
+            }
+
+            u32 arg0 = randomU32(0xFFFFFFFF), arg1 = randomU32(0xFFFFFFFF), code = arg0 >> 28, subcode = (arg0 >> 24) & 0xF;
+
+            if(code == 0xC || code == 0xE || (code == 0xF && (subcode == 0x3 || subcode == 0x5 || subcode >= 0xA)))
+                arg0 &= 0x7FFFFFFF;
+            if(arg0 == 0 && arg1 == 0)
+                arg1 = 1;
+            emit(b, arg0, arg1);
+            break;
+        }
+    }
+}
+
+static void emitBlock(CheatBuilder *b, u32 depth)
+{
+    u32 nbItems = 1 + randomU32(depth == 0 ? 24 : 4);
+
+    for(u32 i = 0; i < nbItems && b->count < b->max; i++)
+    {
+        u32 kind = randomU32(15);
+        if(kind < 3 && depth < 4)
+            emitConditional(b, depth);
+        else if(kind == 3 && depth < 2)
+            emitLoop(b, depth);
+        else
+            emitLine(b);
+    }
+}
+
+static void makeCheatSet(CheatSet *set)
+{
+    set->count = 1 + randomU32(MAX_CHEATS - 1);
+
+    for(u32 i = 0; i < set->count; i++)
+    {
+        CheatBuilder b = { set->codes[i], 0, randomU32(3) == 0 ? MAX_LINES : 40, false };
+        CheatDescription *cheat = &set->cheats[i];
+
+        emitBlock(&b, 0);
+        if(randomU32(31) == 0)
+            b.codes[randomU32(b.count - 1)] = 0; // ends the cheat, as an invalid one
+
+        memset(cheat, 0, sizeof(CheatDescription));
+        cheat->valid = 1;
+        cheat->active = 1;
+        cheat->codesCount = b.count;
+        cheat->codes = set->codes[i];
+    }
+
+    for(u32 i = 0; i < NB_PASSES; i++)
+    {
+        set->keys[i] = randomU32(0xFFF) & randomU32(0xFFF);
+        set->touch[i].px = randomU32(319);
+        set->touch[i].py = randomU32(239);
+    }
+    set->rngSeed = (u64)randomU32(0xFFFFFFFF) << 32 | randomU32(0xFFFFFFFF);
+}
+
+static void resetProcess(CheatSet *set)
+{
+    for(u32 i = 0; i < CHEAT_PROCESS_REGION_COUNT; i++)
+        memcpy(cheatProcessRegions[i].data, initialMemory[i], cheatProcessRegions[i].size);
+    memset(cheatPage, 0, sizeof(cheatPage));
+    cheatRngState = set->rngSeed;
+
+    for(u32 i = 0; i < set->count; i++)
+    {
+        CheatDescription *cheat = &set->cheats[i];
+        cheat->storage1 = cheat->storage2 = 0;
+        cheat->activeStorage = 0;
+        cheat->valid = 1;
+    }
+}
+
+static void getResult(CheatSet *set, CheatResult *result, bool reference)
+{
+    memset(result, 0, sizeof(CheatResult));
+    for(u32 i = 0; i < set->count; i++)
+    {
+        result->storage1[i] = set->cheats[i].storage1;
+        result->storage2[i] = set->cheats[i].storage2;
+        result->activeStorage[i] = set->cheats[i].activeStorage;
+    }
+
+    result->index = reference ? referenceState.index : cheat_state.index;
+    result->offset1 = reference ? referenceState.offset1 : cheat_state.offset1;
+    result->offset2 = reference ? referenceState.offset2 : cheat_state.offset2;
+    result->data1 = reference ? referenceState.data1 : cheat_state.data1;
+    result->data2 = reference ? referenceState.data2 : cheat_state.data2;
+    result->rngState = cheatRngState;
+}
+
+static u32 nbValid, nbApplied;
+static u8 expectedCheatPage[sizeof(cheatPage)];
+
+static bool testCheatSet(u32 setIndex, CheatSet *set)
+{
+    CheatResult expected[NB_PASSES], actual;
+
+    resetProcess(set);
+    for(u32 pass = 0; pass < NB_PASSES; pass++)
+    {
+        bool valid[MAX_CHEATS] = { false };
+
+        cheatProcessSetKeys(set->keys[pass]);
+        cheatProcessTouch = set->touch[pass];
+        for(u32 i = 0; i < set->count; i++)
+            valid[i] = Cheat_ApplyCheatReference(CHEAT_PROCESS_HANDLE, &set->cheats[i]) != 0;
+        getResult(set, &expected[pass], true);
+        memcpy(expected[pass].valid, valid, sizeof(valid));
+    }
+
+    for(u32 i = 0; i < CHEAT_PROCESS_REGION_COUNT; i++)
+        memcpy(expectedMemory[i], cheatProcessRegions[i].data, cheatProcessRegions[i].size);
+    memcpy(expectedCheatPage, cheatPage, sizeof(cheatPage));
+
+    resetProcess(set);
+    for(u32 i = 0; i < set->count; i++)
+    {
+        set->cheats[i].program = set->programs[i];
+        Cheat_CompileCheat(&set->cheats[i]);
+    }
+
+    cheatSession.debug = CHEAT_PROCESS_HANDLE;
+    for(u32 pass = 0; pass < NB_PASSES; pass++)
+    {
+        cheatProcessSetKeys(set->keys[pass]);
+        cheatProcessTouch = set->touch[pass];
+        Cheat_ResetMemoryCache();
+        for(u32 i = 0; i < set->count; i++)
+            Cheat_ApplyCheatInSession(&set->cheats[i]);
+
+        getResult(set, &actual, false);
+        for(u32 i = 0; i < set->count; i++)
+        {
+            actual.valid[i] = set->cheats[i].valid;
+            nbValid += actual.valid[i];
+            nbApplied++;
+        }
+
+        if(memcmp(&actual, &expected[pass], sizeof(CheatResult)) != 0)
+        {
+            printf("FAIL: cheat set %lu, pass %lu: registers, storage or outcome differ (last line %lu, expected %lu)\n",
+                   (unsigned long)setIndex, (unsigned long)pass, (unsigned long)actual.index,
+                   (unsigned long)expected[pass].index);
+            return false;
+        }
+    }
+
+    for(u32 i = 0; i < CHEAT_PROCESS_REGION_COUNT; i++)
+    {
+        if(memcmp(expectedMemory[i], cheatProcessRegions[i].data, cheatProcessRegions[i].size) != 0)
+        {
+            printf("FAIL: cheat set %lu: process memory differs at 0x%08lx\n", (unsigned long)setIndex,
+                   (unsigned long)cheatProcessRegions[i].base);
+            return false;
+        }
+    }
+    if(memcmp(expectedCheatPage, cheatPage, sizeof(cheatPage)) != 0)
+    {
+        printf("FAIL: cheat set %lu: cheat page differs\n", (unsigned long)setIndex);
+        return false;
+    }
+
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    u32 nbSets = argc > 1 ? (u32)strtoul(argv[1], NULL, 0) : 3000, nbFailures = 0;
+    CheatSet *set = (CheatSet *)malloc(sizeof(CheatSet));
+
+    cheatProcessInit();
+    for(u32 i = 0; i < CHEAT_PROCESS_REGION_COUNT; i++)
+    {
+        initialMemory[i] = (u8 *)malloc(cheatProcessRegions[i].size);
+        expectedMemory[i] = (u8 *)malloc(cheatProcessRegions[i].size);
+    }
+
+    for(u32 i = 0; i < nbSets; i++)
+    {
+        if(i % 64 == 0)
+            makeMemory();
+        makeCheatSet(set);
+        if(!testCheatSet(i, set))
+            nbFailures++;
+    }
+
+    if(nbFailures != 0)
+        return 1;
+
+    printf("cheat_vm_test: OK (%lu cheat sets, %lu of %lu cheat applications valid)\n", (unsigned long)nbSets,
+           (unsigned long)nbValid, (unsigned long)nbApplied);
+    return 0;
+}
@@ -0,0 +1,1551 @@
+/*
+    The cheat interpreter Rosalina used before cheats were compiled (Cheat_ApplyCheat and the accessors it used, from
+    sysmodules/rosalina/source/menus/cheats.c), for the host tests of the compiled one. To be included after
+    cheats.c: it shares its cheat descriptions, cheatPage, random number generator and svc calls, and only has its
+    own register state. Everything else is as it was, identifiers aside, which have a Reference suffix.
+*/
+
+#pragma once
+
+typedef struct ReferenceCheatState
+{
+    u32 index;
+    u32 offset1;
+    u32 offset2;
+    u32 data1;
+    u32 data2;
+    struct {
+        u8 activeOffset : 1;
+        u8 activeData : 1;
+        u8 conditionalMode : 3;
+        u8 data1Mode : 1;
+        u8 data2Mode : 1;
+        u8 floatMode : 1;
+    };
+    u8 typeELine;
+    u8 typeEIdx;
+
+    s8 loopLine;
+    u32 loopCount;
+
+    u32 ifStack;
+    u32 storedStack;
+    u8 ifCount;
+    u8 storedIfCount;
+
+} ReferenceCheatState;
+
+static ReferenceCheatState referenceState = { 0 };
+
+static inline u32* activeOffsetReference()
+{
+    return referenceState.activeOffset ? &referenceState.offset2 : &referenceState.offset1;
+}
+
+static inline u32* activeDataReference()
+{
+    return referenceState.activeData ? &referenceState.data2 : &referenceState.data1;
+}
+
+static inline u32* activeStorageReference(CheatDescription* desc)
+{
+    return desc->activeStorage ? &desc->storage2 : &desc->storage1;
+}
+
+static bool Cheat_IsValidAddressReference(const Handle processHandle, u32 address, u32 size)
+{
+    MemInfo info;
+    PageInfo out;
+
+    Result res = svcQueryDebugProcessMemory(&info, &out, processHandle, address);
+    if (R_SUCCEEDED(res) && info.state != MEMSTATE_FREE && info.base_addr > 0 && info.base_addr <= address && address <= info.base_addr + info.size - size) {
+        return true;
+    }
+    return false;
+}
+
+static u32 ReadWriteBuffer32Reference = 0;
+static u16 ReadWriteBuffer16Reference = 0;
+static u8 ReadWriteBuffer8Reference = 0;
+
+static bool Cheat_Write8Reference(const Handle processHandle, u32 offset, u8 value)
+{
+    u32 addr = *activeOffsetReference() + offset;
+    if (addr >= 0x01E81000 && addr < 0x01E82000)
+    {
+        cheatPage[addr - 0x01E81000] = value;
+        return true;
+    }
+    if (Cheat_IsValidAddressReference(processHandle, addr, 1))
+    {
+        *((u8*) (&ReadWriteBuffer8Reference)) = value;
+        return R_SUCCEEDED(svcWriteProcessMemory(processHandle, &ReadWriteBuffer8Reference, addr, 1));
+    }
+    return false;
+}
+
+static bool Cheat_Write16Reference(const Handle processHandle, u32 offset, u16 value)
+{
+    u32 addr = *activeOffsetReference() + offset;
+    if (addr >= 0x01E81000 && addr + 1 < 0x01E82000)
+    {
+        *(u16*)(cheatPage + addr - 0x01E81000) = value;
+        return true;
+    }
+    if (Cheat_IsValidAddressReference(processHandle, addr, 2))
+    {
+        *((u16*) (&ReadWriteBuffer16Reference)) = value;
+        return R_SUCCEEDED(svcWriteProcessMemory(processHandle, &ReadWriteBuffer16Reference, addr, 2));
+    }
+    return false;
+}
+
+static bool Cheat_Write32Reference(const Handle processHandle, u32 offset, u32 value)
+{
+    u32 addr = *activeOffsetReference() + offset;
+    if (addr >= 0x01E81000 && addr + 3 < 0x01E82000)
+    {
+        *(u32*)(cheatPage + addr - 0x01E81000) = value;
+        return true;
+    }
+    if (Cheat_IsValidAddressReference(processHandle, addr, 4))
+    {
+        *((u32*) (&ReadWriteBuffer32Reference)) = value;
+        return R_SUCCEEDED(svcWriteProcessMemory(processHandle, &ReadWriteBuffer32Reference, addr, 4));
+    }
+    return false;
+}
+
+static bool Cheat_Read8Reference(const Handle processHandle, u32 offset, u8* retValue)
+{
+    u32 addr = *activeOffsetReference() + offset;
+    if (addr >= 0x01E81000 && addr < 0x01E82000)
+    {
+        *retValue = cheatPage[addr - 0x01E81000];
+        return true;
+    }
+    if (Cheat_IsValidAddressReference(processHandle, addr, 1))
+    {
+        Result res = svcReadProcessMemory(&ReadWriteBuffer8Reference, processHandle, addr, 1);
+        *retValue = *((u8*) (&ReadWriteBuffer8Reference));
+        return R_SUCCEEDED(res);
+    }
+    return false;
+}
+
+static bool Cheat_Read16Reference(const Handle processHandle, u32 offset, u16* retValue)
+{
+    u32 addr = *activeOffsetReference() + offset;
+    if (addr >= 0x01E81000 && addr + 1 < 0x01E82000)
+    {
+        *retValue = *(u16*)(cheatPage + addr - 0x01E81000);
+        return true;
+    }
+    if (Cheat_IsValidAddressReference(processHandle, addr, 2))
+    {
+        Result res = svcReadProcessMemory(&ReadWriteBuffer16Reference, processHandle, addr, 2);
+        *retValue = *((u16*) (&ReadWriteBuffer16Reference));
+        return R_SUCCEEDED(res);
+    }
+    return false;
+}
+
+static bool Cheat_Read32Reference(const Handle processHandle, u32 offset, u32* retValue)
+{
+    u32 addr = *activeOffsetReference() + offset;
+    if (addr >= 0x01E81000 && addr + 3 < 0x01E82000)
+    {
+        *retValue = *(u32*)(cheatPage + addr - 0x01E81000);
+        return true;
+    }
+    if (Cheat_IsValidAddressReference(processHandle, addr, 4))
+    {
+        Result res = svcReadProcessMemory(&ReadWriteBuffer32Reference, processHandle, addr, 4);
+        *retValue = *((u32*) (&ReadWriteBuffer32Reference));
+        return R_SUCCEEDED(res);
+    }
+    return false;
+}
+
+static u8 typeEMappingReference[] = { 4 << 3, 5 << 3, 6 << 3, 7 << 3, 0 << 3, 1 << 3, 2 << 3, 3 << 3 };
+
+static u8 Cheat_GetNextTypeEReference(const CheatDescription* cheat)
+{
+
+    if (referenceState.typeEIdx == 7)
+    {
+        referenceState.typeEIdx = 0;
+        referenceState.typeELine++;
+    }
+    else
+    {
+        referenceState.typeEIdx++;
+    }
+    return (u8) ((cheat->codes[referenceState.typeELine] >> (typeEMappingReference[referenceState.typeEIdx])) & 0xFF);
+}
+
+static u32 Cheat_ApplyCheatReference(const Handle processHandle, CheatDescription* const cheat)
+{
+    referenceState.index = 0;
+    referenceState.offset1 = 0;
+    referenceState.offset2 = 0;
+    referenceState.data1 = 0;
+    referenceState.data2 = 0;
+    referenceState.activeOffset = 0;
+    referenceState.activeData = 0;
+    referenceState.conditionalMode = 0;
+    referenceState.data1Mode = 0;
+    referenceState.data2Mode = 0;
+    referenceState.floatMode = 0;
+    referenceState.loopCount = 0;
+    referenceState.loopLine = -1;
+    referenceState.ifStack = 0;
+    referenceState.storedStack = 0;
+    referenceState.ifCount = 0;
+    referenceState.storedIfCount = 0;
+
+    while (referenceState.index < cheat->codesCount)
+    {
+        bool skipExecution = (referenceState.ifStack & 0x00000001) != 0;
+        u32 arg0 = (u32) ((cheat->codes[referenceState.index] >> 32) & 0x00000000FFFFFFFFULL);
+        u32 arg1 = (u32) ((cheat->codes[referenceState.index]) & 0x00000000FFFFFFFFULL);
+        if (arg0 == 0 && arg1 == 0)
+        {
+            return 0;
+        }
+        u32 code = ((arg0 >> 28) & 0x0F);
+        u32 subcode = ((arg0 >> 24) & 0x0F);
+        u32 codeArg = arg0 & 0x0F;
+
+        switch (code)
+        {
+            case 0x0:
+                // 0 Type
+                // Format: 0XXXXXXX YYYYYYYY
+                // Description: 32bit write of YYYYYYYY to 0XXXXXXX.
+                if (!skipExecution)
+                {
+                    if (!Cheat_Write32Reference(processHandle, (arg0 & 0x0FFFFFFF), arg1)) return 0;
+                }
+                break;
+            case 0x1:
+                // 1 Type
+                // Format: 1XXXXXXX 0000YYYY
+                // Description: 16bit write of YYYY to 0XXXXXXX.
+                if (!skipExecution)
+                {
+                    if (!Cheat_Write16Reference(processHandle, (arg0 & 0x0FFFFFFF), (u16) (arg1 & 0xFFFF))) return 0;
+                }
+                break;
+            case 0x2:
+                // 2 Type
+                // Format: 2XXXXXXX 000000YY
+                // Description: 8bit write of YY to 0XXXXXXX.
+                if (!skipExecution)
+                {
+                    if (!Cheat_Write8Reference(processHandle, (arg0 & 0x0FFFFFFF), (u8) (arg1 & 0xFF))) return 0;
+                }
+                break;
+            case 0x3:
+                // 3 Type
+                // Format: 3XXXXXXXX YYYYYYYY
+                // Description: 32bit if less than.
+                // Simple: If the value at address 0XXXXXXX is less than the value YYYYYYYY.
+                // Example: 323D6B28 10000000
+            {
+                bool newSkip;
+                u32 value = 0;
+                switch (referenceState.conditionalMode)
+                {
+                    case 0x0:
+                        if (!Cheat_Read32Reference(processHandle, arg0 & 0x0FFFFFFF, &value)) return 0;
+                        newSkip = !(value < arg1);
+                        break;
+                    case 0x1:
+                        if (!Cheat_Read32Reference(processHandle, arg0 & 0x0FFFFFFF, &value)) return 0;
+                        newSkip = !(value < *activeDataReference());
+                        break;
+                    case 0x2:
+                        newSkip = !(*activeDataReference() < arg1);
+                        break;
+                    case 0x3:
+                        newSkip = !(*activeStorageReference(cheat) < arg1);
+                        break;
+                    case 0x4:
+                        newSkip = !(*activeDataReference() < *activeStorageReference(cheat));
+                        break;
+                    default:
+                        return 0;
+                }
+                referenceState.ifStack <<= 1;
+                referenceState.ifStack |= (newSkip || skipExecution) ? 1 : 0;
+                referenceState.ifCount++;
+            }
+                break;
+            case 0x4:
+                // 4 Type
+                // Format: 4XXXXXXXX YYYYYYYY
+                // Description: 32bit if greater than.
+                // Simple: If the value at address 0XXXXXXX is greater than the value YYYYYYYY.
+                // Example: 423D6B28 10000000
+            {
+                bool newSkip;
+                u32 value = 0;
+                switch (referenceState.conditionalMode)
+                {
+                    case 0x0:
+                        if (!Cheat_Read32Reference(processHandle, arg0 & 0x0FFFFFFF, &value)) return 0;
+                        newSkip = !(value > arg1);
+                        break;
+                    case 0x1:
+                        if (!Cheat_Read32Reference(processHandle, arg0 & 0x0FFFFFFF, &value)) return 0;
+                        newSkip = !(value > *activeDataReference());
+                        break;
+                    case 0x2:
+                        newSkip = !(*activeDataReference() > arg1);
+                        break;
+                    case 0x3:
+                        newSkip = !(*activeStorageReference(cheat) > arg1);
+                        break;
+                    case 0x4:
+                        newSkip = !(*activeDataReference() > *activeStorageReference(cheat));
+                        break;
+                    default:
+                        return 0;
+                }
+                referenceState.ifStack <<= 1;
+                referenceState.ifStack |= (newSkip || skipExecution) ? 1 : 0;
+                referenceState.ifCount++;
+            }
+                break;
+            case 0x5:
+                // 5 Type
+                // Format: 5XXXXXXXX YYYYYYYY
+                // Description: 32bit if equal to.
+                // Simple: If the value at address 0XXXXXXX is equal to the value YYYYYYYY.
+                // Example: 523D6B28 10000000
+            {
+                bool newSkip;
+                u32 value = 0;
+                switch (referenceState.conditionalMode)
+                {
+                    case 0x0:
+                        if (!Cheat_Read32Reference(processHandle, arg0 & 0x0FFFFFFF, &value)) return 0;
+                        newSkip = !(value == arg1);
+                        break;
+                    case 0x1:
+                        if (!Cheat_Read32Reference(processHandle, arg0 & 0x0FFFFFFF, &value)) return 0;
+                        newSkip = !(value == *activeDataReference());
+                        break;
+                    case 0x2:
+                        newSkip = !(*activeDataReference() == arg1);
+                        break;
+                    case 0x3:
+                        newSkip = !(*activeStorageReference(cheat) == arg1);
+                        break;
+                    case 0x4:
+                        newSkip = !(*activeDataReference() == *activeStorageReference(cheat));
+                        break;
+                    default:
+                        return 0;
+                }
+                referenceState.ifStack <<= 1;
+                referenceState.ifStack |= (newSkip || skipExecution) ? 1 : 0;
+                referenceState.ifCount++;
+            }
+                break;
+            case 0x6:
+                // 6 Type
+                // Format: 3XXXXXXXX YYYYYYYY
+                // Description: 32bit if not equal to.
+                // Simple: If the value at address 0XXXXXXX is not equal to the value YYYYYYYY.
+                // Example: 623D6B28 10000000
+            {
+                bool newSkip;
+                u32 value = 0;
+                switch (referenceState.conditionalMode)
+                {
+                    case 0x0:
+                        if (!Cheat_Read32Reference(processHandle, arg0 & 0x0FFFFFFF, &value)) return 0;
+                        newSkip = !(value != arg1);
+                        break;
+                    case 0x1:
+                        if (!Cheat_Read32Reference(processHandle, arg0 & 0x0FFFFFFF, &value)) return 0;
+                        newSkip = !(value != *activeDataReference());
+                        break;
+                    case 0x2:
+                        newSkip = !(*activeDataReference() != arg1);
+                        break;
+                    case 0x3:
+                        newSkip = !(*activeStorageReference(cheat) != arg1);
+                        break;
+                    case 0x4:
+                        newSkip = !(*activeDataReference() != *activeStorageReference(cheat));
+                        break;
+                    default:
+                        return 0;
+                }
+                referenceState.ifStack <<= 1;
+                referenceState.ifStack |= (newSkip || skipExecution) ? 1 : 0;
+                referenceState.ifCount++;
+            }
+                break;
+            case 0x7:
+                // 7 Type
+                // Format: 7XXXXXXXX 0000YYYY
+                // Description: 16bit if less than.
+                // Simple: If the value at address 0XXXXXXX is less than the value YYYY.
+                // Example: 723D6B28 00005400
+            {
+                bool newSkip;
+                u16 mask = (u16) ((arg1 >> 16) & 0xFFFF);
+                u16 value = 0;
+
+                switch (referenceState.conditionalMode)
+                {
+                    case 0x0:
+                        if (!Cheat_Read16Reference(processHandle, arg0 & 0x0FFFFFFF, &value)) return 0;
+                        newSkip = !((value & (~mask)) < (arg1 & 0xFFFF));
+                        break;
+                    case 0x1:
+                        if (!Cheat_Read16Reference(processHandle, arg0 & 0x0FFFFFFF, &value)) return 0;
+                        newSkip = !((value & (~mask)) < (*activeDataReference() & (~mask)));
+                        break;
+                    case 0x2:
+                        newSkip = !((*activeDataReference() & (~mask)) < (arg1 & 0xFFFF));
+                        break;
+                    case 0x3:
+                        newSkip = !((*activeStorageReference(cheat) & (~mask)) < (arg1 & 0xFFFF));
+                        break;
+                    case 0x4:
+                        newSkip = !((*activeDataReference() & (~mask)) < (*activeStorageReference(cheat) & (~mask)));
+                        break;
+                    default:
+                        return 0;
+                }
+                referenceState.ifStack <<= 1;
+                referenceState.ifStack |= (newSkip || skipExecution) ? 1 : 0;
+                referenceState.ifCount++;
+            }
+                break;
+            case 0x8:
+                // 8 Type
+                // Format: 8XXXXXXXX 0000YYYY
+                // Description: 16bit if greater than.
+                // Simple: If the value at address 0XXXXXXX is greater than the value YYYY.
+                // Example: 823D6B28 00005400
+            {
+                bool newSkip;
+                u16 mask = (u16) ((arg1 >> 16) & 0xFFFF);
+                u16 value = 0;
+
+                switch (referenceState.conditionalMode)
+                {
+                    case 0x0:
+                        if (!Cheat_Read16Reference(processHandle, arg0 & 0x0FFFFFFF, &value)) return 0;
+                        newSkip = !((value & (~mask)) > (arg1 & 0xFFFF));
+                        break;
+                    case 0x1:
+                        if (!Cheat_Read16Reference(processHandle, arg0 & 0x0FFFFFFF, &value)) return 0;
+                        newSkip = !((value & (~mask)) > (*activeDataReference() & (~mask)));
+                        break;
+                    case 0x2:
+                        newSkip = !((*activeDataReference() & (~mask)) > (arg1 & 0xFFFF));
+                        break;
+                    case 0x3:
+                        newSkip = !((*activeStorageReference(cheat) & (~mask)) > (arg1 & 0xFFFF));
+                        break;
+                    case 0x4:
+                        newSkip = !((*activeDataReference() & (~mask)) > (*activeStorageReference(cheat) & (~mask)));
+                        break;
+                    default:
+                        return 0;
+                }
+
+                referenceState.ifStack <<= 1;
+                referenceState.ifStack |= (newSkip || skipExecution) ? 1 : 0;
+                referenceState.ifCount++;
+            }
+                break;
+            case 0x9:
+                // 9 Type
+                // Format: 9XXXXXXXX 0000YYYY
+                // Description: 16bit if equal to.
+                // Simple: If the value at address 0XXXXXXX is equal to the value YYYY.
+                // Example: 923D6B28 00005400
+            {
+                bool newSkip;
+                u16 mask = (u16) ((arg1 >> 16) & 0xFFFF);
+                u16 value = 0;
+				
+                switch (referenceState.conditionalMode)
+                {
+                    case 0x0:
+                        if (!Cheat_Read16Reference(processHandle, arg0 & 0x0FFFFFFF, &value)) return 0;
+                        newSkip = !((value & (~mask)) == (arg1 & 0xFFFF));
+                        break;
+                    case 0x1:
+                        if (!Cheat_Read16Reference(processHandle, arg0 & 0x0FFFFFFF, &value)) return 0;
+                        newSkip = !((value & (~mask)) == (*activeDataReference() & (~mask)));
+                        break;
+                    case 0x2:
+                        newSkip = !((*activeDataReference() & (~mask)) == (arg1 & 0xFFFF));
+                        break;
+                    case 0x3:
+                        newSkip = !((*activeStorageReference(cheat) & (~mask)) == (arg1 & 0xFFFF));
+                        break;
+                    case 0x4:
+                        newSkip = !((*activeDataReference() & (~mask)) == (*activeStorageReference(cheat) & (~mask)));
+                        break;
+                    default:
+                        return 0;
+                }
+
+                referenceState.ifStack <<= 1;
+                referenceState.ifStack |= (newSkip || skipExecution) ? 1 : 0;
+                referenceState.ifCount++;
+            }
+                break;
+            case 0xA:
+                // A Type
+                // Format: AXXXXXXXX 0000YYYY
+                // Description: 16bit if not equal to.
+                // Simple: If the value at address 0XXXXXXX is not equal to the value YYYY.
+                // Example: A23D6B28 00005400
+            {
+                bool newSkip;
+                u16 mask = (u16) ((arg1 >> 16) & 0xFFFF);
+                u16 value = 0;
+
+                switch (referenceState.conditionalMode)
+                {
+                    case 0x0:
+                        if (!Cheat_Read16Reference(processHandle, arg0 & 0x0FFFFFFF, &value)) return 0;
+                        newSkip = !((value & (~mask)) != (arg1 & 0xFFFF));
+                        break;
+                    case 0x1:
+                        if (!Cheat_Read16Reference(processHandle, arg0 & 0x0FFFFFFF, &value)) return 0;
+                        newSkip = !((value & (~mask)) != (*activeDataReference() & (~mask)));
+                        break;
+                    case 0x2:
+                        newSkip = !((*activeDataReference() & (~mask)) != (arg1 & 0xFFFF));
+                        break;
+                    case 0x3:
+                        newSkip = !((*activeStorageReference(cheat) & (~mask)) != (arg1 & 0xFFFF));
+                        break;
+                    case 0x4:
+                        newSkip = !((*activeDataReference() & (~mask)) != (*activeStorageReference(cheat) & (~mask)));
+                        break;
+                    default:
+                        return 0;
+                }
+
+                referenceState.ifStack <<= 1;
+                referenceState.ifStack |= (newSkip || skipExecution) ? 1 : 0;
+                referenceState.ifCount++;
+            }
+                break;
+
+            case 0xB:
+                // B Type
+                // Format: BXXXXXXX 00000000
+                // Description: Loads offset register with value at given XXXXXXX
+                if (!skipExecution)
+                {
+                    u32 value;
+                    if (!Cheat_Read32Reference(processHandle, arg0 & 0x0FFFFFFF, &value)) return 0;
+                    *activeOffsetReference() = value;
+                }
+                break;
+            case 0xC:
+                // C Type
+                // Format: C0000000 ZZZZZZZZ
+                // Description: Repeat following lines at specified offset.
+                // Simple: used to write a value to an address, and then continues to write that value Z number of times to all addresses at an offset determined by the (D6, D7, D8, or DC) type following it.
+                // Note: used with the D6, D7, D8, and DC types. C types can not be nested.
+                // Example:
+
+                // C0000000 00000005
+                // 023D6B28 0009896C
+                // DC000000 00000010
+                // D2000000 00000000
+                switch (subcode)
+                {
+                    case 0x00:
+                        referenceState.loopLine = referenceState.index;
+                        referenceState.loopCount = arg1;
+                        referenceState.storedStack = referenceState.ifStack;
+                        referenceState.storedIfCount = referenceState.ifCount;
+                        break;
+                    case 0x01:
+                        referenceState.loopLine = referenceState.index;
+                        referenceState.loopCount = referenceState.data1;
+                        referenceState.storedStack = referenceState.ifStack;
+                        referenceState.storedIfCount = referenceState.ifCount;
+                        break;
+                    case 0x02:
+                        referenceState.loopLine = referenceState.index;
+                        referenceState.loopCount = referenceState.data2;
+                        referenceState.storedStack = referenceState.ifStack;
+                        referenceState.storedIfCount = referenceState.ifCount;
+                        break;
+                }
+                break;
+            case 0xD:
+                switch (subcode)
+                {
+                    case 0x00:
+                        // D0 Type
+                        // Format: D0000000 00000000
+                        // Description: ends most recent conditional.
+                        // Simple: type 3 through A are all "conditionals," the conditional most recently executed before this line will be terminated by it.
+                        // Example:
+
+                        // 94000130 FFFB0000
+                        // 74000100 FF00000C
+                        // 023D6B28 0009896C
+                        // D0000000 00000000
+
+                        // The 7 type line would be terminated.
+                        if (arg1 == 0)
+                        {
+                            if (referenceState.loopLine != -1)
+                            {
+                                if (referenceState.ifCount > 0 && referenceState.ifCount > referenceState.storedIfCount)
+                                {
+                                    referenceState.ifStack >>= 1;
+                                    referenceState.ifCount--;
+                                }
+                                else
+                                {
+
+                                    if (referenceState.loopCount > 0)
+                                    {
+                                        referenceState.loopCount--;
+                                        if (referenceState.loopCount == 0)
+                                        {
+                                            referenceState.loopLine = -1;
+                                        }
+                                        else if (referenceState.loopLine != -1)
+                                        {
+                                            referenceState.index = referenceState.loopLine;
+                                        }
+                                    }
+                                }
+                            }
+                            else
+                            {
+                                if (referenceState.ifCount > 0)
+                                {
+                                    referenceState.ifStack >>= 1;
+                                    referenceState.ifCount--;
+                                }
+                            }
+                        }
+                        // D0000000 00000001
+                        // Loop break
+                        else if (!skipExecution && arg1 == 1)
+                        {
+                            referenceState.loopCount = 0;
+                            referenceState.loopLine = -1;
+                            referenceState.index++;
+                            while (referenceState.index < cheat->codesCount)
+                            {
+                                u64 code = cheat->codes[referenceState.index++];
+                                if (code == 0xD100000000000000ull || code == 0xD200000000000000ull)
+                                {
+                                    break;
+                                }
+                            }
+                        }
+                        break;
+                    case 0x01:
+                        // D1 Type
+                        // Format: D1000000 00000000
+                        // Description: ends repeat block.
+                        // Simple: will end all conditionals within a C type code, along with the C type itself.
+                        // Example:
+
+                        // 94000130 FFFB0000
+                        // C0000000 00000010
+                        // 8453DA0C 00000200
+                        // 023D6B28 0009896C
+                        // D6000000 00000005
+                        // D1000000 00000000
+
+                        // The C line, 8 line, 0 line, and D6 line would be terminated.
+                        if (referenceState.loopCount > 0)
+                        {
+                            referenceState.ifStack = referenceState.storedStack;
+                            referenceState.ifCount = referenceState.storedIfCount;
+                            referenceState.loopCount--;
+                            if (referenceState.loopCount == 0)
+                            {
+                                referenceState.loopLine = -1;
+                            }
+                            else
+                            {
+                                if (referenceState.loopLine != -1)
+                                {
+                                    referenceState.index = referenceState.loopLine;
+                                }
+                            }
+                        }
+                        break;
+                    case 0x02:
+                        // D2 Type
+                        // Format: D2000000 00000000
+                        // Description: ends all conditionals/repeats before it and sets offset and stored to zero.
+                        // Simple: ends all lines.
+                        // Example:
+
+                        // 94000130 FEEF0000
+                        // C0000000 00000010
+                        // 8453DA0C 00000200
+                        // 023D6B28 0009896C
+                        // D6000000 00000005
+                        // D2000000 00000000
+
+                        // All lines would terminate.
+                        if (arg1 == 0)
+                        {
+                            if (referenceState.loopCount > 0)
+                            {
+                                referenceState.loopCount--;
+                                if (referenceState.loopCount == 0)
+                                {
+                                    *activeDataReference() = 0;
+                                    *activeOffsetReference() = 0;
+                                    referenceState.loopLine = -1;
+
+                                    referenceState.ifStack = 0;
+                                    referenceState.ifCount = 0;
+                                }
+                                else
+                                {
+                                    if (referenceState.loopLine != -1)
+                                    {
+                                        referenceState.index = referenceState.loopLine;
+                                    }
+                                }
+                            }
+                            else
+                            {
+                                *activeDataReference() = 0;
+                                *activeOffsetReference() = 0;
+                                referenceState.ifStack = 0;
+                                referenceState.ifCount = 0;
+                            }
+                        }
+                        // D2000000 00000001
+                        // Return
+                        else if (!skipExecution && arg1 == 1)
+                        {
+                            referenceState.index = cheat->codesCount;
+                        }
+                        break;
+                    case 0x03:
+                        // D3 Type
+                        // Format: D3000000 XXXXXXXX
+                        // Description: sets offset.
+                        // Simple: loads the address X so that lines after can modify the value at address X.
+                        // Note: used with the D4, D5, D6, D7, D8, and DC types.
+                        // Example: D3000000 023D6B28
+                        if (!skipExecution)
+                        {
+                            if (codeArg == 0)
+                            {
+                                referenceState.offset1 = arg1;
+                            }
+                            else if (codeArg == 1)
+                            {
+                                referenceState.offset2 = arg1;
+                            }
+                        }
+                        break;
+                    case 0x04:
+                        // D4 Type
+                        // Format: D4000000 YYYYYYYY
+                        // Description: adds to the stored address' value.
+                        // Simple: adds to the value at the address defined by lines D3, D9, DA, and DB.
+                        // Note: used with the D3, D9, DA, DB, DC types.
+                        // Example: D4000000 00000025
+                        if (!skipExecution)
+                        {
+                            if (codeArg == 0)
+                            {
+                                *activeDataReference() += arg1;
+                            }
+                            else if (codeArg == 1)
+                            {
+                                referenceState.data1 += arg1 + referenceState.data2;
+                            }
+                            else if (codeArg == 2)
+                            {
+                                referenceState.data2 += arg1 + referenceState.data1;
+                            }
+                        }
+                        break;
+                    case 0x05:
+                        // D5 Type
+                        // Format: D5000000 YYYYYYYY
+                        // Description: sets the stored address' value.
+                        // Simple: makes the value at the address defined by lines D3, D9, DA, and DB to YYYYYYYY.
+                        // Note: used with the D3, D9, DA, DB, and DC types.
+                        // Example: D5000000 34540099
+                        if (!skipExecution)
+                        {
+                            if (codeArg == 0)
+                            {
+                                *activeDataReference() = arg1;
+                            }
+                            else if (codeArg == 1)
+                            {
+                                referenceState.data1 = arg1;
+                            }
+                            else if (codeArg == 2)
+                            {
+                                referenceState.data2 = arg1;
+                            }
+                        }
+                        break;
+                    case 0x06:
+                        // D6 Type
+                        // Format: D6000000 XXXXXXXX
+                        // Description: 32bit store and increment by 4.
+                        // Simple: stores the value at address XXXXXXXX and to addresses in increments of 4.
+                        // Note: used with the C, D3, and D9 types.
+                        // Example: D3000000 023D6B28
+                        if (!skipExecution)
+                        {
+                            if (codeArg == 0)
+                            {
+                                if (!Cheat_Write32Reference(processHandle, arg1, *activeDataReference())) return 0;
+                                *activeOffsetReference() += 4;
+                            }
+                            else if (codeArg == 1)
+                            {
+                                if (!Cheat_Write32Reference(processHandle, arg1, referenceState.data1)) return 0;
+                                *activeOffsetReference() += 4;
+                            }
+                            else if (codeArg == 2)
+                            {
+                                if (!Cheat_Write32Reference(processHandle, arg1, referenceState.data2)) return 0;
+                                *activeOffsetReference() += 4;
+                            }
+                        }
+                        break;
+                    case 0x07:
+                        // D7 Type
+                        // Format: D7000000 XXXXXXXX
+                        // Description: 16bit store and increment by 2.
+                        // Simple: stores 2 bytes of the value at address XXXXXXXX and to addresses in increments of 2.
+                        // Note: used with the C, D3, and DA types.
+                        // Example: D7000000 023D6B28
+                        if (!skipExecution)
+                        {
+                            if (codeArg == 0)
+                            {
+                                if (!Cheat_Write16Reference(processHandle, arg1, (u16) (*activeDataReference() & 0xFFFF))) return 0;
+                                *activeOffsetReference() += 2;
+                            }
+                            else if (codeArg == 1)
+                            {
+                                if (!Cheat_Write16Reference(processHandle, arg1, (u16) (referenceState.data1 & 0xFFFF))) return 0;
+                                *activeOffsetReference() += 2;
+                            }
+                            else if (codeArg == 2)
+                            {
+                                if (!Cheat_Write16Reference(processHandle, arg1, (u16) (referenceState.data2 & 0xFFFF))) return 0;
+                                *activeOffsetReference() += 2;
+                            }
+                        }
+                        break;
+                    case 0x08:
+                        // D8 Type
+                        // Format: D8000000 XXXXXXXX
+                        // Description: 8bit store and increment by 1.
+                        // Simple: stores 1 byte of the value at address XXXXXXXX and to addresses in increments of 1.
+                        // Note: used with the C, D3, and DB types.
+                        // Example: D8000000 023D6B28
+                        if (!skipExecution)
+                        {
+                            if (codeArg == 0)
+                            {
+                                if (!Cheat_Write8Reference(processHandle, arg1, (u8) (*activeDataReference() & 0xFF))) return 0;
+                                *activeOffsetReference() += 1;
+                            }
+                            else if (codeArg == 1)
+                            {
+                                if (!Cheat_Write8Reference(processHandle, arg1, (u8) (referenceState.data1 & 0xFF))) return 0;
+                                *activeOffsetReference() += 1;
+                            }
+                            else if (codeArg == 2)
+                            {
+                                if (!Cheat_Write8Reference(processHandle, arg1, (u8) (referenceState.data2 & 0xFF))) return 0;
+                                *activeOffsetReference() += 1;
+                            }
+                        }
+                        break;
+                    case 0x09:
+                        // D9 Type
+                        // Format: D9000000 XXXXXXXX
+                        // Description: 32bit load.
+                        // Simple: loads the value from address X.
+                        // Note: used with the D5 and D6 types.
+                        // Example: D9000000 023D6B28
+                        if (!skipExecution)
+                        {
+                            if (codeArg == 0)
+                            {
+                                u32 value = 0;
+                                if (!Cheat_Read32Reference(processHandle, arg1, &value)) return 0;
+                                *activeDataReference() = value;
+                            }
+                            else if (codeArg == 1)
+                            {
+                                u32 value = 0;
+                                if (!Cheat_Read32Reference(processHandle, arg1, &value)) return 0;
+                                referenceState.data1 = value;
+                            }
+                            else if (codeArg == 2)
+                            {
+                                u32 value = 0;
+                                if (!Cheat_Read32Reference(processHandle, arg1, &value)) return 0;
+                                referenceState.data2 = value;
+                            }
+                        }
+                        break;
+                    case 0x0A:
+                        // DA Type
+                        // Format: DA000000 XXXXXXXX
+                        // Description: 16bit load.
+                        // Simple: loads 2 bytes from address X.
+                        // Note: used with the D5 and D7 types.
+                        // Example: DA000000 023D6B28
+                        if (!skipExecution)
+                        {
+                            if (codeArg == 0)
+                            {
+                                u16 value = 0;
+                                if (!Cheat_Read16Reference(processHandle, arg1, &value)) return 0;
+                                *activeDataReference() = value;
+                            }
+                            else if (codeArg == 1)
+                            {
+                                u16 value = 0;
+                                if (!Cheat_Read16Reference(processHandle, arg1, &value)) return 0;
+                                referenceState.data1 = value;
+                            }
+                            else if (codeArg == 2)
+                            {
+                                u16 value = 0;
+                                if (!Cheat_Read16Reference(processHandle, arg1, &value)) return 0;
+                                referenceState.data2 = value;
+                            }
+                        }
+                        break;
+                    case 0x0B:
+                        // DB Type
+                        // Format: DB000000 XXXXXXXX
+                        // Description: 8bit load.
+                        // Simple: loads 1 byte from address X.
+                        // Note: used with the D5 and D8 types.
+                        // Example: DB000000 023D6B28
+                        if (!skipExecution)
+                        {
+                            if (codeArg == 0)
+                            {
+                                u8 value = 0;
+                                if (!Cheat_Read8Reference(processHandle, arg1, &value)) return 0;
+                                *activeDataReference() = value;
+                            }
+                            else if (codeArg == 1)
+                            {
+                                u8 value = 0;
+                                if (!Cheat_Read8Reference(processHandle, arg1, &value)) return 0;
+                                referenceState.data1 = value;
+                            }
+                            else if (codeArg == 2)
+                            {
+                                u8 value = 0;
+                                if (!Cheat_Read8Reference(processHandle, arg1, &value)) return 0;
+                                referenceState.data2 = value;
+                            }
+                        }
+                        break;
+                    case 0x0C:
+                        // DC Type
+                        // Format: DC000000 VVVVVVVV
+                        // Description: 32bit store and increment by V.
+                        // Simple: stores the value at address(es) before it and to addresses in increments of V.
+                        // Note: used with the C, D3, D5, D9, D8, DB types.
+                        // Example: DC000000 00000100
+                        if (!skipExecution)
+                        {
+                            *activeOffsetReference() += arg1;
+                        }
+                        break;
+                    case 0x0D:
+                        // DD Type
+                    {
+                        bool newSkip = !(arg1 == 0 || (HID_PAD & arg1) == arg1);
+
+                        referenceState.ifStack <<= 1;
+                        referenceState.ifStack |= (newSkip || skipExecution) ? 1 : 0;;
+                        referenceState.ifCount++;
+                    }
+                        break;
+                    case 0x0E:
+                        // Touchpad conditional
+                        // DE000000 AAAABBBB: AAAA >= X position >= BBBB
+                        // DE000001 AAAABBBB: AAAA >= Y position >= BBBB
+                    {
+                        bool newSkip;
+                        u32 highBound = arg1 >> 16;
+                        u32 lowBound = arg1 & 0xFFFF;
+                        touchPosition touch;
+                        hidTouchRead(&touch);
+                        if (codeArg == 0)
+                        {
+                            newSkip = !(lowBound <= touch.px && highBound >= touch.px);
+                        }
+                        else if (codeArg == 1)
+                        {
+                            newSkip = !(lowBound <= touch.py && highBound >= touch.py);
+                        }
+                        else
+                        {
+                            return 0;
+                        }
+
+                        referenceState.ifStack <<= 1;
+                        referenceState.ifStack |= (newSkip || skipExecution) ? 1 : 0;
+                        referenceState.ifCount++;
+                    }
+                        break;
+                    case 0x0F:
+                    {
+                        switch (codeArg)
+                        {
+                            case 0x00:
+                            {
+                                if (arg1 & 0x00010000)
+                                {
+                                    if (arg1 & 0x1)
+                                    {
+                                        referenceState.offset2 = referenceState.offset1;
+                                    }
+                                    else
+                                    {
+                                        referenceState.offset1 = referenceState.offset2;
+                                    }
+                                }
+                                else if (arg1 & 0x00020000)
+                                {
+                                    if (arg1 & 0x1)
+                                    {
+                                        referenceState.data2 = referenceState.offset2;
+                                    }
+                                    else
+                                    {
+                                        referenceState.data1 = referenceState.offset1;
+                                    }
+                                }
+                                else
+                                {
+                                    referenceState.activeOffset = arg1 & 0x1;
+                                }
+                            }
+                                break;
+                            case 0x01:
+                            {
+                                if (arg1 & 0x00010000)
+                                {
+                                    if (arg1 & 0x1)
+                                    {
+                                        referenceState.data2 = referenceState.data1;
+                                    }
+                                    else
+                                    {
+                                        referenceState.data1 = referenceState.data2;
+                                    }
+                                }
+                                else if (arg1 & 0x00020000)
+                                {
+                                    if (arg1 & 0x1)
+                                    {
+                                        referenceState.offset2 = referenceState.data2;
+                                    }
+                                    else
+                                    {
+                                        referenceState.offset1 = referenceState.data1;
+                                    }
+                                }
+                                else
+                                {
+                                    referenceState.activeData = arg1 & 0x1;
+                                }
+                            }
+                                break;
+                            case 0x02:
+                            {
+                                if (arg1 & 0x00010000)
+                                {
+                                    if (arg1 & 0x1)
+                                    {
+                                        referenceState.data2 = cheat->storage2;
+                                    }
+                                    else
+                                    {
+                                        referenceState.data1 = cheat->storage1;
+                                    }
+                                }
+                                else if (arg1 & 0x00020000)
+                                {
+                                    if (arg1 & 0x1)
+                                    {
+                                        cheat->storage2 = referenceState.data2;
+                                    }
+                                    else
+                                    {
+                                        cheat->storage1 = referenceState.data1;
+                                    }
+                                }
+                                else
+                                {
+                                    cheat->activeStorage = arg1 & 0x1;
+                                }
+                            }
+                                break;
+                            case 0x0E:
+                            {
+                                if (referenceState.activeData)
+                                {
+                                    switch (arg1)
+                                    {
+                                        case 0x0:
+                                        {
+                                            referenceState.data2Mode = 0;
+                                        }
+                                            break;
+                                        case 0x1:
+                                        {
+                                            referenceState.data2Mode = 1;
+                                        }
+                                            break;
+                                        case 0x10:
+                                        {
+                                            referenceState.data2Mode = 0;
+                                            float val;
+                                            memcpy(&val, &referenceState.data2, sizeof(float));
+                                            referenceState.data2 = val;
+                                        }
+                                            break;
+                                        case 0x11:
+                                        {
+                                            referenceState.data2Mode = 1;
+                                            float val = referenceState.data2;
+                                            memcpy(&referenceState.data2, &val, sizeof(float));
+                                        }
+                                            break;
+                                        default:
+                                            return 0;
+                                    }
+                                }
+                                else
+                                {
+                                    switch (arg1)
+                                    {
+                                        case 0x0:
+                                        {
+                                            referenceState.data1Mode = 0;
+                                        }
+                                            break;
+                                        case 0x1:
+                                        {
+                                            referenceState.data1Mode = 1;
+                                        }
+                                            break;
+                                        case 0x10:
+                                        {
+                                            referenceState.data1Mode = 0;
+                                            float val;
+                                            memcpy(&val, &referenceState.data1, sizeof(float));
+                                            referenceState.data1 = val;
+                                        }
+                                            break;
+                                        case 0x11:
+                                        {
+                                            referenceState.data1Mode = 1;
+                                            float val = referenceState.data1;
+                                            memcpy(&referenceState.data1, &val, sizeof(float));
+                                        }
+                                            break;
+                                        default:
+                                            return 0;
+                                    }
+                                }
+                            }
+                                break;
+                            case 0x0F:
+                            {
+                                if (arg1 < 5)
+                                {
+                                    referenceState.conditionalMode = (u8)arg1;
+                                }
+                                else
+                                {
+                                    return 0;
+                                }
+                            }
+                                break;
+                            default:
+                                return 0;
+                        }
+                    }
+                        break;
+                    default:
+                        return 0;
+                }
+                break;
+            case 0xE:
+                // E Type
+                // Format:
+                // EXXXXXXX UUUUUUUU
+                // YYYYYYYY YYYYYYYY
+
+                // Description: writes Y to X for U bytes.
+
+            {
+                u32 beginOffset = (arg0 & 0x0FFFFFFF);
+                u32 count = arg1;
+                referenceState.typeELine = referenceState.index;
+                referenceState.typeEIdx = 7;
+                for (u32 i = 0; i < count; i++)
+                {
+                    u8 byte = Cheat_GetNextTypeEReference(cheat);
+                    if (!skipExecution)
+                    {
+                        if (!Cheat_Write8Reference(processHandle, beginOffset + i, byte)) return 0;
+                    }
+                }
+                referenceState.index = referenceState.typeELine;
+            }
+                break;
+            case 0xF:
+            {
+                if (arg0 == 0xF0F00000)
+                {
+                    // I have no clue how to implement this, or if it's even possible. Needs research.
+                    return 0;
+                }
+                else
+                {
+                    switch (subcode)
+                    {
+                        case 0x0:
+                        {
+                            if(!skipExecution)
+                            {
+                                referenceState.floatMode = arg1 & 0x1;
+                            }
+                        }
+                            break;
+                        case 0x1:
+                        {
+                            if (!skipExecution)
+                            {
+                                if (referenceState.floatMode)
+                                {
+                                    float flarg1;
+                                    memcpy(&flarg1, &arg1, sizeof(float));
+                                    u32 tmp;
+                                    if (!Cheat_Read32Reference(processHandle, arg0 & 0x00FFFFFF, &tmp))
+                                    {
+                                        return 0;
+                                    }
+                                    float value;
+                                    memcpy(&value, &tmp, sizeof(float));
+                                    value += flarg1;
+                                    memcpy(&tmp, &value, sizeof(u32));
+                                    if (!Cheat_Write32Reference(processHandle, arg0 & 0x00FFFFFF, tmp))
+                                    {
+                                        return 0;
+                                    }
+                                }
+                                else
+                                {
+                                    u32 tmp;
+                                    if (!Cheat_Read32Reference(processHandle, arg0 & 0x00FFFFFF, &tmp))
+                                    {
+                                        return 0;
+                                    }
+                                    tmp += arg1;
+                                    if (!Cheat_Write32Reference(processHandle, arg0 & 0x00FFFFFF, tmp))
+                                    {
+                                        return 0;
+                                    }
+                                }
+                            }
+                        }
+                            break;
+                        case 0x2:
+                        {
+                            if (!skipExecution)
+                            {
+                                if (referenceState.floatMode)
+                                {
+                                    float flarg1;
+                                    memcpy(&flarg1, &arg1, sizeof(float));
+                                    u32 tmp;
+                                    if (!Cheat_Read32Reference(processHandle, arg0 & 0x00FFFFFF, &tmp))
+                                    {
+                                        return 0;
+                                    }
+                                    float value;
+                                    memcpy(&value, &tmp, sizeof(float));
+                                    value *= flarg1;
+                                    memcpy(&tmp, &value, sizeof(u32));
+                                    if (!Cheat_Write32Reference(processHandle, arg0 & 0x00FFFFFF, tmp))
+                                    {
+                                        return 0;
+                                    }
+                                }
+                                else
+                                {
+                                    u32 tmp;
+                                    if (!Cheat_Read32Reference(processHandle, arg0 & 0x00FFFFFF, &tmp))
+                                    {
+                                        return 0;
+                                    }
+                                    tmp *= arg1;
+                                    if (!Cheat_Write32Reference(processHandle, arg0 & 0x00FFFFFF, tmp))
+                                    {
+                                        return 0;
+                                    }
+                                }
+                            }
+                        }
+                            break;
+                        case 0x3:
+                        {
+                            if (!skipExecution)
+                            {
+                                if (referenceState.floatMode)
+                                {
+                                    float flarg1;
+                                    memcpy(&flarg1, &arg1, sizeof(float));
+                                    u32 tmp;
+                                    if (!Cheat_Read32Reference(processHandle, arg0 & 0x00FFFFFF, &tmp))
+                                    {
+                                        return 0;
+                                    }
+                                    float value;
+                                    memcpy(&value, &tmp, sizeof(float));
+                                    value /= flarg1;
+                                    memcpy(&tmp, &value, sizeof(u32));
+                                    if (!Cheat_Write32Reference(processHandle, arg0 & 0x00FFFFFF, tmp))
+                                    {
+                                        return 0;
+                                    }
+                                }
+                                else
+                                {
+                                    u32 tmp;
+                                    if (!Cheat_Read32Reference(processHandle, arg0 & 0x00FFFFFF, &tmp))
+                                    {
+                                        return 0;
+                                    }
+                                    tmp /= arg1;
+                                    if (!Cheat_Write32Reference(processHandle, arg0 & 0x00FFFFFF, tmp))
+                                    {
+                                        return 0;
+                                    }
+                                }
+                            }
+                        }
+                            break;
+                        case 0x4:
+                        {
+                            if (!skipExecution)
+                            {
+                                if (referenceState.data1Mode)
+                                {
+                                    float flarg1;
+                                    memcpy(&flarg1, &arg1, sizeof(float));
+                                    float value;
+                                    memcpy(&value, activeDataReference(), sizeof(float));
+                                    value *= flarg1;
+                                    memcpy(activeDataReference(), &value, sizeof(float));
+                                }
+                                else
+                                {
+                                    *activeDataReference() *= arg1;
+                                }
+                            }
+                        }
+                            break;
+                        case 0x5:
+                        {
+                            if (!skipExecution)
+                            {
+                                if (referenceState.data1Mode)
+                                {
+                                    float flarg1;
+                                    memcpy(&flarg1, &arg1, sizeof(float));
+                                    float value;
+                                    memcpy(&value, activeDataReference(), sizeof(float));
+                                    value /= flarg1;
+                                    memcpy(activeDataReference(), &value, sizeof(float));
+                                }
+                                else
+                                {
+                                    *activeDataReference() /= arg1;
+                                }
+                            }
+                        }
+                            break;
+                        case 0x6:
+                        {
+                            if (!skipExecution)
+                            {
+                                *activeDataReference() &= arg1;
+                            }
+                        }
+                            break;
+                        case 0x7:
+                        {
+                            if (!skipExecution)
+                            {
+                                *activeDataReference() |= arg1;
+                            }
+                        }
+                            break;
+                        case 0x8:
+                        {
+                            if (!skipExecution)
+                            {
+                                *activeDataReference() ^= arg1;
+                            }
+                        }
+                            break;
+                        case 0x9:
+                        {
+                            if (!skipExecution)
+                            {
+                                *activeDataReference() = ~*activeDataReference();
+                            }
+                        }
+                            break;
+                        case 0xA:
+                        {
+                            if (!skipExecution)
+                            {
+                                *activeDataReference() <<= arg1;
+                            }
+                        }
+                            break;
+                        case 0xB:
+                        {
+                            if (!skipExecution)
+                            {
+                                *activeDataReference() >>= arg1;
+                            }
+                        }
+                            break;
+                        case 0xC:
+                        {
+                            if (!skipExecution)
+                            {
+                                u8 origActiveOffset = referenceState.activeOffset;
+                                for (size_t i = 0; i < arg1; i++)
+                                {
+                                    u8 data;
+                                    referenceState.activeOffset = 1;
+                                    if (!Cheat_Read8Reference(processHandle, 0, &data))
+                                    {
+                                        return 0;
+                                    }
+                                    referenceState.activeOffset = 0;
+                                    if (!Cheat_Write8Reference(processHandle, 0, data))
+                                    {
+                                        return 0;
+                                    }
+                                }
+                                referenceState.activeOffset = origActiveOffset;
+                            }
+                        }
+                            break;
+                        // Search for pattern
+                        case 0xE:
+                        {
+                            u32 searchSize = arg0 & 0xFFFF;
+                            if (searchSize <= arg1 && searchSize + referenceState.index < cheat->codesCount)
+                            {
+                                bool newSkip = true;
+                                if (!skipExecution) // Don't do an expensive operation if we don't have to
+                                {
+                                    u8* searchData = (u8*)(cheat->codes + referenceState.index + 1);
+                                    referenceState.index += searchSize / 8;
+                                    if (searchSize & 0x7)
+                                    {
+                                        referenceState.index++;
+                                    }
+                                    for (size_t i = 0; i < arg1 - searchSize; i++)
+                                    {
+                                        u8 curVal;
+                                        newSkip = false;
+                                        for (size_t j = 0; j < searchSize; j++)
+                                        {
+                                            if (!Cheat_Read8Reference(processHandle, i + j, &curVal))
+                                            {
+                                                return 0;
+                                            }
+                                            if (curVal != searchData[j])
+                                            {
+                                                newSkip = 1;
+                                                break;
+                                            }
+                                        }
+                                        if (!newSkip)
+                                        {
+                                            break;
+                                        }
+                                    }
+                                }
+
+                                referenceState.ifStack <<= 1;
+                                referenceState.ifStack |= (newSkip || skipExecution) ? 1 : 0;
+                                referenceState.ifCount++;
+                            }
+                            else
+                            {
+                                return 0;
+                            }
+                        }
+                            break;
+                        case 0xF:
+                        {
+                            if (!skipExecution)
+                            {
+                                u32 range = arg1 - (arg0 & 0xFFFFFF);
+                                u32 number = Cheat_GetRandomNumber() % range;
+                                *activeDataReference() = (arg0 & 0xFFFFFF) + number;
+                            }
+                        }
+                            break;
+                        default:
+                            return 0;
+                    }
+                }
+            }
+                break;
+            // This should now not be possible
+            default:
+                return 0;
+        }
+        referenceState.index++;
+    }
+    return 1;
+}
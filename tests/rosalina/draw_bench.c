@@ -0,0 +1,106 @@
+/*
+    Screenshot conversion speed of Rosalina's framebuffer converter (Draw_ConvertFrameBufferLines in
+    sysmodules/rosalina/source/draw.c, one band kernel per format) against the per-pixel one it replaced
+    (draw_reference.h), for each framebuffer format, on a 400x240 top screen framebuffer mapped where draw.c finds it.
+    The output of both has to be the same, for every way the screenshot code can split a screen in chunks.
+
+    Usage: draw_bench
+*/
+
+#include <stdarg.h>
+#include <sys/mman.h>
+#include "draw.c"
+#include "draw_reference.h"
+#include "bench.h"
+
+#define NB_RUNS         20
+#define SCREEN_WIDTH    400
+#define SCREEN_HEIGHT   240
+#define FB_PA           0x18000000
+
+// The kernel functions run right away
+Result svcCustomBackdoor(void *func, ...)
+{
+    va_list args;
+    va_start(args, func);
+    void *arg = va_arg(args, void *);
+    va_end(args);
+
+    ((void (*)(void *))func)(arg);
+    return 0;
+}
+
+static void *mapAt(u32 addr, u32 size)
+{
+    void *p = mmap((void *)(uintptr_t)addr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+    if(p != (void *)(uintptr_t)addr)
+    {
+        perror("mmap");
+        exit(1);
+    }
+    return p;
+}
+
+static void convertReference(u8 *buf, u32 startingLine, u32 numLines)
+{
+    FrameBufferConvertArgs args = { buf, SCREEN_WIDTH, (u8)startingLine, (u8)numLines, true, true };
+    Draw_ConvertFrameBufferLinesKernelReference(&args);
+}
+
+static void convert(u8 *buf, u32 startingLine, u32 numLines)
+{
+    Draw_ConvertFrameBufferLines(buf, SCREEN_WIDTH, startingLine, numLines, true, true);
+}
+
+// Whole screen, in chunks of chunkLines lines as RosalinaMenu_WriteScreenshot makes them when memory is low
+static void convertScreen(void (*converter)(u8 *buf, u32 startingLine, u32 numLines), u8 *picture, u32 chunkLines)
+{
+    for(u32 y = 0; y < SCREEN_HEIGHT; y += chunkLines)
+    {
+        u32 numLines = SCREEN_HEIGHT - y < chunkLines ? SCREEN_HEIGHT - y : chunkLines;
+        converter(picture + y * 3 * SCREEN_WIDTH, y, numLines);
+    }
+}
+
+int main(void)
+{
+    static const char *const formatNames[] = { "RGBA8", "BGR8", "RGB565", "RGB5A1", "RGBA4" };
+    static const u8 formatSizes[] = { 4, 3, 2, 2, 2 };
+    static const u32 chunkings[] = { 240, 120, 37, 13, 8, 3, 1 };
+
+    u32 pictureSize = 3 * SCREEN_WIDTH * SCREEN_HEIGHT;
+    u8 *expected = (u8 *)malloc(pictureSize), *picture = (u8 *)malloc(pictureSize);
+    u8 *framebuffer = (u8 *)mapAt((u32)KERNPA2VA(FB_PA), 0x100000);
+
+    mapAt((u32)PA_PTR(0x10400000), 0x1000);
+    GPU_FB_TOP_SEL = 0;
+    GPU_FB_TOP_LEFT_ADDR_1 = FB_PA;
+
+    printf("draw_bench: %ux%u top screen\n", SCREEN_WIDTH, SCREEN_HEIGHT);
+    for(u32 fmt = GSP_RGBA8_OES; fmt <= GSP_RGBA4_OES; fmt++)
+    {
+        GPU_FB_TOP_FMT = fmt | BIT(6); // 2D
+        GPU_FB_TOP_STRIDE = SCREEN_HEIGHT * formatSizes[fmt];
+        benchFillRandom(framebuffer, SCREEN_WIDTH * GPU_FB_TOP_STRIDE, 0x1234 + fmt);
+
+        for(u32 i = 0; i < sizeof(chunkings) / sizeof(chunkings[0]); i++)
+        {
+            memset(expected, 0, pictureSize);
+            memset(picture, 0xCC, pictureSize);
+            convertScreen(convertReference, expected, chunkings[i]);
+            convertScreen(convert, picture, chunkings[i]);
+            if(memcmp(expected, picture, pictureSize) != 0)
+            {
+                printf("FAIL: %s: different pictures in chunks of %lu lines\n", formatNames[fmt], (unsigned long)chunkings[i]);
+                return 1;
+            }
+        }
+
+        u64 referenceNs = BENCH_BEST_NS(NB_RUNS, convertReference(expected, 0, SCREEN_HEIGHT));
+        u64 ns = BENCH_BEST_NS(NB_RUNS, convert(picture, 0, SCREEN_HEIGHT));
+        printf("  %-6s previous %6.3f ms, band kernel %6.3f ms (x%.1f)\n", formatNames[fmt], referenceNs / 1e6, ns / 1e6,
+               (double)referenceNs / ns);
+    }
+
+    return 0;
+}
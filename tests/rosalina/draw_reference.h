@@ -0,0 +1,95 @@
+/*
+    The framebuffer converter Rosalina's screenshots used before the per-format band kernels
+    (Draw_ConvertFrameBufferLinesKernel in sysmodules/rosalina/source/draw.c), for the host benchmarks: one pixel at a
+    time, line by line, the format being switched on for each. To be included after draw.c; the names taken from it
+    have a Reference suffix.
+*/
+
+#pragma once
+
+static inline void Draw_ConvertPixelToBGR8Reference(u8 *dst, const u8 *src, GSPGPU_FramebufferFormat srcFormat)
+{
+    u8 red, green, blue;
+    switch(srcFormat)
+    {
+        case GSP_RGBA8_OES:
+        {
+            u32 px = *(u32 *)src;
+            dst[0] = (px >>  8) & 0xFF;
+            dst[1] = (px >> 16) & 0xFF;
+            dst[2] = (px >> 24) & 0xFF;
+            break;
+        }
+        case GSP_BGR8_OES:
+        {
+            dst[2] = src[2];
+            dst[1] = src[1];
+            dst[0] = src[0];
+            break;
+        }
+        case GSP_RGB565_OES:
+        {
+            // thanks neobrain
+            u16 px = *(u16 *)src;
+            blue = px & 0x1F;
+            green = (px >> 5) & 0x3F;
+            red = (px >> 11) & 0x1F;
+
+            dst[0] = (blue  << 3) | (blue  >> 2);
+            dst[1] = (green << 2) | (green >> 4);
+            dst[2] = (red   << 3) | (red   >> 2);
+
+            break;
+        }
+        case GSP_RGB5_A1_OES:
+        {
+            u16 px = *(u16 *)src;
+            blue = (px >> 1) & 0x1F;
+            green = (px >> 6) & 0x1F;
+            red = (px >> 11) & 0x1F;
+
+            dst[0] = (blue  << 3) | (blue  >> 2);
+            dst[1] = (green << 3) | (green >> 2);
+            dst[2] = (red   << 3) | (red   >> 2);
+
+            break;
+        }
+        case GSP_RGBA4_OES:
+        {
+            u16 px = *(u16 *)src; // was read as a u32, which is the same on little-endian
+            blue = (px >> 4) & 0xF;
+            green = (px >> 8) & 0xF;
+            red = (px >> 12) & 0xF;
+
+            dst[0] = (blue  << 4) | (blue  >> 0);
+            dst[1] = (green << 4) | (green >> 0);
+            dst[2] = (red   << 4) | (red   >> 0);
+
+            break;
+        }
+        default: break;
+    }
+}
+
+static void Draw_ConvertFrameBufferLinesKernelReference(const FrameBufferConvertArgs *args)
+{
+    static const u8 formatSizes[] = { 4, 3, 2, 2, 2 };
+
+    GSPGPU_FramebufferFormat fmt = args->top ? (GSPGPU_FramebufferFormat)(GPU_FB_TOP_FMT & 7) : (GSPGPU_FramebufferFormat)(GPU_FB_BOTTOM_FMT & 7);
+    u32 width = args->width;
+    u32 stride = args->top ? GPU_FB_TOP_STRIDE : GPU_FB_BOTTOM_STRIDE;
+
+    u32 pa = Draw_GetCurrentFramebufferAddress(args->top, args->left);
+    u8 *addr = (u8 *)KERNPA2VA(pa);
+
+    // Writes the lines from args->buf on, as the current converter does: the previous one wrote them at their line
+    // number, which only worked for screenshots converted in one chunk
+    for (u32 y = args->startingLine; y < args->startingLine + args->numLines; y++)
+    {
+        for(u32 x = 0; x < width; x++)
+        {
+            __builtin_prefetch(addr + x * stride + y * formatSizes[fmt], 0, 3);
+            Draw_ConvertPixelToBGR8Reference(args->buf + (x + width * (y - args->startingLine)) * 3 , addr + x * stride + y * formatSizes[fmt], fmt);
+        }
+    }
+}
@@ -0,0 +1,275 @@
+/*
+    Drives the GDB stub's packet framer (GDB_ReceivePacket and GDB_FramePacket, sysmodules/rosalina/source/gdb/net.c)
+    with fragmented input: fixed cases first, then random streams of valid, corrupted and oversized packets, split at
+    random boundaries. The framed packets and the acknowledgments sent back are checked against what the stream is
+    made of.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "gdb/net.h"
+
+static GDBContext ctx;
+
+// Input, delivered by socRecv in fragments of the given sizes
+static const char *input;
+static u32 inputSize, inputPos;
+static const u32 *fragmentSizes;
+static u32 nbFragments, fragmentIndex;
+
+// Output: acknowledgments and packets sent again, framed packets
+static char output[0x10000];
+static u32 outputSize;
+static char framed[0x10000];
+static u32 framedSize;
+
+static u32 nbFailures;
+
+ssize_t socRecvfrom(int sockfd, void *buf, size_t len, int flags, struct sockaddr *src_addr, socklen_t *addrlen)
+{
+    (void)sockfd; (void)flags; (void)src_addr; (void)addrlen;
+
+    if(inputPos == inputSize)
+        return 0;
+
+    u32 n = fragmentIndex < nbFragments ? fragmentSizes[fragmentIndex++] : inputSize - inputPos;
+    n = n > inputSize - inputPos ? inputSize - inputPos : n;
+    n = n > len ? len : n;
+    memcpy(buf, input + inputPos, n);
+    inputPos += n;
+    return n;
+}
+
+ssize_t socSendto(int sockfd, const void *buf, size_t len, int flags, const struct sockaddr *dest_addr, socklen_t addrlen)
+{
+    (void)sockfd; (void)flags; (void)dest_addr; (void)addrlen;
+
+    if(outputSize + len > sizeof(output))
+        return -1;
+
+    memcpy(output + outputSize, buf, len);
+    outputSize += len;
+    return len;
+}
+
+static void resetContext(u32 bufferSize)
+{
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.buffer = ctx.defaultBuffer;
+    ctx.sendBuffer = ctx.defaultSendBuffer;
+    ctx.workBuffer = ctx.defaultWorkBuffer;
+    ctx.bufferSize = bufferSize;
+
+    // Any packet sent again because of a stray '-' shows up in the output as "$OK#9a"
+    strcpy(ctx.sendBuffer, "$OK#9a");
+    ctx.latestSentPacketSize = 6;
+
+    outputSize = framedSize = 0;
+}
+
+// Same loop as GDB_DoPacket, framed packets being recorded one per line instead of handled
+static void runFramer(const char *data, u32 size, const u32 *sizes, u32 nbSizes)
+{
+    input = data;
+    inputSize = size;
+    inputPos = 0;
+    fragmentSizes = sizes;
+    nbFragments = nbSizes;
+    fragmentIndex = 0;
+
+    while(inputPos < inputSize)
+    {
+        int r;
+        if(GDB_ReceivePacket(&ctx) == -1)
+            break;
+
+        while((r = GDB_FramePacket(&ctx)) == 1)
+        {
+            const char *start = ctx.buffer[0] == '$' ? ctx.buffer + 1 : "^C";
+            u32 len = ctx.buffer[0] == '$' ? (u32)(ctx.commandEnd - start) : 2;
+            memcpy(framed + framedSize, start, len);
+            framedSize += len;
+            framed[framedSize++] = '\n';
+        }
+
+        if(r == -1)
+            break;
+    }
+
+    framed[framedSize] = 0;
+    output[outputSize] = 0;
+}
+
+static void check(const char *name, const char *expectedFramed, const char *expectedOutput)
+{
+    if(strcmp(framed, expectedFramed) != 0 || strcmp(output, expectedOutput) != 0)
+    {
+        printf("FAIL %s\n  framed: \"%s\" (expected \"%s\")\n  sent:   \"%s\" (expected \"%s\")\n", name, framed,
+               expectedFramed, output, expectedOutput);
+        nbFailures++;
+    }
+}
+
+static u32 appendPacket(char *dst, const char *data, u32 len, bool corrupt)
+{
+    u8 checksum = GDB_ComputeChecksum(data, len);
+    dst[0] = '$';
+    memcpy(dst + 1, data, len);
+    sprintf(dst + 1 + len, "#%02x", (u8)(checksum + (corrupt ? 1 : 0)));
+    return len + 4;
+}
+
+static void testFixedCases(void)
+{
+    static const u32 bytewise[0x100] = { [0 ... 0xFF] = 1 };
+    static const u32 halves[] = { 3, 3 };
+    char big[GDB_BUF_LEN + 0x200], data[GDB_BUF_LEN + 0x100];
+    u32 n;
+
+    resetContext(GDB_BUF_LEN);
+    runFramer("$g#67", 5, NULL, 0);
+    check("single packet", "g\n", "+");
+
+    resetContext(GDB_BUF_LEN);
+    runFramer("$g#67$m0,4#fd\x03$c#63", 20, bytewise, 0x100);
+    check("one byte at a time", "g\nm0,4\n^C\nc\n", "++++"); // interrupts are acknowledged as well
+
+    resetContext(GDB_BUF_LEN);
+    runFramer("$g#67", 5, halves, 2);
+    check("split checksum", "g\n", "+");
+
+    resetContext(GDB_BUF_LEN);
+    runFramer("+$g#00+$g#67", 12, NULL, 0);
+    check("bad checksum, stray acks", "g\n", "-+");
+
+    resetContext(GDB_BUF_LEN);
+    runFramer("$g#zz$g#67", 10, NULL, 0);
+    check("invalid checksum digits", "g\n", "-+");
+
+    resetContext(GDB_BUF_LEN);
+    runFramer("-$g#67", 6, NULL, 0);
+    check("NAK", "g\n", "$OK#9a+");
+
+    // Oversized packets whose data would otherwise be taken for a NAK, an interrupt, or the start of a packet.
+    // Only a single NAK has to be sent, then the next packet framed
+    for(n = 0; n < sizeof(data); n++)
+        data[n] = "-\x03" "abc"[n % 5];
+    memcpy(data + 0x200, "$g", 2);
+    n = appendPacket(big, data, sizeof(data), false);
+    n += appendPacket(big + n, "g", 1, false);
+    resetContext(GDB_BUF_LEN);
+    runFramer(big, n, NULL, 0);
+    check("oversized packet", "g\n", "-+");
+
+    resetContext(GDB_BUF_LEN);
+    runFramer(big, n, bytewise, 0x100);
+    check("oversized packet, fragmented", "g\n", "-+");
+
+    // '#' and checksum digits of oversized packets at the end of the receive buffer, then the largest packet
+    for(u32 trailerInBuffer = 0; trailerInBuffer < 3; trailerInBuffer++)
+    {
+        char name[64];
+        n = appendPacket(big, data, GDB_BUF_LEN + 3 - trailerInBuffer, false);
+        n += appendPacket(big + n, "g", 1, false);
+        resetContext(GDB_BUF_LEN);
+        runFramer(big, n, NULL, 0);
+        sprintf(name, "oversized packet, %lu trailer bytes received", (unsigned long)trailerInBuffer);
+        check(name, "g\n", "-+");
+    }
+
+    char expected[GDB_BUF_LEN + 4];
+    memcpy(expected, data, GDB_BUF_LEN);
+    strcpy(expected + GDB_BUF_LEN, "\ng\n");
+    n = appendPacket(big, data, GDB_BUF_LEN, false);
+    n += appendPacket(big + n, "g", 1, false);
+    resetContext(GDB_BUF_LEN);
+    runFramer(big, n, NULL, 0);
+    check("largest packet", expected, "++");
+}
+
+// Random streams of packets, some corrupted or oversized, with stray acknowledgments and interrupts in between
+static void testRandomStreams(u32 nbStreams)
+{
+    static char stream[0x8000], data[GDB_BUF_LEN + 0x100];
+    static char expectedFramed[0x10000], expectedOutput[0x1000];
+    static u32 sizes[0x1000];
+
+    srand(1);
+    for(u32 i = 0; i < nbStreams; i++)
+    {
+        u32 size = 0, expectedFramedSize = 0, expectedOutputSize = 0, nbSizes = 0;
+        u32 bufferSize = (rand() & 1) ? GDB_BUF_LEN : 0x100;
+
+        while(size < sizeof(stream) - sizeof(data) - 8)
+        {
+            int kind = rand() % 16;
+            if(kind == 0)
+            {
+                stream[size++] = '+';
+                continue;
+            }
+            else if(kind == 1)
+            {
+                stream[size++] = '\x03';
+                memcpy(expectedFramed + expectedFramedSize, "^C\n", 3);
+                expectedFramedSize += 3;
+                expectedOutput[expectedOutputSize++] = '+';
+                continue;
+            }
+
+            // Data never contains '#' nor '$' (escaped), but anything else, '-' and 0x03 included
+            bool oversized = kind == 2;
+            bool corrupt = kind == 3;
+            u32 len = oversized ? bufferSize + 1 + rand() % 0x100 : rand() % (bufferSize + 1);
+            for(u32 j = 0; j < len; j++)
+            {
+                char c;
+                do
+                    c = (char)(rand() % 8 == 0 ? "-\x03+}"[rand() % 4] : rand());
+                while(c == '#' || c == '$');
+                data[j] = c;
+            }
+
+            size += appendPacket(stream + size, data, len, corrupt);
+            if(oversized || corrupt)
+                expectedOutput[expectedOutputSize++] = '-';
+            else
+            {
+                memcpy(expectedFramed + expectedFramedSize, data, len);
+                expectedFramedSize += len;
+                expectedFramed[expectedFramedSize++] = '\n';
+                expectedOutput[expectedOutputSize++] = '+';
+            }
+        }
+
+        for(u32 total = 0; total < size && nbSizes < sizeof(sizes) / sizeof(sizes[0]); total += sizes[nbSizes++])
+            sizes[nbSizes] = 1 + (rand() % 4 == 0 ? (u32)rand() % 8 : (u32)rand() % (2 * bufferSize));
+
+        expectedFramed[expectedFramedSize] = 0;
+        expectedOutput[expectedOutputSize] = 0;
+        resetContext(bufferSize);
+        runFramer(stream, size, sizes, nbSizes);
+
+        if(framedSize != expectedFramedSize || memcmp(framed, expectedFramed, framedSize) != 0 ||
+           strcmp(output, expectedOutput) != 0)
+        {
+            printf("FAIL random stream %lu (buffer size %lu)\n", (unsigned long)i, (unsigned long)bufferSize);
+            nbFailures++;
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    u32 nbStreams = argc > 1 ? (u32)strtoul(argv[1], NULL, 0) : 200;
+
+    testFixedCases();
+    testRandomStreams(nbStreams);
+
+    if(nbFailures != 0)
+        return 1;
+
+    printf("gdb_framer_test: OK\n");
+    return 0;
+}
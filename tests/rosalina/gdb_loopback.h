@@ -0,0 +1,152 @@
+/*
+    Loopback connection to Rosalina's GDB stub for the host benchmarks: the stub side (gdb/net.c framing, handlers
+    dispatched by the benchmark) runs in its own thread on one end of a loopback TCP socket, the benchmark being
+    the client on the other end, sending one request then waiting for its reply as GDB does.
+*/
+
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include "gdb/net.h"
+#include "gdb/server.h"
+
+static GDBServer loopbackServer;
+
+// Handles the packet framed in ctx->buffer, as GDB_HandlePacket would
+static int (*loopbackDispatch)(GDBContext *ctx);
+
+ssize_t socRecvfrom(int sockfd, void *buf, size_t len, int flags, struct sockaddr *src_addr, socklen_t *addrlen)
+{
+    (void)flags; (void)src_addr; (void)addrlen;
+    return recv(sockfd, buf, len, 0);
+}
+
+ssize_t socSendto(int sockfd, const void *buf, size_t len, int flags, const struct sockaddr *dest_addr, socklen_t addrlen)
+{
+    (void)flags; (void)dest_addr; (void)addrlen;
+    return send(sockfd, buf, len, 0);
+}
+
+// Same loop as GDB_DoPacket
+static void *loopbackStubThread(void *arg)
+{
+    GDBContext *ctx = (GDBContext *)arg;
+
+    while(GDB_ReceivePacket(ctx) != -1)
+    {
+        int r;
+        while((r = GDB_FramePacket(ctx)) == 1)
+        {
+            ctx->commandData = ctx->buffer + 2;
+            r = loopbackDispatch(ctx);
+            if(r == -1)
+                break;
+        }
+        if(r == -1)
+            break;
+    }
+
+    return NULL;
+}
+
+// The client side: requests are written from loopbackRequest + 1 (after the '$'), replies land in loopbackReply
+static int loopbackClient;
+static char loopbackRequest[GDB_LARGE_BUF_LEN + 8], loopbackReply[GDB_LARGE_BUF_LEN + 8];
+static u32 loopbackRoundTrips;
+
+// Sends the len first characters of loopbackRequest, '$' included, with their checksum
+static void loopbackSendRequest(u32 len)
+{
+    u8 checksum = GDB_ComputeChecksum(loopbackRequest + 1, len - 1);
+    sprintf(loopbackRequest + len, "#%02x", checksum);
+    len += 3;
+
+    for(u32 sent = 0; sent < len;)
+    {
+        ssize_t n = send(loopbackClient, loopbackRequest + sent, len - sent, 0);
+        if(n <= 0)
+        {
+            perror("send");
+            exit(1);
+        }
+        sent += n;
+    }
+}
+
+// Returns the size of the reply data, which starts at loopbackReply + 1
+static u32 loopbackReceiveReply(void)
+{
+    u32 size = 0;
+    char *end;
+
+    while(size < 3 || (end = (char *)memchr(loopbackReply, '#', size)) == NULL || end + 3 > loopbackReply + size)
+    {
+        ssize_t n = recv(loopbackClient, loopbackReply + size, GDB_LARGE_BUF_LEN + 4 - size, 0);
+        if(n <= 0)
+        {
+            perror("recv");
+            exit(1);
+        }
+        size += n;
+    }
+
+    loopbackRoundTrips++;
+    return end - loopbackReply - 1;
+}
+
+// Sets up what GDB_InitializeContext does, for the default buffers
+static GDBContext *loopbackInitContext(void)
+{
+    GDBContext *ctx = &loopbackServer.ctxs[0];
+
+    ctx->parent = &loopbackServer;
+    ctx->buffer = ctx->defaultBuffer;
+    ctx->sendBuffer = ctx->defaultSendBuffer;
+    ctx->workBuffer = ctx->defaultWorkBuffer;
+    ctx->bufferSize = GDB_BUF_LEN;
+    return ctx;
+}
+
+// Connects, runs client on the benchmark's side while the stub serves it, then disconnects
+static void loopbackRun(GDBContext *ctx, void (*client)(GDBContext *ctx))
+{
+    int listener = socket(AF_INET, SOCK_STREAM, 0), one = 1;
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK) };
+    socklen_t addrLen = sizeof(addr);
+    pthread_t thread;
+
+    if(listener < 0 || bind(listener, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(listener, 1) != 0 ||
+       getsockname(listener, (struct sockaddr *)&addr, &addrLen) != 0)
+    {
+        perror("listen");
+        exit(1);
+    }
+
+    loopbackClient = socket(AF_INET, SOCK_STREAM, 0);
+    if(loopbackClient < 0 || connect(loopbackClient, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+    {
+        perror("connect");
+        exit(1);
+    }
+
+    ctx->super.sockfd = accept(listener, NULL, NULL);
+    setsockopt(loopbackClient, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    setsockopt(ctx->super.sockfd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    ctx->receivedSize = ctx->packetSize = ctx->scannedSize = 0;
+    ctx->flags |= GDB_FLAG_NOACK; // as GDB asks with QStartNoAckMode
+
+    pthread_create(&thread, NULL, loopbackStubThread, ctx);
+    client(ctx);
+
+    close(loopbackClient);
+    pthread_join(thread, NULL);
+    close(ctx->super.sockfd);
+    close(listener);
+}
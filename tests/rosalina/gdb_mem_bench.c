@@ -0,0 +1,218 @@
+/*
+    Memory transfer throughput of the GDB stub (the m, x, M and X handlers of sysmodules/rosalina/source/gdb/mem.c,
+    framed by gdb/net.c), with the packet buffers GDB_AllocatePacketBuffers negotiates (gdb.c) and with the
+    GDB_BUF_LEN ones the stub was limited to before. A loopback TCP client dumps, then writes the heap of a fake
+    process, one request at a time as GDB does, the stub running in its own thread: MB/s and round trips per MB.
+
+    Usage: gdb_mem_bench [heap size in MB (default 32)]
+*/
+
+#include "gdb/mem.h"
+#include "utils.h"
+#include "gdb_loopback.h"
+#include "bench.h"
+
+// k_memcpy_no_interrupt masks interrupts with an ARM instruction, svcCustomBackdoor never runs it here
+#define __asm__
+#define volatile(...)
+#include "gdb/mem.c"
+#undef volatile
+#undef __asm__
+
+#define HEAP_BASE       0x08000000
+#define DEBUG_HANDLE    0x1234
+
+static u8 *heap;
+static u32 heapSize;
+
+// The fake process: user memory is its heap, read and written through the debug svcs
+Result svcGetSystemInfo(s64 *out, u32 type, s32 param)
+{
+    (void)type; (void)param;
+    *out = 1; // TTBCR.N: the user address space is the lower 2GB
+    return 0;
+}
+
+Result svcReadProcessMemory(void *buffer, Handle debug, u32 addr, u32 size)
+{
+    if(debug != DEBUG_HANDLE || addr < HEAP_BASE || size > heapSize || addr - HEAP_BASE > heapSize - size)
+        return 0xE0E01BF5;
+
+    memcpy(buffer, heap + (addr - HEAP_BASE), size);
+    return 0;
+}
+
+Result svcWriteProcessMemory(Handle debug, const void *buffer, u32 addr, u32 size)
+{
+    if(debug != DEBUG_HANDLE || addr < HEAP_BASE || size > heapSize || addr - HEAP_BASE > heapSize - size)
+        return 0xE0E01BF5;
+
+    memcpy(heap + (addr - HEAP_BASE), buffer, size);
+    return 0;
+}
+
+// Kernel memory isn't accessible (enableExternalMemoryAccess is off), these are never reached
+u32 svcConvertVAToPA(const void *VA, bool writeCheck)
+{
+    (void)VA; (void)writeCheck;
+    return 0;
+}
+
+Result svcCustomBackdoor(void *func, ...)
+{
+    (void)func;
+    return -1;
+}
+
+void svcFlushEntireDataCache(void)
+{
+}
+
+void svcInvalidateEntireInstructionCache(void)
+{
+}
+
+// Only the memory commands are dispatched
+static int dispatch(GDBContext *ctx)
+{
+    switch(ctx->buffer[1])
+    {
+        case 'm': return GDB_HANDLER(ReadMemory)(ctx);
+        case 'x': return GDB_HANDLER(ReadMemoryRaw)(ctx);
+        case 'M': return GDB_HANDLER(WriteMemory)(ctx);
+        case 'X': return GDB_HANDLER(WriteMemoryRaw)(ctx);
+        default: return GDB_ReplyEmpty(ctx);
+    }
+}
+
+// Largest length a request can ask for, given the packet size: as GDB computes it for m, x and M, the data being
+// bounded by its escaped size for X
+static u32 maxRequestLength(char command, u32 packetSize)
+{
+    switch(command)
+    {
+        case 'm': return (packetSize - 1) / 2;
+        case 'x': return packetSize - 1;
+        case 'M': return (packetSize - 32) / 2;
+        default: return packetSize - 32;
+    }
+}
+
+static bool readHeap(char command, u32 packetSize, u8 *out)
+{
+    for(u32 offset = 0; offset < heapSize;)
+    {
+        u32 len = maxRequestLength(command, packetSize);
+        len = len > heapSize - offset ? heapSize - offset : len;
+
+        loopbackSendRequest(sprintf(loopbackRequest, "$%c%lx,%lx", command, (unsigned long)(HEAP_BASE + offset), (unsigned long)len));
+        u32 size = loopbackReceiveReply();
+        u32 n = command == 'm' ? GDB_DecodeHex(out + offset, loopbackReply + 1, size / 2)
+                               : GDB_UnescapeBinaryData(out + offset, loopbackReply + 2, size - 1);
+
+        if(n == 0 || (command == 'm' && n != len) || (command == 'x' && loopbackReply[1] != 'b'))
+            return false;
+        offset += n;
+    }
+
+    return true;
+}
+
+static bool writeHeap(char command, u32 packetSize, const u8 *in)
+{
+    for(u32 offset = 0; offset < heapSize;)
+    {
+        u32 len = maxRequestLength(command, packetSize), size;
+        len = len > heapSize - offset ? heapSize - offset : len;
+
+        size = sprintf(loopbackRequest, "$%c%lx,", command, (unsigned long)(HEAP_BASE + offset));
+        if(command == 'M')
+        {
+            size += sprintf(loopbackRequest + size, "%lx:", (unsigned long)len);
+            GDB_EncodeHex(loopbackRequest + size, in + offset, len);
+            size += 2 * len;
+        }
+        else
+        {
+            // The length is only known once as much data as fits has been escaped
+            u32 escaped, header = size;
+            char *data = loopbackRequest + header + 9;
+            len = GDB_EscapeBinaryData(&escaped, data, in + offset, len, packetSize - (header + 9));
+            size += sprintf(loopbackRequest + size, "%lx:", (unsigned long)len);
+            memmove(loopbackRequest + size, data, escaped);
+            size += escaped;
+        }
+
+        loopbackSendRequest(size);
+        loopbackReceiveReply();
+        if(strncmp(loopbackReply, "$OK#", 4) != 0)
+            return false;
+        offset += len;
+    }
+
+    return true;
+}
+
+// What the heap holds before each transfer, and what is read or written
+static u8 *data, *out;
+static const char *benchName;
+
+static void bench(GDBContext *ctx)
+{
+    static const char commands[] = { 'm', 'x', 'M', 'X' };
+
+    printf("  %s (%lu-byte packets):\n", benchName, (unsigned long)ctx->bufferSize);
+    for(u32 i = 0; i < sizeof(commands); i++)
+    {
+        char command = commands[i];
+        bool read = command == 'm' || command == 'x', ok;
+
+        // Reads fill out with the heap, writes write it to the heap
+        memcpy(heap, data, heapSize);
+        if(read)
+            memset(out, 0, heapSize);
+        else
+            benchFillRandom(out, heapSize, 0x5678 + i);
+        loopbackRoundTrips = 0;
+
+        u64 ns = BENCH_BEST_NS(1, ok = read ? readHeap(command, ctx->bufferSize, out) : writeHeap(command, ctx->bufferSize, out));
+        if(!ok || memcmp(read ? data : out, read ? out : heap, heapSize) != 0)
+        {
+            printf("FAIL: %s: %c transfer\n", benchName, command);
+            exit(1);
+        }
+
+        printf("    %c: %8.1f MB/s, %6lu round trips (%4lu per MB)\n", command, benchMBps(heapSize, ns),
+               (unsigned long)loopbackRoundTrips, (unsigned long)(loopbackRoundTrips / (heapSize >> 20)));
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    GDBContext *ctx = loopbackInitContext();
+    u32 sizeMB = argc > 1 ? (u32)strtoul(argv[1], NULL, 0) : 32;
+
+    heapSize = (sizeMB != 0 ? sizeMB : 1) << 20;
+    heap = (u8 *)malloc(heapSize);
+    data = (u8 *)malloc(heapSize);
+    out = (u8 *)malloc(heapSize);
+    benchFillRandom(data, heapSize, 0x1234);
+
+    printf("gdb_mem_bench: %lu MB heap\n", (unsigned long)(heapSize >> 20));
+
+    ctx->debug = DEBUG_HANDLE;
+    loopbackDispatch = dispatch;
+    benchName = "default buffers";
+    loopbackRun(ctx, bench);
+
+    if(R_FAILED(GDB_AllocatePacketBuffers(ctx)))
+    {
+        printf("FAIL: GDB_AllocatePacketBuffers\n");
+        return 1;
+    }
+    benchName = "negotiated buffers";
+    loopbackRun(ctx, bench);
+    GDB_FreePacketBuffers(ctx);
+
+    return 0;
+}
@@ -0,0 +1,209 @@
+/*
+    Bulk file transfer throughput of the GDB stub's vFile:pread (sysmodules/rosalina/source/gdb/tio.c), through a
+    loopback client (gdb_loopback.h) reading a host file from start to end, one request of PacketSize bytes at a
+    time as GDB does. Files opened read-only are served from the per-fd read-ahead buffer, the others still read
+    what each request asks for, as every file was before: both with the GDB_BUF_LEN packet buffers and with the
+    ones GDB_AllocatePacketBuffers negotiates (gdb.c). MB/s, round trips and FS reads per MB.
+
+    Host reads come from the page cache: a latency can be given to each FS read, to stand for the FS IPC and the SD
+    card access a read costs on the console.
+
+    Usage: gdb_tio_bench [file size in MB (default 32)] [FS read latency in us (default 0)]
+*/
+
+#include <stdarg.h>
+#include <unistd.h>
+#include <time.h>
+#include "gdb/tio.h"
+#include "gdb_loopback.h"
+#include "bench.h"
+#include "host_ctru.h"
+
+#define GDBHIO_O_RDONLY 0x0
+#define GDBHIO_O_RDWR   0x2
+
+static const char filePath[] = "/bench.bin";
+
+static u8 *data, *out;
+static u32 fileSize;
+
+// FS calls made, as they are what a transfer costs on the console (linked with --wrap)
+static u32 fsReads;
+static struct timespec fsReadLatency;
+
+Result __real_FSFILE_Read(Handle handle, u32 *bytesRead, u64 offset, void *buffer, u32 size);
+
+Result __wrap_FSFILE_Read(Handle handle, u32 *bytesRead, u64 offset, void *buffer, u32 size)
+{
+    fsReads++;
+    if(fsReadLatency.tv_nsec != 0 || fsReadLatency.tv_sec != 0)
+        nanosleep(&fsReadLatency, NULL);
+    return __real_FSFILE_Read(handle, bytesRead, offset, buffer, size);
+}
+
+// vFile:fstat is never sent here
+Result FSUSER_OpenDirectory(Handle *out, FS_Archive archive, FS_Path path)
+{
+    (void)out; (void)archive; (void)path;
+    return 0xC8804478;
+}
+
+Result FSDIR_Close(Handle handle)
+{
+    (void)handle;
+    return 0;
+}
+
+// Only the vFile commands are dispatched
+static int dispatch(GDBContext *ctx)
+{
+    if(strncmp(ctx->buffer + 1, "vFile:", 6) != 0)
+        return GDB_ReplyEmpty(ctx);
+
+    ctx->commandData = ctx->buffer + 7;
+    return GDB_VERBOSE_HANDLER(File)(ctx);
+}
+
+// Returns the F reply's result, its data (if any) being unescaped to dst
+static s32 fileRequest(u8 *dst, u32 *dstSize, const char *fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    loopbackRequest[0] = '$';
+    u32 len = 1 + vsprintf(loopbackRequest + 1, fmt, args);
+    va_end(args);
+
+    loopbackSendRequest(len);
+    u32 size = loopbackReceiveReply();
+    char *end = loopbackReply + 1 + size, *p = loopbackReply + 2;
+    bool negative = *p == '-';
+    p += negative ? 1 : 0;
+
+    if(loopbackReply[1] != 'F')
+        return -1;
+
+    u32 result = 0;
+    for(; p < end && *p != ';' && *p != ','; p++)
+        result = 16 * result + (*p >= 'a' ? *p - 'a' + 10 : *p - '0');
+
+    if(dst != NULL)
+        *dstSize = p < end && *p == ';' ? GDB_UnescapeBinaryData(dst, p + 1, end - (p + 1)) : 0;
+
+    return negative ? -(s32)result : (s32)result;
+}
+
+static int openFile(int flags)
+{
+    char hexPath[2 * sizeof(filePath)];
+
+    GDB_EncodeHex(hexPath, filePath, sizeof(filePath) - 1);
+    hexPath[2 * (sizeof(filePath) - 1)] = 0;
+    return (int)fileRequest(NULL, NULL, "vFile:open:%s,%x,0", hexPath, flags);
+}
+
+static bool readFile(GDBContext *ctx, int fd)
+{
+    for(u32 offset = 0;;)
+    {
+        u32 size;
+        s32 count = fileRequest(out + offset, &size, "vFile:pread:%x,%lx,%lx", fd, (unsigned long)ctx->bufferSize,
+                                (unsigned long)offset);
+
+        if(count < 0 || (u32)count != size || offset + size > fileSize)
+            return false;
+        else if(count == 0)
+            return offset == fileSize;
+        offset += size;
+    }
+}
+
+static const char *benchName;
+
+static void bench(GDBContext *ctx)
+{
+    static const struct
+    {
+        const char *name;
+        int flags;
+    } modes[] = {
+        { "uncached", GDBHIO_O_RDWR },
+        { "read-ahead", GDBHIO_O_RDONLY },
+    };
+
+    printf("  %s (%lu-byte packets):\n", benchName, (unsigned long)ctx->bufferSize);
+    for(u32 i = 0; i < sizeof(modes) / sizeof(modes[0]); i++)
+    {
+        bool ok = true;
+        u32 reads = 0, roundTrips = 0;
+
+        u64 ns = BENCH_BEST_NS(5, {
+            int fd = openFile(modes[i].flags);
+            memset(out, 0, fileSize);
+            fsReads = 0;
+            loopbackRoundTrips = 0;
+            ok = ok && fd >= 0 && readFile(ctx, fd) && memcmp(data, out, fileSize) == 0;
+            reads = fsReads;
+            roundTrips = loopbackRoundTrips;
+            ok = ok && fileRequest(NULL, NULL, "vFile:close:%x", fd) == 0;
+        });
+
+        if(!ok)
+        {
+            printf("FAIL: %s: %s transfer\n", benchName, modes[i].name);
+            exit(1);
+        }
+
+        printf("    %-10s %8.1f MB/s, %5lu round trips %5lu FS reads per MB\n", modes[i].name,
+               benchMBps(fileSize, ns), (unsigned long)(roundTrips / (fileSize >> 20)),
+               (unsigned long)(reads / (fileSize >> 20)));
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    GDBContext *ctx = loopbackInitContext();
+    u32 sizeMB = argc > 1 ? (u32)strtoul(argv[1], NULL, 0) : 32;
+    u32 latencyUs = argc > 2 ? (u32)strtoul(argv[2], NULL, 0) : 0;
+    char root[] = "/tmp/gdb_tio_bench.XXXXXX";
+
+    fileSize = (sizeMB != 0 ? sizeMB : 1) << 20;
+    data = (u8 *)malloc(fileSize);
+    out = (u8 *)malloc(fileSize);
+    benchFillRandom(data, fileSize, 0x1234);
+    fsReadLatency.tv_sec = latencyUs / 1000000;
+    fsReadLatency.tv_nsec = (latencyUs % 1000000) * 1000;
+
+    if(mkdtemp(root) == NULL)
+    {
+        perror("mkdtemp");
+        return 1;
+    }
+    hostFsSetRoot(root);
+
+    FILE *f = fopen(hostFsGetPath(filePath), "wb");
+    if(f == NULL || fwrite(data, 1, fileSize, f) != fileSize)
+    {
+        perror("fwrite");
+        return 1;
+    }
+    fclose(f);
+
+    printf("gdb_tio_bench: %lu MB file, %lu us per FS read\n", (unsigned long)(fileSize >> 20), (unsigned long)latencyUs);
+
+    loopbackDispatch = dispatch;
+    benchName = "default buffers";
+    loopbackRun(ctx, bench);
+
+    if(R_FAILED(GDB_AllocatePacketBuffers(ctx)))
+    {
+        printf("FAIL: GDB_AllocatePacketBuffers\n");
+        return 1;
+    }
+    benchName = "negotiated buffers";
+    loopbackRun(ctx, bench);
+    GDB_FreePacketBuffers(ctx);
+
+    unlink(hostFsGetPath(filePath));
+    rmdir(root);
+    return 0;
+}
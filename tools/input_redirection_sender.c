@@ -0,0 +1,168 @@
+/*
+*   This file is part of Luma3DS
+*   Copyright (C) 2016-2020 Aurora Wright, TuxSH
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+/*
+    Linux host sender for the v2 input redirection protocol (see sysmodules/rosalina/source/input_redirection.c),
+    meant for testing. Build it with:
+
+        cc -O2 -Wall -o input_redirection_sender input_redirection_sender.c
+
+    Usage: input_redirection_sender <3DS address> [rate in Hz (default 60)] [samples per packet (default 4, max 8)]
+
+    The current state is sent at the given rate, along with the previous samples. It's read from stdin, one line
+    per change, as up to 5 hexadecimal words in the v1 order: pad, touch screen, circle pad, IR, special buttons.
+    Missing words keep their neutral value, e.g. "ffe" holds A and "fff" releases it.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <endian.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+#define INPUT_REDIRECTION_PORT          4950
+#define INPUT_REDIRECTION_V2_MAGIC      0x32445249 // "IRD2"
+#define INPUT_REDIRECTION_MAX_SAMPLES   8
+#define SAMPLE_SIZE                     20
+#define HEADER_SIZE                     16
+
+static const uint32_t neutralSample[SAMPLE_SIZE / 4] = { 0x00000FFF, 0x02000000, 0x007FF7FF, 0x80800081, 0 };
+
+static uint32_t getTimestamp(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000);
+}
+
+static void putWord(uint8_t *dst, uint32_t word)
+{
+    word = htole32(word);
+    memcpy(dst, &word, 4);
+}
+
+static void parseSample(uint32_t *sample, char *line)
+{
+    char *pos = line, *end;
+
+    memcpy(sample, neutralSample, SAMPLE_SIZE);
+    for(unsigned i = 0; i < SAMPLE_SIZE / 4; i++)
+    {
+        uint32_t word = (uint32_t)strtoul(pos, &end, 16);
+        if(end == pos)
+            break;
+
+        sample[i] = word;
+        pos = end;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    if(argc < 2 || argc > 4)
+    {
+        fprintf(stderr, "Usage: %s <3DS address> [rate in Hz] [samples per packet]\n", argv[0]);
+        return 1;
+    }
+
+    struct sockaddr_in addr = { 0 };
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(INPUT_REDIRECTION_PORT);
+    if(inet_pton(AF_INET, argv[1], &addr.sin_addr) != 1)
+    {
+        fprintf(stderr, "Invalid address: %s\n", argv[1]);
+        return 1;
+    }
+
+    long rate = argc > 2 ? strtol(argv[2], NULL, 10) : 60;
+    long batch = argc > 3 ? strtol(argv[3], NULL, 10) : 4;
+    if(rate <= 0 || rate > 1000 || batch <= 0 || batch > INPUT_REDIRECTION_MAX_SAMPLES)
+    {
+        fprintf(stderr, "The rate must be within 1-1000 Hz, and the samples per packet within 1-%d\n", INPUT_REDIRECTION_MAX_SAMPLES);
+        return 1;
+    }
+
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if(sock < 0)
+    {
+        perror("socket");
+        return 1;
+    }
+
+    // Ring of the latest samples, the current one being history[sequence % MAX]
+    uint32_t history[INPUT_REDIRECTION_MAX_SAMPLES][SAMPLE_SIZE / 4];
+    uint32_t current[SAMPLE_SIZE / 4];
+    uint32_t sequence = 0, nbSent = 0;
+    uint8_t packet[HEADER_SIZE + INPUT_REDIRECTION_MAX_SAMPLES * SAMPLE_SIZE];
+    bool stdinOpen = true;
+
+    memcpy(current, neutralSample, SAMPLE_SIZE);
+
+    for(;;)
+    {
+        struct pollfd pfd = { .fd = STDIN_FILENO, .events = POLLIN };
+        char line[256];
+
+        if(stdinOpen && poll(&pfd, 1, (int)(1000 / rate)) > 0)
+        {
+            if(fgets(line, sizeof(line), stdin) != NULL)
+                parseSample(current, line);
+            else
+                stdinOpen = false; // keep sending the latest state
+            continue;
+        }
+        else if(!stdinOpen)
+            usleep((useconds_t)(1000000 / rate));
+
+        sequence++;
+        memcpy(history[sequence % INPUT_REDIRECTION_MAX_SAMPLES], current, SAMPLE_SIZE);
+        if(nbSent < (uint32_t)batch)
+            nbSent++;
+
+        putWord(packet, INPUT_REDIRECTION_V2_MAGIC);
+        putWord(packet + 4, sequence);
+        putWord(packet + 8, getTimestamp());
+        packet[12] = (uint8_t)nbSent;
+        memset(packet + 13, 0, 3);
+
+        // Oldest first, the latest sample having the sequence number of the header
+        for(uint32_t i = 0; i < nbSent; i++)
+        {
+            const uint32_t *sample = history[(sequence - nbSent + 1 + i) % INPUT_REDIRECTION_MAX_SAMPLES];
+            for(unsigned j = 0; j < SAMPLE_SIZE / 4; j++)
+                putWord(packet + HEADER_SIZE + i * SAMPLE_SIZE + 4 * j, sample[j]);
+        }
+
+        if(sendto(sock, packet, HEADER_SIZE + nbSent * SAMPLE_SIZE, 0, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+            perror("sendto");
+    }
+}